@@ -1,11 +1,11 @@
 #include "shader/util.glsl"
+#include "shader/pass.glsl"
 #include "shader/atmosphere.glsl"
 #include "shader/cloud.glsl"
 
 layout(early_fragment_tests) in;
 
 layout(bindless_sampler) uniform sampler2D texNoise;
-uniform vec3 light;
 uniform float udotl;
 uniform float time;
 
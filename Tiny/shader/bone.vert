@@ -1,5 +1,6 @@
 #include "shader/util.glsl"
 #include "shader/vtf.glsl"
+#include "shader/camera.glsl"
 
 layout(binding = 1, std430) buffer InMaterial {
 	Material inMaterials[];
@@ -9,8 +10,6 @@ uniform mat4 viewProjectMatrix;
 uniform BindlessSampler2D boneTex[MAX_BONE_TEX];
 
 #ifdef ShadowPass
-uniform mat4 projectMatrix, viewMatrix;
-uniform vec2 camPara;
 #endif
 
 layout (location = 0) in vec3 vertex;
@@ -0,0 +1,10 @@
+// Camera of current pass, refilled by Render when the drawing camera changes
+layout(std140, binding = 3) uniform CameraBlock {
+	mat4 viewMatrix;
+	mat4 projectMatrix;
+	mat4 invViewProjMatrix;
+	mat4 invProjMatrix;
+	mat4 invViewMatrix;
+	vec3 eyePos;
+	vec2 camPara;
+};
@@ -1,4 +1,5 @@
 #include "shader/util.glsl"
+#include "shader/camera.glsl"
 
 uniform BindlessSampler2D sceneBuffer, 
 						sceneNormalBuffer,
@@ -10,10 +11,7 @@ uniform BindlessSampler2D sceneBuffer,
 						bloomBuffer;
 
 uniform vec2 pixelSize;
-uniform mat4 invViewProjMatrix;
-uniform vec3 light;
 uniform float udotl;
-uniform vec3 eyePos;
 
 in vec2 vTexcoord;
 
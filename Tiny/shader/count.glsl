@@ -0,0 +1,4 @@
+// Mesh counts of one multi drawcall, filled once when it is created
+layout(std140, binding = 2) uniform CountBlock {
+	uvec4 uCount;
+};
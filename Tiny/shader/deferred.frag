@@ -1,4 +1,6 @@
 ﻿#include "shader/util.glsl"
+#include "shader/pass.glsl"
+#include "shader/camera.glsl"
 #include "shader/pbr.glsl"
 
 uniform BindlessSampler2D texBuffer, 
@@ -10,17 +12,13 @@ uniform BindlessSamplerCube irradianceMap, prefilteredMap;
 uniform BindlessSampler2D brdfMap;
 
 uniform vec2 pixelSize;
-uniform mat4 invViewProjMatrix, invProjMatrix;
-uniform mat3 invViewMatrix;
 
 uniform BindlessSampler2D shadowBuffers[4];
 
 uniform mat4 lightViewProjDyn, lightViewProjNear, lightViewProjMid, lightViewProjFar;
 uniform vec2 shadowPixSize;
 uniform vec3 levels;
-uniform vec3 light;
 uniform float udotl;
-uniform vec3 eyePos;
 uniform float time;
 
 uniform mat4 lightProjDyn, lightProjNear, lightProjMid, lightProjFar, 
@@ -250,7 +248,7 @@ void main() {
 			sceneColor = (ambient * material.r + kd * albedo * material.g) * udotl;
 		#endif
 	} else {
-		normal = invViewMatrix * normal;
+		normal = mat3(invViewMatrix) * normal;
 		#ifdef USE_BLOOM
 			bright = sceneColor * udotl * 2.5; // Bloom
 		#endif
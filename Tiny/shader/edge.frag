@@ -1,11 +1,10 @@
 #include "shader/util.glsl"
+#include "shader/camera.glsl"
 
 uniform BindlessSampler2D colorBuffer;
 uniform BindlessSampler2D normalWaterBuffer;
 uniform BindlessSampler2D matBuffer;
 uniform vec2 pixelSize;
-uniform mat4 invViewProjMatrix;
-uniform vec3 eyePos;
 uniform vec2 uCamParam;
 uniform float udotl;
 
@@ -1,7 +1,6 @@
 #include "shader/util.glsl"
+#include "shader/camera.glsl"
 
-uniform mat4 viewMatrix;
-uniform vec3 eyePos;
 
 layout (location = 0) in vec3 vertex;
 layout (location = 1) in vec3 normal;
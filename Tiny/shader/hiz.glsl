@@ -1,3 +1,11 @@
+// Same for all cull shaders in a frame, filled once by RenderManager
+layout(std140, binding = 0) uniform HizBlock {
+	mat4 prevVPMatrix;
+	vec2 uSize;
+	vec2 uCamParam;
+	float uMaxLevel;
+};
+
 bool HizQuery(mat4 viewProjectMat, sampler2D depthTex, vec2 size, vec2 camParam, float maxLevel, 
 	vec4 bv0, vec4 bv1, vec4 bv2, vec4 bv3, vec4 bv4, vec4 bv5, vec4 bv6, vec4 bv7, float zOffset) {
 		vec4 b0 = viewProjectMat * bv0;
@@ -1,4 +1,5 @@
 #include "shader/util.glsl"
+#include "shader/camera.glsl"
 
 layout(binding = 1, std430) buffer InMaterial {
 	Material inMaterials[];
@@ -11,8 +12,6 @@ uniform vec3 viewRight;
 #endif
 
 #ifdef ShadowPass
-uniform mat4 projectMatrix, viewMatrix;
-uniform vec2 camPara;
 #endif
 
 layout (location = 0) in vec3 vertex;
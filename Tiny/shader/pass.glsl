@@ -0,0 +1,5 @@
+// Same for every pass in a frame, filled once by RenderManager
+layout(std140, binding = 1) uniform PassBlock {
+	vec4 mapInfo;
+	vec3 light;
+};
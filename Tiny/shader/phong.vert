@@ -1,11 +1,10 @@
 #include "shader/util.glsl"
+#include "shader/camera.glsl"
 
 uniform mat3x4 modelMatrices[100];
 uniform mat4 viewProjectMatrix;
 
 #ifdef ShadowPass
-uniform mat4 projectMatrix, viewMatrix;
-uniform vec2 camPara;
 #endif
 
 layout (location = 0) in vec3 vertex;
@@ -1,6 +1,6 @@
 #include "shader/util.glsl"
+#include "shader/camera.glsl"
 
-uniform mat4 invProjMatrix;
 uniform vec2 screenSize, pixelSize;
 uniform float time;
 layout(bindless_sampler) uniform sampler2D colorBuffer, normalGrassBuffer, depthBuffer;
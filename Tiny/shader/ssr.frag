@@ -1,12 +1,11 @@
 #include "shader/util.glsl"
+#include "shader/camera.glsl"
 
 uniform BindlessSampler2D lightBuffer, 
 						matBuffer, 
 						normalBuffer, 
 						depthBuffer;
 
-uniform mat4 viewMatrix;
-uniform mat4 projectMatrix, invProjMatrix;
 uniform vec2 screenSize, pixelSize;
 
 in vec2 vTexcoord;
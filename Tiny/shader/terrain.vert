@@ -1,4 +1,5 @@
 #include "shader/util.glsl"
+#include "shader/pass.glsl"
 
 #ifdef UseDebug
 layout(binding = 1, std430) buffer InMaterial {
@@ -8,7 +9,6 @@ layout(binding = 1, std430) buffer InMaterial {
 
 uniform mat4 viewProjectMatrix;
 uniform vec3 mapTrans, mapScale;
-uniform vec4 mapInfo;
 
 #ifdef UseDebug
 uniform int uDebugMid;
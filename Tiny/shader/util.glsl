@@ -235,8 +235,10 @@ bool CompMat(float flag, float base) {
 	return (flag > (base - 0.01) && flag < (base + 0.01));
 }
 
+// Rebuild z from xy, normal maps may be two channel bc5
 vec3 GetNormalFromMap(sampler2D tex, vec2 coord, mat3 tbn) {
-	return tbn * (2.0 * texture(tex, coord).rgb - 1.0);
+	vec2 xy = 2.0 * texture(tex, coord).rg - 1.0;
+	return tbn * vec3(xy, sqrt(max(1.0 - dot(xy, xy), 0.0)));
 }
 
 struct Material {
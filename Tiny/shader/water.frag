@@ -1,13 +1,12 @@
 #include "shader/util.glsl"
+#include "shader/camera.glsl"
 
 layout(early_fragment_tests) in;
 
 uniform BindlessSamplerCube texEnv, texSky;
 uniform BindlessSampler2D texRef;
 
-uniform mat4 viewMatrix;
 uniform vec2 waterBias;
-uniform vec3 light;
 uniform float udotl;
 
 in vec3 vNormal;
@@ -1,8 +1,8 @@
 #include "shader/util.glsl"
+#include "shader/camera.glsl"
 
 uniform mat4 viewProjectMatrix;
 uniform float time;
-uniform vec3 eyePos;
 
 layout (location = 0) in vec3 vertex;
 
@@ -1,6 +1,8 @@
 #include "application.h"
 #include "../constants/constants.h"
 #include "../util/util.h"
+#include "../physics/shapeCache.h"
+#include "../util/profiler.h"
 
 Application::Application() {
 	config = new Config("config/config.txt");
@@ -13,6 +15,8 @@ Application::Application() {
 	config->getBool("vsync", cfgs->vsync);
 	config->getBool("dualthread", cfgs->dualthread);
 	config->getBool("dualqueue", cfgs->dualqueue);
+	config->getBool("physthread", cfgs->physthread);
+	config->getBool("physterrain", cfgs->physterrain);
 	config->getInt("smoothframe", cfgs->smoothframe);
 	config->getInt("quality", cfgs->graphQuality);
 	config->getInt("shadow", cfgs->shadowQuality);
@@ -23,6 +27,13 @@ Application::Application() {
 	config->getBool("dynsky", cfgs->dynsky);
 	config->getBool("cartoon", cfgs->cartoon);
 	config->getBool("debug", cfgs->debug);
+	config->getInt("texbudget", cfgs->texbudget);
+	config->getBool("cpucull", cfgs->cpucull);
+	config->getBool("occlusion", cfgs->occlusion);
+	config->getInt("ringsize", cfgs->ringsize);
+	config->getBool("profile", cfgs->profile);
+	config->getBool("shadowcache", cfgs->shadowcache);
+	Profiler::SetEnabled(cfgs->profile);
 
 	windowWidth = cfgs->width;
 	windowHeight = cfgs->height;
@@ -42,9 +53,13 @@ void Application::init() {
 	printf("Init app\n");
 	render = new Render();
 	render->initShaders(cfgs);
+	render->initUploadRing(cfgs);
+	render->initGpuTimer(cfgs);
 	AssetManager::Init();
 	MaterialManager::Init();
+	ShapeCache::Init();
 	scene = new Scene();
+	scene->setPhysicTerrain(cfgs->physterrain);
 	input = new Input();
 
 	float lowDist = cfgs->graphQuality > 4 ? 600 : 200;
@@ -59,16 +74,24 @@ void Application::init() {
 
 void Application::initScene() {
 	scene->finishInit();
+	if (cfgs->physthread)
+		scene->collisionWorld->startThread();
 	printf("Scene inited!\n");
 }
 
 Application::~Application() {
+	if (scene) scene->collisionWorld->stopThread(); // Terrain collision uses height data in assets
 	MaterialManager::Release();
 	AssetManager::Release();
 	delete scene; scene = NULL;
+	ShapeCache::Release(); // After scene, collision objects use shared shapes
 	delete render; render = NULL;
 	delete input; input = NULL;
 	delete renderMgr; renderMgr = NULL;
+	if (cfgs->profile) {
+		Profiler::ExportChromeTrace(PROFILE_TRACE_PATH);
+		Profiler::Release();
+	}
 	delete config;
 	free(cfgs);
 }
@@ -108,8 +131,12 @@ void Application::prepare() {
 	renderMgr->prepareData(scene);
 }
 
-void Application::swapData(bool swapQueue) {
-	renderMgr->swapRenderQueues(scene, swapQueue); // Caculate cull result
+bool Application::swapData(bool swapQueue) {
+	return renderMgr->swapRenderQueues(scene, swapQueue); // Caculate cull result
+}
+
+void Application::publishData() {
+	renderMgr->publishRenderQueues(scene);
 }
 
 void Application::animate(float velocity) {
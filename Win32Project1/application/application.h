@@ -37,7 +37,8 @@ public:
 	virtual void mouseKey(bool press, bool isMain);
 	void updateData();
 	void prepare();
-	void swapData(bool swapQueue);
+	bool swapData(bool swapQueue);
+	void publishData();
 	void animate(float velocity);
 	virtual void resize(int width, int height);
 	virtual void keyDown(int key);
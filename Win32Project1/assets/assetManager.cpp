@@ -52,8 +52,8 @@ AssetManager::~AssetManager() {
 	if (noise3DTexture) delete noise3DTexture; noise3DTexture = NULL;
 }
 
-void AssetManager::addTextureBindless(const char* name, bool srgb, int wrap) {
-	texBld->addTexture(string(name), srgb, wrap);
+void AssetManager::addTextureBindless(const char* name, bool srgb, int wrap, int usage) {
+	texBld->addTexture(string(name), srgb, wrap, usage);
 }
 
 void AssetManager::initTextureBindless(MaterialManager* mtls) {
@@ -67,6 +67,7 @@ void AssetManager::initTextureBindless(MaterialManager* mtls) {
 		if (mat->tex2.length() > 0) {
 			if (texBld->findTexture(mat->tex2) < 0) texBld->addTexture(mat->tex2, mat->srgb2);
 			mat->texids.y = texBld->findTexture(mat->tex2);
+			if (!mat->srgb2) texBld->setUsage(mat->texids.y, USAGE_NORMAL); // Normal slot
 		}
 		if (mat->tex3.length() > 0) {
 			if (texBld->findTexture(mat->tex3) < 0) texBld->addTexture(mat->tex3, mat->srgb3);
@@ -76,6 +77,11 @@ void AssetManager::initTextureBindless(MaterialManager* mtls) {
 			if (texBld->findTexture(mat->tex4) < 0) texBld->addTexture(mat->tex4, mat->srgb4);
 			mat->texids.w = texBld->findTexture(mat->tex4);
 		}
+		// Material textures follow screen usage, others stay full
+		texBld->setStreamed((int)mat->texids.x);
+		texBld->setStreamed((int)mat->texids.y);
+		texBld->setStreamed((int)mat->texids.z);
+		texBld->setStreamed((int)mat->texids.w);
 		printf("mat %s: [%d]%s\n", mat->name.data(), (int)mat->texids.x, mat->tex1.data());
 	}
 	texBld->initData(COMMON_TEXTURE);
@@ -39,7 +39,7 @@ public:
 	Animation* exportAnimation(const char* name, Animation* animation);
 	void addAnimationData(const char* name, const char* path, Animation* animation);
 	void initFrames();
-	void addTextureBindless(const char* name, bool srgb, int wrap = WRAP_REPEAT);
+	void addTextureBindless(const char* name, bool srgb, int wrap = WRAP_REPEAT, int usage = USAGE_AUTO);
 	void initTextureBindless(MaterialManager* mtls);
 	int findTextureBindless(const char* name);
 	void setSkyTexture(CubeMap* tex);
@@ -52,6 +52,7 @@ public:
 	void moveTo(const vec3& pos);
 	float getHeight();
 	void copy(Camera* src);
+	const mat4& getBoundMatrix() { return boundMat; }
 };
 
 
@@ -42,14 +42,17 @@ bool Filter::bindTex(int slot, const Texture2D* tex, Shader* shader) {
 
 void Filter::draw(Camera* camera, Render* render, RenderState* state,
 		Texture2D* inputTexture, const Texture2D* depthTexture) {
+	static int pixelSizeId = Shader::GetUniformId("pixelSize");
+	static int qualityId = Shader::GetUniformId("quality");
+	static int shadowPixSizeId = Shader::GetUniformId("shadowPixSize");
 	Shader* shader = state->shader;
 	render->setFrameBuffer(framebuffer);
-	render->setShaderVec2(shader, "pixelSize", pixWidth, pixHeight);
-	render->setShaderFloat(shader, "quality", state->quality);
+	render->setShaderVec2(shader, pixelSizeId, pixWidth, pixHeight);
+	render->setShaderFloat(shader, qualityId, state->quality);
 
 	if (state->shadow) {
 		float shadowPixSize = state->shadow->shadowPixSize;
-		render->setShaderVec2(shader, "shadowPixSize", shadowPixSize, shadowPixSize);
+		render->setShaderVec2(shader, shadowPixSizeId, shadowPixSize, shadowPixSize);
 	}
 	uint bufferid = 0;
 	bindTex(bufferid, inputTexture, shader);
@@ -61,16 +64,19 @@ void Filter::draw(Camera* camera, Render* render, RenderState* state,
 
 void Filter::draw(Camera* camera, Render* render, RenderState* state,
 		const std::vector<Texture2D*>& inputTextures, const Texture2D* depthTexture) {
+	static int pixelSizeId = Shader::GetUniformId("pixelSize");
+	static int qualityId = Shader::GetUniformId("quality");
+	static int shadowPixSizeId = Shader::GetUniformId("shadowPixSize");
 	isDebug = render->getDebug();
 
 	Shader* shader = state->shader;
 	render->setFrameBuffer(framebuffer);
-	render->setShaderVec2(shader, "pixelSize", pixWidth, pixHeight);
-	render->setShaderFloat(shader, "quality", state->quality);
+	render->setShaderVec2(shader, pixelSizeId, pixWidth, pixHeight);
+	render->setShaderFloat(shader, qualityId, state->quality);
 
 	if (state->shadow) {
 		float shadowPixSize = state->shadow->shadowPixSize;
-		render->setShaderVec2(shader, "shadowPixSize", shadowPixSize, shadowPixSize);
+		render->setShaderVec2(shader, shadowPixSizeId, shadowPixSize, shadowPixSize);
 	}
 	uint bufferid;
 	for (bufferid = 0; bufferid < inputTextures.size(); bufferid++)
@@ -90,29 +90,24 @@ CubeMap* FrameBuffer::getCubeBuffer() {
 	return cubeBuffer;
 }
 
-void FrameBuffer::use() {
-	glBindFramebuffer(GL_FRAMEBUFFER, fboId);
-	GLbitfield clearMask = GL_COLOR_BUFFER_BIT;
-	if (depthOnly)
-		clearMask = GL_DEPTH_BUFFER_BIT;
-	else if (depthBuffer)
-		clearMask |= GL_DEPTH_BUFFER_BIT;
-	glClear(clearMask);
-	glViewport(0, 0, width, height);
+void FrameBuffer::use(StateTracker* states) {
+	states->bindFramebuffer(fboId);
+	states->clear(!depthOnly, depthOnly || depthBuffer, false);
+	states->setViewport(0, 0, (int)width, (int)height);
 }
 
-void FrameBuffer::useFbo() {
-	glBindFramebuffer(GL_FRAMEBUFFER, fboId);
+void FrameBuffer::useFbo(StateTracker* states) {
+	states->bindFramebuffer(fboId);
 }
 
-void FrameBuffer::useCube(int i, int mip) {
+void FrameBuffer::useCube(StateTracker* states, int i, int mip) {
 	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
 		GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, cubeBuffer->id, mip);
-	glClear(GL_COLOR_BUFFER_BIT);
+	states->clear(true, false, false);
 	uint mipWidth = width, mipHeight = height;
 	if (mip > 0) {
 		mipWidth = width * std::pow(0.5, mip);
 		mipHeight = height * std::pow(0.5, mip);
 	}
-	glViewport(0, 0, mipWidth, mipHeight);
+	states->setViewport(0, 0, mipWidth, mipHeight);
 }
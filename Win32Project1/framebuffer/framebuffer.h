@@ -11,6 +11,7 @@
 #include "../render/glheader.h"
 #include "../texture/texture2d.h"
 #include "../texture/cubemap.h"
+#include "../render/stateTracker.h"
 #include <vector>
 
 const GLenum ColorAttachments[] = { GL_COLOR_ATTACHMENT0_EXT, GL_COLOR_ATTACHMENT1_EXT , GL_COLOR_ATTACHMENT2_EXT,
@@ -36,14 +37,14 @@ public:
 	void attachDepthBuffer(int precision, bool useMip);
 	Texture2D* getColorBuffer(int n);
 	Texture2D* getDepthBuffer();
-	void use();
+	void use(StateTracker* states);
 private:
 	CubeMap* cubeBuffer;
 public:
 	FrameBuffer(const CubeMap* cube);
 	CubeMap* getCubeBuffer();
-	void useFbo();
-	void useCube(int i, int mip);
+	void useFbo(StateTracker* states);
+	void useCube(StateTracker* states, int i, int mip);
 };
 
 
@@ -60,6 +60,7 @@ Ibl::~Ibl() {
 }
 
 void Ibl::genIrradiance(Render* render, Shader* shader) {
+	static int viewProjectId = Shader::GetUniformId("viewProjectMatrix");
 	if (!irradianceBuff) return;
 	state->delay = 0;
 	state->cullMode = CULL_FRONT;
@@ -68,31 +69,33 @@ void Ibl::genIrradiance(Render* render, Shader* shader) {
 	render->useFrameBuffer(irradianceBuff);
 
 	render->useFrameCube(0, 0);
-	render->setShaderMat4(shader, "viewProjectMatrix", matPosx);
+	render->setShaderMat4(shader, viewProjectId, matPosx);
 	render->draw(NULL, cubeNode->drawcall, state);
 
 	render->useFrameCube(1, 0);
-	render->setShaderMat4(shader, "viewProjectMatrix", matNegx);
+	render->setShaderMat4(shader, viewProjectId, matNegx);
 	render->draw(NULL, cubeNode->drawcall, state);
 
 	render->useFrameCube(2, 0);
-	render->setShaderMat4(shader, "viewProjectMatrix", matPosy);
+	render->setShaderMat4(shader, viewProjectId, matPosy);
 	render->draw(NULL, cubeNode->drawcall, state);
 
 	render->useFrameCube(3, 0);
-	render->setShaderMat4(shader, "viewProjectMatrix", matNegy);
+	render->setShaderMat4(shader, viewProjectId, matNegy);
 	render->draw(NULL, cubeNode->drawcall, state);
 
 	render->useFrameCube(4, 0);
-	render->setShaderMat4(shader, "viewProjectMatrix", matPosz);
+	render->setShaderMat4(shader, viewProjectId, matPosz);
 	render->draw(NULL, cubeNode->drawcall, state);
 
 	render->useFrameCube(5, 0);
-	render->setShaderMat4(shader, "viewProjectMatrix", matNegz);
+	render->setShaderMat4(shader, viewProjectId, matNegz);
 	render->draw(NULL, cubeNode->drawcall, state);
 }
 
 void Ibl::genPrefiltered(Render* render, Shader* shader) {
+	static int viewProjectId = Shader::GetUniformId("viewProjectMatrix");
+	static int roughnessId = Shader::GetUniformId("uRoughness");
 	if (!prefilteredBuff) return;
 	state->delay = 0;
 	state->cullMode = CULL_FRONT;
@@ -106,33 +109,33 @@ void Ibl::genPrefiltered(Render* render, Shader* shader) {
 		float roughness = (float)mip / (float)(maxMipLevels - 1);
 
 		render->useFrameCube(0, mip);
-		render->setShaderMat4(shader, "viewProjectMatrix", matPosx);
-		render->setShaderFloat(shader, "uRoughness", roughness);
+		render->setShaderMat4(shader, viewProjectId, matPosx);
+		render->setShaderFloat(shader, roughnessId, roughness);
 		render->draw(NULL, cubeNode->drawcall, state);
 
 		render->useFrameCube(1, mip);
-		render->setShaderMat4(shader, "viewProjectMatrix", matNegx);
-		render->setShaderFloat(shader, "uRoughness", roughness);
+		render->setShaderMat4(shader, viewProjectId, matNegx);
+		render->setShaderFloat(shader, roughnessId, roughness);
 		render->draw(NULL, cubeNode->drawcall, state);
 
 		render->useFrameCube(2, mip);
-		render->setShaderMat4(shader, "viewProjectMatrix", matPosy);
-		render->setShaderFloat(shader, "uRoughness", roughness);
+		render->setShaderMat4(shader, viewProjectId, matPosy);
+		render->setShaderFloat(shader, roughnessId, roughness);
 		render->draw(NULL, cubeNode->drawcall, state);
 
 		render->useFrameCube(3, mip);
-		render->setShaderMat4(shader, "viewProjectMatrix", matNegy);
-		render->setShaderFloat(shader, "uRoughness", roughness);
+		render->setShaderMat4(shader, viewProjectId, matNegy);
+		render->setShaderFloat(shader, roughnessId, roughness);
 		render->draw(NULL, cubeNode->drawcall, state);
 
 		render->useFrameCube(4, mip);
-		render->setShaderMat4(shader, "viewProjectMatrix", matPosz);
-		render->setShaderFloat(shader, "uRoughness", roughness);
+		render->setShaderMat4(shader, viewProjectId, matPosz);
+		render->setShaderFloat(shader, roughnessId, roughness);
 		render->draw(NULL, cubeNode->drawcall, state);
 
 		render->useFrameCube(5, mip);
-		render->setShaderMat4(shader, "viewProjectMatrix", matNegz);
-		render->setShaderFloat(shader, "uRoughness", roughness);
+		render->setShaderMat4(shader, viewProjectId, matNegz);
+		render->setShaderFloat(shader, roughnessId, roughness);
 		render->draw(NULL, cubeNode->drawcall, state);
 	}
 }
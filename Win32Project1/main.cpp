@@ -1,6 +1,7 @@
 #include <windows.h>
 #include <windowsx.h>
 #include "simpleApplication.h"
+#include "util/profiler.h"
 
 typedef void (APIENTRY *PFNWGLEXTSWAPCONTROLPROC) (int);
 PFNWGLEXTSWAPCONTROLPROC wglSwapIntervalEXT = NULL;
@@ -17,12 +18,8 @@ bool threadEnd;
 DWORD WINAPI FrameThreadRun(LPVOID param);
 void CreateThreads();
 void ReleaseThreads();
-HANDLE mutex = NULL;
-void InitMutex();
-void DeleteMutex();
 DWORD currentTime = 0, lastTime = 0, startTime = 0;
 float dTime = 0.0;
-bool dataPrepared = false;
 CirQueue<float>* dTimes = NULL;
 float velocity = 0.0;
 DWORD screenLeft, screenTop;
@@ -52,7 +49,6 @@ void SwitchMouse() {
 
 void KillWindow() {
 	if (dTimes) delete dTimes;
-	DeleteMutex();
 	ReleaseThreads();
 	ReleaseApplication();
 	ShowCursor(true);
@@ -100,24 +96,15 @@ void ActRun() {
 }
 
 bool DrawWindow() {
+	PROFILE_SCOPE("frame");
 	if (!app->cfgs->dualthread) {
 		TimeRun();
 		ActRun();
 		app->updateData();
 		app->prepare();
 		app->swapData(false);
-	} else {
-		if (dataPrepared) {
-			WaitForSingleObject(mutex, INFINITE);
-			{
-				app->swapData(true);
-				dataPrepared = false;
-			}
-			ReleaseMutex(mutex);
-			//TimeRun();
-		}
-		else return false;
-	}
+	} else if (!app->swapData(true)) 
+		return false; // Nothing newer than last drawn frame
 
 	if (windowResized) windowResized = false;
 	app->draw();
@@ -127,19 +114,15 @@ bool DrawWindow() {
 }
 
 DWORD WINAPI FrameThreadRun(LPVOID param) {
+	Profiler::SetThreadName("update");
 	while (!app->willExit && app->cfgs->dualthread) {
 		if (!inited) continue;
-		//if (!dataPrepared) {
-			WaitForSingleObject(mutex, INFINITE);
-			{
-				TimeRun();
-				ActRun();
-				app->updateData();
-				app->prepare();
-				dataPrepared = true;
-			}
-			ReleaseMutex(mutex);
-		//}
+		PROFILE_SCOPE("update frame");
+		TimeRun();
+		ActRun();
+		app->updateData();
+		app->prepare();
+		app->publishData();
 	}
 	threadEnd = true;
 	return 1;
@@ -175,7 +158,6 @@ void InitGL() {
 	if (wglSwapIntervalEXT) 
 		wglSwapIntervalEXT(app->cfgs->vsync ? 1 : 0);
 	dTimes = new CirQueue<float>(app->cfgs->smoothframe);
-	InitMutex();
 	CreateThreads();
 	inited = true;
 }
@@ -189,17 +171,9 @@ void ReleaseThreads() {
 	CloseHandle(frameThread);
 }
 
-void InitMutex() {
-	mutex = CreateMutex(NULL, FALSE, NULL);
-}
-
-void DeleteMutex() {
-	ReleaseMutex(mutex);
-	CloseHandle(mutex);
-}
-
 void CreateApplication() {
 	app = new SimpleApplication();
+	Profiler::SetThreadName("render");
 	fullscreen = app->cfgs->fullscreen;
 	startTime = timeGetTime();
 	currentTime = startTime;
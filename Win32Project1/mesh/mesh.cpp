@@ -68,6 +68,17 @@ void Mesh::caculateExData() {
 		normals4[i] = vec4(normals[i].x, normals[i].y, normals[i].z, 0.0);
 	}
 
+	materialList.clear();
+	if (materialids) {
+		for (int i = 0; i < vertexCount; i++) {
+			if (i > 0 && materialids[i] == materialids[i - 1]) continue;
+			bool found = false;
+			for (uint m = 0; m < materialList.size() && !found; m++)
+				found = materialList[m] == materialids[i];
+			if (!found) materialList.push_back(materialids[i]);
+		}
+	}
+
 	caculateBounding();
 }
 
@@ -39,6 +39,7 @@ public:
 	float* bounding;
 	std::vector<FaceBuf*> singleFaces;
 	std::vector<FaceBuf*> normalFaces;
+	std::vector<int> materialList; // Distinct materials used by vertices
 public:
 	Mesh();
 	Mesh(const Mesh& rhs);
@@ -127,11 +127,6 @@ Object* Node::removeObject(Scene* scene, Object* object) {
 
 			scene->collisionWorld->removeObject(object->collisionObject);
 			object->removeCollisionObject();
-			if (object->mesh) {
-				StaticObject* staticObj = (StaticObject*)object;
-				if (staticObj->isDynamic())
-					scene->removeDynamicObject(staticObj);
-			}
 			return object;
 		}
 	}
@@ -245,7 +240,7 @@ void Node::attachChild(Scene* scene, Node* child) {
 	updateSelfAndDownwardNodesDrawcall(scene, false);
 }
 
-Node* Node::detachChild(Node* child) {
+Node* Node::detachChild(Scene* scene, Node* child) {
 	std::vector<Node*>::iterator it;
 	for(it=children.begin();it!=children.end();++it) {
 		if((*it)==child) {
@@ -257,6 +252,7 @@ Node* Node::detachChild(Node* child) {
 				superior->updateBounding();
 				superior = superior->parent;
 			}
+			scene->nodesVersion++; // Cached shadow casters may be under child
 
 			if (child->type == TYPE_INSTANCE) {
 				for (uint i = 0; i < child->objects.size(); i++) {
@@ -33,6 +33,7 @@ private:
 	void moveBaseObjectsBounding(float dx,float dy,float dz);
 	void moveSelfAndDownwardNodesBounding(float dx,float dy,float dz);
 	void updateSelfAndDownwardNodesDrawcall(Scene* scene, bool updateNormal);
+public:
 	void recursiveTransform(mat4& finalNodeMatrix);
 public:
 	vec3 position; // Local position
@@ -69,7 +70,7 @@ public:
 	virtual void addObject(Scene* scene, Object* object);
 	virtual Object* removeObject(Scene* scene, Object* object);
 	void attachChild(Scene* scene, Node* child);
-	Node* detachChild(Node* child);
+	Node* detachChild(Scene* scene, Node* child);
 	virtual void translateNode(Scene* scene, float x, float y, float z);
 	void translateNodeObject(Scene* scene, int i, float x, float y, float z);
 	void translateNodeObjectCenterAtWorld(Scene* scene, int i, float x, float y, float z);
@@ -2,6 +2,7 @@
 #include <stdlib.h>
 #include "../node/node.h"
 #include "../constants/constants.h"
+#include "../physics/shapeCache.h"
 
 Object::Object() {
 	parent = NULL;
@@ -33,6 +34,7 @@ Object::Object() {
 
 	shapeOffset = vec3(0.0);
 	collisionShape = NULL;
+	sharedShape = false;
 	collisionObject = NULL;
 	mass = 0;
 	dynamic = false;
@@ -55,6 +57,7 @@ Object::Object(const Object& rhs) {
 
 	shapeOffset = rhs.shapeOffset;
 	collisionShape = NULL;
+	sharedShape = false;
 	collisionObject = NULL;
 	mass = rhs.mass;
 	dynamic = rhs.dynamic;
@@ -76,7 +79,7 @@ Object::~Object() {
 	if (transforms) free(transforms); transforms = NULL;
 	if (transformsFull) free(transformsFull); transformsFull = NULL;
 	
-	if (collisionShape) delete collisionShape;
+	if (collisionShape && !sharedShape) delete collisionShape;
 
 	std::map<std::string, SoundObject*>::iterator it;
 	for (it = sounds.begin(); it != sounds.end(); ++it)
@@ -101,31 +104,22 @@ void Object::initMatricesData() {
 
 void Object::caculateLocalAABB(bool looseWidth, bool looseAll) {
 	if (!mesh) return; // caculate AABB by yourself
-	int vertexCount = mesh->vertexCount;
-	if (vertexCount <= 0) return;
-	vec4* vertices = mesh->vertices;
+	if (mesh->vertexCount <= 0) return;
+
+	// Transform cached mesh extent instead of scanning all vertices
+	MeshExtent* extent = ShapeCache::shapeCache->getExtent(mesh);
 	mat4 localRotateMatrix = GetRotateAndScale(localTransformMatrix);
-	vec4 first4 = localRotateMatrix * vertices[0];
-	float firstInvw = 1.0 / first4.w;
-	float sx = first4.x * firstInvw;
-	float sy = first4.y * firstInvw;
-	float sz = first4.z * firstInvw;
-	float lx = sx;
-	float ly = sy;
-	float lz = sz;
-	for (int i = 1; i < vertexCount; i++) {
-		vec4 vertex4 = vertices[i];
-		vec4 local4 = localRotateMatrix * vertex4;
-		float invw = 1.0 / local4.w;
-		vec3 local3(local4.x * invw, local4.y * invw, local4.z * invw);
-		sx = sx > local3.x ? local3.x : sx;
-		sy = sy > local3.y ? local3.y : sy;
-		sz = sz > local3.z ? local3.z : sz;
-		lx = lx < local3.x ? local3.x : lx;
-		ly = ly < local3.y ? local3.y : ly;
-		lz = lz < local3.z ? local3.z : lz;
-	}
-	vec3 minVertex(sx, sy, sz), maxVertex(lx, ly, lz);
+	vec3 center = (extent->minVertex + extent->maxVertex) * 0.5;
+	vec3 half = (extent->maxVertex - extent->minVertex) * 0.5;
+	vec4 center4 = localRotateMatrix * vec4(center, 1.0);
+	vec4 ex = localRotateMatrix * vec4(half.x, 0.0, 0.0, 0.0);
+	vec4 ey = localRotateMatrix * vec4(0.0, half.y, 0.0, 0.0);
+	vec4 ez = localRotateMatrix * vec4(0.0, 0.0, half.z, 0.0);
+	vec3 localCenter(center4.x / center4.w, center4.y / center4.w, center4.z / center4.w);
+	vec3 localHalf(fabsf(ex.x) + fabsf(ey.x) + fabsf(ez.x),
+		fabsf(ex.y) + fabsf(ey.y) + fabsf(ez.y),
+		fabsf(ex.z) + fabsf(ey.z) + fabsf(ez.z));
+	vec3 minVertex = localCenter - localHalf, maxVertex = localCenter + localHalf;
 	if (!bounding) bounding = new AABB(minVertex, maxVertex);
 	else ((AABB*)bounding)->update(minVertex, maxVertex);
 
@@ -148,48 +142,29 @@ void Object::caculateLocalAABB(bool looseWidth, bool looseAll) {
 }
 
 void Object::caculateCollisionShape() {
-	if (collisionShape) delete collisionShape;
+	if (collisionShape && !sharedShape) delete collisionShape;
 	if (!mesh) { // Animation object use node bounding box
 		vec3 halfSize = ((AABB*)parent->boundingBox)->halfSize;
 		collisionShape = new CollisionShape(halfSize);
+		sharedShape = false;
 	} else {
-		float sx = MAX_VAL; float sy = MAX_VAL; float sz = MAX_VAL;
-		float lx = MIN_VAL; float ly = MIN_VAL; float lz = MIN_VAL;
-		for (uint n = 0; n < mesh->normalFaces.size(); ++n) {
-			FaceBuf* buf = mesh->normalFaces[n];
-			for (int i = 0; i < buf->count; ++i) {
-				int index = mesh->indices[buf->start + i];
-
-				vec4 vertex = mesh->vertices[index];
-				vertex = scale(size.x, size.y, size.z) * vertex;
-				float invw = 1.0 / vertex.w;
-				vertex.x *= invw;
-				vertex.y *= invw;
-				vertex.z *= invw;
-				
-				sx = sx > vertex.x ? vertex.x : sx;
-				sy = sy > vertex.y ? vertex.y : sy;
-				sz = sz > vertex.z ? vertex.z : sz;
-				lx = lx < vertex.x ? vertex.x : lx;
-				ly = ly < vertex.y ? vertex.y : ly;
-				lz = lz < vertex.z ? vertex.z : lz;
-			}
-		}
-		vec3 halfSize = vec3(lx - sx, ly - sy, lz - sz) * 0.5;
-		halfSize *= mesh->getBoundScale();
-		collisionShape = new CollisionShape(halfSize);
+		collisionShape = ShapeCache::shapeCache->getBoxShape(mesh, size);
+		sharedShape = true;
 	}
 }
 
 CollisionObject* Object::initCollisionObject() {
-	if (!collisionObject)
-		collisionObject = new CollisionObject(collisionShape->shape, mass);
-	else {
+	if (!collisionObject) {
+		if (mass > 0 || !mesh)
+			collisionObject = new CollisionObject(collisionShape->shape, mass);
+		else // Static prop merged into static cell by collision world
+			collisionObject = new CollisionObject(collisionShape->shape);
+	} else {
 		collisionObject->setCollisionShape(collisionShape->shape);
 		collisionObject->setMass(mass);
 	}
-	collisionObject->object->setUserPointer(this);
-	if (mass > 0) 
+	collisionObject->setUserPointer(this);
+	if (mass > 0 && collisionObject->object) 
 		collisionObject->object->setActivationState(DISABLE_DEACTIVATION);
 	return collisionObject;
 }
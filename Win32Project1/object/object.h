@@ -41,6 +41,7 @@ public:
 	int detailLevel;
 	vec3 shapeOffset;
 	CollisionShape* collisionShape;
+	bool sharedShape; // Shape owned by shape cache
 	CollisionObject* collisionObject;
 	float mass;
 	bool dynamic;
@@ -123,16 +123,14 @@ void StaticObject::standOnGround(Scene* scene) {
 
 	translateAtWorld(worldCenter);
 	collisionObject->initTranslate(worldCenter);
+	updateParentBounding();
+}
 
-	// Update object's aabb
+// Update object's aabb in parent node
+void StaticObject::updateParentBounding() {
 	localBoundPosition = boundCenter + GetTranslate(localTransformMatrix);
 	parent->updateObjectBoundingInNode(this, true);
-	parent->boundingBox->merge(parent->objectsBBs);
-	Node* superior = parent->parent;
-	while (superior) {
-		superior->updateBounding();
-		superior = superior->parent;
-	}
+	parent->boundingBox->merge(parent->objectsBBs); // Ancestors refit later by scene
 }
 
 
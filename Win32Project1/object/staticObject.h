@@ -27,7 +27,8 @@ public:
 	virtual void setSize(float sx, float sy, float sz);
 	void translateAtWorld(const vec3& position);
 	void rotateAtWorld(const vec4& q);
-	void standOnGround(Scene* scene);
+	void standOnGround(Scene* scene);
+	void updateParentBounding();
 	void setDynamic(bool dyn) { dynamic = dyn; if (dynamic) setMass(100.0); }
 };
 
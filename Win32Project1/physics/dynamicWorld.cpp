@@ -1,7 +1,30 @@
 #include "dynamicWorld.h"
+#include "../util/profiler.h"
+#include <chrono>
+
+static void EraseObject(std::vector<CollisionObject*>& list, CollisionObject* cob) {
+	std::vector<CollisionObject*>::iterator it = list.begin();
+	for (; it != list.end(); ++it) {
+		if (*it == cob) {
+			list.erase(it);
+			return;
+		}
+	}
+}
+
+static double CurrentSeconds() {
+	using namespace std::chrono;
+	return duration_cast<duration<double> >(steady_clock::now().time_since_epoch()).count();
+}
 
 DynamicWorld::DynamicWorld() {
 	objects.clear();
+	stepThread = NULL;
+	running = false;
+	fixedStep = 0.0083334f;
+	lastStepTime = 0.0;
+	stepChanges.clear();
+	lastChanges.clear();
 	broadphase = new btDbvtBroadphase();
 	collisionConfiguration = new btDefaultCollisionConfiguration();
 	dispatcher = new btCollisionDispatcher(collisionConfiguration);
@@ -9,9 +32,13 @@ DynamicWorld::DynamicWorld() {
 	dynamicsWorld = new btDiscreteDynamicsWorld(dispatcher, broadphase, solver, collisionConfiguration);
 	dynamicsWorld->setGravity(btVector3(0.0, -10.0, 0.0));
 	dynamicsWorld->setForceUpdateAllAabbs(true);
+	terrainShape = NULL;
+	terrainBody = NULL;
 }
 
 DynamicWorld::~DynamicWorld() {
+	stopThread();
+	removeTerrain();
 	for (int i = dynamicsWorld->getNumCollisionObjects() - 1; i >= 0; i--)
 		dynamicsWorld->removeCollisionObject(dynamicsWorld->getCollisionObjectArray()[i]);
 	delete dynamicsWorld;
@@ -20,27 +47,308 @@ DynamicWorld::~DynamicWorld() {
 	delete collisionConfiguration;
 	delete broadphase;
 
-	std::list<CollisionObject*>::iterator it = objects.begin();
-	while (it != objects.end()) {
-		delete *it;
-		++it;
-	}
+	for (uint i = 0; i < objects.size(); ++i)
+		delete objects[i];
 	objects.clear();
+
+	std::map<i64, StaticCell*>::iterator it = staticCells.begin();
+	for (; it != staticCells.end(); ++it)
+		delete it->second;
+	staticCells.clear();
 }
 
 void DynamicWorld::addObject(CollisionObject* cob) {
-	if (cob->object->getUserIndex() >= 0) return;
-	cob->object->setUserIndex(objects.size());
-	dynamicsWorld->addRigidBody(cob->object);
+	if (cob->worldIndex >= 0) return;
+	std::lock_guard<std::mutex> guard(stepLock);
+	cob->worldIndex = objects.size();
 	objects.push_back(cob);
+	if (!cob->object) {
+		cob->applyPending();
+		addStaticObject(cob);
+		std::lock_guard<std::mutex> syncGuard(sync.lock);
+		cob->sync = &sync;
+		return;
+	}
+
+	cob->object->setUserIndex(cob->worldIndex);
+	dynamicsWorld->addRigidBody(cob->object);
+	((ChangeMotionState*)cob->motion)->changes = &stepChanges;
+
+	std::lock_guard<std::mutex> syncGuard(sync.lock);
+	cob->applyPending();
+	cob->publishPose(true);
+	cob->sync = &sync;
 }
 
 void DynamicWorld::removeObject(CollisionObject* cob) {
-	dynamicsWorld->removeRigidBody(cob->object);
-	objects.remove(cob);
+	if (!cob) return;
+	std::lock_guard<std::mutex> guard(stepLock);
+	if (cob->worldIndex >= 0) {
+		// Swap with last one, no list search
+		CollisionObject* last = objects.back();
+		objects[cob->worldIndex] = last;
+		last->worldIndex = cob->worldIndex;
+		if (last->object) last->object->setUserIndex(last->worldIndex);
+		objects.pop_back();
+	}
+
+	if (!cob->object) 
+		removeStaticObject(cob);
+	else {
+		dynamicsWorld->removeRigidBody(cob->object);
+		if (cob->isMoved) EraseObject(stepChanges, cob);
+		EraseObject(lastChanges, cob);
+	}
+	sync.lock.lock();
+	if (cob->isDirty) EraseObject(sync.dirtyObjects, cob);
+	if (cob->needRecell) EraseObject(sync.recellObjects, cob);
+	if (cob->isChanged) EraseObject(sync.changedObjects, cob);
+	sync.lock.unlock();
 	delete cob;
 }
 
+// Merge static prop into compound body of its cell, called with step lock
+void DynamicWorld::addStaticObject(CollisionObject* cob) {
+	i64 key = StaticCellKey(cob->staticTrans.getOrigin());
+
+	StaticCell* cell = NULL;
+	std::map<i64, StaticCell*>::iterator it = staticCells.find(key);
+	if (it != staticCells.end()) 
+		cell = it->second;
+	else {
+		cell = new StaticCell(key);
+		staticCells[key] = cell;
+		dynamicsWorld->addRigidBody(cell->body);
+	}
+
+	cob->cell = cell;
+	cob->childIndex = cell->children.size();
+	cell->shape->addChildShape(cob->staticTrans, cob->staticShape);
+	cell->children.push_back(cob);
+	cell->needRefit = true;
+}
+
+// Compound removes child by swapping with last one, keep our table the same
+void DynamicWorld::removeStaticObject(CollisionObject* cob) {
+	StaticCell* cell = cob->cell;
+	if (!cell) return;
+	int index = cob->childIndex;
+	cell->shape->removeChildShapeByIndex(index);
+	CollisionObject* last = cell->children.back();
+	cell->children[index] = last;
+	last->childIndex = index;
+	cell->children.pop_back();
+	cell->needRefit = true;
+	cob->cell = NULL;
+	cob->childIndex = -1;
+
+	// Empty cell leaves broadphase
+	if (cell->children.size() == 0) {
+		dynamicsWorld->removeRigidBody(cell->body);
+		staticCells.erase(cell->key);
+		delete cell;
+	}
+}
+
+// Move props whose new position falls in another cell, called with step lock
+void DynamicWorld::recellStaticObjects() {
+	std::vector<CollisionObject*> recells;
+	sync.lock.lock();
+	recells.swap(sync.recellObjects);
+	for (uint i = 0; i < recells.size(); ++i)
+		recells[i]->needRecell = false;
+	sync.lock.unlock();
+
+	for (uint i = 0; i < recells.size(); ++i) {
+		removeStaticObject(recells[i]);
+		addStaticObject(recells[i]);
+	}
+}
+
+// Recaculate cell bounding after its children changed, called with step lock
+void DynamicWorld::refitStaticCells() {
+	recellStaticObjects();
+	std::map<i64, StaticCell*>::iterator it = staticCells.begin();
+	for (; it != staticCells.end(); ++it) {
+		StaticCell* cell = it->second;
+		if (!cell->needRefit) continue;
+		cell->shape->recalculateLocalAabb();
+		dynamicsWorld->updateSingleAabb(cell->body);
+		cell->needRefit = false;
+	}
+}
+
+// Object of a contact, child index is needed for static props in cell compound
+void* DynamicWorld::queryUserPointer(const btCollisionObject* body, int childIndex) {
+	if (body == terrainBody) return NULL;
+	if (body->getCollisionShape()->isCompound() && body->getUserIndex() < 0) {
+		StaticCell* cell = (StaticCell*)body->getUserPointer();
+		if (childIndex < 0 || childIndex >= (int)cell->children.size()) return NULL;
+		return cell->children[childIndex]->staticUser;
+	}
+	return body->getUserPointer();
+}
+
+// Heightfield reads height samples in place, keep decimated copy alive with the world.
+// Quad edges flipped so triangles split along the same diagonal as terrain mesh
+void DynamicWorld::setTerrain(const unsigned char* heights, int width, int length, int step, const vec3& offset, const vec3& scale) {
+	removeTerrain();
+	std::lock_guard<std::mutex> guard(stepLock);
+	int countX = (width - 1) / step + 1, countZ = (length - 1) / step + 1;
+	terrainHeights.resize(countX * countZ);
+	for (int z = 0; z < countZ; z++) {
+		for (int x = 0; x < countX; x++)
+			terrainHeights[z * countX + x] = heights[z * step * width + x * step];
+	}
+	terrainShape = new btHeightfieldTerrainShape(countX, countZ, &terrainHeights[0], 1.0, 0.0, 255.0, 1, PHY_UCHAR, true);
+	vec3 gridScale = vec3(scale.x * step, scale.y, scale.z * step);
+	terrainShape->setLocalScaling(btVector3(gridScale.x, gridScale.y, gridScale.z));
+
+	// Heightfield shape is centered at its aabb center
+	btTransform trans; trans.setIdentity();
+	vec3 center = vec3((countX - 1) * 0.5, 255.0 * 0.5, (countZ - 1) * 0.5);
+	trans.setOrigin(btVector3(offset.x + center.x * gridScale.x, offset.y + center.y * gridScale.y, offset.z + center.z * gridScale.z));
+	btRigidBody::btRigidBodyConstructionInfo info(0.0, NULL, terrainShape);
+	info.m_startWorldTransform = trans;
+	terrainBody = new btRigidBody(info);
+	terrainBody->setUserIndex(-1);
+	terrainBody->setUserPointer(NULL);
+	dynamicsWorld->addRigidBody(terrainBody);
+}
+
+void DynamicWorld::removeTerrain() {
+	if (!terrainBody) return;
+	std::lock_guard<std::mutex> guard(stepLock);
+	dynamicsWorld->removeRigidBody(terrainBody);
+	delete terrainBody; terrainBody = NULL;
+	delete terrainShape; terrainShape = NULL;
+	terrainHeights.clear();
+}
+
 void DynamicWorld::act(float dtime) {
-	dynamicsWorld->stepSimulation(dtime, 10, 0.0083334f);
-}
\ No newline at end of file
+	PROFILE_SCOPE("DynamicWorld::act");
+	if (!running) {
+		refitStaticCells();
+		dynamicsWorld->stepSimulation(dtime, 10, fixedStep);
+		collectChanges(false);
+		return;
+	}
+
+	// Physics stepped by its own thread, only update interpolation factor
+	std::lock_guard<std::mutex> guard(sync.lock);
+	float alpha = (float)((CurrentSeconds() - lastStepTime) / fixedStep);
+	sync.alpha = alpha < 0.0 ? 0.0 : (alpha > 1.0 ? 1.0 : alpha);
+}
+
+void DynamicWorld::startThread() {
+	if (running) return;
+	stepLock.lock();
+	sync.lock.lock();
+	for (uint i = 0; i < objects.size(); ++i)
+		objects[i]->publishPose(true);
+	sync.threaded = true;
+	sync.alpha = 1.0;
+	lastStepTime = CurrentSeconds();
+	sync.lock.unlock();
+	stepLock.unlock();
+
+	running = true;
+	stepThread = new std::thread(&DynamicWorld::stepLoop, this);
+}
+
+void DynamicWorld::stopThread() {
+	if (!running) return;
+	running = false;
+	stepThread->join();
+	delete stepThread;
+	stepThread = NULL;
+
+	// Flush writes not applied by physics thread
+	sync.lock.lock();
+	for (uint i = 0; i < sync.dirtyObjects.size(); ++i)
+		sync.dirtyObjects[i]->applyPending();
+	sync.dirtyObjects.clear();
+	sync.threaded = false;
+	sync.lock.unlock();
+}
+
+void DynamicWorld::stepLoop() {
+	Profiler::SetThreadName("physics");
+	const int maxSteps = 10;
+	double accumulator = 0.0, last = CurrentSeconds();
+	while (running) {
+		double now = CurrentSeconds();
+		accumulator += now - last;
+		last = now;
+
+		int steps = 0;
+		while (accumulator >= fixedStep && steps < maxSteps) {
+			stepOnce();
+			accumulator -= fixedStep;
+			steps++;
+		}
+		// Drop time we can not catch up with
+		if (steps >= maxSteps) accumulator = 0.0;
+
+		double wait = fixedStep - accumulator;
+		if (wait > 0.0)
+			std::this_thread::sleep_for(std::chrono::microseconds((long long)(wait * 1000000.0)));
+	}
+}
+
+void DynamicWorld::stepOnce() {
+	PROFILE_SCOPE("physics step");
+	std::lock_guard<std::mutex> guard(stepLock);
+
+	// Apply game thread writes
+	sync.lock.lock();
+	for (uint i = 0; i < sync.dirtyObjects.size(); ++i)
+		sync.dirtyObjects[i]->applyPending();
+	sync.dirtyObjects.clear();
+	sync.lock.unlock();
+
+	refitStaticCells();
+	dynamicsWorld->stepSimulation(fixedStep, 0, fixedStep);
+	collectChanges(true);
+}
+
+// Hand bodies moved in this step to game thread, publish their poses if threaded
+// Bodies stopped since last step are reported once more with settled pose
+void DynamicWorld::collectChanges(bool publish) {
+	std::lock_guard<std::mutex> guard(sync.lock);
+	for (uint i = 0; i < lastChanges.size(); ++i) {
+		CollisionObject* cob = lastChanges[i];
+		if (cob->isMoved) continue;
+		if (publish && !cob->hasPendingTrans) cob->publishPose(false);
+		if (!cob->isChanged) {
+			cob->isChanged = true;
+			sync.changedObjects.push_back(cob);
+		}
+	}
+	for (uint i = 0; i < stepChanges.size(); ++i) {
+		CollisionObject* cob = stepChanges[i];
+		cob->isMoved = false;
+		// Objects teleported meanwhile keep their written pose
+		if (publish && !cob->hasPendingTrans) cob->publishPose(false);
+		if (!cob->isChanged) {
+			cob->isChanged = true;
+			sync.changedObjects.push_back(cob);
+		}
+	}
+	lastChanges.swap(stepChanges);
+	stepChanges.clear();
+	if (publish) lastStepTime = CurrentSeconds();
+}
+
+// Threaded bodies stay queued every frame while interpolating between steps,
+// dropped once their settled pose has been fetched
+void DynamicWorld::fetchChangedObjects(std::vector<CollisionObject*>& changes) {
+	changes.clear();
+	std::lock_guard<std::mutex> guard(sync.lock);
+	changes.swap(sync.changedObjects);
+	for (uint i = 0; i < changes.size(); ++i) {
+		CollisionObject* cob = changes[i];
+		cob->isChanged = sync.threaded && cob->isInterpolating();
+		if (cob->isChanged) sync.changedObjects.push_back(cob);
+	}
+}
@@ -2,8 +2,14 @@
 #define DYNAMIC_WORLD_H_
 
 #include <list>
+#include <vector>
+#include <map>
+#include <thread>
+#include <mutex>
+#include <atomic>
 #include "../util/util.h"
 #include <bullet/btBulletDynamicsCommon.h>
+#include <bullet/BulletCollision/CollisionShapes/btHeightfieldTerrainShape.h>
 
 inline mat4 Quat2Mat(const vec4& q) {
 	btQuaternion quat(q.x, q.y, q.z, q.w);
@@ -60,26 +66,140 @@ struct CollisionShape {
 	}
 };
 
+struct CollisionObject;
+
+// Shared state between game thread and physics thread
+struct PhysicsSync {
+	std::mutex lock;
+	bool threaded;
+	float alpha; // Interpolation factor between previous & current step
+	std::vector<CollisionObject*> dirtyObjects; // Objects with pending writes
+	std::vector<CollisionObject*> changedObjects; // Objects moved by simulation since last fetch
+	std::vector<CollisionObject*> recellObjects; // Static props moved out of their cell
+	PhysicsSync() : threaded(false), alpha(1.0) {}
+};
+
+#ifndef STATIC_CELL_SIZE
+#define STATIC_CELL_SIZE 128.0
+#endif
+
+inline i64 StaticCellKey(const btVector3& pos) {
+	int cx = (int)floorf(pos.x() / STATIC_CELL_SIZE);
+	int cz = (int)floorf(pos.z() / STATIC_CELL_SIZE);
+	return ((i64)cx << 32) | (uint)cz;
+}
+
+// Static props of a spatial cell merged into one compound body
+struct StaticCell {
+	i64 key;
+	btCompoundShape* shape;
+	btRigidBody* body;
+	std::vector<CollisionObject*> children; // Compound child index to collision object
+	bool needRefit;
+	StaticCell(i64 cellKey) {
+		key = cellKey;
+		shape = new btCompoundShape(true);
+		btRigidBody::btRigidBodyConstructionInfo info(0.0, NULL, shape);
+		body = new btRigidBody(info);
+		body->setUserIndex(-1);
+		body->setUserPointer(this);
+		children.clear();
+		needRefit = false;
+	}
+	~StaticCell() {
+		delete body;
+		delete shape;
+	}
+	void updateChild(int index, const btTransform& trans) {
+		shape->updateChildTransform(index, trans, false);
+		needRefit = true;
+	}
+};
+
+// Motion state collecting bodies really moved by simulation
+struct ChangeMotionState : public btMotionState {
+	btTransform transform;
+	CollisionObject* owner;
+	std::vector<CollisionObject*>* changes;
+	ChangeMotionState(const btTransform& trans, CollisionObject* cob) :transform(trans), owner(cob), changes(NULL) {}
+	virtual void getWorldTransform(btTransform& trans) const { trans = transform; }
+	virtual void setWorldTransform(const btTransform& trans);
+	void resetTransform(const btTransform& trans) { transform = trans; }
+};
+
 struct CollisionObject {
-	btRigidBody* object;
+	btRigidBody* object; // NULL if merged into static cell
 	btMotionState* motion;
 	vec3 ax, ay, az;
+	PhysicsSync* sync;
+	int worldIndex; // Index in world's object list
+	// Static prop without own rigid body
+	btCollisionShape* staticShape;
+	btTransform staticTrans;
+	void* staticUser;
+	StaticCell* cell;
+	int childIndex;
+	// Double buffered pose published by physics thread
+	vec3 poseTranslate[2];
+	vec4 poseRotate[2];
+	vec3 poseVelocity;
+	bool poseActive;
+	// Writes from game thread applied before next physics step
+	btTransform pendingTrans;
+	btVector3 pendingVel;
+	bool hasPendingTrans, hasPendingVel, isDirty;
+	bool needRecell; // Queued to move into another static cell
+	bool isMoved, isChanged; // In step change list, in fetched change list
 	CollisionObject(btCollisionShape* shape, float mass) {
+		init();
 		btVector3 inertia(0.0, 0.0, 0.0);
 		if (mass > 0.0) shape->calculateLocalInertia(mass, inertia);
 		btTransform trans; trans.setIdentity();
-		motion = new btDefaultMotionState(trans);
+		motion = new ChangeMotionState(trans, this);
 		object = new btRigidBody(mass, motion, shape, inertia);
 		object->setUserIndex(-1);
 		resetVelocity();
+		publishPose(true);
+	}
+	// Static prop merged into a cell compound by world
+	CollisionObject(btCollisionShape* shape) {
+		init();
+		object = NULL;
+		motion = NULL;
+		staticShape = shape;
+		publishPose(true);
+	}
+	~CollisionObject() {
+		if (motion) delete motion;
+		if (object) {
+			object->setMotionState(NULL);
+			delete object;
+		}
+	}
+	void init() {
+		sync = NULL;
+		worldIndex = -1;
+		staticShape = NULL;
+		staticTrans.setIdentity();
+		staticUser = NULL;
+		cell = NULL;
+		childIndex = -1;
+		hasPendingTrans = false;
+		hasPendingVel = false;
+		isDirty = false;
+		needRecell = false;
+		isMoved = false;
+		isChanged = false;
 		ax = vec3(1, 0, 0);
 		ay = vec3(0, 1, 0);
 		az = vec3(0, 0, 1);
 	}
-	~CollisionObject() {
-		if (motion) delete motion;
-		object->setMotionState(NULL);
-		delete object;
+	void setUserPointer(void* user) {
+		if (object) object->setUserPointer(user);
+		else staticUser = user;
+	}
+	void* getUserPointer() {
+		return object ? object->getUserPointer() : staticUser;
 	}
 	void setAxis(const btQuaternion& q) {
 		mat4 m = Quat2Mat(vec4(q.x(), q.y(), q.z(), q.w()));
@@ -88,43 +208,66 @@ struct CollisionObject {
 		az = GetAxisZ(m);
 	}
 	void setCollisionShape(btCollisionShape* shape) {
-		object->setCollisionShape(shape);
+		if (object) object->setCollisionShape(shape);
+		else staticShape = shape;
 	}
 	void setMass(float mass) {
+		if (!object) return;
 		btVector3 inertia(0.0, 0.0, 0.0);
 		if (mass > 0.0) object->getCollisionShape()->calculateLocalInertia(mass, inertia);
 		object->setMassProps(mass, inertia);
 	}
+	bool isThreaded() {
+		return sync && sync->threaded;
+	}
+	// Previous & current published pose differ, called with sync locked
+	bool isInterpolating() {
+		return poseTranslate[0] != poseTranslate[1] || poseRotate[0] != poseRotate[1];
+	}
 	bool isStatic() {
+		if (!object) return true;
+		if (isThreaded()) {
+			std::lock_guard<std::mutex> guard(sync->lock); // poseActive written by physics thread
+			return (!poseActive || object->isStaticObject());
+		}
 		return (!object->isActive() || object->isStaticObject());
 	}
 	void initTranslate(const vec3& pos) {
-		btTransform trans = object->getWorldTransform();
+		btTransform trans = getTransform();
 		trans.setOrigin(btVector3(pos.x, pos.y, pos.z));
-		object->setWorldTransform(trans);
+		setTransform(trans);
 	}
 	void initRotate(const vec4& rot) {
-		btTransform trans = object->getWorldTransform();
+		btTransform trans = getTransform();
 		btQuaternion q = btQuaternion(rot.x, rot.y, rot.z, rot.w);
 		trans.setRotation(q);
-		object->setWorldTransform(trans);
+		setTransform(trans);
 		setAxis(q);
 	}
 	void initTransform(const vec3& pos, const vec4& rot) {
-		btTransform trans = object->getWorldTransform();
+		btTransform trans = getTransform();
 		trans.setOrigin(btVector3(pos.x, pos.y, pos.z));
 		btQuaternion q = btQuaternion(rot.x, rot.y, rot.z, rot.w);
 		trans.setRotation(q);
-		object->setWorldTransform(trans);
+		setTransform(trans);
 		setAxis(q);
 	}
 	void setTranslate(const vec3& after, const vec3& before) {
-		object->activate();
+		if (!object) return;
 		vec3 vel = after - before;
+		if (isThreaded()) {
+			std::lock_guard<std::mutex> guard(sync->lock);
+			pendingVel = btVector3(vel.x, vel.y, vel.z);
+			hasPendingVel = true;
+			poseVelocity = vel;
+			markDirty();
+			return;
+		}
+		object->activate();
 		object->setLinearVelocity(btVector3(vel.x, vel.y, vel.z));
 	}
 	void setRotateAngle(const vec3& angle, bool inverseYZ) {
-		btTransform trans = object->getWorldTransform();
+		btTransform trans = getTransform();
 		btQuaternion quat(0, 0, 0, 1);
 		btQuaternion qx; qx.setRotation(btVector3(ax.x, ax.y, ax.z), angleToRadian(angle.x));
 		quat = qx * quat;
@@ -142,36 +285,161 @@ struct CollisionObject {
 		quat = qz * quat;
 		setAxis(quat);
 		trans.setRotation(quat);
-		object->setWorldTransform(trans);
+		setTransform(trans);
 	}
 	vec3 getTranslate() {
-		btTransform trans = object->getWorldTransform();
+		if (isThreaded()) {
+			std::lock_guard<std::mutex> guard(sync->lock);
+			return poseTranslate[0] + (poseTranslate[1] - poseTranslate[0]) * sync->alpha;
+		}
+		btTransform trans = object ? object->getWorldTransform() : staticTrans;
 		btVector3 res = trans.getOrigin();
 		return vec3(res.getX(), res.getY(), res.getZ());
 	}
 	vec4 getRotate() {
-		btTransform trans = object->getWorldTransform();
+		if (isThreaded()) {
+			std::lock_guard<std::mutex> guard(sync->lock);
+			btQuaternion q0(poseRotate[0].x, poseRotate[0].y, poseRotate[0].z, poseRotate[0].w);
+			btQuaternion q1(poseRotate[1].x, poseRotate[1].y, poseRotate[1].z, poseRotate[1].w);
+			btQuaternion quat = q0.slerp(q1, sync->alpha);
+			return vec4(quat.x(), quat.y(), quat.z(), quat.w());
+		}
+		btTransform trans = object ? object->getWorldTransform() : staticTrans;
 		btQuaternion quat = trans.getRotation();
 		return vec4(quat.x(), quat.y(), quat.z(), quat.w());
 	}
 	vec3 getLinearVelocity() {
+		if (isThreaded()) {
+			std::lock_guard<std::mutex> guard(sync->lock);
+			return poseVelocity;
+		}
+		if (!object) return vec3(0.0, 0.0, 0.0);
 		btVector3 vel = object->getLinearVelocity();
 		return vec3(vel.x(), vel.y(), vel.z());
 	}
 	void resetVelocity() {
+		if (!object) return;
+		if (isThreaded()) {
+			std::lock_guard<std::mutex> guard(sync->lock);
+			pendingVel = btVector3(0.0, 0.0, 0.0);
+			hasPendingVel = true;
+			poseVelocity = vec3(0.0, 0.0, 0.0);
+			markDirty();
+			return;
+		}
 		object->setLinearVelocity(btVector3(0.0, 0.0, 0.0));
 		object->setAngularVelocity(btVector3(0.0, 0.0, 0.0));
 	}
+	// Called by physics thread with sync locked
+	void applyPending() {
+		if (!object) {
+			if (hasPendingTrans) moveStatic(pendingTrans);
+		} else if (hasPendingTrans) {
+			object->setWorldTransform(pendingTrans);
+			((ChangeMotionState*)motion)->resetTransform(pendingTrans);
+			object->activate();
+		}
+		if (hasPendingVel && object) {
+			object->activate();
+			object->setLinearVelocity(pendingVel);
+			if (pendingVel.isZero()) object->setAngularVelocity(btVector3(0.0, 0.0, 0.0));
+		}
+		hasPendingTrans = false;
+		hasPendingVel = false;
+		isDirty = false;
+	}
+	// Shift current pose to previous and store newest body transform
+	void publishPose(bool reset) {
+		btTransform trans = object ? object->getWorldTransform() : staticTrans;
+		btVector3 pos = trans.getOrigin();
+		btQuaternion quat = trans.getRotation();
+		btVector3 vel = object ? object->getLinearVelocity() : btVector3(0.0, 0.0, 0.0);
+		poseTranslate[0] = reset ? vec3(pos.x(), pos.y(), pos.z()) : poseTranslate[1];
+		poseRotate[0] = reset ? vec4(quat.x(), quat.y(), quat.z(), quat.w()) : poseRotate[1];
+		poseTranslate[1] = vec3(pos.x(), pos.y(), pos.z());
+		poseRotate[1] = vec4(quat.x(), quat.y(), quat.z(), quat.w());
+		if (!hasPendingVel) poseVelocity = vec3(vel.x(), vel.y(), vel.z());
+		poseActive = object ? object->isActive() : false;
+	}
+private:
+	// Static prop stays in its cell compound or waits for world to move it, sync locked if threaded
+	void moveStatic(const btTransform& trans) {
+		staticTrans = trans;
+		if (!cell) return;
+		if (StaticCellKey(trans.getOrigin()) == cell->key)
+			cell->updateChild(childIndex, trans);
+		else if (!needRecell) {
+			needRecell = true;
+			sync->recellObjects.push_back(this);
+		}
+	}
+	void markDirty() {
+		if (isDirty) return;
+		isDirty = true;
+		sync->dirtyObjects.push_back(this);
+	}
+	btTransform getTransform() {
+		if (isThreaded()) {
+			std::lock_guard<std::mutex> guard(sync->lock);
+			if (hasPendingTrans) return pendingTrans;
+			btQuaternion q(poseRotate[1].x, poseRotate[1].y, poseRotate[1].z, poseRotate[1].w);
+			return btTransform(q, btVector3(poseTranslate[1].x, poseTranslate[1].y, poseTranslate[1].z));
+		}
+		return object ? object->getWorldTransform() : staticTrans;
+	}
+	void setTransform(const btTransform& trans) {
+		if (isThreaded()) {
+			std::lock_guard<std::mutex> guard(sync->lock);
+			pendingTrans = trans;
+			hasPendingTrans = true;
+			// Teleport, no interpolation from old pose
+			btVector3 pos = trans.getOrigin();
+			btQuaternion quat = trans.getRotation();
+			poseTranslate[0] = poseTranslate[1] = vec3(pos.x(), pos.y(), pos.z());
+			poseRotate[0] = poseRotate[1] = vec4(quat.x(), quat.y(), quat.z(), quat.w());
+			markDirty();
+			return;
+		}
+		if (!object) {
+			moveStatic(trans);
+			return;
+		}
+		object->setWorldTransform(trans);
+		((ChangeMotionState*)motion)->resetTransform(trans);
+	}
 };
 
+inline void ChangeMotionState::setWorldTransform(const btTransform& trans) {
+	static const btScalar moveThreshold = 0.000001;
+	bool moved = trans.getOrigin().distance2(transform.getOrigin()) > moveThreshold ||
+		btFabs(trans.getRotation().dot(transform.getRotation())) < 1.0 - moveThreshold;
+	transform = trans;
+	if (moved && changes && !owner->isMoved) {
+		owner->isMoved = true;
+		changes->push_back(owner);
+	}
+}
+
 class DynamicWorld {
 private:
-	std::list<CollisionObject*> objects;
+	std::vector<CollisionObject*> objects;
+	std::map<i64, StaticCell*> staticCells;
+	PhysicsSync sync;
+	std::mutex stepLock; // Guard bullet world while stepping
+	std::thread* stepThread;
+	std::atomic<bool> running;
+	float fixedStep;
+	double lastStepTime;
+	std::vector<CollisionObject*> stepChanges; // Moved in current step
+	std::vector<CollisionObject*> lastChanges; // Moved in last step
 	btBroadphaseInterface* broadphase;
 	btDefaultCollisionConfiguration* collisionConfiguration;
 	btCollisionDispatcher* dispatcher;
 	btSequentialImpulseConstraintSolver* solver;
 	btDiscreteDynamicsWorld* dynamicsWorld;
+	btHeightfieldTerrainShape* terrainShape;
+	btRigidBody* terrainBody;
+	std::vector<unsigned char> terrainHeights; // Samples read by heightfield
 public:
 	DynamicWorld();
 	~DynamicWorld();
@@ -179,6 +447,23 @@ public:
 	void addObject(CollisionObject* cob);
 	void removeObject(CollisionObject* cob);
 	void act(float dtime);
+	void startThread();
+	void stopThread();
+	void fetchChangedObjects(std::vector<CollisionObject*>& changes);
+	// Takes every step-th sample of width * length map, same grid as terrain mesh
+	void setTerrain(const unsigned char* heights, int width, int length, int step, const vec3& offset, const vec3& scale);
+	void removeTerrain();
+	bool hasTerrain() { return terrainBody != NULL; }
+	void* queryUserPointer(const btCollisionObject* body, int childIndex);
+private:
+	void addStaticObject(CollisionObject* cob);
+	void removeStaticObject(CollisionObject* cob);
+	void recellStaticObjects();
+	void refitStaticCells();
+	void stepLoop();
+	void stepOnce();
+	void collectChanges(bool publish);
+public:
 	int getNumCollisionObjects() { return dynamicsWorld->getNumCollisionObjects(); }
 	btCollisionObjectArray& getCollisionObjectArray() { return dynamicsWorld->getCollisionObjectArray(); }
 };
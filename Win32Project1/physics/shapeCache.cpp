@@ -0,0 +1,87 @@
+#include "shapeCache.h"
+
+ShapeCache* ShapeCache::shapeCache = NULL;
+
+static void MergeExtent(const vec4& vertex, vec3& minV, vec3& maxV) {
+	float invw = 1.0 / vertex.w;
+	vec3 local3(vertex.x * invw, vertex.y * invw, vertex.z * invw);
+	minV.x = minV.x > local3.x ? local3.x : minV.x;
+	minV.y = minV.y > local3.y ? local3.y : minV.y;
+	minV.z = minV.z > local3.z ? local3.z : minV.z;
+	maxV.x = maxV.x < local3.x ? local3.x : maxV.x;
+	maxV.y = maxV.y < local3.y ? local3.y : maxV.y;
+	maxV.z = maxV.z < local3.z ? local3.z : maxV.z;
+}
+
+void ShapeCache::Init() {
+	if (!ShapeCache::shapeCache)
+		ShapeCache::shapeCache = new ShapeCache();
+}
+
+void ShapeCache::Release() {
+	if (ShapeCache::shapeCache)
+		delete ShapeCache::shapeCache;
+	ShapeCache::shapeCache = NULL;
+}
+
+ShapeCache::ShapeCache() {
+	extents.clear();
+	shapes.clear();
+}
+
+ShapeCache::~ShapeCache() {
+	std::map<Mesh*, MeshExtent*>::iterator ite = extents.begin();
+	for (; ite != extents.end(); ++ite)
+		delete ite->second;
+	extents.clear();
+
+	std::map<ShapeKey, CollisionShape*>::iterator its = shapes.begin();
+	for (; its != shapes.end(); ++its)
+		delete its->second;
+	shapes.clear();
+}
+
+MeshExtent* ShapeCache::caculateExtent(Mesh* mesh) {
+	MeshExtent* extent = new MeshExtent();
+	extent->minVertex = vec3(MAX_VAL), extent->maxVertex = vec3(-MAX_VAL);
+	for (int i = 0; i < mesh->vertexCount; ++i)
+		MergeExtent(mesh->vertices[i], extent->minVertex, extent->maxVertex);
+
+	extent->minFace = vec3(MAX_VAL), extent->maxFace = vec3(-MAX_VAL);
+	for (uint n = 0; n < mesh->normalFaces.size(); ++n) {
+		FaceBuf* buf = mesh->normalFaces[n];
+		for (int i = 0; i < buf->count; ++i)
+			MergeExtent(mesh->vertices[mesh->indices[buf->start + i]], extent->minFace, extent->maxFace);
+	}
+	if (extent->minVertex.x > extent->maxVertex.x) { // No vertices
+		extent->minVertex = vec3(0.0);
+		extent->maxVertex = vec3(0.0);
+	}
+	if (extent->minFace.x > extent->maxFace.x) { // No normal faces
+		extent->minFace = vec3(0.0);
+		extent->maxFace = vec3(0.0);
+	}
+	return extent;
+}
+
+MeshExtent* ShapeCache::getExtent(Mesh* mesh) {
+	std::map<Mesh*, MeshExtent*>::iterator it = extents.find(mesh);
+	if (it != extents.end()) return it->second;
+	MeshExtent* extent = caculateExtent(mesh);
+	extents[mesh] = extent;
+	return extent;
+}
+
+CollisionShape* ShapeCache::getBoxShape(Mesh* mesh, const vec3& size) {
+	ShapeKey key(mesh, size);
+	std::map<ShapeKey, CollisionShape*>::iterator it = shapes.find(key);
+	if (it != shapes.end()) return it->second;
+
+	MeshExtent* extent = getExtent(mesh);
+	vec3 faceSize = extent->maxFace - extent->minFace;
+	vec3 halfSize = vec3(fabsf(faceSize.x * size.x), fabsf(faceSize.y * size.y), fabsf(faceSize.z * size.z)) * 0.5;
+	halfSize *= mesh->getBoundScale();
+	CollisionShape* shape = new CollisionShape(halfSize);
+	shapes[key] = shape;
+	return shape;
+}
@@ -0,0 +1,46 @@
+#ifndef SHAPE_CACHE_H_
+#define SHAPE_CACHE_H_
+
+#include <map>
+#include "dynamicWorld.h"
+#include "../mesh/mesh.h"
+
+// Local extents of a mesh in model space
+struct MeshExtent {
+	vec3 minVertex, maxVertex; // All vertices
+	vec3 minFace, maxFace; // Vertices referenced by normal faces
+};
+
+struct ShapeKey {
+	Mesh* mesh;
+	vec3 size;
+	ShapeKey(Mesh* m, const vec3& s) :mesh(m), size(s) {}
+	bool operator<(const ShapeKey& rhs) const {
+		if (mesh != rhs.mesh) return mesh < rhs.mesh;
+		if (size.x != rhs.size.x) return size.x < rhs.size.x;
+		if (size.y != rhs.size.y) return size.y < rhs.size.y;
+		return size.z < rhs.size.z;
+	}
+};
+
+// Extents computed once per mesh, collision shapes shared by (mesh, scale)
+class ShapeCache {
+public:
+	static ShapeCache* shapeCache;
+public:
+	static void Init();
+	static void Release();
+private:
+	std::map<Mesh*, MeshExtent*> extents;
+	std::map<ShapeKey, CollisionShape*> shapes;
+private:
+	ShapeCache();
+	~ShapeCache();
+	MeshExtent* caculateExtent(Mesh* mesh);
+public:
+	MeshExtent* getExtent(Mesh* mesh);
+	CollisionShape* getBoxShape(Mesh* mesh, const vec3& size);
+	uint getShapeCount() { return shapes.size(); }
+};
+
+#endif
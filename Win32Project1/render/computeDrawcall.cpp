@@ -53,13 +53,14 @@ RenderBuffer* ComputeDrawcall::createBuffers(int objCount) {
 }
 
 void ComputeDrawcall::draw(Render* render, RenderState* state, Shader* shader) {
+	static int fullSizeId = Shader::GetUniformId("fullSize");
 	dataBuffer->use();
 
 	dataBuffer->setShaderBase(PositionOutIndex, 1);
 	dataBuffer->setShaderBase(IndirectBufIndex, 2);
 
 	render->useShader(state->shaderCompute);
-	state->shaderCompute->setFloat("fullSize", maxCount);
+	state->shaderCompute->setFloat(fullSizeId, maxCount);
 
 	glDispatchCompute(dispatchCount, dispatchCount, 1);
 	glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT | GL_COMMAND_BARRIER_BIT);
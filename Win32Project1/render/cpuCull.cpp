@@ -0,0 +1,157 @@
+#include "cpuCull.h"
+#include <xmmintrin.h>
+#include <math.h>
+#include <string.h>
+#include <vector>
+using namespace std;
+
+#define CULL_NEG_CHECK 5.0f
+
+// CheckCull in util.glsl on 8 box corners, corner = center +- half extents in clip space
+static bool FrustumCulled(const __m128* cols, const float* bound, float tx, float tz) {
+	__m128 center = _mm_add_ps(_mm_add_ps(_mm_mul_ps(cols[0], _mm_set1_ps(tx)), _mm_mul_ps(cols[1], _mm_set1_ps(bound[3]))),
+		_mm_add_ps(_mm_mul_ps(cols[2], _mm_set1_ps(tz)), cols[3]));
+	__m128 ex = _mm_mul_ps(cols[0], _mm_set1_ps(bound[0] * 0.5f));
+	__m128 ey = _mm_mul_ps(cols[1], _mm_set1_ps(bound[1] * 0.5f));
+	__m128 ez = _mm_mul_ps(cols[2], _mm_set1_ps(bound[2] * 0.5f));
+
+	__m128 minP = _mm_set1_ps(1e30f), maxP = _mm_set1_ps(-1e30f);
+	for (int c = 0; c < 8; c++) {
+		__m128 p = _mm_add_ps(center, (c & 1) ? ex : _mm_sub_ps(_mm_setzero_ps(), ex));
+		p = _mm_add_ps(p, (c & 2) ? ey : _mm_sub_ps(_mm_setzero_ps(), ey));
+		p = _mm_add_ps(p, (c & 4) ? ez : _mm_sub_ps(_mm_setzero_ps(), ez));
+		__m128 w = _mm_shuffle_ps(p, p, _MM_SHUFFLE(3, 3, 3, 3));
+		if (_mm_cvtss_f32(w) < 0.001f) return false; // Crosses camera plane
+		__m128 ndc = _mm_div_ps(p, w);
+		minP = _mm_min_ps(minP, ndc);
+		maxP = _mm_max_ps(maxP, ndc);
+	}
+	int outside = _mm_movemask_ps(_mm_or_ps(_mm_cmpgt_ps(minP, _mm_set1_ps(1.0f)), _mm_cmplt_ps(maxP, _mm_set1_ps(-1.0f))));
+	return (outside & 7) != 0;
+}
+
+static void DecodeQuat(const float* rotat, float* q) {
+	float x = rotat[0], y = rotat[1], z = rotat[2], sign = 1.0f;
+	if (z > CULL_NEG_CHECK) {
+		z -= CULL_NEG_CHECK * 2.0f;
+		sign = -1.0f;
+	}
+	float ww = 1.0f - (x * x + y * y + z * z);
+	q[0] = x, q[1] = y, q[2] = z;
+	q[3] = sign * sqrtf(ww > 0.0f ? ww : 0.0f);
+}
+
+static void UnpackScale(float v, float* s) {
+	int iv = (int)v;
+	int z = iv >> 20;
+	int y = (iv - (z << 20)) >> 10;
+	s[0] = v - (float)((z << 20) + (y << 10));
+	s[1] = (float)y, s[2] = (float)z;
+}
+
+// Translate * QuatToMat4 * Scale, column major
+static void ComposeMatrix(const float* ins, float* mat) {
+	float q[4], s[3];
+	DecodeQuat(ins + 4, q);
+	if (ins[7] > 0.0f) s[0] = s[1] = s[2] = ins[3];
+	else UnpackScale(ins[3], s);
+
+	float cols[3][3] = {
+		{ 1.0f - 2.0f * q[1] * q[1] - 2.0f * q[2] * q[2], 2.0f * q[0] * q[1] + 2.0f * q[3] * q[2], 2.0f * q[0] * q[2] - 2.0f * q[3] * q[1] },
+		{ 2.0f * q[0] * q[1] - 2.0f * q[3] * q[2], 1.0f - 2.0f * q[0] * q[0] - 2.0f * q[2] * q[2], 2.0f * q[1] * q[2] + 2.0f * q[3] * q[0] },
+		{ 2.0f * q[0] * q[2] + 2.0f * q[3] * q[1], 2.0f * q[1] * q[2] - 2.0f * q[3] * q[0], 1.0f - 2.0f * q[0] * q[0] - 2.0f * q[1] * q[1] }
+	};
+	for (int c = 0; c < 3; c++) {
+		mat[c * 4 + 0] = cols[c][0] * s[c];
+		mat[c * 4 + 1] = cols[c][1] * s[c];
+		mat[c * 4 + 2] = cols[c][2] * s[c];
+		mat[c * 4 + 3] = 0.0f;
+	}
+	mat[12] = ins[0], mat[13] = ins[1], mat[14] = ins[2], mat[15] = 1.0f;
+}
+
+static void OutputMatrix(int kind, const float* ins, float* out) {
+	if (kind == CULL_BILL) {
+		memcpy(out, ins, CULL_TRANSFORM_SIZE * sizeof(float));
+		return;
+	}
+	float mat[16];
+	ComposeMatrix(ins, mat);
+	if (kind == CULL_ANIM) { // Transposed, last column is mesh info
+		for (int c = 0; c < 3; c++)
+			for (int r = 0; r < 4; r++)
+				out[c * 4 + r] = mat[r * 4 + c];
+		memcpy(out + 12, ins + 12, 4 * sizeof(float));
+	} else {
+		memcpy(out, mat, sizeof(mat));
+		out[15] = ins[15];
+	}
+}
+
+static int GetMeshId(int kind, const float* ins) {
+	switch (kind) {
+		case CULL_NORMAL: return (int)ins[12];
+		case CULL_SINGLE: return (int)ins[13];
+	}
+	return (int)ins[14];
+}
+
+int CullInstances(int kind, const float* viewProj, const buff* transforms, int insCount, 
+	Indirect* indirects, int meshCount, const uint* bases, float* outMats, ThreadPool* pool) {
+	for (int m = 0; m < meshCount; m++) {
+		indirects[m].primCount = 0;
+		indirects[m].baseInstance = bases[m * 4 + kind];
+	}
+	if (insCount <= 0 || meshCount <= 0) return 0;
+
+	__m128 cols[4];
+	for (int c = 0; c < 4; c++) cols[c] = _mm_loadu_ps(viewProj + c * 4);
+
+	// Visible mesh per instance & counts per chunk, then chunk offsets keep output order fixed
+	int chunkCount = (insCount + CULL_CHUNK_SIZE - 1) / CULL_CHUNK_SIZE;
+	vector<int> meshOf(insCount);
+	vector<uint> offsets(chunkCount * meshCount, 0);
+
+	auto cullChunk = [&](int chunk) {
+		uint* counts = &offsets[chunk * meshCount];
+		int end = min(insCount, (chunk + 1) * CULL_CHUNK_SIZE);
+		for (int i = chunk * CULL_CHUNK_SIZE; i < end; i++) {
+			const float* ins = transforms + i * CULL_TRANSFORM_SIZE;
+			int mesh = GetMeshId(kind, ins);
+			bool visible = mesh >= 0 && mesh < meshCount;
+			if (visible && kind != CULL_ANIM)
+				visible = !FrustumCulled(cols, ins + 8, ins[0], ins[2]);
+			meshOf[i] = visible ? mesh : -1;
+			if (visible) counts[mesh]++;
+		}
+	};
+	if (pool && chunkCount > 1) pool->parallelFor(chunkCount, cullChunk);
+	else for (int c = 0; c < chunkCount; c++) cullChunk(c);
+
+	int visibleCount = 0;
+	for (int m = 0; m < meshCount; m++) {
+		uint offset = 0;
+		for (int c = 0; c < chunkCount; c++) {
+			uint count = offsets[c * meshCount + m];
+			offsets[c * meshCount + m] = offset;
+			offset += count;
+		}
+		indirects[m].primCount = offset;
+		visibleCount += offset;
+	}
+
+	auto writeChunk = [&](int chunk) {
+		uint* next = &offsets[chunk * meshCount];
+		int end = min(insCount, (chunk + 1) * CULL_CHUNK_SIZE);
+		for (int i = chunk * CULL_CHUNK_SIZE; i < end; i++) {
+			int mesh = meshOf[i];
+			if (mesh < 0) continue;
+			uint index = indirects[mesh].baseInstance + next[mesh]++;
+			OutputMatrix(kind, transforms + i * CULL_TRANSFORM_SIZE, outMats + index * 16);
+		}
+	};
+	if (pool && chunkCount > 1) pool->parallelFor(chunkCount, writeChunk);
+	else for (int c = 0; c < chunkCount; c++) writeChunk(c);
+
+	return visibleCount;
+}
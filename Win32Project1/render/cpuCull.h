@@ -0,0 +1,22 @@
+#ifndef CPU_CULL_H_
+#define CPU_CULL_H_
+
+#include "../util/util.h"
+#include "../util/threadPool.h"
+
+#define CULL_NORMAL 0
+#define CULL_SINGLE 1
+#define CULL_BILL 2
+#define CULL_ANIM 3
+
+#define CULL_TRANSFORM_SIZE 16 // Floats per instance in, same layout as Transform in multiCull.comp
+#define CULL_CHUNK_SIZE 256
+
+// Cpu version of multiCull.comp & flush.comp for one instance kind, hi-z query is skipped
+// so it keeps every instance the frustum test keeps, as the shadow pass shader does.
+// bases holds 4 uint per mesh, outMats gets 16 floats at baseInstance + primCount of its mesh.
+// Unlike gpu atomics, instances of a mesh stay in input order. Returns visible count
+int CullInstances(int kind, const float* viewProj, const buff* transforms, int insCount, 
+	Indirect* indirects, int meshCount, const uint* bases, float* outMats, ThreadPool* pool);
+
+#endif
@@ -0,0 +1,114 @@
+#include "gpuTimer.h"
+
+uint GLQueryBackend::create() {
+	GLuint query = 0;
+	glGenQueries(1, &query);
+	return query;
+}
+
+void GLQueryBackend::begin(uint query) {
+	glBeginQuery(GL_TIME_ELAPSED, query);
+}
+
+void GLQueryBackend::end() {
+	glEndQuery(GL_TIME_ELAPSED);
+}
+
+bool GLQueryBackend::ready(uint query) {
+	GLint available = 0;
+	glGetQueryObjectiv(query, GL_QUERY_RESULT_AVAILABLE, &available);
+	return available != 0;
+}
+
+u64 GLQueryBackend::result(uint query) {
+	GLuint64 elapsed = 0;
+	glGetQueryObjectui64v(query, GL_QUERY_RESULT, &elapsed);
+	return (u64)elapsed;
+}
+
+void GLQueryBackend::release(uint query) {
+	GLuint id = query;
+	glDeleteQueries(1, &id);
+}
+
+GpuTimer::GpuTimer(QueryBackend* queryBackend) {
+	backend = queryBackend;
+	for (int i = 0; i < GPU_TIMER_FRAMES; i++) {
+		frames[i].created = 0, frames[i].count = 0;
+		frames[i].cpuStart = 0;
+		frames[i].pending = false;
+	}
+	current = 0;
+	open = false;
+	dropped = 0;
+	track = Profiler::IsEnabled() ? Profiler::CreateTrack("gpu") : NULL;
+	results.clear();
+}
+
+GpuTimer::~GpuTimer() {
+	for (int i = 0; i < GPU_TIMER_FRAMES; i++) {
+		for (int q = 0; q < frames[i].created; q++)
+			backend->release(frames[i].queries[q]);
+	}
+	delete backend;
+	results.clear();
+}
+
+bool GpuTimer::isReady(const GpuFrame& frame) {
+	for (int q = 0; q < frame.count; q++) {
+		if (!backend->ready(frame.queries[q])) return false;
+	}
+	return true;
+}
+
+void GpuTimer::collect(GpuFrame& frame) {
+	results.clear();
+	u64 start = frame.cpuStart;
+	for (int q = 0; q < frame.count; q++) {
+		u64 duration = backend->result(frame.queries[q]) / 1000;
+		results.push_back(GpuPassTime(frame.names[q], duration));
+		if (track) track->push(frame.names[q], start, duration);
+		start += duration;
+	}
+	frame.pending = false;
+}
+
+// Oldest frames first, slot about to be reused is dropped if gpu still not done
+void GpuTimer::beginFrame() {
+	if (open) end();
+	for (int i = 1; i <= GPU_TIMER_FRAMES; i++) {
+		GpuFrame& frame = frames[(current + i) % GPU_TIMER_FRAMES];
+		if (!frame.pending) continue;
+		if (isReady(frame)) collect(frame);
+		else if (i == 1) {
+			frame.pending = false;
+			dropped++;
+		} else break;
+	}
+
+	current = (current + 1) % GPU_TIMER_FRAMES;
+	GpuFrame& frame = frames[current];
+	frame.count = 0;
+	frame.cpuStart = Profiler::Now();
+	frame.pending = false;
+}
+
+bool GpuTimer::begin(const char* name) {
+	GpuFrame& frame = frames[current];
+	if (open || frame.count >= GPU_TIMER_PASSES) return false;
+	if (frame.count == frame.created) 
+		frame.queries[frame.created++] = backend->create();
+	frame.names[frame.count] = name;
+	backend->begin(frame.queries[frame.count]);
+	open = true;
+	return true;
+}
+
+void GpuTimer::end() {
+	if (!open) return;
+	backend->end();
+	open = false;
+	GpuFrame& frame = frames[current];
+	frame.count++;
+	frame.pending = true;
+}
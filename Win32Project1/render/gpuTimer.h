@@ -0,0 +1,90 @@
+#ifndef GPU_TIMER_H_
+#define GPU_TIMER_H_
+
+#include "glheader.h"
+#include "../util/profiler.h"
+#include <vector>
+
+#define GPU_TIMER_FRAMES 4 // Queries of a frame are read this many frames later
+#define GPU_TIMER_PASSES 32 // Timed passes per frame, more are ignored
+
+// Elapsed time queries, gl version wraps GL_TIME_ELAPSED so tests can fake it
+class QueryBackend {
+public:
+	virtual ~QueryBackend() {}
+	virtual uint create() = 0;
+	virtual void begin(uint query) = 0;
+	virtual void end() = 0;
+	virtual bool ready(uint query) = 0;
+	virtual u64 result(uint query) = 0; // Nanoseconds
+	virtual void release(uint query) = 0;
+};
+
+class GLQueryBackend: public QueryBackend {
+public:
+	virtual uint create();
+	virtual void begin(uint query);
+	virtual void end();
+	virtual bool ready(uint query);
+	virtual u64 result(uint query);
+	virtual void release(uint query);
+};
+
+struct GpuPassTime {
+	const char* name;
+	u64 duration; // Microseconds
+	GpuPassTime(const char* n, u64 d) :name(n), duration(d) {}
+};
+
+struct GpuFrame {
+	const char* names[GPU_TIMER_PASSES];
+	uint queries[GPU_TIMER_PASSES];
+	int created, count;
+	u64 cpuStart;
+	bool pending;
+};
+
+// Times passes in a ring of frames & only reads queries already finished,
+// results go to a "gpu" profiler track laid back to back from frame start
+class GpuTimer {
+private:
+	QueryBackend* backend;
+	GpuFrame frames[GPU_TIMER_FRAMES];
+	int current;
+	bool open;
+	uint dropped;
+	ProfileTrack* track;
+	std::vector<GpuPassTime> results;
+private:
+	bool isReady(const GpuFrame& frame);
+	void collect(GpuFrame& frame);
+public:
+	GpuTimer(QueryBackend* queryBackend);
+	~GpuTimer();
+	void beginFrame();
+	// False if a pass is already open, gl timer queries can not nest
+	bool begin(const char* name);
+	void end();
+	// Passes of latest finished frame
+	const std::vector<GpuPassTime>& getResults() { return results; }
+	uint getDropped() { return dropped; }
+};
+
+class GpuScope {
+private:
+	GpuTimer* timer;
+	bool active;
+public:
+	GpuScope(GpuTimer* gpuTimer, const char* name) {
+		timer = gpuTimer;
+		active = timer && timer->begin(name);
+	}
+	~GpuScope() {
+		if (active) timer->end();
+	}
+};
+
+// Cpu scope & gpu timer query around a render pass
+#define PROFILE_PASS(render, name) PROFILE_SCOPE(name); GpuScope PROFILE_JOIN(gpuScope, __LINE__)((render)->getGpuTimer(), name)
+
+#endif
@@ -1,6 +1,7 @@
 #include "multiDrawcall.h"
 #include "../instance/multiInstance.h"
 #include "../render/render.h"
+#include "cpuCull.h"
 
 // Attribute slots
 const uint VertexSlot = 0;
@@ -41,6 +42,20 @@ MultiDrawcall::MultiDrawcall(MultiInstance* multi) :Drawcall() {
 
 	indirectBuffer = createIndirects(multiRef);
 
+	Indirect* indirects[4] = { multiRef->indirectsNormal, multiRef->indirectsSingle, multiRef->indirectsBill, multiRef->indirectsAnim };
+	uint counts[4] = { multiRef->normalCount, multiRef->singleCount, multiRef->billCount, multiRef->animCount };
+	for (int i = 0; i < 4; i++) {
+		cullIndirects[i] = NULL;
+		if (indirects[i] && counts[i] > 0) {
+			cullIndirects[i] = (Indirect*)malloc(counts[i] * sizeof(Indirect));
+			memcpy(cullIndirects[i], indirects[i], counts[i] * sizeof(Indirect));
+		}
+	}
+	cullMats = NULL;
+
+	countBlock = new UniformBuffer(16);
+	countBlock->setData(0, counts, sizeof(counts));
+
 	meshCount = multiRef->meshCount;
 	if (!multiRef->hasAnim) setType(MULTI_DC);
 	else setType(ANIMATE_DC);
@@ -49,9 +64,13 @@ MultiDrawcall::MultiDrawcall(MultiInstance* multi) :Drawcall() {
 
 MultiDrawcall::~MultiDrawcall() {
 	if (indirectBuffer) delete indirectBuffer;
+	if (countBlock) delete countBlock;
 	if (singleBuffer) delete singleBuffer;
 	if (billBuffer) delete billBuffer;
 	if (animBuffer) delete animBuffer;
+	for (int i = 0; i < 4; i++)
+		if (cullIndirects[i]) free(cullIndirects[i]);
+	if (cullMats) free(cullMats);
 }
 
 RenderBuffer* MultiDrawcall::createBuffers(MultiInstance* multi, int vertexCount, int indexCount, uint inIndex, uint outIndex, uint maxCount, RenderBuffer* ref) {
@@ -98,6 +117,7 @@ RenderBuffer* MultiDrawcall::createIndirects(MultiInstance* multi) {
 }
 
 void MultiDrawcall::draw(Render* render, RenderState* state, Shader* shader) {
+	static int alphaId = Shader::GetUniformId("uAlpha");
 	if (frame < state->delay) frame++;
 	else {
 		bool shadowPass = state->pass < COLOR_PASS;
@@ -107,7 +127,7 @@ void MultiDrawcall::draw(Render* render, RenderState* state, Shader* shader) {
 			if (multiRef->normalCount > 0 && multiRef->normalInsCount > 0) {
 				dataBuffer->use();
 				render->useShader(shader);
-				if (shadowPass) render->setShaderFloat(shader, "uAlpha", 0.0);
+				if (shadowPass) render->setShaderFloat(shader, alphaId, 0.0);
 				indirectBuffer->useAs(IndirectNormalIndex, GL_DRAW_INDIRECT_BUFFER);
 				glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_SHORT, 0, multiRef->normalCount, 0);
 			}
@@ -118,7 +138,7 @@ void MultiDrawcall::draw(Render* render, RenderState* state, Shader* shader) {
 				if (shadowPass) render->setCullMode(CULL_BACK);
 				else render->setCullState(false);
 				render->useShader(shader);
-				if (shadowPass) render->setShaderFloat(shader, "uAlpha", 1.0);
+				if (shadowPass) render->setShaderFloat(shader, alphaId, 1.0);
 				indirectBuffer->useAs(IndirectSingleIndex, GL_DRAW_INDIRECT_BUFFER);
 				glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_SHORT, 0, multiRef->singleCount, 0);
 			}
@@ -129,7 +149,7 @@ void MultiDrawcall::draw(Render* render, RenderState* state, Shader* shader) {
 				render->useShader(state->shaderBill);
 				if (shadowPass) {
 					render->setCullState(false);
-					render->setShaderFloat(state->shaderBill, "uAlpha", 1.0);
+					render->setShaderFloat(state->shaderBill, alphaId, 1.0);
 				}
 				indirectBuffer->useAs(IndirectBillIndex, GL_DRAW_INDIRECT_BUFFER);
 				glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_SHORT, 0, multiRef->billCount, 0);
@@ -138,7 +158,7 @@ void MultiDrawcall::draw(Render* render, RenderState* state, Shader* shader) {
 			if (multiRef->animCount > 0 && multiRef->animInsCount > 0) {
 				animBuffer->use();
 				render->useShader(shader);
-				render->setShaderFloat(shader, "uAlpha", 0.0);
+				render->setShaderFloat(shader, alphaId, 0.0);
 				indirectBuffer->useAs(IndirectAnimIndex, GL_DRAW_INDIRECT_BUFFER);
 				glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_SHORT, 0, multiRef->animCount, 0);
 			}
@@ -148,6 +168,11 @@ void MultiDrawcall::draw(Render* render, RenderState* state, Shader* shader) {
 
 void MultiDrawcall::update(Camera* camera, Render* render, RenderState* state) {
 	objectCount = multiRef->updateTransform();
+	if (state->cullPool) {
+		cullOnCpu(camera, state->cullPool);
+		return;
+	}
+
 	dataBuffer->updateBufferData(BaseIndex, meshCount, (void*)(multiRef->bases));
 	if (multiRef->normalInsCount > 0)
 		dataBuffer->updateBufferData(InIndex, multiRef->normalInsCount, (void*)(multiRef->transformsNormal));
@@ -169,13 +194,44 @@ void MultiDrawcall::updateIndirect(Render* render, RenderState* state) {
 	indirectBuffer->setShaderBase(IndirectAnimIndex, 4);
 	dataBuffer->setShaderBase(BaseIndex, 5);
 
+	countBlock->use(COUNT_BLOCK_BINDING);
+
 	render->useShader(state->shaderFlush);
-	render->setShaderUVec4(state->shaderFlush, "uCount", multiRef->normalCount, multiRef->singleCount, multiRef->billCount, multiRef->animCount);
 	glDispatchCompute(meshCount, 1, 1);
 	glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
 }
 
+// Same output as flush.comp & multiCull.comp without hi-z, uploaded for indirect draw
+void MultiDrawcall::cullOnCpu(Camera* camera, ThreadPool* pool) {
+	if (!cullMats) {
+		int maxCount = multiRef->maxNormalInstance;
+		if (multiRef->maxSingleInstance > maxCount) maxCount = multiRef->maxSingleInstance;
+		if (multiRef->maxBillInstance > maxCount) maxCount = multiRef->maxBillInstance;
+		if (multiRef->maxAnimInstance > maxCount) maxCount = multiRef->maxAnimInstance;
+		cullMats = (float*)malloc(maxCount * 16 * sizeof(float));
+	}
+
+	if (!multiRef->hasAnim) {
+		cullKind(CULL_NORMAL, camera, pool, multiRef->transformsNormal, multiRef->normalInsCount, multiRef->normalCount, dataBuffer, IndirectNormalIndex);
+		cullKind(CULL_SINGLE, camera, pool, multiRef->transformsSingle, multiRef->singleInsCount, multiRef->singleCount, singleBuffer, IndirectSingleIndex);
+		cullKind(CULL_BILL, camera, pool, multiRef->transformsBill, multiRef->billInsCount, multiRef->billCount, billBuffer, IndirectBillIndex);
+	} else
+		cullKind(CULL_ANIM, camera, pool, multiRef->transformsAnim, multiRef->animInsCount, multiRef->animCount, animBuffer, IndirectAnimIndex);
+}
+
+void MultiDrawcall::cullKind(int kind, Camera* camera, ThreadPool* pool, buff* transforms, int insCount, int count, RenderBuffer* buffer, uint indirectIndex) {
+	if (insCount <= 0 || count <= 0 || !cullIndirects[kind]) return;
+	Indirect* indirects = cullIndirects[kind];
+	CullInstances(kind, camera->viewProjectMatrix.entries, transforms, insCount, indirects, count, multiRef->bases, cullMats, pool);
+	buffer->updateBufferData(OutIndex, insCount, cullMats);
+	indirectBuffer->updateBufferData(indirectIndex, count * sizeof(Indirect), indirects);
+}
+
 void MultiDrawcall::prepareRenderData(Camera* camera, Render* render, RenderState* state) {
+	static int bufferPassId = Shader::GetUniformId("bufferPass");
+	static int insCountId = Shader::GetUniformId("uInsCount");
+	static int viewProjectId = Shader::GetUniformId("viewProjectMatrix");
+	static int passId = Shader::GetUniformId("pass");
 	dataBuffer->setShaderBase(InIndex, 1);
 	singleBuffer->setShaderBase(InIndex, 2);
 	billBuffer->setShaderBase(InIndex, 3);
@@ -190,19 +246,19 @@ void MultiDrawcall::prepareRenderData(Camera* camera, Render* render, RenderStat
 	indirectBuffer->setShaderBase(IndirectSingleIndex, 10);
 	indirectBuffer->setShaderBase(IndirectBillIndex, 11);
 	indirectBuffer->setShaderBase(IndirectAnimIndex, 12);
+	countBlock->use(COUNT_BLOCK_BINDING);
 
 	render->useShader(state->shaderMulti);
-	render->setShaderUint(state->shaderMulti, "bufferPass", multiRef->bufferPass);
-	render->setShaderIVec4(state->shaderMulti, "uCount", multiRef->normalCount, multiRef->singleCount, multiRef->billCount, multiRef->animCount);
-	render->setShaderUVec4(state->shaderMulti, "uInsCount", multiRef->normalInsCount, multiRef->singleInsCount, multiRef->billInsCount, multiRef->animInsCount);
-	render->setShaderMat4(state->shaderMulti, "viewProjectMatrix", camera->viewProjectMatrix);
+	render->setShaderUint(state->shaderMulti, bufferPassId, multiRef->bufferPass);
+	render->setShaderUVec4(state->shaderMulti, insCountId, multiRef->normalInsCount, multiRef->singleInsCount, multiRef->billInsCount, multiRef->animInsCount);
+	render->setShaderMat4(state->shaderMulti, viewProjectId, camera->viewProjectMatrix);
 
 	int dispatch = objectCount > MAX_DISPATCH ? MAX_DISPATCH : objectCount;
-	render->setShaderUint(state->shaderMulti, "pass", 0);
+	render->setShaderUint(state->shaderMulti, passId, 0);
 	glDispatchCompute(dispatch, 1, 1);
 	if (objectCount > MAX_DISPATCH) {
 		dispatch = objectCount - MAX_DISPATCH;
-		render->setShaderUint(state->shaderMulti, "pass", 1);
+		render->setShaderUint(state->shaderMulti, passId, 1);
 		glDispatchCompute(dispatch, 1, 1);
 	}
 	glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
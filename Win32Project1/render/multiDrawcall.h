@@ -4,6 +4,7 @@
 class MultiInstance;
 
 #include "drawcall.h"
+#include "uniformBuffer.h"
 
 class MultiDrawcall: public Drawcall {
 private:
@@ -15,12 +16,18 @@ private:
 	RenderBuffer* animBuffer;
 private:
 	RenderBuffer* indirectBuffer;
+	UniformBuffer* countBlock; // Mesh counts for flush & cull shaders
 	int meshCount;
+private:
+	Indirect* cullIndirects[4]; // Kept for cpu cull, multi instance frees its own
+	float* cullMats;
 private:
 	RenderBuffer* createBuffers(MultiInstance* multi, int vertexCount, int indexCount, uint inIndex, uint outIndex, uint maxCount, RenderBuffer* ref = NULL);
 	RenderBuffer* createIndirects(MultiInstance* multi);
 	void updateIndirect(Render* render, RenderState* state);
 	void prepareRenderData(Camera* camera, Render* render, RenderState* state);
+	void cullOnCpu(Camera* camera, ThreadPool* pool);
+	void cullKind(int kind, Camera* camera, ThreadPool* pool, buff* transforms, int insCount, int count, RenderBuffer* buffer, uint indirectIndex);
 public:
 	MultiDrawcall(MultiInstance* multi);
 	virtual ~MultiDrawcall();
@@ -0,0 +1,219 @@
+#include "occlusionBuffer.h"
+#include <xmmintrin.h>
+#include <math.h>
+#include <stdlib.h>
+using namespace std;
+
+OcclusionBuffer::OcclusionBuffer(int w, int h) {
+	width = w, height = h;
+	depth = (float*)malloc(width * height * sizeof(float));
+	for (int i = 0; i < width * height; i++) depth[i] = OCCLUSION_CLEAR;
+	for (int i = 0; i < 16; i++) viewProj[i] = (i % 5 == 0) ? 1.0f : 0.0f;
+	tested = 0, culled = 0;
+}
+
+OcclusionBuffer::~OcclusionBuffer() {
+	free(depth);
+	triangles.clear();
+}
+
+void OcclusionBuffer::begin(const mat4& viewProjMatrix) {
+	for (int i = 0; i < 16; i++) viewProj[i] = viewProjMatrix.entries[i];
+	for (int i = 0; i < width * height; i++) depth[i] = OCCLUSION_CLEAR;
+	triangles.clear();
+	tested = 0, culled = 0;
+}
+
+static inline vec4 TransformPoint(const float* m, const float* p) {
+	return vec4(m[0] * p[0] + m[4] * p[1] + m[8] * p[2] + m[12],
+		m[1] * p[0] + m[5] * p[1] + m[9] * p[2] + m[13],
+		m[2] * p[0] + m[6] * p[1] + m[10] * p[2] + m[14],
+		m[3] * p[0] + m[7] * p[1] + m[11] * p[2] + m[15]);
+}
+
+// Near plane in gl clip space is z = -w, in front if z + w >= 0
+static inline float NearDistance(const vec4& p) {
+	return p.z + p.w;
+}
+
+void OcclusionBuffer::addTriangles(const float* points, int stride, const int* indices, int indexCount, const mat4* transform) {
+	float m[16];
+	if (transform) {
+		mat4 vp;
+		for (int i = 0; i < 16; i++) vp.entries[i] = viewProj[i];
+		mat4 mvp = vp * (*transform);
+		for (int i = 0; i < 16; i++) m[i] = mvp.entries[i];
+	} else {
+		for (int i = 0; i < 16; i++) m[i] = viewProj[i];
+	}
+
+	for (int i = 0; i + 2 < indexCount; i += 3) {
+		vec4 tri[3];
+		int front = 0;
+		for (int v = 0; v < 3; v++) {
+			tri[v] = TransformPoint(m, points + indices[i + v] * stride);
+			if (NearDistance(tri[v]) >= 0.0f) front++;
+		}
+		if (front == 0) continue;
+		if (front == 3) {
+			addPolygon(tri, 3);
+			continue;
+		}
+
+		// Clip against near plane, one plane gives at most 4 vertices
+		vec4 clipped[4];
+		int count = 0;
+		for (int v = 0; v < 3; v++) {
+			const vec4& a = tri[v];
+			const vec4& b = tri[(v + 1) % 3];
+			float da = NearDistance(a), db = NearDistance(b);
+			if (da >= 0.0f) clipped[count++] = a;
+			if ((da >= 0.0f) != (db >= 0.0f)) {
+				float t = da / (da - db);
+				clipped[count++] = a + (b - a) * t;
+			}
+		}
+		addPolygon(clipped, count);
+	}
+}
+
+void OcclusionBuffer::addPolygon(const vec4* clips, int count) {
+	float sx[4], sy[4], sz[4];
+	for (int i = 0; i < count; i++) {
+		float invW = clips[i].w > 1e-6f ? 1.0f / clips[i].w : 1e6f;
+		sx[i] = (clips[i].x * invW * 0.5f + 0.5f) * width;
+		sy[i] = (clips[i].y * invW * 0.5f + 0.5f) * height;
+		sz[i] = clips[i].z * invW;
+	}
+
+	for (int i = 1; i + 1 < count; i++) {
+		int v1 = i, v2 = i + 1;
+		float area = (sx[v1] - sx[0]) * (sy[v2] - sy[0]) - (sx[v2] - sx[0]) * (sy[v1] - sy[0]);
+		if (fabsf(area) < 1e-6f) continue;
+		if (area < 0.0f) v1 = i + 1, v2 = i;
+
+		OccluderTriangle tri;
+		int ids[3] = { 0, v1, v2 };
+		float minx = sx[0], maxx = sx[0], miny = sy[0], maxy = sy[0];
+		for (int v = 0; v < 3; v++) {
+			tri.x[v] = sx[ids[v]], tri.y[v] = sy[ids[v]], tri.z[v] = sz[ids[v]];
+			minx = tri.x[v] < minx ? tri.x[v] : minx;
+			maxx = tri.x[v] > maxx ? tri.x[v] : maxx;
+			miny = tri.y[v] < miny ? tri.y[v] : miny;
+			maxy = tri.y[v] > maxy ? tri.y[v] : maxy;
+		}
+		if (maxx < 0.0f || maxy < 0.0f || minx >= width || miny >= height) continue;
+		tri.minX = minx < 0.0f ? 0 : (int)minx;
+		tri.maxX = maxx >= width ? width - 1 : (int)maxx;
+		tri.minY = miny < 0.0f ? 0 : (int)miny;
+		tri.maxY = maxy >= height ? height - 1 : (int)maxy;
+		triangles.push_back(tri);
+	}
+}
+
+// Bands own disjoint rows, so result does not depend on thread count
+void OcclusionBuffer::rasterBand(int band) {
+	int y0 = band * OCCLUSION_BAND;
+	int y1 = y0 + OCCLUSION_BAND > height ? height - 1 : y0 + OCCLUSION_BAND - 1;
+	const __m128 offsets = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+	const __m128 zero = _mm_setzero_ps();
+
+	for (uint t = 0; t < triangles.size(); t++) {
+		const OccluderTriangle& tri = triangles[t];
+		if (tri.maxY < y0 || tri.minY > y1) continue;
+
+		float area = (tri.x[1] - tri.x[0]) * (tri.y[2] - tri.y[0]) - (tri.x[2] - tri.x[0]) * (tri.y[1] - tri.y[0]);
+		float dzdx = ((tri.z[1] - tri.z[0]) * (tri.y[2] - tri.y[0]) - (tri.z[2] - tri.z[0]) * (tri.y[1] - tri.y[0])) / area;
+		float dzdy = ((tri.z[2] - tri.z[0]) * (tri.x[1] - tri.x[0]) - (tri.z[1] - tri.z[0]) * (tri.x[2] - tri.x[0])) / area;
+
+		// Edge a->b: (xb - xa) * (py - ya) - (yb - ya) * (px - xa), inside if all >= 0
+		float ea[3], eb[3];
+		for (int e = 0; e < 3; e++) {
+			int a = e, b = (e + 1) % 3;
+			ea[e] = -(tri.y[b] - tri.y[a]);
+			eb[e] = tri.x[b] - tri.x[a];
+		}
+
+		int rowStart = tri.minY > y0 ? tri.minY : y0;
+		int rowEnd = tri.maxY < y1 ? tri.maxY : y1;
+		int xStart = tri.minX & ~3;
+		for (int y = rowStart; y <= rowEnd; y++) {
+			float py = y + 0.5f;
+			__m128 rowE[3], stepE[3];
+			for (int e = 0; e < 3; e++) {
+				int a = e;
+				float base = eb[e] * (py - tri.y[a]) - ea[e] * tri.x[a];
+				rowE[e] = _mm_set1_ps(base);
+				stepE[e] = _mm_set1_ps(ea[e]);
+			}
+			// Farthest depth of plane over pixel footprint, pixel may be only partly covered
+			float footZ = 0.5f * (fabsf(dzdx) + fabsf(dzdy));
+			__m128 rowZ = _mm_set1_ps(tri.z[0] - dzdx * tri.x[0] + dzdy * (py - tri.y[0]) + footZ);
+			__m128 stepZ = _mm_set1_ps(dzdx);
+
+			float* line = depth + y * width;
+			for (int x = xStart; x <= tri.maxX; x += 4) {
+				__m128 px = _mm_add_ps(_mm_set1_ps((float)x), offsets);
+				__m128 inside = _mm_cmpge_ps(_mm_add_ps(rowE[0], _mm_mul_ps(stepE[0], px)), zero);
+				inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(rowE[1], _mm_mul_ps(stepE[1], px)), zero));
+				inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(rowE[2], _mm_mul_ps(stepE[2], px)), zero));
+				if (_mm_movemask_ps(inside) == 0) continue;
+
+				__m128 z = _mm_add_ps(rowZ, _mm_mul_ps(stepZ, px));
+				__m128 old = _mm_loadu_ps(line + x);
+				__m128 nearer = _mm_min_ps(old, z);
+				_mm_storeu_ps(line + x, _mm_or_ps(_mm_and_ps(inside, nearer), _mm_andnot_ps(inside, old)));
+			}
+		}
+	}
+}
+
+void OcclusionBuffer::rasterize(ThreadPool* pool) {
+	int bands = (height + OCCLUSION_BAND - 1) / OCCLUSION_BAND;
+	if (pool) pool->parallelFor(bands, [this](int band) { rasterBand(band); });
+	else {
+		for (int b = 0; b < bands; b++) rasterBand(b);
+	}
+}
+
+bool OcclusionBuffer::testBox(const vec3& minVertex, const vec3& maxVertex) {
+	tested++;
+	float minx = 1e30f, maxx = -1e30f, miny = 1e30f, maxy = -1e30f, minz = 1e30f;
+	for (int c = 0; c < 8; c++) {
+		float p[3] = { (c & 1) ? maxVertex.x : minVertex.x, (c & 2) ? maxVertex.y : minVertex.y, (c & 4) ? maxVertex.z : minVertex.z };
+		vec4 clip = TransformPoint(viewProj, p);
+		if (NearDistance(clip) < 0.0f || clip.w <= 1e-6f) return true; // Crosses near plane
+		float invW = 1.0f / clip.w;
+		float nx = clip.x * invW, ny = clip.y * invW, nz = clip.z * invW;
+		minx = nx < minx ? nx : minx;
+		maxx = nx > maxx ? nx : maxx;
+		miny = ny < miny ? ny : miny;
+		maxy = ny > maxy ? ny : maxy;
+		minz = nz < minz ? nz : minz;
+	}
+
+	float sx0 = (minx * 0.5f + 0.5f) * width, sx1 = (maxx * 0.5f + 0.5f) * width;
+	float sy0 = (miny * 0.5f + 0.5f) * height, sy1 = (maxy * 0.5f + 0.5f) * height;
+	if (sx1 < 0.0f || sy1 < 0.0f || sx0 >= width || sy0 >= height) return true; // Left to frustum test
+	// Occluders cover pixels by centre, a box touching a partly covered pixel
+	// always has an uncovered centre among its neighbours, so grow rect by one
+	int x0 = (int)floorf(sx0) - 1, x1 = (int)floorf(sx1) + 1;
+	int y0 = (int)floorf(sy0) - 1, y1 = (int)floorf(sy1) + 1;
+	x0 = x0 < 0 ? 0 : x0, x1 = x1 >= width ? width - 1 : x1;
+	y0 = y0 < 0 ? 0 : y0, y1 = y1 >= height ? height - 1 : y1;
+
+	const __m128 lanes = _mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f);
+	__m128 boxZ = _mm_set1_ps(minz);
+	__m128 first = _mm_set1_ps((float)x0), last = _mm_set1_ps((float)x1);
+	for (int y = y0; y <= y1; y++) {
+		const float* line = depth + y * width;
+		for (int x = x0 & ~3; x <= x1; x += 4) {
+			__m128 px = _mm_add_ps(_mm_set1_ps((float)x), lanes);
+			__m128 inRect = _mm_and_ps(_mm_cmpge_ps(px, first), _mm_cmple_ps(px, last));
+			__m128 behind = _mm_cmpge_ps(_mm_loadu_ps(line + x), boxZ);
+			if (_mm_movemask_ps(_mm_and_ps(inRect, behind))) return true;
+		}
+	}
+	culled++;
+	return false;
+}
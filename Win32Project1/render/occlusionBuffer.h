@@ -0,0 +1,48 @@
+#ifndef OCCLUSION_BUFFER_H_
+#define OCCLUSION_BUFFER_H_
+
+#include "../maths/Maths.h"
+#include "../util/threadPool.h"
+#include <vector>
+
+#define OCCLUSION_WIDTH 320 // Multiple of 4
+#define OCCLUSION_HEIGHT 192
+#define OCCLUSION_BAND 16 // Rows rasterized by one job
+#define OCCLUSION_CLEAR 1e30f
+
+struct OccluderTriangle {
+	float x[3], y[3], z[3]; // Pixel position & ndc depth, counter clockwise
+	int minX, maxX, minY, maxY;
+};
+
+// Low resolution cpu depth of a few large occluders,
+// boxes whose nearest depth is behind it everywhere they cover are hidden.
+// No gl calls, depth keeps the nearest occluder so tests stay conservative
+class OcclusionBuffer {
+private:
+	int width, height;
+	float* depth;
+	float viewProj[16];
+	std::vector<OccluderTriangle> triangles;
+	int tested, culled;
+private:
+	void addPolygon(const vec4* clips, int count);
+	void rasterBand(int band);
+public:
+	OcclusionBuffer(int w = OCCLUSION_WIDTH, int h = OCCLUSION_HEIGHT);
+	~OcclusionBuffer();
+	void begin(const mat4& viewProjMatrix);
+	// Positions are xyz with stride in floats, transform NULL if already in world space
+	void addTriangles(const float* points, int stride, const int* indices, int indexCount, const mat4* transform);
+	void rasterize(ThreadPool* pool);
+	// False only if box is surely hidden
+	bool testBox(const vec3& minVertex, const vec3& maxVertex);
+	int getTriangleCount() { return (int)triangles.size(); }
+	int getTestedCount() { return tested; }
+	int getCulledCount() { return culled; }
+	int getWidth() { return width; }
+	int getHeight() { return height; }
+	const float* getDepth() { return depth; }
+};
+
+#endif
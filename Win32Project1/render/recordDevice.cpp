@@ -0,0 +1,90 @@
+#include "recordDevice.h"
+#include <stdio.h>
+
+static const char* CallNames[CALL_TYPE_COUNT] = {
+	"cap", "depthFunc", "alphaFunc", "cullFace", "polygonMode", "colorMask",
+	"clearColor", "clear", "viewport", "program", "texture", "framebuffer"
+};
+
+RecordDevice::RecordDevice(RenderDevice* nextDevice) {
+	next = nextDevice;
+	reset();
+}
+
+void RecordDevice::setCap(int cap, bool enable) {
+	record(CALL_CAP);
+	if (next) next->setCap(cap, enable);
+}
+
+void RecordDevice::depthFunc(int mode) {
+	record(CALL_DEPTH_FUNC);
+	if (next) next->depthFunc(mode);
+}
+
+void RecordDevice::alphaFunc(int mode, float threshold) {
+	record(CALL_ALPHA_FUNC);
+	if (next) next->alphaFunc(mode, threshold);
+}
+
+void RecordDevice::cullFace(int mode) {
+	record(CALL_CULL_FACE);
+	if (next) next->cullFace(mode);
+}
+
+void RecordDevice::polygonMode(bool line) {
+	record(CALL_POLYGON_MODE);
+	if (next) next->polygonMode(line);
+}
+
+void RecordDevice::colorMask(bool r, bool g, bool b, bool a) {
+	record(CALL_COLOR_MASK);
+	if (next) next->colorMask(r, g, b, a);
+}
+
+void RecordDevice::clearColor(float r, float g, float b, float a) {
+	record(CALL_CLEAR_COLOR);
+	if (next) next->clearColor(r, g, b, a);
+}
+
+void RecordDevice::clear(bool color, bool depth, bool stencil) {
+	record(CALL_CLEAR);
+	if (next) next->clear(color, depth, stencil);
+}
+
+void RecordDevice::viewport(int x, int y, int width, int height) {
+	record(CALL_VIEWPORT);
+	if (next) next->viewport(x, y, width, height);
+}
+
+void RecordDevice::useProgram(uint program) {
+	record(CALL_PROGRAM);
+	if (next) next->useProgram(program);
+}
+
+void RecordDevice::bindTexture(uint unit, uint texture) {
+	record(CALL_TEXTURE);
+	if (next) next->bindTexture(unit, texture);
+}
+
+void RecordDevice::bindFramebuffer(uint fbo) {
+	record(CALL_FRAMEBUFFER);
+	if (next) next->bindFramebuffer(fbo);
+}
+
+uint RecordDevice::getTotal() {
+	uint total = 0;
+	for (int i = 0; i < CALL_TYPE_COUNT; i++)
+		total += counts[i];
+	return total;
+}
+
+void RecordDevice::reset() {
+	for (int i = 0; i < CALL_TYPE_COUNT; i++)
+		counts[i] = 0;
+}
+
+void RecordDevice::print() {
+	printf("gl state calls: %d\n", getTotal());
+	for (int i = 0; i < CALL_TYPE_COUNT; i++)
+		if (counts[i] > 0) printf("  %s: %d\n", CallNames[i], counts[i]);
+}
@@ -0,0 +1,49 @@
+#ifndef RECORD_DEVICE_H_
+#define RECORD_DEVICE_H_
+
+#include "renderDevice.h"
+
+#define CALL_CAP 0
+#define CALL_DEPTH_FUNC 1
+#define CALL_ALPHA_FUNC 2
+#define CALL_CULL_FACE 3
+#define CALL_POLYGON_MODE 4
+#define CALL_COLOR_MASK 5
+#define CALL_CLEAR_COLOR 6
+#define CALL_CLEAR 7
+#define CALL_VIEWPORT 8
+#define CALL_PROGRAM 9
+#define CALL_TEXTURE 10
+#define CALL_FRAMEBUFFER 11
+#define CALL_TYPE_COUNT 12
+
+// Counts calls that reach the device, forwards them if next is set,
+// with no next it needs no gl context so tests can run headless
+class RecordDevice : public RenderDevice {
+private:
+	RenderDevice* next;
+	uint counts[CALL_TYPE_COUNT];
+private:
+	void record(int call) { counts[call]++; }
+public:
+	RecordDevice(RenderDevice* nextDevice);
+	virtual ~RecordDevice() {}
+	virtual void setCap(int cap, bool enable);
+	virtual void depthFunc(int mode);
+	virtual void alphaFunc(int mode, float threshold);
+	virtual void cullFace(int mode);
+	virtual void polygonMode(bool line);
+	virtual void colorMask(bool r, bool g, bool b, bool a);
+	virtual void clearColor(float r, float g, float b, float a);
+	virtual void clear(bool color, bool depth, bool stencil);
+	virtual void viewport(int x, int y, int width, int height);
+	virtual void useProgram(uint program);
+	virtual void bindTexture(uint unit, uint texture);
+	virtual void bindFramebuffer(uint fbo);
+	uint getCount(int call) { return counts[call]; }
+	uint getTotal();
+	void reset();
+	void print();
+};
+
+#endif
@@ -4,15 +4,27 @@
 #include <stdio.h>
 
 Render::Render() {
+	glDevice = new GLDevice();
+	states = new StateTracker(glDevice);
 	initEnvironment();
 	shaders = new ShaderManager();
 	currentFrame = NULL;
+	uploadRing = NULL;
+	gpuTimer = NULL;
+	cameraBlock = new UniformBuffer(352);
+	blockCamera = NULL;
 }
 
 Render::~Render() {
+	if (uploadRing) delete uploadRing;
+	uploadRing = NULL;
+	if (gpuTimer) delete gpuTimer;
+	gpuTimer = NULL;
+	delete cameraBlock;
 	delete shaders;
 	shaders = NULL;
-	clearTextureSlots();
+	delete states;
+	delete glDevice;
 }
 
 float Render::MaxAniso = 0.0;
@@ -22,17 +34,7 @@ void Render::initEnvironment() {
 	GLenum err=glewInit();
 	if(GLEW_OK!=err)
 		printf("Error: %s\n",glewGetErrorString(err));
-	// Force to refresh states
-	enableDepthTest=false;
-	depthTestMode=GREATER;
-	enableAlphaTest = true;
-	alphaTestMode = LESS;
-	alphaThreshold = 1.0;
-	enableCull=false;
-	cullMode=CULL_NONE;
-	drawLine=true;
-	enableBlend = true;
-	enableColor = false;
+	// Tracker starts unknown, all states go through once
 	setDepthTest(true,LEQUAL);
 	setAlphaTest(false, GREATER, 0);
 	setCullState(true);
@@ -42,8 +44,6 @@ void Render::initEnvironment() {
 	setColorWrite(true);
 	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 	setClearColor(1,1,1,1);
-	currentShader=NULL;
-	clearTextureSlots();
 
 	glGetFloatv(GL_MAX_TEXTURE_MAX_ANISOTROPY_EXT, &MaxAniso);
 	debugMode = false;
@@ -54,11 +54,7 @@ void Render::initEnvironment() {
 }
 
 void Render::clearFrame(bool clearColor,bool clearDepth,bool clearStencil) {
-	GLbitfield clearMask=0;
-	if(clearColor) clearMask|=GL_COLOR_BUFFER_BIT;
-	if(clearDepth) clearMask|=GL_DEPTH_BUFFER_BIT;
-	if(clearStencil) clearMask|=GL_STENCIL_BUFFER_BIT;
-	glClear(clearMask);
+	states->clear(clearColor, clearDepth, clearStencil);
 }
 
 void Render::setState(const RenderState* state) {
@@ -71,115 +67,42 @@ void Render::setState(const RenderState* state) {
 }
 
 void Render::setDepthTest(bool enable,int testMode) {
-	if(enable!=enableDepthTest) {
-		enableDepthTest=enable;
-		if(enable) glEnable(GL_DEPTH_TEST);
-		else glDisable(GL_DEPTH_TEST);
-	}
-	if(testMode!=depthTestMode) {
-		depthTestMode=testMode;
-		switch(testMode) {
-			case LESS:
-				glDepthFunc(GL_LESS);
-				break;
-			case LEQUAL:
-				glDepthFunc(GL_LEQUAL);
-				break;
-			case GREATER:
-				glDepthFunc(GL_GREATER);
-				break;
-			case GEQUAL:
-				glDepthFunc(GL_GEQUAL);
-				break;
-			case ALWAYS:
-				glDepthFunc(GL_ALWAYS);
-				break;
-		}
-	}
+	states->setCap(CAP_DEPTH_TEST, enable);
+	states->setDepthFunc(testMode);
 }
 
 void Render::setAlphaTest(bool enable, int testMode, float threshold) {
-	if (enable != enableAlphaTest) {
-		enableAlphaTest = enable;
-		if (enable) glEnable(GL_ALPHA_TEST);
-		else glDisable(GL_ALPHA_TEST);
-	}
-	if (testMode != alphaTestMode || threshold != alphaThreshold) {
-		alphaTestMode = testMode;
-		alphaThreshold = threshold;
-		switch (testMode) {
-			case LESS:
-				glAlphaFunc(GL_LESS, alphaThreshold);
-				break;
-			case LEQUAL:
-				glAlphaFunc(GL_LEQUAL, alphaThreshold);
-				break;
-			case GREATER:
-				glAlphaFunc(GL_GREATER, alphaThreshold);
-				break;
-			case GEQUAL:
-				glAlphaFunc(GL_GEQUAL, alphaThreshold);
-				break;
-		}
-	}
+	states->setCap(CAP_ALPHA_TEST, enable);
+	states->setAlphaFunc(testMode, threshold);
 }
 
 void Render::setCullState(bool enable) {
-	if(enable==enableCull) return;
-	enableCull=enable;
-	if(enable) glEnable(GL_CULL_FACE);
-	else glDisable(GL_CULL_FACE);
+	states->setCap(CAP_CULL, enable);
 }
 
 void Render::setCullMode(int mode) {
-	if(mode==cullMode) return;
-	cullMode=mode;
-	switch(mode) {
-		case CULL_BACK:
-			glCullFace(GL_BACK);
-			break;
-		case CULL_FRONT:
-			glCullFace(GL_FRONT);
-			break;
-		case CULL_NONE:
-			glCullFace(GL_NONE);
-			break;
-		case CULL_ALL:
-			glCullFace(GL_FRONT_AND_BACK);
-			break;
-	}
+	states->setCullFace(mode);
 }
 
 void Render::setDrawLine(bool line) {
-	if(line==drawLine) return;
-	drawLine=line;
-	if(!line) glPolygonMode(GL_FRONT_AND_BACK,GL_FILL);
-	else glPolygonMode(GL_FRONT_AND_BACK,GL_LINE);
+	states->setPolygonMode(line);
 }
 
 void Render::setBlend(bool enable) {
-	if (enable == enableBlend) return;
-	enableBlend = enable;
-	if (enable) glEnable(GL_BLEND);
-	else glDisable(GL_BLEND);
+	states->setCap(CAP_BLEND, enable);
 }
 
 void Render::setColorWrite(bool enable) {
-	if (enable == enableColor) return;
-	enableColor = enable;
-	if (enable) glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
-	else glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+	states->setColorMask(enable, enable, enable, enable);
 }
 
 void Render::setClearColor(float r,float g,float b,float a) {
-	clearColor.r=r; clearColor.g=g;
-	clearColor.b=b; clearColor.a=a;
-	glClearColor(r,g,b,a);
+	states->setClearColor(r, g, b, a);
 }
 
 void Render::setViewPort(int width,int height) {
 	viewWidth=width; viewHeight=height;
-	glViewport(0,0,width,height);
+	states->setViewport(0, 0, width, height);
 }
 
 void Render::resize(int width, int height, Camera* camera1, Camera* camera2, Camera* reflectCamera) {
@@ -198,9 +121,20 @@ Shader* Render::findShader(const char* shader) {
 }
 
 void Render::useShader(Shader* shader) {
-	if (shader == currentShader) return;
-	currentShader = shader;
-	shader->use();
+	states->useProgram(shader->getProgramId());
+}
+
+// Camera block layout follows shader/camera.glsl
+void Render::useCamera(Camera* camera, const vec3& eyePos) {
+	cameraBlock->setMatrix4(0, camera->viewMatrix);
+	cameraBlock->setMatrix4(64, camera->projectMatrix);
+	cameraBlock->setMatrix4(128, camera->invViewProjectMatrix);
+	cameraBlock->setMatrix4(192, camera->invProjMatrix);
+	cameraBlock->setMatrix4(256, camera->invViewMatrix);
+	cameraBlock->setVector3(320, eyePos.x, eyePos.y, eyePos.z);
+	cameraBlock->setVector2(336, camera->zNear, 1.0 / (camera->zFar - camera->zNear));
+	cameraBlock->use(CAMERA_BLOCK_BINDING);
+	blockCamera = camera;
 }
 
 // Pass 1 draw near shadow
@@ -215,161 +149,159 @@ void Render::draw(Camera* camera,Drawcall* drawcall,RenderState* state) {
 		return; 
 	}
 
+	static int viewProjectId = Shader::GetUniformId("viewProjectMatrix");
+	static int isColorId = Shader::GetUniformId("isColor");
+	static int viewRightId = Shader::GetUniformId("viewRight");
+	static int normalId = Shader::GetUniformId("uNormal");
+	static int boneTexId = Shader::GetUniformId("boneTex");
+	static int timeId = Shader::GetUniformId("time");
+	static int udotlId = Shader::GetUniformId("udotl");
+	static int qualityId = Shader::GetUniformId("quality");
+	static int distortionId = Shader::GetUniformId("distortionId");
+	static int distortionTexId = Shader::GetUniformId("distortionTex");
+	static int roadTexId = Shader::GetUniformId("roadTex");
+	static int heightTexId = Shader::GetUniformId("heightTex");
+	static int heightNormalId = Shader::GetUniformId("heightNormal");
+	static int waterBiasId = Shader::GetUniformId("waterBias");
+	static int texEnvId = Shader::GetUniformId("texEnv");
+	static int texSkyId = Shader::GetUniformId("texSky");
+	static int texRefId = Shader::GetUniformId("texRef");
+	static int lightViewProjIds[4] = { Shader::GetUniformId("lightViewProjDyn"), Shader::GetUniformId("lightViewProjNear"),
+		Shader::GetUniformId("lightViewProjMid"), Shader::GetUniformId("lightViewProjFar") };
+	static int lightProjIds[4] = { Shader::GetUniformId("lightProjDyn"), Shader::GetUniformId("lightProjNear"),
+		Shader::GetUniformId("lightProjMid"), Shader::GetUniformId("lightProjFar") };
+	static int lightViewIds[4] = { Shader::GetUniformId("lightViewDyn"), Shader::GetUniformId("lightViewNear"),
+		Shader::GetUniformId("lightViewMid"), Shader::GetUniformId("lightViewFar") };
+	static int gapsId = Shader::GetUniformId("gaps");
+	static int levelsId = Shader::GetUniformId("levels");
+	static int shadowCenterId = Shader::GetUniformId("shadowCenter");
+	static int camParasId = Shader::GetUniformId("camParas");
+	static int screenSizeId = Shader::GetUniformId("screenSize");
+	static int texNoiseId = Shader::GetUniformId("texNoise");
+	static int resolutionId = Shader::GetUniformId("uResolution");
+	static int environmentMapId = Shader::GetUniformId("environmentMap");
+
 	setState(state);
 	Shader* shader = state->shader;
 	if (drawcall->getType() == INSTANCE_DC || drawcall->getType() == MULTI_DC)
 		shader = state->shaderIns;
 	else if (drawcall->getType() == ANIMATE_DC) 
-		shader->setHandle64v("boneTex", AssetManager::assetManager->frames->animCount, AssetManager::assetManager->frames->datas);
+		shader->setHandle64v(boneTexId, AssetManager::assetManager->frames->animCount, AssetManager::assetManager->frames->datas);
 	
 	if (camera) {
+		// View, projection & eye come from camera block
+		if (camera != blockCamera) useCamera(camera, state->eyePos ? *(state->eyePos) : camera->position);
+
 		if (state->pass < DEFERRED_PASS) {
 			if (!state->skyPass && !state->atmoPass && !state->iblPass) {
-				shader->setMatrix4("viewProjectMatrix", camera->viewProjectMatrix);
+				shader->setMatrix4(viewProjectId, camera->viewProjectMatrix);
 				if (state->tess && state->grassPass) {
-					shader->setFloat("time", state->time * 0.025);
-					shader->setVector3v("eyePos", *(state->eyePos));
-					shader->setMatrix4("viewMatrix", camera->viewMatrix);
-					shader->setFloat("distortionId", AssetManager::assetManager->getDistortionTex());
-					shader->setFloat("quality", state->quality);
+					shader->setFloat(timeId, state->time * 0.025);
+					shader->setFloat(distortionId, AssetManager::assetManager->getDistortionTex());
+					shader->setFloat(qualityId, state->quality);
 				}
 
 				if (state->shaderCompute) {
-					state->shaderCompute->setMatrix4("viewProjectMatrix", camera->viewProjectMatrix);
+					state->shaderCompute->setMatrix4(viewProjectId, camera->viewProjectMatrix);
 					if(!state->grassPass)
-						state->shaderCompute->setFloat("isColor", state->pass >= COLOR_PASS ? 1.0 : 0.0);
+						state->shaderCompute->setFloat(isColorId, state->pass >= COLOR_PASS ? 1.0 : 0.0);
 					else {
-						state->shaderCompute->setVector3v("eyePos", *(state->eyePos));
-						state->shaderCompute->setMatrix4("viewMatrix", camera->viewMatrix);
-						state->shaderCompute->setHandle64("distortionTex", AssetManager::assetManager->getDistortionHnd());
-						state->shaderCompute->setHandle64("roadTex", AssetManager::assetManager->getRoadHnd());
-						state->shaderCompute->setHandle64("heightTex", AssetManager::assetManager->getHeightHnd());
-						state->shaderCompute->setHandle64("heightNormal", AssetManager::assetManager->getHeightNormalHnd());
-						state->shaderCompute->setFloat("time", state->time * 0.025);
-						state->shaderCompute->setFloat("quality", state->quality);
+						state->shaderCompute->setHandle64(distortionTexId, AssetManager::assetManager->getDistortionHnd());
+						state->shaderCompute->setHandle64(roadTexId, AssetManager::assetManager->getRoadHnd());
+						state->shaderCompute->setHandle64(heightTexId, AssetManager::assetManager->getHeightHnd());
+						state->shaderCompute->setHandle64(heightNormalId, AssetManager::assetManager->getHeightNormalHnd());
+						state->shaderCompute->setFloat(timeId, state->time * 0.025);
+						state->shaderCompute->setFloat(qualityId, state->quality);
 					}
 				}
 
 				if (drawcall->getType() == MULTI_DC) {
 					// Billboard drawcall
 					if (state->shaderBill) {
-						state->shaderBill->setMatrix4("viewProjectMatrix", camera->viewProjectMatrix);
+						state->shaderBill->setMatrix4(viewProjectId, camera->viewProjectMatrix);
 						if (state->pass != COLOR_PASS)
-							state->shaderBill->setVector3("viewRight", state->light.z, 0.0, -state->light.x);
+							state->shaderBill->setVector3(viewRightId, state->light.z, 0.0, -state->light.x);
 						else if (state->pass == COLOR_PASS) {
 							static vec3 upVec(0.0, 1.0, 0.0);
 							vec3 viewRight(camera->viewMatrix.entries[0], camera->viewMatrix.entries[4], camera->viewMatrix.entries[8]);
 							vec3 normal = (viewRight.CrossProduct(upVec)).GetNormalized();
 							normal = normal * 0.5 + 0.5;
-							state->shaderBill->setVector3v("uNormal", normal);
-							state->shaderBill->setVector3v("viewRight", viewRight);
+							state->shaderBill->setVector3v(normalId, normal);
+							state->shaderBill->setVector3v(viewRightId, viewRight);
 						}
 					}
 				}
 
 				if (state->waterPass) {
-					shader->setFloat("time", state->time);
-					shader->setVector3v("eyePos", *(state->eyePos));
-					shader->setVector3v("light", -state->light);
-					shader->setFloat("udotl", state->udotl);
-					shader->setMatrix4("viewMatrix", camera->viewMatrix);
+					shader->setFloat(timeId, state->time);
+					shader->setFloat(udotlId, state->udotl);
 					if (state->enableSsr)
-						shader->setVector2("waterBias", 0.0, 0.0);
+						shader->setVector2(waterBiasId, 0.0, 0.0);
 					else
-						shader->setVector2("waterBias", 0.05, -0.05);
+						shader->setVector2(waterBiasId, 0.05, -0.05);
 					if (AssetManager::assetManager->getEnvTexture() &&
 						!shader->isTexBinded(AssetManager::assetManager->getEnvTexture()->hnd))
-							shader->setHandle64("texEnv", AssetManager::assetManager->getEnvTexture()->hnd);
+							shader->setHandle64(texEnvId, AssetManager::assetManager->getEnvTexture()->hnd);
 					if (AssetManager::assetManager->getSkyTexture() &&
 						!shader->isTexBinded(AssetManager::assetManager->getSkyTexture()->hnd))
-							shader->setHandle64("texSky", AssetManager::assetManager->getSkyTexture()->hnd);
+							shader->setHandle64(texSkyId, AssetManager::assetManager->getSkyTexture()->hnd);
 					if (AssetManager::assetManager->getReflectTexture() &&
 						!shader->isTexBinded(AssetManager::assetManager->getReflectTexture()->hnd))
-							shader->setHandle64("texRef", AssetManager::assetManager->getReflectTexture()->hnd);
+							shader->setHandle64(texRefId, AssetManager::assetManager->getReflectTexture()->hnd);
 				}
 			} else if (state->skyPass) {
 				mat4 viewMat = camera->viewMatrix;
 				viewMat.entries[12] = 0.0, viewMat.entries[13] = 0.0, viewMat.entries[14] = 0.0;
-				shader->setMatrix4("viewProjectMatrix", camera->projectMatrix * viewMat);
+				shader->setMatrix4(viewProjectId, camera->projectMatrix * viewMat);
 				if (AssetManager::assetManager->getSkyTexture() &&
 					!shader->isTexBinded(AssetManager::assetManager->getSkyTexture()->hnd))
-						shader->setHandle64("texSky", AssetManager::assetManager->getSkyTexture()->hnd);
+						shader->setHandle64(texSkyId, AssetManager::assetManager->getSkyTexture()->hnd);
 			}
 		} else if (state->pass == DEFERRED_PASS) {
-			shader->setMatrix4("invViewProjMatrix", camera->invViewProjectMatrix);
-			shader->setMatrix4("invProjMatrix", camera->invProjMatrix);
-			shader->setMatrix4("viewMatrix", camera->viewMatrix);
-			shader->setVector3v("eyePos", *(state->eyePos));
-			shader->setFloat("time", state->time);
-
-			float invViewMat[9] = { camera->invViewMatrix[0], camera->invViewMatrix[1], camera->invViewMatrix[2],
-								camera->invViewMatrix[4], camera->invViewMatrix[5], camera->invViewMatrix[6],
-								camera->invViewMatrix[8], camera->invViewMatrix[9], camera->invViewMatrix[10] };
-			shader->setMatrix3("invViewMatrix", invViewMat);
+			shader->setFloat(timeId, state->time);
 
 			if (state->shadow) {
-				if (state->shadow->flushDyn) shader->setMatrix4("lightViewProjDyn", state->shadow->renderLightCameraDyn->viewProjectMatrix);
-				if (state->shadow->flushNear) shader->setMatrix4("lightViewProjNear", state->shadow->renderLightCameraNear->viewProjectMatrix);
-				if (state->shadow->flushMid) shader->setMatrix4("lightViewProjMid", state->shadow->renderLightCameraMid->viewProjectMatrix);
-				if (state->shadow->flushFar) shader->setMatrix4("lightViewProjFar", state->shadow->renderLightCameraFar->viewProjectMatrix);
-				shader->setVector2("gaps", state->shadow->gap, state->shadow->inv2Gap);
-				shader->setVector3("levels", state->shadow->level1, state->shadow->level2, state->shadow->radius);
-				shader->setVector3v("shadowCenter", state->shadow->renderLightCameraNear->position);
-			}
-			if (state->lightEffect) {
-				shader->setVector3("light", -state->light.x, -state->light.y, -state->light.z);
-				shader->setFloat("udotl", state->udotl);
+				if (state->shadow->flushDyn) shader->setMatrix4(lightViewProjIds[0], state->shadow->renderLightCameraDyn->viewProjectMatrix);
+				if (state->shadow->flushNear) shader->setMatrix4(lightViewProjIds[1], state->shadow->renderLightCameraNear->viewProjectMatrix);
+				if (state->shadow->flushMid) shader->setMatrix4(lightViewProjIds[2], state->shadow->renderLightCameraMid->viewProjectMatrix);
+				if (state->shadow->flushFar) shader->setMatrix4(lightViewProjIds[3], state->shadow->renderLightCameraFar->viewProjectMatrix);
+				shader->setVector2(gapsId, state->shadow->gap, state->shadow->inv2Gap);
+				shader->setVector3(levelsId, state->shadow->level1, state->shadow->level2, state->shadow->radius);
+				shader->setVector3v(shadowCenterId, state->shadow->renderLightCameraNear->position);
 			}
+			if (state->lightEffect) 
+				shader->setFloat(udotlId, state->udotl);
 		} else if (state->pass > DEFERRED_PASS && state->ssgPass) {
-			shader->setMatrix4("invProjMatrix", camera->invProjMatrix);
-			shader->setFloat("time", state->time);
+			shader->setFloat(timeId, state->time);
 		} else if (state->pass == POST_PASS) {
-			shader->setMatrix4("invViewProjMatrix", camera->invViewProjectMatrix);
-			shader->setVector3v("eyePos", *(state->eyePos));
-			shader->setFloat("udotl", state->udotl);
+			shader->setFloat(udotlId, state->udotl);
 		}
-		if (state->ssrPass) {
-			shader->setMatrix4("viewMatrix", camera->viewMatrix);
-			shader->setMatrix4("projectMatrix", camera->projectMatrix);
-			shader->setMatrix4("invProjMatrix", camera->invProjMatrix);
-			shader->setVector2("screenSize", viewWidth, viewHeight);
-		}
-
-		if (state->pass < COLOR_PASS) {
-			float invd = 1.0 / (camera->zFar - camera->zNear);
+		if (state->ssrPass) 
+			shader->setVector2(screenSizeId, viewWidth, viewHeight);
 
-			shader->setMatrix4("projectMatrix", camera->projectMatrix);
-			shader->setMatrix4("viewMatrix", camera->viewMatrix);
-			shader->setVector2("camPara", camera->zNear, invd);
-
-			if (state->shaderBill) {
-				state->shaderBill->setMatrix4("projectMatrix", camera->projectMatrix);
-				state->shaderBill->setMatrix4("viewMatrix", camera->viewMatrix);
-				state->shaderBill->setVector2("camPara", camera->zNear, invd);
-			}
-		} else if (state->pass == DEFERRED_PASS) {
+		if (state->pass == DEFERRED_PASS) {
 			if (state->shadow) {
 				float invdDyn = 1.0 / (state->shadow->renderLightCameraDyn->zFar - state->shadow->renderLightCameraDyn->zNear);
 				if (state->shadow->flushDyn) {
-					shader->setMatrix4("lightProjDyn", state->shadow->renderLightCameraDyn->projectMatrix);
-					shader->setMatrix4("lightViewDyn", state->shadow->renderLightCameraDyn->viewMatrix);
+					shader->setMatrix4(lightProjIds[0], state->shadow->renderLightCameraDyn->projectMatrix);
+					shader->setMatrix4(lightViewIds[0], state->shadow->renderLightCameraDyn->viewMatrix);
 				}
 				float invdNear = 1.0 / (state->shadow->renderLightCameraNear->zFar - state->shadow->renderLightCameraNear->zNear);
 				if (state->shadow->flushNear) {
-					shader->setMatrix4("lightProjNear", state->shadow->renderLightCameraNear->projectMatrix);
-					shader->setMatrix4("lightViewNear", state->shadow->renderLightCameraNear->viewMatrix);
+					shader->setMatrix4(lightProjIds[1], state->shadow->renderLightCameraNear->projectMatrix);
+					shader->setMatrix4(lightViewIds[1], state->shadow->renderLightCameraNear->viewMatrix);
 				}
 
 				float invdMid = 1.0 / (state->shadow->renderLightCameraMid->zFar - state->shadow->renderLightCameraMid->zNear);
 				if (state->shadow->flushMid) {
-					shader->setMatrix4("lightProjMid", state->shadow->renderLightCameraMid->projectMatrix);
-					shader->setMatrix4("lightViewMid", state->shadow->renderLightCameraMid->viewMatrix);
+					shader->setMatrix4(lightProjIds[2], state->shadow->renderLightCameraMid->projectMatrix);
+					shader->setMatrix4(lightViewIds[2], state->shadow->renderLightCameraMid->viewMatrix);
 				}
 
 				float invdFar = 1.0 / (state->shadow->renderLightCameraFar->zFar - state->shadow->renderLightCameraFar->zNear);
 				if (state->shadow->flushFar) {
-					shader->setMatrix4("lightProjFar", state->shadow->renderLightCameraFar->projectMatrix);
-					shader->setMatrix4("lightViewFar", state->shadow->renderLightCameraFar->viewMatrix);
+					shader->setMatrix4(lightProjIds[3], state->shadow->renderLightCameraFar->projectMatrix);
+					shader->setMatrix4(lightViewIds[3], state->shadow->renderLightCameraFar->viewMatrix);
 				}
 
 				float camParas[8] = { 
@@ -378,19 +310,19 @@ void Render::draw(Camera* camera,Drawcall* drawcall,RenderState* state) {
 					state->shadow->renderLightCameraMid->zNear, invdMid,
 					state->shadow->renderLightCameraFar->zNear, invdFar 
 				};
-				shader->setVector2v("camParas", 4, camParas);
+				shader->setVector2v(camParasId, 4, camParas);
 			}
 		}
 	} else {
 		if (state->atmoPass) {
 			if (AssetManager::assetManager->getNoiseTex() >= 0 &&
 				!shader->isTexBinded(AssetManager::assetManager->getNoiseHnd()))
-				shader->setHandle64("texNoise", AssetManager::assetManager->getNoiseHnd());
+				shader->setHandle64(texNoiseId, AssetManager::assetManager->getNoiseHnd());
 		} else if (state->iblPass) {
 			if (AssetManager::assetManager->getSkyTexture() &&
 				!shader->isTexBinded(AssetManager::assetManager->getSkyTexture()->hnd)) {
-					shader->setFloat("uResolution", AssetManager::assetManager->getSkyTexture()->getWidth());
-					shader->setHandle64("environmentMap", AssetManager::assetManager->getSkyTexture()->hnd);
+					shader->setFloat(resolutionId, AssetManager::assetManager->getSkyTexture()->getWidth());
+					shader->setHandle64(environmentMapId, AssetManager::assetManager->getSkyTexture()->hnd);
 			}
 		}
 	}
@@ -405,27 +337,27 @@ void Render::finishDraw() {
 
 void Render::setFrameBuffer(FrameBuffer* framebuffer) {
 	currentFrame = framebuffer;
-	if(framebuffer) framebuffer->use();
+	if(framebuffer) framebuffer->use(states);
 	else {
-		glBindFramebufferEXT(GL_FRAMEBUFFER_EXT,0);
+		states->bindFramebuffer(0);
 		clearFrame(true,true,false);
-		glViewport(0,0,viewWidth,viewHeight);
+		states->setViewport(0, 0, viewWidth, viewHeight);
 	}
 }
 
 void Render::useFrameBuffer(FrameBuffer* framebuffer) {
 	if (framebuffer) {
 		currentFrame = framebuffer;
-		currentFrame->useFbo();
+		currentFrame->useFbo(states);
 	}
 }
 
 void Render::useFrameCube(int i, int mip) {
-	if (currentFrame) currentFrame->useCube(i, mip);
+	if (currentFrame) currentFrame->useCube(states, i, mip);
 }
 
 void Render::setColorMask(bool r, bool g, bool b, bool a) {
-	glColorMask(r, g, b, a);
+	states->setColorMask(r, g, b, a);
 }
 
 int Render::getError() {
@@ -435,55 +367,42 @@ int Render::getError() {
 	return (int)error;
 }
 
+// Units hold one texture per target, tracking per unit only may rebind but never skips
 uint Render::useTexture(uint type, uint slot, uint texid) {
-	std::map<uint, std::map<uint, uint>*>::iterator typeItor = textureTypeSlots.find(type);
-	std::map<uint, uint>* textureInUse = NULL;
-	if (typeItor != textureTypeSlots.end())
-		textureInUse = typeItor->second;
-	else {
-		std::map<uint, uint>* slotMap = new std::map<uint, uint>();
-		textureTypeSlots[type] = slotMap;
-		slotMap->clear();
-		textureInUse = slotMap;
-	}
+	return states->bindTexture(slot, texid);
+}
 
-	int beforeTex = 0; // Default no texture use
-	std::map<uint, uint>::iterator texItor = textureInUse->find(slot);
-	if (texItor != textureInUse->end()) { // Can find before texture
-		beforeTex = texItor->second;
-		if (beforeTex == texid) return beforeTex;
-	}
+// Texture creation binds through the active unit behind tracker
+void Render::clearTextureSlots() {
+	states->invalidateTextures();
+}
 
-	GLenum textureType = GL_TEXTURE_2D;
-	switch (type) {
-		case TEXTURE_2D:
-			textureType = GL_TEXTURE_2D;
-			break;
-		case TEXTURE_2D_ARRAY:
-			textureType = GL_TEXTURE_2D_ARRAY;
-			break;
-		case TEXTURE_CUBE:
-			textureType = GL_TEXTURE_CUBE_MAP;
-			break;
-	}
-	glBindTextureUnit(slot, texid);
-	(*textureInUse)[slot] = texid;
+void Render::beginFrame() {
+	states->resetCounters();
+	clearTextureSlots();
+	blockCamera = NULL;
+	if (uploadRing) uploadRing->nextFrame();
+	if (gpuTimer) gpuTimer->beginFrame();
+}
 
-	return beforeTex;
+void Render::initUploadRing(const ConfigArg* cfgs) {
+	if (uploadRing || cfgs->ringsize <= 0) return;
+	uploadRing = new RingBuffer(cfgs->ringsize * 1024 * 1024);
+	RingBuffer::uploads = uploadRing;
 }
 
-void Render::clearTextureSlots() {
-	std::map<uint, std::map<uint, uint>*>::iterator itor = textureTypeSlots.begin();
-	while (itor != textureTypeSlots.end()) {
-		delete itor->second;
-		++itor;
-	}
-	textureTypeSlots.clear();
+void Render::initGpuTimer(const ConfigArg* cfgs) {
+	if (!gpuTimer && cfgs->profile) gpuTimer = new GpuTimer(new GLQueryBackend());
+}
+
+void Render::setDevice(RenderDevice* device) {
+	states->setDevice(device ? device : glDevice);
 }
 
 void Render::setTextureBindless2Shaders(TextureBindless* tex) {
+	static int texBldsId = Shader::GetUniformId("texBlds");
 	std::vector<Shader*>* shaders2Bind = shaders->getShaderBindTex();
 	for(uint i = 0; i<shaders2Bind->size(); i++)
-		(*shaders2Bind)[i]->setHandle64v("texBlds", tex->getSize(), tex->getHnds());
+		(*shaders2Bind)[i]->setHandle64v(texBldsId, tex->getSize(), tex->getHnds());
 }
 
@@ -13,6 +13,10 @@
 #include "../texture/texturebindless.h"
 #include "../render/shaderscontainer.h"
 #include "drawcall.h"
+#include "stateTracker.h"
+#include "ringBuffer.h"
+#include "gpuTimer.h"
+#include "uniformBuffer.h"
 
 #define TEXTURE_2D 1
 #define TEXTURE_2D_ARRAY 2
@@ -24,27 +28,20 @@ public:
 private:
 	void initEnvironment();
 public: // Global render state
-	bool enableCull;
-	int cullMode;
-	bool drawLine;
-	bool enableDepthTest;
-	int depthTestMode;
-	bool enableAlphaTest;
-	int alphaTestMode;
-	float alphaThreshold;
-	bool enableBlend;
-	bool enableColor;
-	COLOR clearColor;
-	Shader* currentShader;
+	StateTracker* states;
 private:
+	RenderDevice* glDevice;
 	bool debugMode;
 	bool debugTerrain;
 	bool drawFog;
 	ShaderManager* shaders;
 	FrameBuffer* currentFrame;
+	RingBuffer* uploadRing;
+	GpuTimer* gpuTimer;
+	UniformBuffer* cameraBlock;
+	Camera* blockCamera; // Camera whose matrices are in block
 public:
 	int viewWidth, viewHeight;
-	std::map<uint, std::map<uint, uint>*> textureTypeSlots;
 public:
 	Render();
 	~Render();
@@ -55,6 +52,7 @@ public:
 	void setCullState(bool enable);
 	void setCullMode(int mode);
 	void setDrawLine(bool line);
+	bool isDrawLine() { return states->isDrawLine(); }
 	void setBlend(bool enable);
 	void setColorWrite(bool enable);
 	void setClearColor(float r, float g, float b, float a);
@@ -62,6 +60,8 @@ public:
 	void resize(int width, int height, Camera* camera1, Camera* camera2, Camera* reflectCamera);
 	Shader* findShader(const char* shader);
 	void useShader(Shader* shader);
+	// Fill camera block at pass start, draws refill it only when camera switches
+	void useCamera(Camera* camera, const vec3& eyePos);
 	void draw(Camera* camera, Drawcall* drawcall, RenderState* state);
 	void finishDraw();
 	void setFrameBuffer(FrameBuffer* framebuffer);
@@ -71,23 +71,34 @@ public:
 	void setColorMask(bool r, bool g, bool b, bool a);
 	uint useTexture(uint type, uint slot, uint texid);
 	void clearTextureSlots();
+	void beginFrame();
+	// Route state calls through another device, NULL restores gl
+	void setDevice(RenderDevice* device);
 	void setTextureBindless2Shaders(TextureBindless* tex);
 	int getError();
 	void setDebug(bool debug) { debugMode = debug; }
 	bool getDebug() { return debugMode; }
 
 	void initShaders(const ConfigArg* cfgs) { SetupShaders(shaders, cfgs); }
+	void initUploadRing(const ConfigArg* cfgs);
+	void initGpuTimer(const ConfigArg* cfgs);
+	GpuTimer* getGpuTimer() { return gpuTimer; }
 	void setShaderInt(Shader* shader, const char* param, int value) {  shader->setInt(param, value); }
 	void setShaderUint(Shader* shader, const char* param, uint value) { shader->setUint(param, value); }
+	void setShaderUint(Shader* shader, int id, uint value) { shader->setUint(id, value); }
 	void setShaderUintv(Shader* shader, const char* param, int count, uint* arr) { shader->setUintv(param, count, arr); }
 	void setShaderSampler(Shader* shader, const char* param, int value) { shader->setSampler(param, value); }
 	void setShaderFloat(Shader* shader, const char* param, float value) { shader->setFloat(param, value); }
+	void setShaderFloat(Shader* shader, int id, float value) { shader->setFloat(id, value); }
 	void setShaderVec2(Shader* shader, const char* param, float x, float y) { shader->setVector2(param, x, y); }
+	void setShaderVec2(Shader* shader, int id, float x, float y) { shader->setVector2(id, x, y); }
 	void setShaderVec3(Shader* shader, const char* param, float x, float y, float z) { shader->setVector3(param, x, y, z); }
 	void setShaderUVec3(Shader* shader, const char* param, uint x, uint y, uint z) { shader->setUVector3(param, x, y, z); }
 	void setShaderUVec4(Shader* shader, const char* param, uint x, uint y, uint z, uint w) { shader->setUVector4(param, x, y, z, w); }
+	void setShaderUVec4(Shader* shader, int id, uint x, uint y, uint z, uint w) { shader->setUVector4(id, x, y, z, w); }
 	void setShaderUVec4v(Shader* shader, const char* param, int count, uint* arr) { shader->setUVector4v(param, count, arr); }
 	void setShaderIVec4(Shader* shader, const char* param, int x, int y, int z, int w) { shader->setIVector4(param, x, y, z, w); }
+	void setShaderIVec4(Shader* shader, int id, int x, int y, int z, int w) { shader->setIVector4(id, x, y, z, w); }
 	void setShaderVec4(Shader* shader, const char* param, float x, float y, float z, float w) { shader->setVector4(param, x, y, z, w); }
 	void setShaderVec2v(Shader* shader, const char* param, float* arr) { shader->setVector2v(param, arr); }
 	void setShaderVec2v(Shader* shader, const char* param, int count, float* arr) { shader->setVector2v(param, count, arr); }
@@ -95,6 +106,7 @@ public:
 	void setShaderVec4v(Shader* shader, const char* param, float* arr) { shader->setVector4v(param, arr); }
 	void setShaderVec4v(Shader* shader, const char* param, int count, float* arr) { shader->setVector4v(param, count, arr); }
 	void setShaderMat4(Shader* shader, const char* param, float* matrix) { shader->setMatrix4(param, matrix); }
+	void setShaderMat4(Shader* shader, int id, float* matrix) { shader->setMatrix4(id, matrix); }
 	void setShaderMat4(Shader* shader, const char* param, int count, float* matrices) { shader->setMatrix4(param, count, matrices); }
 	void setShaderMat3x4(Shader* shader, const char* param, int count, float* matrices) { shader->setMatrix3x4(param, count, matrices); }
 	void setShaderMat3(Shader* shader, const char* param, float* matrix) { shader->setMatrix3(param, matrix); }
@@ -3,6 +3,7 @@
 
 #include "glheader.h"
 #include "../constants/constants.h"
+#include "ringBuffer.h"
 
 const std::map<GLenum, uint> TypeSize = {
 	std::map<GLenum, uint>::value_type(GL_FLOAT, sizeof(GLfloat)),
@@ -93,7 +94,8 @@ struct RenderData {
 	void updateBuffer(uint count, void* data) {
 		dataSize = count * channelCount * rowCount;
 		streamData = data;
-		glNamedBufferSubData(bufferid, 0, dataSize * bitSize, streamData);
+		if (!streamData || !RingBuffer::uploads || !RingBuffer::uploads->upload(bufferid, 0, dataSize * bitSize, streamData))
+			glNamedBufferSubData(bufferid, 0, dataSize * bitSize, streamData);
 	}
 	void updateBufferMap(GLenum target, uint count, void* data) {
 		int mapSize = count * channelCount * rowCount;
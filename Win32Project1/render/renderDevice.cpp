@@ -0,0 +1,86 @@
+#include "renderDevice.h"
+#include "glheader.h"
+
+static GLenum GetCompareFunc(int mode) {
+	switch (mode) {
+		case LESS: return GL_LESS;
+		case LEQUAL: return GL_LEQUAL;
+		case GREATER: return GL_GREATER;
+		case GEQUAL: return GL_GEQUAL;
+		case ALWAYS: return GL_ALWAYS;
+	}
+	return GL_LESS;
+}
+
+void GLDevice::setCap(int cap, bool enable) {
+	GLenum glCap = GL_DEPTH_TEST;
+	switch (cap) {
+		case CAP_DEPTH_TEST: glCap = GL_DEPTH_TEST; break;
+		case CAP_ALPHA_TEST: glCap = GL_ALPHA_TEST; break;
+		case CAP_CULL: glCap = GL_CULL_FACE; break;
+		case CAP_BLEND: glCap = GL_BLEND; break;
+	}
+	if (enable) glEnable(glCap);
+	else glDisable(glCap);
+}
+
+void GLDevice::depthFunc(int mode) {
+	glDepthFunc(GetCompareFunc(mode));
+}
+
+void GLDevice::alphaFunc(int mode, float threshold) {
+	glAlphaFunc(GetCompareFunc(mode), threshold);
+}
+
+void GLDevice::cullFace(int mode) {
+	switch (mode) {
+		case CULL_BACK:
+			glCullFace(GL_BACK);
+			break;
+		case CULL_FRONT:
+			glCullFace(GL_FRONT);
+			break;
+		case CULL_NONE:
+			glCullFace(GL_NONE);
+			break;
+		case CULL_ALL:
+			glCullFace(GL_FRONT_AND_BACK);
+			break;
+	}
+}
+
+void GLDevice::polygonMode(bool line) {
+	glPolygonMode(GL_FRONT_AND_BACK, line ? GL_LINE : GL_FILL);
+}
+
+void GLDevice::colorMask(bool r, bool g, bool b, bool a) {
+	glColorMask(r, g, b, a);
+}
+
+void GLDevice::clearColor(float r, float g, float b, float a) {
+	glClearColor(r, g, b, a);
+}
+
+void GLDevice::clear(bool color, bool depth, bool stencil) {
+	GLbitfield clearMask = 0;
+	if (color) clearMask |= GL_COLOR_BUFFER_BIT;
+	if (depth) clearMask |= GL_DEPTH_BUFFER_BIT;
+	if (stencil) clearMask |= GL_STENCIL_BUFFER_BIT;
+	glClear(clearMask);
+}
+
+void GLDevice::viewport(int x, int y, int width, int height) {
+	glViewport(x, y, width, height);
+}
+
+void GLDevice::useProgram(uint program) {
+	glUseProgram(program);
+}
+
+void GLDevice::bindTexture(uint unit, uint texture) {
+	glBindTextureUnit(unit, texture);
+}
+
+void GLDevice::bindFramebuffer(uint fbo) {
+	glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+}
@@ -0,0 +1,49 @@
+#ifndef RENDER_DEVICE_H_
+#define RENDER_DEVICE_H_
+
+#include "../constants/constants.h"
+
+#define CAP_DEPTH_TEST 0
+#define CAP_ALPHA_TEST 1
+#define CAP_CULL 2
+#define CAP_BLEND 3
+#define CAP_COUNT 4
+
+// Thin dispatch of the gl calls render state goes through,
+// modes use glheader defines (LESS, CULL_BACK ...) not gl enums
+class RenderDevice {
+public:
+	virtual ~RenderDevice() {}
+	virtual void setCap(int cap, bool enable) = 0;
+	virtual void depthFunc(int mode) = 0;
+	virtual void alphaFunc(int mode, float threshold) = 0;
+	virtual void cullFace(int mode) = 0;
+	virtual void polygonMode(bool line) = 0;
+	virtual void colorMask(bool r, bool g, bool b, bool a) = 0;
+	virtual void clearColor(float r, float g, float b, float a) = 0;
+	virtual void clear(bool color, bool depth, bool stencil) = 0;
+	virtual void viewport(int x, int y, int width, int height) = 0;
+	virtual void useProgram(uint program) = 0;
+	virtual void bindTexture(uint unit, uint texture) = 0;
+	virtual void bindFramebuffer(uint fbo) = 0;
+};
+
+class GLDevice : public RenderDevice {
+public:
+	GLDevice() {}
+	virtual ~GLDevice() {}
+	virtual void setCap(int cap, bool enable);
+	virtual void depthFunc(int mode);
+	virtual void alphaFunc(int mode, float threshold);
+	virtual void cullFace(int mode);
+	virtual void polygonMode(bool line);
+	virtual void colorMask(bool r, bool g, bool b, bool a);
+	virtual void clearColor(float r, float g, float b, float a);
+	virtual void clear(bool color, bool depth, bool stencil);
+	virtual void viewport(int x, int y, int width, int height);
+	virtual void useProgram(uint program);
+	virtual void bindTexture(uint unit, uint texture);
+	virtual void bindFramebuffer(uint fbo);
+};
+
+#endif
@@ -2,6 +2,9 @@
 #include "../assets/assetManager.h"
 #include "../mesh/board.h"
 #include "../object/staticObject.h"
+#include "../util/profiler.h"
+#include <algorithm>
+using namespace std;
 
 RenderManager::RenderManager(ConfigArg* cfg, Scene* scene, float distance1, float distance2, const vec3& light) {
 	depthPre = LOW_PRE;
@@ -43,13 +46,21 @@ RenderManager::RenderManager(ConfigArg* cfg, Scene* scene, float distance1, floa
 	lightDir = light.GetNormalized();
 	queue1 = new Renderable(distance1, distance2, cfgs);
 	queue2 = new Renderable(distance1, distance2, cfgs);
-	currentQueue = queue1;
-	nextQueue = queue2;
-	renderData = NULL;
+	queue3 = new Renderable(distance1, distance2, cfgs);
+	frames[0] = queue1, frames[1] = queue2, frames[2] = queue3;
+	for (uint i = 0; i < 3; i++) frames[i]->setShadowMapSizes(nearSize, midSize, farSize);
+	currentQueue = frames[frameSwap.getFront()];
+	renderData = cfgs->dualthread ? frames[frameSwap.getBack()] : NULL;
 
 	debugQueue = new RenderQueue(QUEUE_DEBUG, distance1, distance2, cfgs);
 
 	state = new RenderState();
+	cullPool = (cfgs->cpucull || cfgs->occlusion) ? new ThreadPool() : NULL;
+	state->cullPool = cfgs->cpucull ? cullPool : NULL;
+	occlusion = cfgs->occlusion ? new OcclusionBuffer() : NULL;
+	occluderTerrain = NULL;
+	shadowCacheNear = cfgs->shadowcache ? new ShadowCache() : NULL;
+	shadowCacheMid = cfgs->shadowcache ? new ShadowCache() : NULL;
 
 	reflectBuffer = NULL;
 	needResize = true;
@@ -60,6 +71,8 @@ RenderManager::RenderManager(ConfigArg* cfg, Scene* scene, float distance1, floa
 
 	grassDrawcall = NULL;
 	hiz = new HizGenerator();
+	hizBlock = new UniformBuffer(96);
+	passBlock = new UniformBuffer(32);
 	prevCameraMat.LoadIdentity();
 	hizDepth = NULL;
 	ibl = NULL;
@@ -74,14 +87,23 @@ RenderManager::~RenderManager() {
 
 	delete queue1; queue1 = NULL;
 	delete queue2; queue2 = NULL;
+	delete queue3; queue3 = NULL;
 	delete debugQueue; debugQueue = NULL;
 
 	delete state; state = NULL;
 	if (reflectBuffer) delete reflectBuffer; reflectBuffer = NULL;
 	if (grassDrawcall) delete grassDrawcall; grassDrawcall = NULL;
 	if (hiz) delete hiz; hiz = NULL;
+	if (hizBlock) delete hizBlock; hizBlock = NULL;
+	if (passBlock) delete passBlock; passBlock = NULL;
 	if (hizDepth) delete hizDepth; hizDepth = NULL;
 	if (ibl) delete ibl; ibl = NULL;
+	if (occlusion) delete occlusion; occlusion = NULL;
+	if (cullPool) delete cullPool; cullPool = NULL;
+	if (shadowCacheNear) delete shadowCacheNear; shadowCacheNear = NULL;
+	if (shadowCacheMid) delete shadowCacheMid; shadowCacheMid = NULL;
+	terrainPoints.clear();
+	terrainIndices.clear();
 }
 
 void RenderManager::resize(float width, float height) {
@@ -126,7 +148,11 @@ void RenderManager::flushRenderQueues() {
 }
 
 void RenderManager::updateRenderQueues(Scene* scene) {
-	if (!renderData) return;
+	PROFILE_SCOPE("updateRenderQueues");
+	if (!renderData) {
+		scene->clearChangedNodes();
+		return;
+	}
 
 	Camera* cameraDyn = shadow->actLightCameraDyn;
 	Camera* cameraNear = shadow->actLightCameraNear;
@@ -135,32 +161,141 @@ void RenderManager::updateRenderQueues(Scene* scene) {
 	Camera* cameraMain = scene->actCamera;
 
 	PushNodeToQueue(renderData->queues[QUEUE_DYNAMIC_SN], scene, scene->staticRoot, cameraDyn, cameraMain);
-	PushNodeToQueue(renderData->queues[QUEUE_STATIC_SN], scene, scene->staticRoot, cameraNear, cameraMain);
-	PushNodeToQueue(renderData->queues[QUEUE_STATIC_SM], scene, scene->staticRoot, cameraMid, cameraMain);
+	if (shadowCacheNear && shadowCacheMid) {
+		PushShadowCacheToQueue(renderData->queues[QUEUE_STATIC_SN], scene, shadowCacheNear, cameraNear, cameraMain, shadow->lightDir);
+		PushShadowCacheToQueue(renderData->queues[QUEUE_STATIC_SM], scene, shadowCacheMid, cameraMid, cameraMain, shadow->lightDir);
+	} else {
+		PushNodeToQueue(renderData->queues[QUEUE_STATIC_SN], scene, scene->staticRoot, cameraNear, cameraMain);
+		PushNodeToQueue(renderData->queues[QUEUE_STATIC_SM], scene, scene->staticRoot, cameraMid, cameraMain);
+	}
 	//PushNodeToQueue(renderData->queues[QUEUE_STATIC_SF], scene, scene->staticRoot, cameraFar, cameraMain);
-	PushNodeToQueue(renderData->queues[QUEUE_STATIC], scene, scene->staticRoot, cameraMain, cameraMain);
+	if (occlusion) drawOccluders(scene, cameraMain);
+	PushNodeToQueue(renderData->queues[QUEUE_STATIC], scene, scene->staticRoot, cameraMain, cameraMain, occlusion);
 	PushNodeToQueue(renderData->queues[QUEUE_ANIMATE_SN], scene, scene->animationRoot, cameraDyn, cameraMain);
 	PushNodeToQueue(renderData->queues[QUEUE_ANIMATE_SM], scene, scene->animationRoot, cameraMid, cameraMain);
 	//PushNodeToQueue(renderData->queues[QUEUE_ANIMATE_SF], scene, scene->animationRoot, cameraFar, cameraMain);
-	PushNodeToQueue(renderData->queues[QUEUE_ANIMATE], scene, scene->animationRoot, cameraMain, cameraMain);
+	PushNodeToQueue(renderData->queues[QUEUE_ANIMATE], scene, scene->animationRoot, cameraMain, cameraMain, occlusion);
 	
 	if (cfgs->debug && scene->isInited()) PushDebugToQueue(debugQueue, scene, cameraMain);
+	scene->clearChangedNodes();
+}
+
+// Coarse terrain kept under real surface, each vertex takes lowest height of cells around it
+static void BuildTerrainOccluder(TerrainNode* terrain, vector<float>& points, vector<int>& indices) {
+	points.clear();
+	indices.clear();
+	vec4* vertices = terrain->getMesh()->vertices;
+	int lineSize = terrain->lineSize, line = lineSize + 1;
+	int count = (lineSize + OCCLUDER_TERRAIN_STEP - 1) / OCCLUDER_TERRAIN_STEP + 1;
+	for (int i = 0; i < count; i++) {
+		int ci = min(i * OCCLUDER_TERRAIN_STEP, lineSize);
+		for (int j = 0; j < count; j++) {
+			int cj = min(j * OCCLUDER_TERRAIN_STEP, lineSize);
+			float lowest = vertices[ci * line + cj].y;
+			for (int di = max(ci - OCCLUDER_TERRAIN_STEP, 0); di <= min(ci + OCCLUDER_TERRAIN_STEP, lineSize); di++) {
+				for (int dj = max(cj - OCCLUDER_TERRAIN_STEP, 0); dj <= min(cj + OCCLUDER_TERRAIN_STEP, lineSize); dj++)
+					lowest = min(lowest, vertices[di * line + dj].y);
+			}
+			vec4 v = vertices[ci * line + cj];
+			vec3 p = terrain->offset + mul(terrain->offsize, vec3(v.x, lowest, v.z));
+			points.push_back(p.x);
+			points.push_back(p.y);
+			points.push_back(p.z);
+		}
+	}
+	for (int i = 0; i < count - 1; i++) {
+		for (int j = 0; j < count - 1; j++) {
+			int a = i * count + j, b = a + 1, c = a + count, d = c + 1;
+			indices.push_back(a), indices.push_back(c), indices.push_back(b);
+			indices.push_back(b), indices.push_back(c), indices.push_back(d);
+		}
+	}
+}
+
+// Opaque faces of still meshes small enough to raster every frame
+static bool IsOccluder(Object* object) {
+	Mesh* mesh = object->mesh;
+	if (!mesh || !object->bounding || object->billboard || object->isDynamic()) return false;
+	return !mesh->isBillboard && mesh->normalFaces.size() > 0 && mesh->indexCount <= OCCLUDER_MAX_INDICES;
+}
+
+static void GatherOccluders(Node* node, Camera* camera, vector<pair<float, Object*> >& candidates) {
+	if (!node->checkInCamera(camera)) return;
+	for (uint i = 0; i < node->children.size(); ++i) {
+		Node* child = node->children[i];
+		if (child->objects.size() <= 0) GatherOccluders(child, camera, candidates);
+		else if (child->type == TYPE_STATIC || child->type == TYPE_INSTANCE) {
+			for (uint j = 0; j < child->objects.size(); ++j) {
+				Object* object = child->objects[j];
+				if (!IsOccluder(object) || !object->sphereInCamera(camera)) continue;
+				float distance = (camera->position - object->bounding->position).GetLength();
+				float size = ((AABB*)object->bounding)->radius / (distance > 1.0 ? distance : 1.0);
+				if (size >= OCCLUDER_MIN_SIZE)
+					candidates.push_back(pair<float, Object*>(size, object));
+			}
+		}
+	}
+}
+
+// Raster terrain & nearest big meshes on workers before main queues test nodes against them
+void RenderManager::drawOccluders(Scene* scene, Camera* camera) {
+	PROFILE_SCOPE("drawOccluders");
+	occlusion->begin(camera->viewProjectMatrix);
+	if (scene->terrainNode) {
+		if (occluderTerrain != scene->terrainNode) {
+			BuildTerrainOccluder(scene->terrainNode, terrainPoints, terrainIndices);
+			occluderTerrain = scene->terrainNode;
+		}
+		occlusion->addTriangles(&terrainPoints[0], 3, &terrainIndices[0], (int)terrainIndices.size(), NULL);
+	}
+
+	vector<pair<float, Object*> > candidates;
+	GatherOccluders(scene->staticRoot, camera, candidates);
+	sort(candidates.begin(), candidates.end());
+	int drawn = 0;
+	for (int i = (int)candidates.size() - 1; i >= 0 && drawn < OCCLUDER_MAX_OBJECTS; i--, drawn++) {
+		Object* object = candidates[i].second;
+		Mesh* mesh = object->mesh;
+		for (uint f = 0; f < mesh->normalFaces.size(); f++) {
+			FaceBuf* buf = mesh->normalFaces[f];
+			occlusion->addTriangles((float*)mesh->vertices, 4, mesh->indices + buf->start, buf->count, &object->transformMatrix);
+		}
+	}
+	occlusion->rasterize(cullPool);
 }
 
 void RenderManager::animateQueues(float velocity) {
+	PROFILE_SCOPE("animate");
 	currentQueue->queues[QUEUE_ANIMATE_SN]->animate(velocity);
 	currentQueue->queues[QUEUE_ANIMATE_SM]->animate(velocity);
 	currentQueue->queues[QUEUE_ANIMATE_SF]->animate(velocity);
 	currentQueue->queues[QUEUE_ANIMATE]->animate(velocity);
 }
 
-void RenderManager::swapRenderQueues(Scene* scene, bool swapQueue) {
+// Update thread, hand filled queues & cameras to render thread without waiting
+void RenderManager::publishRenderQueues(Scene* scene) {
+	if (!renderData) return;
+	renderData->camera->copy(scene->actCamera);
+	renderData->lightCameras[0]->copy(shadow->actLightCameraDyn);
+	renderData->lightCameras[1]->copy(shadow->actLightCameraNear);
+	renderData->lightCameras[2]->copy(shadow->actLightCameraMid);
+	renderData->lightCameras[3]->copy(shadow->actLightCameraFar);
+	renderData->showWater = actShowWater;
+	renderData = frames[frameSwap.publish()];
+}
+
+// Render thread, false if no newer frame published when swapping
+bool RenderManager::swapRenderQueues(Scene* scene, bool swapQueue) {
 	if (swapQueue) {
-		currentQueue = (currentQueue == queue1) ? queue2 : queue1;
-		nextQueue = (nextQueue == queue1) ? queue2 : queue1;
-		renderData = nextQueue;
-		scene->renderCamera->copy(scene->actCamera);
-		shadow->copyCameraData();
+		if (!frameSwap.acquire()) return false;
+		currentQueue = frames[frameSwap.getFront()];
+		scene->renderCamera->copy(currentQueue->camera);
+		shadow->renderLightCameraDyn->copy(currentQueue->lightCameras[0]);
+		shadow->renderLightCameraNear->copy(currentQueue->lightCameras[1]);
+		shadow->renderLightCameraMid->copy(currentQueue->lightCameras[2]);
+		shadow->renderLightCameraFar->copy(currentQueue->lightCameras[3]);
+		renderShowWater = currentQueue->showWater;
+		return true;
 	} else {
 		currentQueue = queue1;
 		renderData = currentQueue;
@@ -171,6 +306,7 @@ void RenderManager::swapRenderQueues(Scene* scene, bool swapQueue) {
 		shadow->mergeCamera();
 	}
 	renderShowWater = actShowWater;
+	return true;
 }
 
 void RenderManager::prepareData(Scene* scene) {
@@ -189,6 +325,7 @@ void RenderManager::updateDebugData(Scene* scene) {
 }
 
 void RenderManager::renderShadow(Render* render, Scene* scene) {
+	PROFILE_PASS(render, "renderShadow");
 	if (cfgs->shadowQuality < 1) return;
 
 	static Shader* phongShadowShader = render->findShader("phong_s");
@@ -310,20 +447,17 @@ void RenderManager::drawGrass(Render* render, RenderState* state, Scene* scene,
 			grassDrawcall = new ComputeDrawcall(&terrainData, grassCount);
 		}
 		static Shader* grassShader = render->findShader("grass");
-		Shader* compShader = render->findShader("grassComp");
+		static Shader* compShader = render->findShader("grassComp");
+		static int mapTransId = Shader::GetUniformId("mapTrans");
+		static int mapScaleId = Shader::GetUniformId("mapScale");
 
 		state->shader = grassShader;
 		state->shaderCompute = compShader;
 		state->eyePos = &(camera->position);
 
 		StaticObject* terrain = (StaticObject*)node->objects[0];
-		compShader->setVector3v("mapTrans", GetTranslate(terrain->transformMatrix));
-		compShader->setVector3v("mapScale", terrain->size);
-		compShader->setVector4("mapInfo", STEP_SIZE, node->lineSize, MAP_SIZE, MAP_SIZE);
-		compShader->setFloat("uMaxLevel", hiz->getMaxLevel());
-		compShader->setMatrix4("prevVPMatrix", prevCameraMat);
-		compShader->setVector2("uSize", (float)render->viewWidth, (float)render->viewHeight);
-		compShader->setVector2("uCamParam", camera->zNear, camera->zFar);
+		compShader->setVector3v(mapTransId, GetTranslate(terrain->transformMatrix));
+		compShader->setVector3v(mapScaleId, terrain->size);
 
 		grassDrawcall->update();
 		render->draw(camera, grassDrawcall, state);
@@ -340,6 +474,8 @@ void RenderManager::drawGrass(Render* render, RenderState* state, Scene* scene,
 }
 
 void RenderManager::renderScene(Render* render, Scene* scene) {
+	PROFILE_PASS(render, "renderScene");
+	updatePassBlock(scene);
 	static Shader* phongShader = render->findShader("phong");
 	static Shader* phongInsShader = render->findShader("phong_ins");
 	static Shader* billInsShader = render->findShader("bill_ins");
@@ -361,6 +497,8 @@ void RenderManager::renderScene(Render* render, Scene* scene) {
 	state->dynSky = cfgs->dynsky;
 
 	Camera* camera = scene->renderCamera;
+	updateHizBlock(render, camera);
+	render->useCamera(camera, camera->position);
 
 	// Draw terrain & grass
 	TerrainNode* terrainNode = scene->terrainNode;
@@ -368,6 +506,11 @@ void RenderManager::renderScene(Render* render, Scene* scene) {
 		static Shader* terrainShader = render->findShader("terrain");
 		static Shader* debugTerrainShader = render->findShader("terrain_debug");
 		static Shader* terrainCullShader = render->findShader("terrainComp");
+		static int refChunkId = Shader::GetUniformId("refChunk");
+		static int mapTransId = Shader::GetUniformId("mapTrans");
+		static int mapScaleId = Shader::GetUniformId("mapScale");
+		static int roadTexId = Shader::GetUniformId("roadTex");
+		static int debugMidId = Shader::GetUniformId("uDebugMid");
 
 		StaticObject* terrain = (StaticObject*)terrainNode->objects[0];
 		state->mapTrans = GetTranslate(terrain->transformMatrix);
@@ -375,26 +518,21 @@ void RenderManager::renderScene(Render* render, Scene* scene) {
 		state->mapInfo = vec4(STEP_SIZE, terrainNode->lineSize, MAP_SIZE, MAP_SIZE);
 		
 		render->useTexture(TEXTURE_2D, 0, hizDepth->id);
-		terrainCullShader->setFloat("uMaxLevel", hiz->getMaxLevel());
-		terrainCullShader->setMatrix4("prevVPMatrix", prevCameraMat);
-		terrainCullShader->setVector2("uSize", (float)render->viewWidth, (float)render->viewHeight);
-		terrainCullShader->setVector2("uCamParam", camera->zNear, camera->zFar);
 
 		vec3 ref = ((camera->position - state->mapTrans) / state->mapScl) / CHUNK_SIZE;
-		terrainCullShader->setIVector2("refChunk", floor(ref.x), floor(ref.z));
-		terrainCullShader->setVector3v("mapTrans", state->mapTrans);
-		terrainCullShader->setVector3v("mapScale", state->mapScl);
+		terrainCullShader->setIVector2(refChunkId, floor(ref.x), floor(ref.z));
+		terrainCullShader->setVector3v(mapTransId, state->mapTrans);
+		terrainCullShader->setVector3v(mapScaleId, state->mapScl);
 		state->shaderCompute = terrainCullShader;
 		((TerrainDrawcall*)terrainNode->drawcall)->update(camera, render, state);
 		state->shaderCompute = NULL;
 		
 		state->shader = render->getDebugTerrain() ? debugTerrainShader : terrainShader;
-		state->shader->setVector3v("mapTrans", state->mapTrans);
-		state->shader->setVector3v("mapScale", state->mapScl);
-		state->shader->setVector4("mapInfo", STEP_SIZE, terrainNode->lineSize, MAP_SIZE, MAP_SIZE);
-		state->shader->setHandle64("roadTex", AssetManager::assetManager->getRoadHnd());
+		state->shader->setVector3v(mapTransId, state->mapTrans);
+		state->shader->setVector3v(mapScaleId, state->mapScl);
+		state->shader->setHandle64(roadTexId, AssetManager::assetManager->getRoadHnd());
 		if (render->getDebugTerrain())
-			state->shader->setInt("uDebugMid", MaterialManager::materials->find(BLUE_MAT));
+			state->shader->setInt(debugMidId, MaterialManager::materials->find(BLUE_MAT));
 		render->draw(camera, terrainNode->drawcall, state);
 
 		if (/*!cfgs->cartoon && */!cfgs->debug && !render->getDebugTerrain()) 
@@ -409,20 +547,12 @@ void RenderManager::renderScene(Render* render, Scene* scene) {
 	state->shaderFlush = flushShader;
 	render->useTexture(TEXTURE_2D, 0, hizDepth->id);
 
-	state->shaderMulti->setFloat("uMaxLevel", hiz->getMaxLevel());
-	state->shaderMulti->setMatrix4("prevVPMatrix", prevCameraMat);
-	state->shaderMulti->setVector2("uSize", (float)render->viewWidth, (float)render->viewHeight);
-	state->shaderMulti->setVector2("uCamParam", camera->zNear, camera->zFar);
 	currentQueue->queues[QUEUE_STATIC]->draw(scene, camera, render, state);
 
 	state->shader = boneShader;
 	state->shaderMulti = animMultiShader;
 	state->shaderFlush = animFlushShader;
 
-	state->shaderMulti->setFloat("uMaxLevel", hiz->getMaxLevel());
-	state->shaderMulti->setMatrix4("prevVPMatrix", prevCameraMat);
-	state->shaderMulti->setVector2("uSize", (float)render->viewWidth, (float)render->viewHeight);
-	state->shaderMulti->setVector2("uCamParam", camera->zNear, camera->zFar);
 	currentQueue->queues[QUEUE_ANIMATE]->draw(scene, camera, render, state);
 
 	// Draw sky
@@ -439,10 +569,6 @@ void RenderManager::renderScene(Render* render, Scene* scene) {
 		state->drawLine = true;
 		state->enableAlphaTest = false;
 
-		state->shaderMulti->setFloat("uMaxLevel", hiz->getMaxLevel());
-		state->shaderMulti->setMatrix4("prevVPMatrix", prevCameraMat);
-		state->shaderMulti->setVector2("uSize", (float)render->viewWidth, (float)render->viewHeight);
-		state->shaderMulti->setVector2("uCamParam", camera->zNear, camera->zFar);
 
 		debugQueue->draw(scene, camera, render, state);
 	}
@@ -451,13 +577,32 @@ void RenderManager::renderScene(Render* render, Scene* scene) {
 	if (needResize) needResize = false;
 }
 
+// Hi-z cull constants shared by all cull shaders, one upload per frame
+void RenderManager::updateHizBlock(Render* render, Camera* camera) {
+	hizBlock->setMatrix4(0, prevCameraMat);
+	hizBlock->setVector2(64, (float)render->viewWidth, (float)render->viewHeight);
+	hizBlock->setVector2(72, camera->zNear, camera->zFar);
+	hizBlock->setFloat(80, hiz->getMaxLevel());
+	hizBlock->use(HIZ_BLOCK_BINDING);
+}
+
+// Terrain map info & light direction read by terrain, grass, sky & deferred shaders
+void RenderManager::updatePassBlock(Scene* scene) {
+	if (scene->terrainNode) 
+		passBlock->setVector4(0, STEP_SIZE, scene->terrainNode->lineSize, MAP_SIZE, MAP_SIZE);
+	passBlock->setVector3(16, -lightDir.x, -lightDir.y, -lightDir.z);
+	passBlock->use(PASS_BLOCK_BINDING);
+}
+
 void RenderManager::renderSkyTex(Render* render, Scene* scene) {
+	PROFILE_PASS(render, "renderSkyTex");
+	updatePassBlock(scene);
 	if (!scene->skyBox) return;
 	if (needRefreshSky) {
 		static Shader* atmoShader = render->findShader("atmos");
 		scene->skyBox->state->time = scene->time;
 		scene->skyBox->state->udotl = udotl;
-		scene->skyBox->update(render, lightDir, atmoShader);
+		scene->skyBox->update(render, atmoShader);
 
 		if (!ibl) ibl = new Ibl(scene);
 		static bool needRefreshIbl = true;
@@ -476,16 +621,16 @@ void RenderManager::renderSkyTex(Render* render, Scene* scene) {
 }
 
 void RenderManager::renderWater(Render* render, Scene* scene) {
+	PROFILE_PASS(render, "renderWater");
 	static Shader* waterCullShader = render->findShader("waterComp");
 	static Shader* waterShader = render->findShader("water");
+	static int sizeId = Shader::GetUniformId("size");
 	Camera* camera = scene->renderCamera;
 
 	state->reset();
 	render->useTexture(TEXTURE_2D, 0, hizDepth->id);
-	waterCullShader->setFloat("uMaxLevel", hiz->getMaxLevel());
-	waterCullShader->setMatrix4("prevVPMatrix", prevCameraMat);
-	waterCullShader->setVector2("uSize", (float)render->viewWidth, (float)render->viewHeight);
-	waterCullShader->setVector2("uCamParam", camera->zNear, camera->zFar);
+	updateHizBlock(render, camera);
+	render->useCamera(camera, camera->position);
 	state->shaderCompute = waterCullShader;
 	((WaterDrawcall*)(scene->water->drawcall))->update(camera, render, state);
 	state->shaderCompute = NULL;
@@ -498,17 +643,21 @@ void RenderManager::renderWater(Render* render, Scene* scene) {
 	state->waterPass = true;
 	state->shader = waterShader;
 
-	waterShader->setVector2("size", scene->water->size.x * 0.5, scene->water->size.y * 0.5);
+	waterShader->setVector2(sizeId, scene->water->size.x * 0.5, scene->water->size.y * 0.5);
 	render->draw(camera, scene->water->drawcall, state);
 }
 
 void RenderManager::renderReflect(Render* render, Scene* scene) {
+	PROFILE_PASS(render, "renderReflect");
+	updatePassBlock(scene);
 	if (!scene->water || !scene->reflectCamera || !reflectBuffer) return;
 	render->setFrameBuffer(reflectBuffer);
 	if (scene->terrainNode) {
 		if (scene->terrainNode->checkInCamera(scene->reflectCamera)) {
 			if (scene->terrainNode->drawcall) {
 				static Shader* terrainShader = render->findShader("terrain");
+				static int isReflectId = Shader::GetUniformId("isReflect");
+				static int waterHeightId = Shader::GetUniformId("waterHeight");
 				state->reset();
 				state->eyePos = &(scene->renderCamera->position);
 				state->cullMode = CULL_FRONT;
@@ -516,17 +665,23 @@ void RenderManager::renderReflect(Render* render, Scene* scene) {
 				state->udotl = udotl;
 				state->shader = terrainShader;
 				
-				render->setShaderFloat(terrainShader, "isReflect", 1.0);
-				render->setShaderFloat(terrainShader, "waterHeight", scene->water->position.y);
+				render->setShaderFloat(terrainShader, isReflectId, 1.0);
+				render->setShaderFloat(terrainShader, waterHeightId, scene->water->position.y);
 				render->draw(scene->reflectCamera, scene->terrainNode->drawcall, state);
-				render->setShaderFloat(terrainShader, "isReflect", 0.0);
+				render->setShaderFloat(terrainShader, isReflectId, 0.0);
 			}
 		}
 	}
 }
 
 void RenderManager::drawDeferred(Render* render, Scene* scene, FrameBuffer* screenBuff, Filter* filter) {
+	PROFILE_PASS(render, "drawDeferred");
+	updatePassBlock(scene);
 	static Shader* deferredShader = render->findShader("deferred");
+	static int shadowBuffersId = Shader::GetUniformId("shadowBuffers");
+	static int irradianceId = Shader::GetUniformId("irradianceMap");
+	static int prefilteredId = Shader::GetUniformId("prefilteredMap");
+	static int brdfId = Shader::GetUniformId("brdfMap");
 	state->reset();
 	state->eyePos = &(scene->renderCamera->position);
 	state->enableDepthTest = false;
@@ -545,20 +700,21 @@ void RenderManager::drawDeferred(Render* render, Scene* scene, FrameBuffer* scre
 		!deferredShader->isTexBinded(farBuffer->getDepthBuffer()->hnd)) {
 		u64 shadowTexs[4] = { nearDynamicBuffer->getDepthBuffer()->hnd, nearStaticBuffer->getDepthBuffer()->hnd,
 				midBuffer->getDepthBuffer()->hnd, farBuffer->getDepthBuffer()->hnd };
-			deferredShader->setHandle64v("shadowBuffers", 4, shadowTexs);
+			deferredShader->setHandle64v(shadowBuffersId, 4, shadowTexs);
 	}
 
 	if (ibl && !deferredShader->isTexBinded(ibl->getIrradianceTex()->hnd))
-		deferredShader->setHandle64("irradianceMap", ibl->getIrradianceTex()->hnd);
+		deferredShader->setHandle64(irradianceId, ibl->getIrradianceTex()->hnd);
 	if (ibl && !deferredShader->isTexBinded(ibl->getPrefilteredTex()->hnd))
-		deferredShader->setHandle64("prefilteredMap", ibl->getPrefilteredTex()->hnd);
+		deferredShader->setHandle64(prefilteredId, ibl->getPrefilteredTex()->hnd);
 	if (ibl && !deferredShader->isTexBinded(ibl->getBrdf()->hnd))
-		deferredShader->setHandle64("brdfMap", ibl->getBrdf()->hnd);
+		deferredShader->setHandle64(brdfId, ibl->getBrdf()->hnd);
 
 	filter->draw(scene->renderCamera, render, state, screenBuff->colorBuffers, screenBuff->depthBuffer);
 }
 
 void RenderManager::drawCombined(Render* render, Scene* scene, const std::vector<Texture2D*>& inputTextures, Filter* filter) {
+	PROFILE_PASS(render, "drawCombined");
 	static Shader* combinedShader = render->findShader("combined");
 	static Shader* combinedNFGShader = render->findShader("combined_nfg");
 	state->reset();
@@ -572,6 +728,7 @@ void RenderManager::drawCombined(Render* render, Scene* scene, const std::vector
 }
 
 void RenderManager::drawScreenFilter(Render* render, Scene* scene, const char* shaderStr, FrameBuffer* inputBuff, Filter* filter) {
+	PROFILE_PASS(render, shaderStr);
 	Shader* shader = render->findShader(shaderStr);
 	state->reset();
 	state->eyePos = &(scene->renderCamera->position);
@@ -583,6 +740,7 @@ void RenderManager::drawScreenFilter(Render* render, Scene* scene, const char* s
 }
 
 void RenderManager::drawScreenFilter(Render* render, Scene* scene, const char* shaderStr, Texture2D* inputTexture, Filter* filter) {
+	PROFILE_PASS(render, shaderStr);
 	Shader* shader = render->findShader(shaderStr);
 	state->reset();
 	state->eyePos = &(scene->renderCamera->position);
@@ -593,13 +751,15 @@ void RenderManager::drawScreenFilter(Render* render, Scene* scene, const char* s
 }
 
 void RenderManager::drawScreenFilter(Render* render, Scene* scene, const char* shaderStr, const std::vector<Texture2D*>& inputTextures, Filter* filter) {
+	PROFILE_PASS(render, shaderStr);
+	static int camParamId = Shader::GetUniformId("uCamParam");
 	Shader* shader = render->findShader(shaderStr);
 	state->reset();
 	state->eyePos = &(scene->renderCamera->position);
 	state->enableDepthTest = false;
 	state->pass = POST_PASS;
 	state->shader = shader;
-	state->shader->setVector2("uCamParam", scene->renderCamera->zNear, scene->renderCamera->zFar);
+	state->shader->setVector2(camParamId, scene->renderCamera->zNear, scene->renderCamera->zFar);
 	filter->draw(scene->renderCamera, render, state, inputTextures, NULL);
 }
 
@@ -609,6 +769,7 @@ void RenderManager::drawDualFilter(Render* render, Scene* scene, const char* sha
 }
 
 void RenderManager::drawSSRFilter(Render* render, Scene* scene, const char* shaderStr, const std::vector<Texture2D*>& inputTextures, Filter* filter) {
+	PROFILE_PASS(render, shaderStr);
 	Shader* shader = render->findShader(shaderStr);
 	state->reset();
 	state->eyePos = &(scene->renderCamera->position);
@@ -621,6 +782,7 @@ void RenderManager::drawSSRFilter(Render* render, Scene* scene, const char* shad
 }
 
 void RenderManager::drawSSGFilter(Render* render, Scene* scene, const char* shaderStr, const std::vector<Texture2D*>& inputTextures, Filter* filter) {
+	PROFILE_PASS(render, shaderStr);
 	Shader* shader = render->findShader(shaderStr);
 	state->reset();
 	state->eyePos = &(scene->renderCamera->position);
@@ -634,12 +796,13 @@ void RenderManager::drawSSGFilter(Render* render, Scene* scene, const char* shad
 
 void RenderManager::drawTexture2Screen(Render* render, Scene* scene, u64 texhnd) {
 	static Shader* screenShader = render->findShader("screen");
+	static int texId = Shader::GetUniformId("tex");
 	state->reset();
 	state->eyePos = &(scene->renderCamera->position);
 	state->enableDepthTest = false;
 	state->pass = POST_PASS;
 	state->shader = screenShader;
-	state->shader->setHandle64("tex", texhnd);
+	state->shader->setHandle64(texId, texhnd);
 
 	if (!scene->textureNode) {
 		Board board(2, 2, 2);
@@ -656,13 +819,15 @@ void RenderManager::drawTexture2Screen(Render* render, Scene* scene, u64 texhnd)
 
 void RenderManager::drawDepth2Screen(Render* render, Scene* scene, int texid) {
 	static Shader* screenShader = render->findShader("depth");
+	static int levelId = Shader::GetUniformId("uLevel");
+	static int camParamId = Shader::GetUniformId("uCamParam");
 	state->reset();
 	state->eyePos = &(scene->renderCamera->position);
 	state->enableDepthTest = false;
 	state->pass = POST_PASS;
 	state->shader = screenShader;
-	state->shader->setFloat("uLevel", 0);
-	state->shader->setVector2("uCamParam", scene->renderCamera->zNear, scene->renderCamera->zFar);
+	state->shader->setFloat(levelId, 0);
+	state->shader->setVector2(camParamId, scene->renderCamera->zNear, scene->renderCamera->zFar);
 
 	if (!scene->textureNode) {
 		Board board(2, 2, 2);
@@ -680,6 +845,7 @@ void RenderManager::drawDepth2Screen(Render* render, Scene* scene, int texid) {
 }
 
 void RenderManager::genHiz(Render* render, Scene* scene, Texture2D* depth) {
+	PROFILE_PASS(render, "genHiz");
 	hizDepth->copyDataFrom(depth);
 	static Shader* hizShader = render->findShader("hiz");
 	hiz->genMipmap(render, hizShader, hizDepth);
@@ -699,6 +865,7 @@ bool RenderManager::isWaterShow(Render* render, const Scene* scene) {
 }
 
 void RenderManager::drawNoise3d(Render* render, Scene* scene, FrameBuffer* noiseBuf) {
+	static int viewProjectId = Shader::GetUniformId("viewProjectMatrix");
 	mat4 proj = perspective(90.0, 1.0, 0.5, 10.0);
 	mat4 matPosx = proj * viewMat(vec3(0.0f, 0.0f, 1.0f), vec3(0.0f, 1.0f, 0.0f), vec3(-1.0f, 0.0f, 0.0f), vec3(0.0, 0.0, 0.0));
 	mat4 matNegx = proj * viewMat(vec3(0.0f, 0.0f, -1.0f), vec3(0.0f, 1.0f, 0.0f), vec3(1.0f, 0.0f, 0.0f), vec3(0.0, 0.0, 0.0));
@@ -729,26 +896,26 @@ void RenderManager::drawNoise3d(Render* render, Scene* scene, FrameBuffer* noise
 	render->useFrameBuffer(noiseBuf);
 
 	render->useFrameCube(0, 0);
-	render->setShaderMat4(state.shader, "viewProjectMatrix", matPosx);
+	render->setShaderMat4(state.shader, viewProjectId, matPosx);
 	render->draw(NULL, node->drawcall, &state);
 
 	render->useFrameCube(1, 0);
-	render->setShaderMat4(state.shader, "viewProjectMatrix", matNegx);
+	render->setShaderMat4(state.shader, viewProjectId, matNegx);
 	render->draw(NULL, node->drawcall, &state);
 
 	render->useFrameCube(2, 0);
-	render->setShaderMat4(state.shader, "viewProjectMatrix", matPosy);
+	render->setShaderMat4(state.shader, viewProjectId, matPosy);
 	render->draw(NULL, node->drawcall, &state);
 
 	render->useFrameCube(3, 0);
-	render->setShaderMat4(state.shader, "viewProjectMatrix", matNegy);
+	render->setShaderMat4(state.shader, viewProjectId, matNegy);
 	render->draw(NULL, node->drawcall, &state);
 
 	render->useFrameCube(4, 0);
-	render->setShaderMat4(state.shader, "viewProjectMatrix", matPosz);
+	render->setShaderMat4(state.shader, viewProjectId, matPosz);
 	render->draw(NULL, node->drawcall, &state);
 
 	render->useFrameCube(5, 0);
-	render->setShaderMat4(state.shader, "viewProjectMatrix", matNegz);
+	render->setShaderMat4(state.shader, viewProjectId, matNegz);
 	render->draw(NULL, node->drawcall, &state);
 }
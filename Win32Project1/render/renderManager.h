@@ -12,12 +12,30 @@
 #include "../filter/filter.h"
 #include "../render/renderQueue.h"
 #include "../render/computeDrawcall.h"
+#include "../render/uniformBuffer.h"
+#include "../util/tripleBuffer.h"
+#include "../util/threadPool.h"
 #include "../texture/hizGenerator.h"
 #include "../ibl/ibl.h"
 
+#define LIGHT_CAMERA_COUNT 4
+
+#define OCCLUDER_MAX_OBJECTS 32 // Largest on screen static meshes drawn as occluders
+#define OCCLUDER_MAX_INDICES 6000
+#define OCCLUDER_MIN_SIZE 0.08 // Bounding radius / distance
+#define OCCLUDER_TERRAIN_STEP 8 // Terrain blocks merged into one occluder cell
+
 struct Renderable {
 	std::vector<RenderQueue*> queues;
+	// Snapshot taken with queues, render thread draws with it
+	Camera* camera;
+	Camera* lightCameras[LIGHT_CAMERA_COUNT];
+	bool showWater;
 	Renderable(float midDis, float lowDis, ConfigArg* cfg) {
+		camera = new Camera(0.0);
+		for (uint i = 0; i < LIGHT_CAMERA_COUNT; i++)
+			lightCameras[i] = new Camera(0.0);
+		showWater = false;
 		queues.clear();
 		for (uint i = 0; i < QUEUE_SIZE; i++) 
 			queues.push_back(new RenderQueue(i, midDis, lowDis, cfg));
@@ -30,9 +48,18 @@ struct Renderable {
 		queues[QUEUE_ANIMATE_SM]->shadowLevel = 2;
 		queues[QUEUE_ANIMATE_SF]->shadowLevel = 3;
 	}
+	void setShadowMapSizes(float nearSize, float midSize, float farSize) {
+		for (uint i = 0; i < queues.size(); i++) {
+			int level = queues[i]->shadowLevel;
+			queues[i]->shadowMapSize = level == 1 ? nearSize : (level == 2 ? midSize : (level == 3 ? farSize : 0.0));
+		}
+	}
 	~Renderable() {
 		for (uint i = 0; i < queues.size(); i++)
 			delete queues[i];
+		delete camera;
+		for (uint i = 0; i < LIGHT_CAMERA_COUNT; i++)
+			delete lightCameras[i];
 	}
 	void flush() {
 		for (uint i = 0; i < queues.size(); i++)
@@ -55,17 +82,31 @@ private:
 	bool needResize, needRefreshSky, actShowWater, renderShowWater;
 	ComputeDrawcall* grassDrawcall;
 	mat4 prevCameraMat;
+	UniformBuffer* hizBlock;
+	UniformBuffer* passBlock;
+	ThreadPool* cullPool;
+	OcclusionBuffer* occlusion;
+	TerrainNode* occluderTerrain;
+	std::vector<float> terrainPoints;
+	std::vector<int> terrainIndices;
+	ShadowCache* shadowCacheNear;
+	ShadowCache* shadowCacheMid;
 private:
 	RenderQueue* debugQueue;
 public:
-	Renderable* renderData;
+	Renderable* renderData; // Filled by update thread
 	Renderable* queue1;
 	Renderable* queue2;
-	Renderable* currentQueue;
-	Renderable* nextQueue;
+	Renderable* queue3;
+	Renderable* currentQueue; // Drawn by render thread
+	Renderable* frames[3];
+	TripleBuffer frameSwap;
 private:
 	void drawGrass(Render* render, RenderState* state, Scene* scene, Camera* camera);
 	void updateWaterVisible(const Scene* scene);
+	void updateHizBlock(Render* render, Camera* camera);
+	void updatePassBlock(Scene* scene);
+	void drawOccluders(Scene* scene, Camera* camera);
 private:
 	FrameBuffer* nearStaticBuffer;
 	FrameBuffer* nearDynamicBuffer;
@@ -84,7 +125,8 @@ public:
 	void flushRenderQueues();
 	void updateRenderQueues(Scene* scene);
 	void animateQueues(float velocity);
-	void swapRenderQueues(Scene* scene, bool swapQueue);
+	bool swapRenderQueues(Scene* scene, bool swapQueue);
+	void publishRenderQueues(Scene* scene);
 	void prepareData(Scene* scene);
 	void updateDebugData(Scene* scene);
 	void renderShadow(Render* render,Scene* scene);
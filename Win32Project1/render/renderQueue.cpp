@@ -4,6 +4,7 @@
 #include "../node/instanceNode.h"
 #include "../assets/assetManager.h"
 #include "../scene/scene.h"
+#include "../util/profiler.h"
 #include <string.h>
 #include <stdlib.h>
 using namespace std;
@@ -24,6 +25,7 @@ RenderQueue::RenderQueue(int type, float midDis, float lowDis, ConfigArg* cfg) {
 	midDistSqr = powf(midDis, 2);
 	lowDistSqr = powf(lowDis, 2);
 	shadowLevel = 0;
+	shadowMapSize = 0.0, shadowTexelScale = 0.0;
 	firstFlush = true;
 	cfgArgs = cfg;
 }
@@ -52,8 +54,8 @@ RenderQueue::~RenderQueue() {
 	if (instanceDebug) delete instanceDebug;
 }
 
-void RenderQueue::push(Node* node) {
-	queue->push(node);
+void RenderQueue::push(Node* node, u64 key) {
+	queue->push(node, key);
 }
 
 void RenderQueue::pushAnim(Node* node) {
@@ -105,11 +107,36 @@ void RenderQueue::pushDatasToBatch(BatchData* data, int pass) {
 	data->batch->setRenderData(pass, data);
 }
 
+// Object material overrides, else first material of its vertices
+static uint BatchMaterial(int objectMaterial, const vector<int>& materials) {
+	if (objectMaterial >= 0) return objectMaterial + 1;
+	return materials.size() > 0 ? materials[0] + 1 : 0;
+}
+
+// Batches are added to multi instance in key order instead of map pointer order
+static void SortBatches(vector<u64>& keys, vector<void*>& batches) {
+	int count = (int)batches.size();
+	if (count < 2) return;
+	vector<u64> tmpKeys(count);
+	vector<void*> tmpBatches(count);
+	RadixSortKeys(&keys[0], &batches[0], &tmpKeys[0], &tmpBatches[0], count);
+}
+
 void RenderQueue::createInstances(Scene* scene) {
 	if (!multiInstance || !multiInstance->inited()) {
-		map<Mesh*, InstanceData*>::iterator itData = instanceQueue.begin();
-		while (itData != instanceQueue.end()) {
+		vector<u64> keys;
+		vector<void*> datas;
+		for (uint i = 0; i < scene->meshes.size(); ++i) {
+			map<Mesh*, InstanceData*>::iterator itData = instanceQueue.find(scene->meshes[i]->mesh);
+			if (itData == instanceQueue.end()) continue;
 			InstanceData* data = itData->second;
+			keys.push_back(MakeBatchKey(TYPE_INSTANCE, BatchMaterial(data->object->material, data->insMesh->materialList), i));
+			datas.push_back(data);
+		}
+		SortBatches(keys, datas);
+
+		for (uint i = 0; i < datas.size(); ++i) {
+			InstanceData* data = (InstanceData*)datas[i];
 			pushDatasToInstance(scene, data, false);
 			Instance* instance = data->instance;
 			if (instance) {
@@ -134,7 +161,6 @@ void RenderQueue::createInstances(Scene* scene) {
 					}
 				}
 			}
-			++itData;
 		}
 	}
 
@@ -183,6 +209,7 @@ void RenderQueue::createInstances(Scene* scene) {
 }
 
 void RenderQueue::draw(Scene* scene, Camera* camera, Render* render, RenderState* state) {
+	queue->sort();
 	for (int it = 0; it < queue->size; it++) {
 		Node* node = queue->get(it);
 
@@ -222,12 +249,20 @@ void RenderQueue::draw(Scene* scene, Camera* camera, Render* render, RenderState
 	}
 
 	if (!animations || !animations->inited()) {
-		map<Animation*, AnimationData*>::iterator itAnim = animationQueue.begin();
-		while (itAnim != animationQueue.end()) {
-			AnimationData* data = itAnim->second;
+		vector<u64> keys;
+		vector<void*> datas;
+		for (uint i = 0; i < scene->anims.size(); ++i) {
+			Animation* anim = scene->anims[i];
+			map<Animation*, AnimationData*>::iterator itAnim = animationQueue.find(anim);
+			if (itAnim == animationQueue.end()) continue;
+			keys.push_back(MakeBatchKey(TYPE_ANIMATE, BatchMaterial(-1, anim->aMids), i));
+			datas.push_back(itAnim->second);
+		}
+		SortBatches(keys, datas);
+
+		for (uint i = 0; i < datas.size(); ++i) {
 			if (!animations) animations = new MultiInstance();
-			if (!animations->inited()) animations->add(data);
-			++itAnim;
+			if (!animations->inited()) animations->add((AnimationData*)datas[i]);
 		}
 	}
 
@@ -272,6 +307,23 @@ Mesh* RenderQueue::queryLodMesh(Object* object, const vec3& eye) {
 	return mesh;
 }
 
+// Coarser lod for small or far cascade shadows, NULL if object casts no shadow
+Mesh* RenderQueue::queryShadowLodMesh(Object* object, const vec3& eye) {
+	float e2oDis = (eye - object->bounding->position).GetSquaredLength();
+	int viewLod = e2oDis > lowDistSqr ? LOD_LOW : (e2oDis > midDistSqr ? LOD_MID : LOD_HIGH);
+	int lod = SelectShadowLod(viewLod, ((AABB*)object->bounding)->radius, shadowTexelScale, GetShadowLodRule(shadowLevel));
+	if (lod == SHADOW_LOD_DROP) return NULL;
+
+	Mesh* meshes[3] = { object->mesh, object->meshMid, object->meshLow };
+	while (lod > viewLod && !meshes[lod]) lod--; // Coarser mesh missing
+	return meshes[lod];
+}
+
+bool RenderQueue::isShadowTooSmall(Object* object) {
+	if (shadowLevel <= 0 || !object->bounding) return false;
+	return SelectShadowLod(LOD_HIGH, ((AABB*)object->bounding)->radius, shadowTexelScale, GetShadowLodRule(shadowLevel)) == SHADOW_LOD_DROP;
+}
+
 void PushDebugToQueue(RenderQueue* queue, Scene* scene, Camera* camera) {
 	if (queue->instanceDebug == NULL) {
 		if (scene->boundingNodes.size() <= 0) return;
@@ -294,68 +346,192 @@ void PushDebugToQueue(RenderQueue* queue, Scene* scene, Camera* camera) {
 	}
 }
 
-void PushNodeToQueue(RenderQueue* queue, Scene* scene, Node* node, Camera* camera, Camera* mainCamera) {
-	if (queue->firstFlush) {
-		if (queue->queueType == QUEUE_DYNAMIC_SN ||
-			queue->queueType == QUEUE_STATIC_SN || queue->queueType == QUEUE_STATIC_SM || 
-			queue->queueType == QUEUE_STATIC_SF || queue->queueType == QUEUE_STATIC) {
-			for (uint i = 0; i < scene->meshes.size(); ++i) {
-				Mesh* mesh = scene->meshes[i]->mesh;
-				Object* object = scene->meshes[i]->object;
-				InstanceData* insData = new InstanceData(mesh, object, scene->queryMeshCount(mesh));
-				queue->instanceQueue.insert(pair<Mesh*, InstanceData*>(mesh, insData));
-			}
-		} else if (queue->queueType == QUEUE_ANIMATE_SN || queue->queueType == QUEUE_ANIMATE_SM || 
-				queue->queueType == QUEUE_ANIMATE_SF || queue->queueType == QUEUE_ANIMATE) {
-			map<Animation*, uint>::iterator it = scene->animCount.begin();
-			while (it != scene->animCount.end()) {
-				Animation* anim = it->first;
-				AnimationData* animData = new AnimationData(anim, it->second);
-				queue->animationQueue.insert(pair<Animation*, AnimationData*>(anim, animData));
-				++it;
-			}
-		}
-		queue->firstFlush = false;
+static void RequestMaterialTextures(TextureBindless* texBld, int mid, float screenSize) {
+	Material* mat = MaterialManager::materials->find(mid);
+	if (!mat) return;
+	if (mat->texids.x >= 0) texBld->requestTexture((int)mat->texids.x, screenSize);
+	if (mat->texids.y >= 0) texBld->requestTexture((int)mat->texids.y, screenSize);
+	if (mat->texids.z >= 0) texBld->requestTexture((int)mat->texids.z, screenSize);
+	if (mat->texids.w >= 0) texBld->requestTexture((int)mat->texids.w, screenSize);
+}
+
+// Tell texture streaming how large object textures appear in main view
+static void RequestObjectTextures(RenderQueue* queue, Object* object, Mesh* mesh, Camera* mainCamera) {
+	TextureBindless* texBld = AssetManager::assetManager->texBld;
+	if (!texBld || !texBld->isStreaming() || !object->bounding) return;
+	float distance = (mainCamera->position - object->bounding->position).GetLength();
+	float screenSize = ProjectedScreenSize(((AABB*)object->bounding)->radius, distance, 
+		mainCamera->fovy, (float)queue->cfgArgs->height);
+	if (object->material >= 0) 
+		RequestMaterialTextures(texBld, object->material, screenSize);
+	else if (mesh) {
+		for (uint m = 0; m < mesh->materialList.size(); m++)
+			RequestMaterialTextures(texBld, mesh->materialList[m], screenSize);
+	}
+	if (object->billboard) 
+		RequestMaterialTextures(texBld, object->billboard->material, screenSize);
+}
+
+// Node type picks shader in draw, water blends over the scene
+static u64 MakeNodeKey(Node* node, Camera* camera) {
+	int layer = node->type == TYPE_WATER ? SORT_LAYER_TRANSPARENT : SORT_LAYER_OPAQUE;
+	uint material = 0, mesh = 0;
+	if (node->objects.size() > 0) {
+		Object* object = node->objects[0];
+		material = object->material + 1;
+		mesh = (uint)(((size_t)object->mesh >> 4) & 0xffff);
 	}
+	float depth = 0.0;
+	if (node->boundingBox) 
+		depth = (node->boundingBox->position - camera->position).GetLength() / camera->zFar;
+	return MakeSortKey(layer, node->type, material, mesh, depth);
+}
+
+static bool IsMainQueue(RenderQueue* queue) {
+	return queue->queueType == QUEUE_STATIC || queue->queueType == QUEUE_ANIMATE;
+}
 
-	if (node->checkInCamera(camera)) {
+// Terrain is an occluder itself & water draws over it, test others only
+static bool PassOcclusion(OcclusionBuffer* occlusion, Node* node) {
+	if (!occlusion || !node->boundingBox || node->type == TYPE_TERRAIN || node->type == TYPE_WATER) return true;
+	AABB* box = (AABB*)node->boundingBox;
+	return occlusion->testBox(box->minVertex, box->maxVertex);
+}
+
+static void PushInstanceObject(RenderQueue* queue, Object* object, Camera* mainCamera) {
+	Mesh* mesh = queue->shadowLevel > 0 ? queue->queryShadowLodMesh(object, mainCamera->position) : 
+		queue->queryLodMesh(object, mainCamera->position);
+	if (!mesh) return;
+	if (queue->shadowLevel > 0 && !mesh->drawShadow) return;
+	InstanceData* insData = queue->instanceQueue[mesh];
+	insData->addInstance(object);
+	if (IsMainQueue(queue)) RequestObjectTextures(queue, object, mesh, mainCamera);
+}
+
+// Records pushed nodes & instance objects into cache if given, dynamic objects are left to PushDynamicObjects then
+static void PushNode(RenderQueue* queue, Scene* scene, Node* node, Camera* camera, Camera* mainCamera, OcclusionBuffer* occlusion, ShadowCache* cache) {
+	if (node->checkInCamera(camera) && PassOcclusion(occlusion, node)) {
 		for (unsigned int i = 0; i<node->children.size(); ++i) {
 			Node* child = node->children[i];
 			if (child->objects.size() <= 0)
-				PushNodeToQueue(queue, scene, child, camera, mainCamera);
+				PushNode(queue, scene, child, camera, mainCamera, occlusion, cache);
 			else {
 				if (child->shadowLevel < queue->shadowLevel) continue;
 
-				if (child->checkInCamera(camera)) {
-					if (child->type != TYPE_INSTANCE && child->type != TYPE_STATIC && child->type != TYPE_ANIMATE)
-						queue->push(child);
-					else if (child->type == TYPE_INSTANCE) {
+				if (child->checkInCamera(camera) && PassOcclusion(occlusion, child)) {
+					if (child->type != TYPE_INSTANCE && child->type != TYPE_STATIC && child->type != TYPE_ANIMATE) {
+						u64 key = MakeNodeKey(child, camera);
+						queue->push(child, key);
+						if (cache) cache->addNode(child, key);
+						if (IsMainQueue(queue)) {
+							for (uint j = 0; j < child->objects.size(); ++j)
+								RequestObjectTextures(queue, child->objects[j], child->objects[j]->mesh, mainCamera);
+						}
+					} else if (child->type == TYPE_INSTANCE) {
 						for (uint j = 0; j < child->objects.size(); ++j) {
 							Object* object = child->objects[j];
+							if (cache && object->isDynamic()) continue;
 							if (queue->queueType == QUEUE_DYNAMIC_SN && !object->isDynamic()) continue;
 							else if (queue->queueType == QUEUE_STATIC_SN && object->isDynamic()) continue;
 
 							if (queue->shadowLevel > 0 && !object->genShadow) continue;
 							if (object->sphereInCamera(camera)) {
-								Mesh* mesh = queue->queryLodMesh(object, mainCamera->position);
-								if (!mesh) continue;
-								if (queue->shadowLevel > 0 && !mesh->drawShadow) continue;
-								InstanceData* insData = queue->instanceQueue[mesh];
-								insData->addInstance(object);
+								if (occlusion && object->bounding) {
+									AABB* box = (AABB*)object->bounding;
+									if (!occlusion->testBox(box->minVertex, box->maxVertex)) continue;
+								}
+								if (cache) cache->addObject(object);
+								PushInstanceObject(queue, object, mainCamera);
 							}
 						}
 					} else if (child->type == TYPE_ANIMATE) {
-						if (child->objects.size() > 0) {
+						if (child->objects.size() > 0 && !queue->isShadowTooSmall(child->objects[0])) {
 							queue->pushAnim(child);
 							AnimationNode* animNode = (AnimationNode*)child;
 							Animation* anim = animNode->getObject()->animation;
 							AnimationData* animData = queue->animationQueue[anim];
 							animData->addAnimObject(animNode->getObject());
+							if (IsMainQueue(queue)) RequestObjectTextures(queue, animNode->getObject(), NULL, mainCamera);
 							animNode->animate(scene->velocity);
 						}
-					} 
+					} else if (child->type == TYPE_STATIC && IsMainQueue(queue)) {
+						for (uint j = 0; j < child->objects.size(); ++j)
+							RequestObjectTextures(queue, child->objects[j], child->objects[j]->mesh, mainCamera);
+					}
 				}
 			}
 		}
 	}
+}
+
+static void PrepareQueue(RenderQueue* queue, Scene* scene, Camera* camera) {
+	if (queue->shadowLevel > 0) queue->shadowTexelScale = ShadowTexelScale(camera->projectMatrix, queue->shadowMapSize);
+	if (queue->firstFlush) {
+		if (queue->queueType == QUEUE_DYNAMIC_SN ||
+			queue->queueType == QUEUE_STATIC_SN || queue->queueType == QUEUE_STATIC_SM || 
+			queue->queueType == QUEUE_STATIC_SF || queue->queueType == QUEUE_STATIC) {
+			for (uint i = 0; i < scene->meshes.size(); ++i) {
+				Mesh* mesh = scene->meshes[i]->mesh;
+				Object* object = scene->meshes[i]->object;
+				InstanceData* insData = new InstanceData(mesh, object, scene->queryMeshCount(mesh));
+				queue->instanceQueue.insert(pair<Mesh*, InstanceData*>(mesh, insData));
+			}
+		} else if (queue->queueType == QUEUE_ANIMATE_SN || queue->queueType == QUEUE_ANIMATE_SM || 
+				queue->queueType == QUEUE_ANIMATE_SF || queue->queueType == QUEUE_ANIMATE) {
+			map<Animation*, uint>::iterator it = scene->animCount.begin();
+			while (it != scene->animCount.end()) {
+				Animation* anim = it->first;
+				AnimationData* animData = new AnimationData(anim, it->second);
+				queue->animationQueue.insert(pair<Animation*, AnimationData*>(anim, animData));
+				++it;
+			}
+		}
+		queue->firstFlush = false;
+	}
+}
+
+void PushNodeToQueue(RenderQueue* queue, Scene* scene, Node* node, Camera* camera, Camera* mainCamera, OcclusionBuffer* occlusion) {
+	PROFILE_SCOPE("PushNodeToQueue");
+	PrepareQueue(queue, scene, camera);
+	PushNode(queue, scene, node, camera, mainCamera, occlusion, NULL);
+}
+
+static void GatherDynamicNodes(Node* node, ShadowCache* cache) {
+	for (uint i = 0; i < node->children.size(); ++i) {
+		Node* child = node->children[i];
+		if (child->objects.size() <= 0) GatherDynamicNodes(child, cache);
+		else if (child->type == TYPE_INSTANCE && HasDynamicObject(child)) cache->addDynamicNode(child);
+	}
+}
+
+static void PushDynamicObjects(RenderQueue* queue, ShadowCache* cache, Camera* camera, Camera* mainCamera) {
+	for (uint i = 0; i < cache->dynamicNodes.size(); ++i) {
+		Node* node = cache->dynamicNodes[i];
+		if (node->shadowLevel < queue->shadowLevel || !node->checkInCamera(camera)) continue;
+		for (uint j = 0; j < node->objects.size(); ++j) {
+			Object* object = node->objects[j];
+			if (!object->isDynamic() || (queue->shadowLevel > 0 && !object->genShadow)) continue;
+			if (object->sphereInCamera(camera)) PushInstanceObject(queue, object, mainCamera);
+		}
+	}
+}
+
+// Static cascades replay cached cull result, tree is traversed only when cache is invalid
+void PushShadowCacheToQueue(RenderQueue* queue, Scene* scene, ShadowCache* cache, Camera* camera, Camera* mainCamera, const vec3& light) {
+	PROFILE_SCOPE("PushShadowCacheToQueue");
+	PrepareQueue(queue, scene, camera);
+	uint nodesVersion = scene->nodesVersion;
+	if (!cache->isValid(camera, light, nodesVersion, scene->changedNodes)) {
+		PROFILE_SCOPE("rebuildShadowCache");
+		cache->begin(camera, light, nodesVersion);
+		PushNode(queue, scene, scene->staticRoot, cache->getCullCamera(), mainCamera, NULL, cache);
+		GatherDynamicNodes(scene->staticRoot, cache);
+	} else {
+		for (uint i = 0; i < cache->nodes.size(); ++i)
+			queue->push(cache->nodes[i], cache->keys[i]);
+		for (uint i = 0; i < cache->objects.size(); ++i)
+			PushInstanceObject(queue, cache->objects[i], mainCamera);
+	}
+	// Near cascade leaves dynamic objects to QUEUE_DYNAMIC_SN
+	if (queue->queueType != QUEUE_STATIC_SN) PushDynamicObjects(queue, cache, camera, mainCamera);
 }
\ No newline at end of file
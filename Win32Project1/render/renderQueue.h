@@ -9,6 +9,10 @@
 #include "../instance/multiInstance.h"
 #include "../batch/batch.h"
 #include "../animation/animationData.h"
+#include "sortKey.h"
+#include "occlusionBuffer.h"
+#include "shadowCache.h"
+#include "shadowLod.h"
 
 #ifndef QUEUE_STATIC
 #define QUEUE_SIZE       9
@@ -26,16 +30,25 @@
 
 struct Queue {
 	Node** data;
+	u64* keys;
+	Node** tmpData; // Radix sort scratch
+	u64* tmpKeys;
 	int capacity, size;
 	Queue(int count) {
 		capacity = count;
 		data = (Node**)malloc(capacity*sizeof(Node*));
+		keys = (u64*)malloc(capacity*sizeof(u64));
+		tmpData = (Node**)malloc(capacity*sizeof(Node*));
+		tmpKeys = (u64*)malloc(capacity*sizeof(u64));
 		size = 0;
 	}
 	~Queue() {
 		free(data); data = NULL;
+		free(keys); keys = NULL;
+		free(tmpData); tmpData = NULL;
+		free(tmpKeys); tmpKeys = NULL;
 	}
-	void push(Node* node) {
+	void push(Node* node, u64 key = 0) {
 		size++;
 		if (size > capacity) {
 			int capacityBefore = capacity;
@@ -44,8 +57,20 @@ struct Queue {
 			memcpy(tmp, data, capacityBefore * sizeof(Node*));
 			free(data);
 			data = tmp;
+			u64* tmpKey = (u64*)malloc(capacity*sizeof(u64));
+			memcpy(tmpKey, keys, capacityBefore * sizeof(u64));
+			free(keys);
+			keys = tmpKey;
+			free(tmpData);
+			tmpData = (Node**)malloc(capacity*sizeof(Node*));
+			free(tmpKeys);
+			tmpKeys = (u64*)malloc(capacity*sizeof(u64));
 		}
 		*(data + size - 1) = node;
+		*(keys + size - 1) = key;
+	}
+	void sort() {
+		RadixSortKeys(keys, (void**)data, tmpKeys, (void**)tmpData, size);
 	}
 	void flush() {
 		size = 0;
@@ -78,11 +103,13 @@ public:
 	MultiInstance* boundings;
 	BatchData* batchData;
 	int shadowLevel;
+	float shadowMapSize;
+	float shadowTexelScale; // Of light camera queue is filled with
 	bool firstFlush;
 public:
 	RenderQueue(int type, float midDis, float lowDis, ConfigArg* cfg);
 	~RenderQueue();
-	void push(Node* node);
+	void push(Node* node, u64 key = 0);
 	void pushAnim(Node* node);
 	void flush();
 	void deleteInstance(InstanceData* data);
@@ -90,9 +117,12 @@ public:
 	void draw(Scene* scene, Camera* camera, Render* render, RenderState* state);
 	void animate(float velocity);
 	Mesh* queryLodMesh(Object* object, const vec3& eye);
+	Mesh* queryShadowLodMesh(Object* object, const vec3& eye);
+	bool isShadowTooSmall(Object* object);
 };
 
-void PushNodeToQueue(RenderQueue* queue, Scene* scene, Node* node, Camera* camera, Camera* mainCamera);
+void PushNodeToQueue(RenderQueue* queue, Scene* scene, Node* node, Camera* camera, Camera* mainCamera, OcclusionBuffer* occlusion = NULL);
+void PushShadowCacheToQueue(RenderQueue* queue, Scene* scene, ShadowCache* cache, Camera* camera, Camera* mainCamera, const vec3& light);
 void PushDebugToQueue(RenderQueue* queue, Scene* scene, Camera* camera);
 
 #endif
@@ -4,6 +4,8 @@
 #include "../shader/shader.h"
 #include "../shadow/shadow.h"
 
+class ThreadPool;
+
 struct RenderState {
 	bool enableCull;
 	int cullMode;
@@ -41,6 +43,7 @@ struct RenderState {
 	Shader* shaderCompute;
 	Shader* shaderMulti;
 	Shader* shaderFlush;
+	ThreadPool* cullPool; // Multi instances culled on cpu if set
 
 	vec3 mapTrans, mapScl;
 	vec4 mapInfo;
@@ -50,6 +53,7 @@ struct RenderState {
 		light = vec3(0, 0, 0);
 		udotl = 0.0;
 		eyePos = NULL;
+		cullPool = NULL;
 
 		mapTrans = vec3(0, 0, 0);
 		mapScl = vec3(0, 0, 0);
@@ -95,6 +99,7 @@ struct RenderState {
 		shaderCompute = rhs->shaderCompute;
 		shaderMulti = rhs->shaderMulti;
 		shaderFlush = rhs->shaderFlush;
+		cullPool = rhs->cullPool;
 		mapTrans = rhs->mapTrans;
 		mapScl = rhs->mapScl;
 		mapInfo = rhs->mapInfo;
@@ -0,0 +1,59 @@
+#include "ringAllocator.h"
+#include <stdio.h>
+
+RingAllocator::RingAllocator(uint ringSize, FenceSource* fenceSource) {
+	size = ringSize;
+	head = 0, used = 0;
+	frameBytes = 0;
+	fences = fenceSource;
+	waits = 0;
+}
+
+RingAllocator::~RingAllocator() {
+	finish();
+}
+
+void RingAllocator::waitOldest() {
+	RingFrame& frame = frames.front();
+	if (!fences->wait(frame.fence)) printf("ring fence wait failed\n");
+	fences->release(frame.fence);
+	used -= frame.bytes;
+	frames.pop_front();
+	waits++;
+}
+
+uint RingAllocator::allocate(uint bytes, uint align) {
+	if (bytes == 0 || bytes > size) return RING_FAIL;
+	if (align == 0) align = 1;
+
+	// Ranges in flight are [head - used, head), free ones follow head
+	uint offset = 0, need = 0;
+	while (true) {
+		if (used == 0) head = 0;
+		offset = (head + align - 1) / align * align;
+		if (offset + bytes > size) offset = 0; // Wrap, tail of ring becomes padding
+		need = offset >= head ? offset + bytes - head : size - head + offset + bytes;
+		if (need <= size - used) break;
+		if (frames.empty()) return RING_FAIL; // Current frame alone fills ring
+		waitOldest();
+	}
+
+	head = offset + bytes;
+	if (head == size) head = 0;
+	used += need;
+	frameBytes += need;
+	return offset;
+}
+
+void RingAllocator::nextFrame() {
+	if (frameBytes > 0) {
+		frames.push_back(RingFrame(frameBytes, fences->insert()));
+		frameBytes = 0;
+	}
+	while (frames.size() > RING_MAX_FRAMES) waitOldest();
+}
+
+void RingAllocator::finish() {
+	nextFrame();
+	while (!frames.empty()) waitOldest();
+}
@@ -0,0 +1,55 @@
+#ifndef RING_ALLOCATOR_H_
+#define RING_ALLOCATOR_H_
+
+#include "../constants/constants.h"
+#include <deque>
+
+#define RING_FAIL 0xffffffff
+#define RING_MAX_FRAMES 3 // Frames in flight before oldest is waited
+
+// Marks gpu progress, gl version wraps sync objects so tests can fake it
+class FenceSource {
+public:
+	virtual ~FenceSource() {}
+	// Fence after all commands issued so far
+	virtual void* insert() = 0;
+	// Block until fence passed, false if wait failed
+	virtual bool wait(void* fence) = 0;
+	virtual void release(void* fence) = 0;
+};
+
+struct RingFrame {
+	uint bytes; // Including alignment & wrap padding
+	void* fence;
+	RingFrame(uint b, void* f) :bytes(b), fence(f) {}
+};
+
+// Hands out aligned ranges of a ring in order, ranges of a frame are reused
+// only after its fence passed. No gl calls, caller maps offsets to memory
+class RingAllocator {
+private:
+	uint size;
+	uint head; // Next free byte
+	uint used; // Bytes in flight & of current frame
+	uint frameBytes;
+	std::deque<RingFrame> frames;
+	FenceSource* fences;
+	uint waits;
+private:
+	void waitOldest();
+public:
+	RingAllocator(uint ringSize, FenceSource* fenceSource);
+	~RingAllocator();
+	// Offset of range, RING_FAIL if it can not fit even after waiting
+	uint allocate(uint bytes, uint align);
+	// Fence ranges allocated since last call
+	void nextFrame();
+	// Wait all frames, ring is empty after it
+	void finish();
+	uint getSize() { return size; }
+	uint getUsed() { return used; }
+	uint getWaits() { return waits; }
+	int getFramesInFlight() { return (int)frames.size(); }
+};
+
+#endif
@@ -0,0 +1,54 @@
+#include "ringBuffer.h"
+#include <string.h>
+#include <stdio.h>
+
+void* GLFenceSource::insert() {
+	return (void*)glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+bool GLFenceSource::wait(void* fence) {
+	if (!fence) return false;
+	while (true) {
+		GLenum res = glClientWaitSync((GLsync)fence, GL_SYNC_FLUSH_COMMANDS_BIT, RING_WAIT_NS);
+		if (res == GL_ALREADY_SIGNALED || res == GL_CONDITION_SATISFIED) return true;
+		if (res == GL_WAIT_FAILED) return false;
+	}
+}
+
+void GLFenceSource::release(void* fence) {
+	if (fence) glDeleteSync((GLsync)fence);
+}
+
+RingBuffer* RingBuffer::uploads = NULL;
+
+RingBuffer::RingBuffer(uint size) {
+	GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+	glCreateBuffers(1, &bufferid);
+	glNamedBufferStorage(bufferid, size, NULL, flags);
+	mapped = (byte*)glMapNamedBufferRange(bufferid, 0, size, flags);
+	if (!mapped) printf("ring buffer map failed\n");
+	allocator = new RingAllocator(mapped ? size : 0, &fences);
+}
+
+RingBuffer::~RingBuffer() {
+	delete allocator;
+	if (mapped) glUnmapNamedBuffer(bufferid);
+	glDeleteBuffers(1, &bufferid);
+	if (uploads == this) uploads = NULL;
+}
+
+void* RingBuffer::allocate(uint bytes, uint align, uint& offset) {
+	if (!mapped) return NULL;
+	offset = allocator->allocate(bytes, align);
+	if (offset == RING_FAIL) return NULL;
+	return mapped + offset;
+}
+
+bool RingBuffer::upload(GLuint target, uint targetOffset, uint bytes, const void* data) {
+	uint offset = 0;
+	void* ptr = allocate(bytes, RING_ALIGN, offset);
+	if (!ptr) return false;
+	memcpy(ptr, data, bytes);
+	glCopyNamedBufferSubData(bufferid, target, offset, targetOffset, bytes);
+	return true;
+}
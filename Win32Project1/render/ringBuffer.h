@@ -0,0 +1,40 @@
+#ifndef RING_BUFFER_H_
+#define RING_BUFFER_H_
+
+#include "glheader.h"
+#include "ringAllocator.h"
+
+#define RING_ALIGN 16
+#define RING_WAIT_NS 1000000 // Timeout of one client wait, retried until signaled
+
+class GLFenceSource: public FenceSource {
+public:
+	virtual void* insert();
+	virtual bool wait(void* fence);
+	virtual void release(void* fence);
+};
+
+// Persistent coherent mapped buffer for per frame uploads,
+// data is written into a fenced range & copied by gpu into target buffer
+// so cpu never waits for a target still used by previous frames
+class RingBuffer {
+private:
+	GLuint bufferid;
+	byte* mapped;
+	GLFenceSource fences;
+	RingAllocator* allocator;
+public:
+	static RingBuffer* uploads; // Used by buffer updates if set
+public:
+	RingBuffer(uint size);
+	~RingBuffer();
+	// Writable memory valid this frame, offset into ring buffer returned, NULL if full
+	void* allocate(uint bytes, uint align, uint& offset);
+	// False if ring can not hold it, caller uploads directly then
+	bool upload(GLuint target, uint targetOffset, uint bytes, const void* data);
+	void nextFrame() { allocator->nextFrame(); }
+	GLuint getBuffer() { return bufferid; }
+	RingAllocator* getAllocator() { return allocator; }
+};
+
+#endif
@@ -0,0 +1,81 @@
+#include "shadowCache.h"
+using namespace std;
+
+ShadowCache::ShadowCache() {
+	cullCamera = new Camera(0);
+	position = vec3(0, 0, 0), lightDir = vec3(0, 0, 0);
+	pad = 0.0;
+	version = 0;
+	built = false;
+	rebuilds = 0;
+}
+
+ShadowCache::~ShadowCache() {
+	delete cullCamera;
+	sources.clear();
+	nodes.clear();
+	keys.clear();
+	objects.clear();
+	dynamicNodes.clear();
+}
+
+bool ShadowCache::isValid(Camera* lightCamera, const vec3& light, uint nodesVersion, const vector<Node*>& changed) {
+	if (!built || version != nodesVersion) return false;
+	if ((lightCamera->position - position).GetLength() > pad) return false;
+	if ((light - lightDir).GetLength() > SHADOW_CACHE_DIR_EPS) return false;
+	for (uint i = 0; i < changed.size(); i++) {
+		Node* node = changed[i];
+		if (sources.find(node) != sources.end()) return false;
+		if (HasDynamicObject(node)) return false; // May be a new one
+		if (node->objects.size() > 0 && node->checkInCamera(cullCamera)) return false;
+	}
+	return true;
+}
+
+// Cull camera is light camera's bounding box grown by pad on every side,
+// so it covers light camera after any move shorter than pad
+void ShadowCache::begin(Camera* lightCamera, const vec3& light, uint nodesVersion) {
+	mat4 bound = lightCamera->getBoundMatrix();
+	float halfX = 1.0 / bound.entries[0], halfY = 1.0 / bound.entries[5];
+	float depth = -2.0 / bound.entries[10], center = -bound.entries[14] * depth * 0.5;
+	pad = (halfX > halfY ? halfX : halfY) * SHADOW_CACHE_PAD;
+
+	cullCamera->copy(lightCamera);
+	cullCamera->initOrthoCamera(-halfX - pad, halfX + pad, -halfY - pad, halfY + pad, 
+		center - depth * 0.5 - pad, center + depth * 0.5 + pad);
+	cullCamera->updateFrustum();
+
+	position = lightCamera->position;
+	lightDir = light;
+	version = nodesVersion;
+	sources.clear();
+	nodes.clear();
+	keys.clear();
+	objects.clear();
+	dynamicNodes.clear();
+	built = true;
+	rebuilds++;
+}
+
+void ShadowCache::addNode(Node* node, u64 key) {
+	nodes.push_back(node);
+	keys.push_back(key);
+	sources.insert(node);
+}
+
+void ShadowCache::addObject(Object* object) {
+	objects.push_back(object);
+	sources.insert(object->parent);
+}
+
+void ShadowCache::addDynamicNode(Node* node) {
+	dynamicNodes.push_back(node);
+	sources.insert(node);
+}
+
+bool HasDynamicObject(Node* node) {
+	for (uint i = 0; i < node->objects.size(); i++) {
+		if (node->objects[i]->isDynamic()) return true;
+	}
+	return false;
+}
@@ -0,0 +1,45 @@
+#ifndef SHADOW_CACHE_H_
+#define SHADOW_CACHE_H_
+
+#include "../camera/camera.h"
+#include "../node/node.h"
+#include <vector>
+#include <set>
+
+#define SHADOW_CACHE_PAD 0.15 // Cull size added around cascade, relative to its half size
+#define SHADOW_CACHE_DIR_EPS 1e-5
+
+// Static nodes & instance objects of one cascade found with a padded light frustum,
+// replayed until light camera moves out of the padding, light turns or a static node around changes.
+// Dynamic objects are never cached, only nodes holding them so they can be merged every frame
+class ShadowCache {
+private:
+	Camera* cullCamera;
+	vec3 position, lightDir;
+	float pad;
+	uint version;
+	bool built;
+	std::set<Node*> sources; // Nodes whose content is cached
+	int rebuilds;
+public:
+	std::vector<Node*> nodes;
+	std::vector<u64> keys;
+	std::vector<Object*> objects;
+	std::vector<Node*> dynamicNodes;
+public:
+	ShadowCache();
+	~ShadowCache();
+	// changed are static nodes updated since last check, nodesVersion changes when nodes are detached or deleted
+	bool isValid(Camera* lightCamera, const vec3& light, uint nodesVersion, const std::vector<Node*>& changed);
+	void begin(Camera* lightCamera, const vec3& light, uint nodesVersion);
+	void addNode(Node* node, u64 key);
+	void addObject(Object* object);
+	void addDynamicNode(Node* node);
+	void invalidate() { built = false; }
+	Camera* getCullCamera() { return cullCamera; }
+	int getRebuildCount() { return rebuilds; }
+};
+
+bool HasDynamicObject(Node* node);
+
+#endif
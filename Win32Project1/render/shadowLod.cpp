@@ -0,0 +1,28 @@
+#include "shadowLod.h"
+
+static const ShadowLodRule ShadowLodRules[4] = {
+	{ 0.0, 0.0, 0.0, LOD_HIGH }, // Not a shadow queue
+	{ 1.0, 48.0, 12.0, LOD_HIGH }, // Near
+	{ 2.0, 96.0, 24.0, LOD_MID }, // Mid
+	{ 4.0, 192.0, 48.0, LOD_MID }, // Far
+};
+
+const ShadowLodRule& GetShadowLodRule(int shadowLevel) {
+	if (shadowLevel < 0) shadowLevel = 0;
+	else if (shadowLevel > 3) shadowLevel = 3;
+	return ShadowLodRules[shadowLevel];
+}
+
+float ShadowTexelScale(const mat4& lightProject, float mapSize) {
+	return lightProject.entries[0] * 0.5 * mapSize;
+}
+
+int SelectShadowLod(int viewLod, float radius, float texelScale, const ShadowLodRule& rule) {
+	if (texelScale <= 0.0) return viewLod;
+	float texels = radius * 2.0 * texelScale;
+	if (texels < rule.dropTexels) return SHADOW_LOD_DROP;
+
+	int lod = viewLod > rule.minLod ? viewLod : rule.minLod;
+	int sizeLod = texels < rule.lowTexels ? LOD_LOW : (texels < rule.midTexels ? LOD_MID : LOD_HIGH);
+	return lod > sizeLod ? lod : sizeLod;
+}
@@ -0,0 +1,25 @@
+#ifndef SHADOW_LOD_H_
+#define SHADOW_LOD_H_
+
+#include "../maths/Maths.h"
+
+#define LOD_HIGH 0
+#define LOD_MID 1
+#define LOD_LOW 2
+#define SHADOW_LOD_DROP -1
+
+struct ShadowLodRule {
+	float dropTexels; // Objects narrower than this in shadow map cast no shadow
+	float midTexels, lowTexels; // Narrower objects use mid / low mesh
+	int minLod; // Cascade never draws finer than this
+};
+
+// Rule of a shadow queue by its shadowLevel, coarser for farther cascades
+const ShadowLodRule& GetShadowLodRule(int shadowLevel);
+// Shadow map texels per world unit of an orthographic light camera
+float ShadowTexelScale(const mat4& lightProject, float mapSize);
+// Coarsest of view lod, size lod & cascade minimum, SHADOW_LOD_DROP if object is too small.
+// No gl calls, texelScale <= 0 keeps view lod
+int SelectShadowLod(int viewLod, float radius, float texelScale, const ShadowLodRule& rule);
+
+#endif
@@ -0,0 +1,60 @@
+#include "sortKey.h"
+#include <string.h>
+
+#define SORT_FIELD(value, bits) ((u64)(value) & ((1ULL << (bits)) - 1))
+
+// depth is 0 at camera & 1 at far plane
+u64 MakeSortKey(int layer, uint shader, uint material, uint mesh, float depth) {
+	if (depth < 0.0) depth = 0.0;
+	else if (depth > 1.0) depth = 1.0;
+	u64 depthBits = (u64)(depth * ((1 << SORT_DEPTH_BITS) - 1));
+	u64 key = (u64)layer << 62;
+	if (layer == SORT_LAYER_TRANSPARENT) {
+		u64 farFirst = ((1 << SORT_DEPTH_BITS) - 1) - depthBits;
+		key |= farFirst << 46;
+		key |= SORT_FIELD(shader, SORT_SHADER_BITS) << 40;
+		key |= SORT_FIELD(material, SORT_MATERIAL_BITS) << 28;
+		key |= SORT_FIELD(mesh, SORT_MESH_BITS) << 12;
+	} else {
+		key |= SORT_FIELD(shader, SORT_SHADER_BITS) << 56;
+		key |= SORT_FIELD(material, SORT_MATERIAL_BITS) << 44;
+		key |= SORT_FIELD(mesh, SORT_MESH_BITS) << 28;
+		key |= depthBits << 12;
+	}
+	return key;
+}
+
+u64 MakeBatchKey(uint shader, uint material, uint order) {
+	return MakeSortKey(SORT_LAYER_OPAQUE, shader, material, order, 0.0);
+}
+
+void RadixSortKeys(u64* keys, void** values, u64* tmpKeys, void** tmpValues, int count) {
+	if (count < 2) return;
+	u64* srcKeys = keys, *dstKeys = tmpKeys;
+	void** srcValues = values, **dstValues = tmpValues;
+	int counts[256];
+	for (int shift = 0; shift < 64; shift += 8) {
+		memset(counts, 0, sizeof(counts));
+		for (int i = 0; i < count; i++)
+			counts[(srcKeys[i] >> shift) & 0xff]++;
+		if (counts[(srcKeys[0] >> shift) & 0xff] == count) continue;
+
+		int offset = 0;
+		for (int b = 0; b < 256; b++) {
+			int c = counts[b];
+			counts[b] = offset;
+			offset += c;
+		}
+		for (int i = 0; i < count; i++) {
+			int dst = counts[(srcKeys[i] >> shift) & 0xff]++;
+			dstKeys[dst] = srcKeys[i];
+			dstValues[dst] = srcValues[i];
+		}
+		u64* swapKeys = srcKeys; srcKeys = dstKeys; dstKeys = swapKeys;
+		void** swapValues = srcValues; srcValues = dstValues; dstValues = swapValues;
+	}
+	if (srcKeys != keys) {
+		memcpy(keys, srcKeys, count * sizeof(u64));
+		memcpy(values, srcValues, count * sizeof(void*));
+	}
+}
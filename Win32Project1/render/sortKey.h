@@ -0,0 +1,23 @@
+#ifndef SORT_KEY_H_
+#define SORT_KEY_H_
+
+#include "../constants/constants.h"
+
+#define SORT_LAYER_OPAQUE 0
+#define SORT_LAYER_TRANSPARENT 1
+
+#define SORT_SHADER_BITS 6
+#define SORT_MATERIAL_BITS 12
+#define SORT_MESH_BITS 16
+#define SORT_DEPTH_BITS 16
+
+// Opaque: layer | shader | material | mesh | depth, front to back in same state
+// Transparent: layer | far to near depth | shader | material | mesh
+u64 MakeSortKey(int layer, uint shader, uint material, uint mesh, float depth);
+// Multi draw batches draw in the order they are added: shader | material | scene order
+u64 MakeBatchKey(uint shader, uint material, uint order);
+// Stable lsd radix sort of keys with their values, tmp buffers hold count items,
+// byte passes shared by all keys are skipped
+void RadixSortKeys(u64* keys, void** values, u64* tmpKeys, void** tmpValues, int count);
+
+#endif
@@ -0,0 +1,116 @@
+#include "stateTracker.h"
+
+StateTracker::StateTracker(RenderDevice* dev) {
+	device = dev;
+	invalidate();
+	resetCounters();
+}
+
+void StateTracker::setDevice(RenderDevice* dev) {
+	device = dev;
+	invalidate();
+}
+
+void StateTracker::invalidate() {
+	for (int i = 0; i < CAP_COUNT; i++)
+		caps[i] = STATE_UNKNOWN;
+	depthMode = STATE_UNKNOWN;
+	alphaMode = STATE_UNKNOWN;
+	alphaThreshold = 0.0;
+	cullMode = STATE_UNKNOWN;
+	lineMode = STATE_UNKNOWN;
+	colorMask = STATE_UNKNOWN;
+	clearKnown = false;
+	for (int i = 0; i < 4; i++) {
+		clearColors[i] = 0.0;
+		viewports[i] = STATE_UNKNOWN;
+	}
+	program = STATE_UNKNOWN_ID;
+	framebuffer = STATE_UNKNOWN_ID;
+	invalidateTextures();
+}
+
+void StateTracker::invalidateTextures() {
+	for (int i = 0; i < STATE_TEXTURE_UNITS; i++)
+		textures[i] = STATE_UNKNOWN_ID;
+}
+
+void StateTracker::setCap(int cap, bool enable) {
+	int value = enable ? 1 : 0;
+	if (!check(caps[cap] != value)) return;
+	caps[cap] = value;
+	device->setCap(cap, enable);
+}
+
+void StateTracker::setDepthFunc(int mode) {
+	if (!check(depthMode != mode)) return;
+	depthMode = mode;
+	device->depthFunc(mode);
+}
+
+void StateTracker::setAlphaFunc(int mode, float threshold) {
+	if (!check(alphaMode != mode || alphaThreshold != threshold)) return;
+	alphaMode = mode;
+	alphaThreshold = threshold;
+	device->alphaFunc(mode, threshold);
+}
+
+void StateTracker::setCullFace(int mode) {
+	if (!check(cullMode != mode)) return;
+	cullMode = mode;
+	device->cullFace(mode);
+}
+
+void StateTracker::setPolygonMode(bool line) {
+	int value = line ? 1 : 0;
+	if (!check(lineMode != value)) return;
+	lineMode = value;
+	device->polygonMode(line);
+}
+
+void StateTracker::setColorMask(bool r, bool g, bool b, bool a) {
+	int mask = (r ? 1 : 0) | (g ? 2 : 0) | (b ? 4 : 0) | (a ? 8 : 0);
+	if (!check(colorMask != mask)) return;
+	colorMask = mask;
+	device->colorMask(r, g, b, a);
+}
+
+void StateTracker::setClearColor(float r, float g, float b, float a) {
+	bool same = clearKnown && clearColors[0] == r && clearColors[1] == g && clearColors[2] == b && clearColors[3] == a;
+	if (!check(!same)) return;
+	clearKnown = true;
+	clearColors[0] = r, clearColors[1] = g, clearColors[2] = b, clearColors[3] = a;
+	device->clearColor(r, g, b, a);
+}
+
+void StateTracker::clear(bool color, bool depth, bool stencil) {
+	if (!check(color || depth || stencil)) return;
+	device->clear(color, depth, stencil);
+}
+
+void StateTracker::setViewport(int x, int y, int width, int height) {
+	bool same = viewports[0] == x && viewports[1] == y && viewports[2] == width && viewports[3] == height;
+	if (!check(!same)) return;
+	viewports[0] = x, viewports[1] = y, viewports[2] = width, viewports[3] = height;
+	device->viewport(x, y, width, height);
+}
+
+void StateTracker::useProgram(uint prog) {
+	if (!check(program != prog)) return;
+	program = prog;
+	device->useProgram(prog);
+}
+
+uint StateTracker::bindTexture(uint unit, uint texture) {
+	uint before = textures[unit] == STATE_UNKNOWN_ID ? 0 : textures[unit];
+	if (!check(textures[unit] != texture)) return before;
+	textures[unit] = texture;
+	device->bindTexture(unit, texture);
+	return before;
+}
+
+void StateTracker::bindFramebuffer(uint fbo) {
+	if (!check(framebuffer != fbo)) return;
+	framebuffer = fbo;
+	device->bindFramebuffer(fbo);
+}
@@ -0,0 +1,63 @@
+#ifndef STATE_TRACKER_H_
+#define STATE_TRACKER_H_
+
+#include "renderDevice.h"
+
+#define STATE_UNKNOWN -1
+#define STATE_UNKNOWN_ID 0xffffffff
+#define STATE_TEXTURE_UNITS 32
+
+// Shadows all state set through it & only passes changes on to device,
+// unknown state always goes through so invalidate after outside gl calls
+class StateTracker {
+private:
+	RenderDevice* device;
+	int caps[CAP_COUNT];
+	int depthMode;
+	int alphaMode;
+	float alphaThreshold;
+	int cullMode;
+	int lineMode;
+	int colorMask; // One bit per channel
+	bool clearKnown;
+	float clearColors[4];
+	int viewports[4];
+	uint program;
+	uint framebuffer;
+	uint textures[STATE_TEXTURE_UNITS];
+	uint issued, skipped;
+private:
+	bool check(bool changed) {
+		if (changed) issued++;
+		else skipped++;
+		return changed;
+	}
+public:
+	StateTracker(RenderDevice* dev);
+	~StateTracker() {}
+	void setDevice(RenderDevice* dev);
+	RenderDevice* getDevice() { return device; }
+	void invalidate();
+	void invalidateTextures();
+	void setCap(int cap, bool enable);
+	void setDepthFunc(int mode);
+	void setAlphaFunc(int mode, float threshold);
+	void setCullFace(int mode);
+	void setPolygonMode(bool line);
+	void setColorMask(bool r, bool g, bool b, bool a);
+	void setClearColor(float r, float g, float b, float a);
+	void clear(bool color, bool depth, bool stencil);
+	void setViewport(int x, int y, int width, int height);
+	void useProgram(uint prog);
+	// Returns texture bound before, 0 if unknown
+	uint bindTexture(uint unit, uint texture);
+	void bindFramebuffer(uint fbo);
+	bool isCapEnabled(int cap) { return caps[cap] == 1; }
+	bool isDrawLine() { return lineMode == 1; }
+	// Calls passed on & dropped since last reset
+	uint getIssued() { return issued; }
+	uint getSkipped() { return skipped; }
+	void resetCounters() { issued = 0, skipped = 0; }
+};
+
+#endif
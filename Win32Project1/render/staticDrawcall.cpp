@@ -94,12 +94,13 @@ RenderBuffer* StaticDrawcall::createBuffers(Batch* batch, int bufCount, int vert
 }
 
 void StaticDrawcall::draw(Render* render, RenderState* state, Shader* shader) {
+	static int modelMatricesId = Shader::GetUniformId("modelMatrices");
 	if (indexCntToDraw <= 0) return;
 	if (frame < state->delay) frame++;
 	else {
 		render->useShader(shader);
 		if (state->pass < DEFERRED_PASS && !isFullStatic() && objectCntToDraw > 0 && uModelMatrix)
-			shader->setMatrix3x4("modelMatrices", objectCntToDraw, uModelMatrix);
+			shader->setMatrix3x4(modelMatricesId, objectCntToDraw, uModelMatrix);
 
 		GLenum type = state->tess ? GL_PATCHES : GL_TRIANGLES;
 
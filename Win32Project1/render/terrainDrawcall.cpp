@@ -92,6 +92,7 @@ TerrainDrawcall::~TerrainDrawcall() {
 }
 
 void TerrainDrawcall::update(Camera* camera, Render* render, RenderState* state) {
+	static int viewProjectId = Shader::GetUniformId("viewProjectMatrix");
 	indirectBuffer->count = 0; // Refresh index count
 	dataBuffer->updateBufferMap(GL_DRAW_INDIRECT_BUFFER, IndirectIndex, sizeof(Indirect), indirectBuffer);
 
@@ -101,7 +102,7 @@ void TerrainDrawcall::update(Camera* camera, Render* render, RenderState* state)
 	dataBuffer->setShaderBase(OutIndex, 4);
 
 	render->useShader(state->shaderCompute);
-	state->shaderCompute->setMatrix4("viewProjectMatrix", camera->viewProjectMatrix);
+	state->shaderCompute->setMatrix4(viewProjectId, camera->viewProjectMatrix);
 	
 	glDispatchCompute(chunkCount, 1, 1); // Update per chunk, check chunk cull
 	glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
@@ -115,7 +116,7 @@ void TerrainDrawcall::update(Camera* camera, Render* render, RenderState* state)
 }
 
 void TerrainDrawcall::draw(Render* render, RenderState* state, Shader* shader) {
-	bool drawLine = render->drawLine;
+	bool drawLine = render->isDrawLine();
 	if (render->getDebugTerrain()) {
 		render->setDrawLine(true);
 		MaterialManager::materials->useMaterialBuffer(1);
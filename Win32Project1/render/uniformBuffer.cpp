@@ -0,0 +1,33 @@
+#include "uniformBuffer.h"
+#include "ringBuffer.h"
+#include <stdlib.h>
+#include <string.h>
+
+UniformBuffer::UniformBuffer(uint blockSize) {
+	size = (blockSize + 15) & ~15;
+	data = (byte*)malloc(size);
+	memset(data, 0, size);
+	glCreateBuffers(1, &bufferid);
+	glNamedBufferStorage(bufferid, size, data, GL_DYNAMIC_STORAGE_BIT);
+	dirty = false;
+}
+
+UniformBuffer::~UniformBuffer() {
+	glDeleteBuffers(1, &bufferid);
+	free(data);
+}
+
+void UniformBuffer::setData(uint offset, const void* value, uint bytes) {
+	if (offset + bytes > size || memcmp(data + offset, value, bytes) == 0) return;
+	memcpy(data + offset, value, bytes);
+	dirty = true;
+}
+
+void UniformBuffer::use(uint binding) {
+	if (dirty) {
+		if (!RingBuffer::uploads || !RingBuffer::uploads->upload(bufferid, 0, size, data))
+			glNamedBufferSubData(bufferid, 0, size, data);
+		dirty = false;
+	}
+	glBindBufferBase(GL_UNIFORM_BUFFER, binding, bufferid);
+}
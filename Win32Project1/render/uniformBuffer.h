@@ -0,0 +1,33 @@
+#ifndef UNIFORM_BUFFER_H_
+#define UNIFORM_BUFFER_H_
+
+#include "glheader.h"
+#include "../constants/constants.h"
+
+#define HIZ_BLOCK_BINDING 0
+#define PASS_BLOCK_BINDING 1
+#define COUNT_BLOCK_BINDING 2
+#define CAMERA_BLOCK_BINDING 3
+
+// Std140 block shared by shaders, cpu copy uploaded only when changed
+class UniformBuffer {
+private:
+	GLuint bufferid;
+	uint size;
+	byte* data;
+	bool dirty;
+public:
+	UniformBuffer(uint blockSize);
+	~UniformBuffer();
+	// Offsets follow std140, vec3 & vec4 16 aligned, vec2 8 aligned
+	void setData(uint offset, const void* value, uint bytes);
+	void setFloat(uint offset, float value) { setData(offset, &value, sizeof(float)); }
+	void setVector2(uint offset, float x, float y) { float v[2] = { x, y }; setData(offset, v, sizeof(v)); }
+	void setVector3(uint offset, float x, float y, float z) { float v[3] = { x, y, z }; setData(offset, v, sizeof(v)); }
+	void setVector4(uint offset, float x, float y, float z, float w) { float v[4] = { x, y, z, w }; setData(offset, v, sizeof(v)); }
+	void setMatrix4(uint offset, float* matrix) { setData(offset, matrix, 16 * sizeof(float)); }
+	// Upload if changed & bind to block binding
+	void use(uint binding);
+};
+
+#endif
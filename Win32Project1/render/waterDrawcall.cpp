@@ -76,6 +76,7 @@ WaterDrawcall::~WaterDrawcall() {
 }
 
 void WaterDrawcall::update(Camera* camera, Render* render, RenderState* state) {
+	static int viewProjectId = Shader::GetUniformId("viewProjectMatrix");
 	indirectBuffer->count = 0; // Refresh index count
 	dataBuffer->updateBufferMap(GL_DRAW_INDIRECT_BUFFER, IndirectIndex, sizeof(Indirect), indirectBuffer);
 
@@ -85,8 +86,7 @@ void WaterDrawcall::update(Camera* camera, Render* render, RenderState* state) {
 	dataBuffer->setShaderBase(OutIndex, 4);
 
 	render->useShader(state->shaderCompute);
-	state->shaderCompute->setMatrix4("viewProjectMatrix", camera->viewProjectMatrix);
-	state->shaderCompute->setVector3v("eyePos", camera->position);
+	state->shaderCompute->setMatrix4(viewProjectId, camera->viewProjectMatrix);
 
 	glDispatchCompute(chunkCount, 1, 1); // Update per chunk, check chunk cull
 	glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
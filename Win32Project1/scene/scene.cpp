@@ -1,6 +1,7 @@
 #include "scene.h"
 #include "../constants/constants.h"
 #include "../assets/assetManager.h"
+#include "../util/profiler.h"
 #include "../mesh/box.h"
 #include "../mesh/sphere.h"
 #include "../mesh/board.h"
@@ -9,6 +10,7 @@
 #include "../mesh/terrain.h"
 #include "../mesh/water.h"
 #include "../object/staticObject.h"
+#include <set>
 using namespace std;
 
 Scene::Scene() {
@@ -38,7 +40,11 @@ Scene::Scene() {
 	anims.clear();
 	animPlayers.clear();
 	animationNodes.clear();
-	dynamicObjects.clear();
+	changedObjects.clear();
+	refitNodes.clear();
+	changedNodes.clear();
+	nodesVersion = 0;
+	physicTerrain = false;
 	Node::nodesToUpdate.clear();
 	Node::nodesToRemove.clear();
 	Instance::instanceTable.clear();
@@ -46,6 +52,7 @@ Scene::Scene() {
 	collisionWorld = new DynamicWorld();
 	soundMgr = new SoundManager();
 	sounds.clear();
+	streams.clear();
 }
 
 Scene::~Scene() {
@@ -70,12 +77,16 @@ Scene::~Scene() {
 	animPlayers.clear();
 	animCount.clear();
 	animationNodes.clear();
-	dynamicObjects.clear();
+	changedObjects.clear();
+	refitNodes.clear();
 
 	delete collisionWorld;
 	for (uint i = 0; i < sounds.size(); ++i)
 		delete sounds[i];
 	sounds.clear();
+	for (uint i = 0; i < streams.size(); ++i)
+		delete streams[i];
+	streams.clear();
 	delete soundMgr;
 }
 
@@ -86,10 +97,13 @@ void Scene::initNodes() {
 }
 
 void Scene::updateNodes() {
+	PROFILE_SCOPE("updateNodes");
 	uint size = Node::nodesToUpdate.size();
 	if (size == 0) return;
-	for (uint i = 0; i < size; i++)
+	for (uint i = 0; i < size; i++) {
 		Node::nodesToUpdate[i]->updateNode(this);
+		changedNodes.push_back(Node::nodesToUpdate[i]);
+	}
 	Node::nodesToUpdate.clear();
 }
 
@@ -99,6 +113,7 @@ void Scene::flushNodes() {
 	for (uint i = 0; i < size; i++)
 		delete Node::nodesToRemove[i];
 	Node::nodesToRemove.clear();
+	nodesVersion++;
 }
 
 void Scene::updateReflectCamera() {
@@ -144,6 +159,8 @@ void Scene::createTerrain(const vec3& position, const vec3& size) {
 	terrainObject->setSize(size.x, size.y, size.z);
 	terrainNode->addObject(this, terrainObject);
 	terrainNode->prepareCollisionData();
+	if (physicTerrain) 
+		collisionWorld->setTerrain(terrainNode->getMesh()->getHeightMap(), MAP_SIZE, MAP_SIZE, STEP_SIZE, terrainNode->offset, terrainNode->offsize);
 	terrainNode->updateNode(this);
 	terrainNode->prepareDrawcall();
 }
@@ -263,15 +280,16 @@ void Scene::addObject(Object* object, bool isPhysic) {
 			if (animObj->parent)
 				animationNodes.push_back((AnimationNode*)(animObj->parent));
 		}
-	} else { 
-		StaticObject* obj = (StaticObject*)object;
-		if (obj->parent && obj->isDynamic())
-			dynamicObjects.push_back(obj);
 	}
 	
 	if (isPhysic) {
 		object->caculateCollisionShape();
 		CollisionObject* cob = object->initCollisionObject();
+		if (object->parent && !cob->object) { // Static props are put into cells by position
+			mat4 nodeMat;
+			object->parent->recursiveTransform(nodeMat);
+			cob->initTransform(GetTranslate(nodeMat * object->translateMat), object->rotateQuat);
+		}
 		collisionWorld->addObject(cob);
 	}
 }
@@ -304,17 +322,6 @@ void Scene::synPhysics2Graphic(StaticObject* object) {
 	object->collisionObject->resetVelocity();
 }
 
-void Scene::updateDynamicNodes() {
-	list<StaticObject*>::iterator it;
-	for (it = dynamicObjects.begin(); it != dynamicObjects.end(); ++it) {
-		StaticObject* object = *it;
-		if (!object->collisionObject || object->collisionObject->isStatic()) continue;
-		synPhysics2Graphic(object); // Read back collision transform
-		object->standOnGround(this); // Stand object on ground after collision (no terrain collision) & update object's bounding box
-		object->updateObjectTransform(true, true); // Send render data for using
-	}
-}
-
 // Read collision transform to render data
 void Scene::synPhysics2Graphic(AnimationNode* node, AnimationObject* object) {
 	vec3 gPosition = object->collisionObject->getTranslate();
@@ -327,30 +334,71 @@ void Scene::synPhysics2Graphic(AnimationNode* node, AnimationObject* object) {
 	object->collisionObject->resetVelocity();
 }
 
-// Update animation nodes' transform & aabb after collision
-void Scene::updateAnimNodes() {
-	list<AnimationNode*>::iterator it;
-	for (it = animationNodes.begin(); it != animationNodes.end(); ++it) {
-		AnimationNode* node = *it;
-		AnimationObject* object = node->getObject();
-		if (!object->collisionObject || object->collisionObject->isStatic()) continue;
-
-		synPhysics2Graphic(node, object); // Read back collision transform
+// Update animation node's transform & aabb after collision
+void Scene::updateAnimNode(AnimationNode* node, AnimationObject* object) {
+	synPhysics2Graphic(node, object); // Read back collision transform
+	if (!physicTerrain)
 		terrainNode->standObjectsOnGround(this, node); // Stand animation nodes on ground after collision (no terrain collision)
-		node->boundingBox->update(GetTranslate(node->nodeTransform)); // Update bounding box after terrain collision
-		Node* superior = node->parent;
-		while (superior) {
-			superior->updateBounding();
-			superior = superior->parent;
-		}
+	node->boundingBox->update(GetTranslate(node->nodeTransform)); // Update bounding box after terrain collision
+	if (node->parent) refitNodes.push_back(node->parent);
 
-		object->updateObjectTransform(true, true); // Send render data for using
-		if (player->getNode() == node)
-			player->setPosition(node->position);
+	object->updateObjectTransform(true, true); // Send render data for using
+	if (player->getNode() == node)
+		player->setPosition(node->position);
+}
+
+void Scene::updateDynamicNode(StaticObject* object) {
+	synPhysics2Graphic(object); // Read back collision transform
+	if (!physicTerrain)
+		object->standOnGround(this); // Stand object on ground after collision (no terrain collision) & update object's bounding box
+	else
+		object->updateParentBounding();
+	if (object->parent->parent) refitNodes.push_back(object->parent->parent);
+	object->updateObjectTransform(true, true); // Send render data for using
+}
+
+// Sync only objects moved by physics, then refit ancestors' bounding once
+void Scene::updatePhysicsNodes() {
+	collisionWorld->fetchChangedObjects(changedObjects);
+	for (uint i = 0; i < changedObjects.size(); ++i) {
+		Object* object = (Object*)changedObjects[i]->getUserPointer();
+		if (!object || !object->parent) continue;
+		if (!object->mesh) 
+			updateAnimNode((AnimationNode*)object->parent, (AnimationObject*)object);
+		else if (object->isDynamic())
+			updateDynamicNode((StaticObject*)object);
+	}
+	changedObjects.clear();
+	refitBoundings();
+}
+
+// Refit queued nodes and all their ancestors bottom-up, each node only once
+void Scene::refitBoundings() {
+	if (refitNodes.size() == 0) return;
+	std::set<Node*> queued;
+	std::vector<std::vector<Node*> > levels;
+	for (uint i = 0; i < refitNodes.size(); ++i) {
+		Node* node = refitNodes[i];
+		if (queued.find(node) != queued.end()) continue;
+		uint depth = 0;
+		for (Node* superior = node->parent; superior; superior = superior->parent)
+			depth++;
+		for (; node && queued.find(node) == queued.end(); node = node->parent, depth--) {
+			queued.insert(node);
+			if (levels.size() <= depth) levels.resize(depth + 1);
+			levels[depth].push_back(node);
+		}
+	}
+	for (int d = (int)levels.size() - 1; d >= 0; --d) {
+		for (uint i = 0; i < levels[d].size(); ++i)
+			levels[d][i]->updateBounding();
 	}
+	refitNodes.clear();
 }
 
 void Scene::playSounds() {
 	for (uint i = 0; i < sounds.size(); ++i)
 		sounds[i]->play();
+	for (uint i = 0; i < streams.size(); ++i)
+		streams[i]->play();
 }
\ No newline at end of file
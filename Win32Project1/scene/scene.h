@@ -14,6 +14,7 @@
 #include "../node/instanceNode.h"
 #include "../sky/sky.h"
 #include "player.h"
+#include <atomic>
 
 #ifndef MAX_DEBUG_OBJ
 #define MAX_DEBUG_OBJ 8192
@@ -35,6 +36,7 @@ public:
 private:
 	std::map<Mesh*, uint> meshCount;
 	bool inited;
+	bool physicTerrain; // Terrain contact handled by physics, no manual grounding
 private:
 	void initNodes();
 public:
@@ -56,6 +58,9 @@ public:
 	DynamicWorld* collisionWorld;
 	SoundManager* soundMgr;
 	std::vector<SoundObject*> sounds;
+	std::vector<SoundStream*> streams; // Ambience & music
+	std::vector<Node*> changedNodes; // Nodes updated since last render queue update
+	std::atomic<uint> nodesVersion; // Increased when nodes are detached or deleted, read by render queue update
 public:
 	Scene();
 	~Scene();
@@ -66,17 +71,22 @@ public:
 	void updateVisualTerrain(int bx, int bz, int sizex, int sizez);
 	void updateNodes();
 	void flushNodes();
+	void clearChangedNodes() { changedNodes.clear(); }
 	void updateReflectCamera();
 	void addObject(Object* object, bool isPhysic = true);
 	void addPlay(AnimationNode* node);
 	uint queryMeshCount(Mesh* mesh);
 	void finishInit() { inited = true; }
+	void setPhysicTerrain(bool phy) { physicTerrain = phy; }
+	bool isPhysicTerrain() { return physicTerrain; }
 	bool isInited() { return inited; }
 	void act(float dTime) { time = dTime * 0.025; }
 	void setVelocity(float v) { velocity = v; }
 	void addSound(SoundObject* sound) { sounds.push_back(sound); }
+	void addStream(SoundStream* stream) { streams.push_back(stream); }
 	void playSounds();
 	void updateListenerPosition() { soundMgr->setListenerPosition(actCamera->position); }
+	void updateSounds(float dTime) { soundMgr->update(dTime); }
 public: // Just for debugging
 	void updateNodeAABB(Node* node);
 	void clearAllAABB();
@@ -85,15 +95,17 @@ private:
 	void updateAABBWater(AABB* aabb, const char* mat, const vec3& exTrans, const vec3& exScale);
 private:
 	std::list<AnimationNode*> animationNodes;
-	std::list<StaticObject*> dynamicObjects;
+	std::vector<CollisionObject*> changedObjects; // Collision objects moved by last physics steps
+	std::vector<Node*> refitNodes; // Nodes whose bounding & ancestors' need refit
 public:
 	void removeAnimationNode(AnimationNode* node) { animationNodes.remove(node); }
-	void removeDynamicObject(StaticObject* object) { dynamicObjects.remove(object); }
 public:
 	void initAnimNodes();
-	void updateAnimNodes();
-	void updateDynamicNodes();
+	void updatePhysicsNodes();
 private:
+	void updateDynamicNode(StaticObject* object);
+	void updateAnimNode(AnimationNode* node, AnimationObject* object);
+	void refitBoundings();
 	void synPhysics2Graphic(AnimationNode* node, AnimationObject* object);
 	void synPhysics2Graphic(StaticObject* object);
 };
@@ -1,5 +1,6 @@
 #include "shader.h"
 #include "../constants/constants.h"
+#include <string.h>
 using namespace std;
 
 //#define DEBUG_SHADER 1
@@ -10,6 +11,7 @@ Shader::Shader(const char* vert, const char* frag, const char* tesc, const char*
 	bindedTexs.clear();
 	texSlots.clear();
 	slotHnds.clear();
+	reflected = false;
 }
 
 Shader::Shader(const char* comp) {
@@ -18,6 +20,7 @@ Shader::Shader(const char* comp) {
 	bindedTexs.clear();
 	texSlots.clear();
 	slotHnds.clear();
+	reflected = false;
 }
 
 Shader::~Shader() {
@@ -30,6 +33,18 @@ Shader::~Shader() {
 	slotHnds.clear();
 }
 
+map<string, int> Shader::UniformIds;
+vector<string> Shader::UniformNames;
+
+int Shader::GetUniformId(const char* name) {
+	map<string, int>::iterator it = UniformIds.find(name);
+	if (it != UniformIds.end()) return it->second;
+	int id = (int)UniformNames.size();
+	UniformIds[name] = id;
+	UniformNames.push_back(name);
+	return id;
+}
+
 void Shader::attachDef(const char* def, const char* value) {
 	program->attachDef(def, value);
 }
@@ -46,10 +61,63 @@ void Shader::compile(bool preload) {
 	program->compile(preload);
 }
 
+bool Shader::loadBinary() {
+	return program->loadBinary();
+}
+
+void Shader::saveBinary() {
+	program->saveBinary();
+}
+
 void Shader::dettach() {
 	program->dettach();
 }
 
+// Arrays found by name without [0], block members have no location & are skipped
+void Shader::reflect() {
+	paramLocations.clear();
+	uniformLocs.clear();
+	uniformValues.clear();
+	uniformCached.clear();
+	bindedTexs.clear();
+
+	GLuint prog = program->shaderProg;
+	GLint count = 0, maxLength = 0;
+	glGetProgramiv(prog, GL_ACTIVE_UNIFORMS, &count);
+	glGetProgramiv(prog, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+	vector<char> name(maxLength + 1, 0);
+	for (GLint i = 0; i < count; i++) {
+		GLint size = 0;
+		GLenum type = 0;
+		glGetActiveUniform(prog, i, maxLength + 1, NULL, &size, &type, &name[0]);
+		GLint location = glGetUniformLocation(prog, &name[0]);
+		if (location == INVALID_LOCATION) continue;
+
+		string uniform(&name[0]);
+		size_t arr = uniform.rfind("[0]");
+		if (arr != string::npos && arr + 3 == uniform.length()) uniform = uniform.substr(0, arr);
+		paramLocations[uniform] = location;
+		int id = GetUniformId(uniform.data());
+		if (id >= (int)uniformLocs.size()) uniformLocs.resize(id + 1, INVALID_LOCATION);
+		uniformLocs[id] = location;
+	}
+	reflected = true;
+}
+
+// False if uniform already holds value, program keeps uniforms between uses
+bool Shader::cacheValue(int id, const void* value, int bytes) {
+	if (bytes > UNIFORM_CACHE_BYTES) return true;
+	if (id >= (int)uniformCached.size()) {
+		uniformCached.resize(id + 1, false);
+		uniformValues.resize((id + 1) * UNIFORM_CACHE_BYTES);
+	}
+	byte* cached = &uniformValues[id * UNIFORM_CACHE_BYTES];
+	if (uniformCached[id] && memcmp(cached, value, bytes) == 0) return false;
+	memcpy(cached, value, bytes);
+	uniformCached[id] = true;
+	return true;
+}
+
 void Shader::use() {
 	program->use();
 }
@@ -77,6 +145,18 @@ int Shader::findParamLocation(const char* param) {
 	map<string, GLint>::iterator itor=paramLocations.find(param);
 	if(itor!=paramLocations.end())
 		return itor->second;
+	if (!reflected && program) {
+		addParam(param);
+		itor = paramLocations.find(param);
+		if (itor != paramLocations.end()) return itor->second;
+	}
+	return INVALID_LOCATION;
+}
+
+// Ids made after reflect are not active here
+int Shader::findParamLocation(int id) {
+	if (id < (int)uniformLocs.size()) return uniformLocs[id];
+	if (!reflected && program) return findParamLocation(UniformNames[id].data());
 	return INVALID_LOCATION;
 }
 
@@ -95,36 +175,32 @@ bool Shader::getError(const char* param, int location) {
 	return false;
 }
 
-void Shader::setInt(const char* param,int value) {
-	int location = findParamLocation(param);
-	if (location == INVALID_LOCATION) {
-		addParam(param);
-		location = findParamLocation(param);
-	}
-	if (location != INVALID_LOCATION && program)
-		glProgramUniform1i(program->shaderProg, location, value);
-	if (getError(param, location))
+void Shader::setInt(const char* param, int value) {
+	setInt(GetUniformId(param), value);
+}
+
+void Shader::setInt(int id, int value) {
+	int location = findParamLocation(id);
+	if (location == INVALID_LOCATION || !program || !cacheValue(id, &value, sizeof(int))) return;
+	glProgramUniform1i(program->shaderProg, location, value);
+	if (getError(UniformNames[id].data(), location))
 		printf("value is: %d\n", value);
 }
 
 void Shader::setUint(const char* param, uint value) {
-	int location = findParamLocation(param);
-	if (location == INVALID_LOCATION) {
-		addParam(param);
-		location = findParamLocation(param);
-	}
-	if (location != INVALID_LOCATION && program)
-		glProgramUniform1ui(program->shaderProg, location, value);
-	getError(param, location);
+	setUint(GetUniformId(param), value);
+}
+
+void Shader::setUint(int id, uint value) {
+	int location = findParamLocation(id);
+	if (location == INVALID_LOCATION || !program || !cacheValue(id, &value, sizeof(uint))) return;
+	glProgramUniform1ui(program->shaderProg, location, value);
+	getError(UniformNames[id].data(), location);
 }
 
 void Shader::setUintv(const char* param, int count, uint* arr) {
 	if (count <= 0) return;
 	int location = findParamLocation(param);
-	if (location == INVALID_LOCATION) {
-		addParam(param);
-		location = findParamLocation(param);
-	}
 	if (location != INVALID_LOCATION && program)
 		glProgramUniform1uiv(program->shaderProg, location, count, arr);
 	getError(param, location);
@@ -134,59 +210,58 @@ void Shader::setSampler(const char* param,int value) {
 	setInt(param,value);
 }
 
-void Shader::setFloat(const char* param,float value) {
-	int location = findParamLocation(param);
-	if (location == INVALID_LOCATION) {
-		addParam(param);
-		location = findParamLocation(param);
-	}
-	if (location != INVALID_LOCATION && program)
-		glProgramUniform1f(program->shaderProg, location, value);
-	if (getError(param, location))
+void Shader::setFloat(const char* param, float value) {
+	setFloat(GetUniformId(param), value);
+}
+
+void Shader::setFloat(int id, float value) {
+	int location = findParamLocation(id);
+	if (location == INVALID_LOCATION || !program || !cacheValue(id, &value, sizeof(float))) return;
+	glProgramUniform1f(program->shaderProg, location, value);
+	if (getError(UniformNames[id].data(), location))
 		printf("value is: %f\n", value);
 }
 
 void Shader::setIVector2(const char* param, int x, int y) {
-	int location = findParamLocation(param);
-	if (location == INVALID_LOCATION) {
-		addParam(param);
-		location = findParamLocation(param);
-	}
-	if (location != INVALID_LOCATION && program)
-		glProgramUniform2i(program->shaderProg, location, x, y);
-	if (getError(param, location))
+	setIVector2(GetUniformId(param), x, y);
+}
+
+void Shader::setIVector2(int id, int x, int y) {
+	int location = findParamLocation(id);
+	int value[2] = { x, y };
+	if (location == INVALID_LOCATION || !program || !cacheValue(id, value, sizeof(value))) return;
+	glProgramUniform2i(program->shaderProg, location, x, y);
+	if (getError(UniformNames[id].data(), location))
 		printf("value is: %d %d\n", x, y);
 }
 
-void Shader::setVector2(const char* param,float x,float y) {
-	int location = findParamLocation(param);
-	if (location == INVALID_LOCATION) {
-		addParam(param);
-		location = findParamLocation(param);
-	}
-	if (location != INVALID_LOCATION && program)
-		glProgramUniform2f(program->shaderProg, location, x, y);
-	getError(param, location);
+void Shader::setVector2(const char* param, float x, float y) {
+	setVector2(GetUniformId(param), x, y);
 }
 
-void Shader::setVector3(const char* param,float x,float y,float z) {
-	int location = findParamLocation(param);
-	if (location == INVALID_LOCATION) {
-		addParam(param);
-		location = findParamLocation(param);
-	}
-	if (location != INVALID_LOCATION && program)
-		glProgramUniform3f(program->shaderProg, location, x, y, z);
-	if (getError(param, location))
+void Shader::setVector2(int id, float x, float y) {
+	int location = findParamLocation(id);
+	float value[2] = { x, y };
+	if (location == INVALID_LOCATION || !program || !cacheValue(id, value, sizeof(value))) return;
+	glProgramUniform2f(program->shaderProg, location, x, y);
+	getError(UniformNames[id].data(), location);
+}
+
+void Shader::setVector3(const char* param, float x, float y, float z) {
+	setVector3(GetUniformId(param), x, y, z);
+}
+
+void Shader::setVector3(int id, float x, float y, float z) {
+	int location = findParamLocation(id);
+	float value[3] = { x, y, z };
+	if (location == INVALID_LOCATION || !program || !cacheValue(id, value, sizeof(value))) return;
+	glProgramUniform3f(program->shaderProg, location, x, y, z);
+	if (getError(UniformNames[id].data(), location))
 		printf("vec3 is: %f,%f,%f\n", x, y, z);
 }
 
 void Shader::setUVector3(const char* param, uint x, uint y, uint z) {
 	int location = findParamLocation(param);
-	if (location == INVALID_LOCATION) {
-		addParam(param);
-		location = findParamLocation(param);
-	}
 	if (location != INVALID_LOCATION && program)
 		glProgramUniform3ui(program->shaderProg, location, x, y, z);
 	if (getError(param, location))
@@ -194,91 +269,82 @@ void Shader::setUVector3(const char* param, uint x, uint y, uint z) {
 }
 
 void Shader::setUVector4(const char* param, uint x, uint y, uint z, uint w) {
-	int location = findParamLocation(param);
-	if (location == INVALID_LOCATION) {
-		addParam(param);
-		location = findParamLocation(param);
-	}
-	if (location != INVALID_LOCATION && program)
-		glProgramUniform4ui(program->shaderProg, location, x, y, z, w);
-	if (getError(param, location))
+	setUVector4(GetUniformId(param), x, y, z, w);
+}
+
+void Shader::setUVector4(int id, uint x, uint y, uint z, uint w) {
+	int location = findParamLocation(id);
+	uint value[4] = { x, y, z, w };
+	if (location == INVALID_LOCATION || !program || !cacheValue(id, value, sizeof(value))) return;
+	glProgramUniform4ui(program->shaderProg, location, x, y, z, w);
+	if (getError(UniformNames[id].data(), location))
 		printf("vec4 is: %d,%d,%d,%d\n", x, y, z, w);
 }
 
 void Shader::setUVector4v(const char* param, int count, uint* arr) {
 	int location = findParamLocation(param);
-	if (location == INVALID_LOCATION) {
-		addParam(param);
-		location = findParamLocation(param);
-	}
 	if (location != INVALID_LOCATION && program)
 		glProgramUniform4uiv(program->shaderProg, location, count, arr);
 	getError(param, location);
 }
 
 void Shader::setIVector4(const char* param, int x, int y, int z, int w) {
-	int location = findParamLocation(param);
-	if (location == INVALID_LOCATION) {
-		addParam(param);
-		location = findParamLocation(param);
-	}
-	if (location != INVALID_LOCATION && program)
-		glProgramUniform4i(program->shaderProg, location, x, y, z, w);
-	if (getError(param, location))
+	setIVector4(GetUniformId(param), x, y, z, w);
+}
+
+void Shader::setIVector4(int id, int x, int y, int z, int w) {
+	int location = findParamLocation(id);
+	int value[4] = { x, y, z, w };
+	if (location == INVALID_LOCATION || !program || !cacheValue(id, value, sizeof(value))) return;
+	glProgramUniform4i(program->shaderProg, location, x, y, z, w);
+	if (getError(UniformNames[id].data(), location))
 		printf("vec4 is: %d,%d,%d,%d\n", x, y, z, w);
 }
 
-void Shader::setVector4(const char* param,float x,float y,float z,float w) {
-	int location = findParamLocation(param);
-	if (location == INVALID_LOCATION) {
-		addParam(param);
-		location = findParamLocation(param);
-	}
-	if (location != INVALID_LOCATION && program)
-		glProgramUniform4f(program->shaderProg, location, x, y, z, w);
-	getError(param, location);
+void Shader::setVector4(const char* param, float x, float y, float z, float w) {
+	setVector4(GetUniformId(param), x, y, z, w);
+}
+
+void Shader::setVector4(int id, float x, float y, float z, float w) {
+	int location = findParamLocation(id);
+	float value[4] = { x, y, z, w };
+	if (location == INVALID_LOCATION || !program || !cacheValue(id, value, sizeof(value))) return;
+	glProgramUniform4f(program->shaderProg, location, x, y, z, w);
+	getError(UniformNames[id].data(), location);
 }
 
 void Shader::setVector2v(const char* param, float* arr) {
 	int location = findParamLocation(param);
-	if (location == INVALID_LOCATION) {
-		addParam(param);
-		location = findParamLocation(param);
-	}
 	if (location != INVALID_LOCATION && program)
 		glProgramUniform2fv(program->shaderProg, location, 1, arr);
 	getError(param, location);
 }
 
 void Shader::setVector2v(const char* param, int count, float* arr) {
-	int location = findParamLocation(param);
-	if (location == INVALID_LOCATION) {
-		addParam(param);
-		location = findParamLocation(param);
-	}
-	if (location != INVALID_LOCATION && program)
-		glProgramUniform2fv(program->shaderProg, location, count, arr);
-	getError(param, location);
+	setVector2v(GetUniformId(param), count, arr);
+}
+
+void Shader::setVector2v(int id, int count, float* arr) {
+	int location = findParamLocation(id);
+	if (location == INVALID_LOCATION || !program || !cacheValue(id, arr, count * 2 * sizeof(float))) return;
+	glProgramUniform2fv(program->shaderProg, location, count, arr);
+	getError(UniformNames[id].data(), location);
 }
 
 void Shader::setVector3v(const char* param, float* arr) {
-	int location = findParamLocation(param);
-	if (location == INVALID_LOCATION) {
-		addParam(param);
-		location = findParamLocation(param);
-	}
-	if (location != INVALID_LOCATION && program)
-		glProgramUniform3fv(program->shaderProg, location, 1, arr);
-	if (getError(param, location)) 
+	setVector3v(GetUniformId(param), arr);
+}
+
+void Shader::setVector3v(int id, float* arr) {
+	int location = findParamLocation(id);
+	if (location == INVALID_LOCATION || !program || !cacheValue(id, arr, 3 * sizeof(float))) return;
+	glProgramUniform3fv(program->shaderProg, location, 1, arr);
+	if (getError(UniformNames[id].data(), location))
 		printf("vec3 is: %f,%f,%f\n", arr[0], arr[1], arr[2]);
 }
 
 void Shader::setVector4v(const char* param, float* arr) {
 	int location = findParamLocation(param);
-	if (location == INVALID_LOCATION) {
-		addParam(param);
-		location = findParamLocation(param);
-	}
 	if (location != INVALID_LOCATION && program)
 		glProgramUniform4fv(program->shaderProg, location, 1, arr);
 	getError(param, location);
@@ -286,24 +352,20 @@ void Shader::setVector4v(const char* param, float* arr) {
 
 void Shader::setVector4v(const char* param, int count, float* arr) {
 	int location = findParamLocation(param);
-	if (location == INVALID_LOCATION) {
-		addParam(param);
-		location = findParamLocation(param);
-	}
 	if (location != INVALID_LOCATION && program)
 		glProgramUniform4fv(program->shaderProg, location, count, arr);
 	getError(param, location);
 }
 
-void Shader::setMatrix4(const char* param,float* matrix) {
-	int location = findParamLocation(param);
-	if (location == INVALID_LOCATION) {
-		addParam(param);
-		location = findParamLocation(param);
-	}
-	if (location != INVALID_LOCATION && program)
-		glProgramUniformMatrix4fv(program->shaderProg, location, 1, GL_FALSE, matrix);
-	if (getError(param, location)) {
+void Shader::setMatrix4(const char* param, float* matrix) {
+	setMatrix4(GetUniformId(param), matrix);
+}
+
+void Shader::setMatrix4(int id, float* matrix) {
+	int location = findParamLocation(id);
+	if (location == INVALID_LOCATION || !program || !cacheValue(id, matrix, 16 * sizeof(float))) return;
+	glProgramUniformMatrix4fv(program->shaderProg, location, 1, GL_FALSE, matrix);
+	if (getError(UniformNames[id].data(), location)) {
 		printf("matrix is: \n");
 		for (int i = 0; i < 4; i++)
 			printf("%f %f %f %f\n", matrix[i * 4 + 0], matrix[i * 4 + 1], matrix[i * 4 + 2], matrix[i * 4 + 3]);
@@ -313,33 +375,25 @@ void Shader::setMatrix4(const char* param,float* matrix) {
 void Shader::setMatrix4(const char* param,int count,float* matrices) {
 	if (count <= 0) return;
 	int location = findParamLocation(param);
-	if (location == INVALID_LOCATION) {
-		addParam(param);
-		location = findParamLocation(param);
-	}
 	if (location != INVALID_LOCATION && program)
 		glProgramUniformMatrix4fv(program->shaderProg, location, count, GL_FALSE, matrices);
 	getError(param, location);
 }
 
 void Shader::setMatrix3x4(const char* param, int count, float* matrices) {
+	setMatrix3x4(GetUniformId(param), count, matrices);
+}
+
+void Shader::setMatrix3x4(int id, int count, float* matrices) {
 	if (count <= 0) return;
-	int location = findParamLocation(param);
-	if (location == INVALID_LOCATION) {
-		addParam(param);
-		location = findParamLocation(param);
-	}
+	int location = findParamLocation(id);
 	if (location != INVALID_LOCATION && program)
 		glProgramUniformMatrix3x4fv(program->shaderProg, location, count, GL_FALSE, matrices);
-	getError(param, location);
+	getError(UniformNames[id].data(), location);
 }
 
 void Shader::setMatrix3(const char* param, float* matrix) {
 	int location = findParamLocation(param);
-	if (location == INVALID_LOCATION) {
-		addParam(param);
-		location = findParamLocation(param);
-	}
 	if (location != INVALID_LOCATION && program)
 		glProgramUniformMatrix3fv(program->shaderProg, location, 1, GL_FALSE, matrix);
 	getError(param, location);
@@ -348,42 +402,38 @@ void Shader::setMatrix3(const char* param, float* matrix) {
 void Shader::setMatrix3(const char* param, int count, float* matrices) {
 	if (count <= 0) return;
 	int location = findParamLocation(param);
-	if (location == INVALID_LOCATION) {
-		addParam(param);
-		location = findParamLocation(param);
-	}
 	if (location != INVALID_LOCATION && program)
 		glProgramUniformMatrix3fv(program->shaderProg, location, count, GL_FALSE, matrices);
 	getError(param, location);
 }
 
 void Shader::setHandle64(const char* param, u64 value) {
-	int location = findParamLocation(param);
-	if (location == INVALID_LOCATION) {
-		addParam(param);
-		location = findParamLocation(param);
-	}
-	if (location != INVALID_LOCATION && program) {
-		glProgramUniformHandleui64ARB(program->shaderProg, location, value);
-		bindedTexs[value] = true;
-	}
-	if (getError(param, location))
+	setHandle64(GetUniformId(param), value);
+}
+
+void Shader::setHandle64(int id, u64 value) {
+	int location = findParamLocation(id);
+	if (location == INVALID_LOCATION || !program) return;
+	bindedTexs[value] = true;
+	if (!cacheValue(id, &value, sizeof(u64))) return;
+	glProgramUniformHandleui64ARB(program->shaderProg, location, value);
+	if (getError(UniformNames[id].data(), location))
 		printf("value is: %lld\n", value);
 }
 
 void Shader::setHandle64v(const char* param, int count, u64* arr) {
+	setHandle64v(GetUniformId(param), count, arr);
+}
+
+void Shader::setHandle64v(int id, int count, u64* arr) {
 	if (count <= 0) return;
-	int location = findParamLocation(param);
-	if (location == INVALID_LOCATION) {
-		addParam(param);
-		location = findParamLocation(param);
-	}
+	int location = findParamLocation(id);
 	if (location != INVALID_LOCATION && program) {
 		glProgramUniformHandleui64vARB(program->shaderProg, location, count, arr);
 		for (int i = 0; i < count; i++)
 			bindedTexs[arr[i]] = true;
 	}
-	if (getError(param, location))
+	if (getError(UniformNames[id].data(), location))
 		printf("value is: %lld\n", arr[count - 1]);
 }
 
@@ -12,11 +12,14 @@
 #include "../constants/constants.h"
 #include <map>
 #include <string>
+#include <vector>
 
 #ifndef INVALID_LOCATION 
 #define INVALID_LOCATION -1
 #endif
 
+#define UNIFORM_CACHE_BYTES 64 // Largest value kept to skip redundant sets, a mat4
+
 class Shader {
 private:
 	ShaderProgram* program;
@@ -27,6 +30,18 @@ private:
 	std::map<int, u64> slotHnds;
 	std::string vertName, fragName;
 	std::string compName;
+	std::vector<GLint> uniformLocs; // By uniform id, reflected after link
+	std::vector<byte> uniformValues;
+	std::vector<bool> uniformCached;
+	bool reflected;
+private:
+	static std::map<std::string, int> UniformIds;
+	static std::vector<std::string> UniformNames;
+private:
+	bool cacheValue(int id, const void* value, int bytes);
+public:
+	// Same id in all shaders, resolve once & keep it (e.g. in a static)
+	static int GetUniformId(const char* name);
 public:
 	bool isTexBinded(u64 texhnd) { 
 		std::map<u64, bool>::iterator it = bindedTexs.find(texhnd);
@@ -55,38 +70,59 @@ public:
 	void attachEx(std::string ex);
 	void compose();
 	void compile(bool preload);
+	bool loadBinary();
+	void saveBinary();
 	void dettach();
+	// Read active uniform locations, resets cached values
+	void reflect();
 	void use();
+	uint getProgramId() { return program->shaderProg; }
 	void addAttrib(const char* name);
 	void addParam(const char* name);
 	int findAttribLocation(const char* attrib);
 	int findParamLocation(const char* param);
+	int findParamLocation(int id);
 	bool getError(const char* param, int location);
 	void setInt(const char* param,int value);
+	void setInt(int id, int value);
 	void setUint(const char* param, uint value);
+	void setUint(int id, uint value);
 	void setUintv(const char* param, int count, uint* arr);
 	void setSampler(const char* param,int value);
 	void setFloat(const char* param,float value);
+	void setFloat(int id, float value);
 	void setIVector2(const char* param, int x, int y);
+	void setIVector2(int id, int x, int y);
 	void setVector2(const char* param,float x,float y);
+	void setVector2(int id, float x, float y);
 	void setVector3(const char* param,float x,float y,float z);
+	void setVector3(int id, float x, float y, float z);
 	void setUVector3(const char* param, uint x, uint y, uint z);
 	void setUVector4(const char* param, uint x, uint y, uint z, uint w);
+	void setUVector4(int id, uint x, uint y, uint z, uint w);
 	void setUVector4v(const char* param, int count, uint* arr);
 	void setIVector4(const char* param, int x, int y, int z, int w);
+	void setIVector4(int id, int x, int y, int z, int w);
 	void setVector4(const char* param,float x,float y,float z,float w);
+	void setVector4(int id, float x, float y, float z, float w);
 	void setVector2v(const char* param, float* arr);
 	void setVector2v(const char* param, int count, float* arr);
+	void setVector2v(int id, int count, float* arr);
 	void setVector3v(const char* param, float* arr);
+	void setVector3v(int id, float* arr);
 	void setVector4v(const char* param, float* arr);
 	void setVector4v(const char* param, int count, float* arr);
 	void setMatrix4(const char* param,float* matrix);
+	void setMatrix4(int id, float* matrix);
 	void setMatrix4(const char* param,int count,float* matrices);
 	void setMatrix3x4(const char* param, int count, float* matrices);
+	void setMatrix3x4(int id, int count, float* matrices);
 	void setMatrix3(const char* param, float* matrix);
 	void setMatrix3(const char* param, int count, float* matrices);
 	void setHandle64(const char* param, u64 value);
+	void setHandle64(int id, u64 value);
 	void setHandle64v(const char* param, int count, u64* arr);
+	void setHandle64v(int id, int count, u64* arr);
 	void setSlotHnd(int slot, u64 hnd);
 };
 
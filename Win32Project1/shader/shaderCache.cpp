@@ -0,0 +1,144 @@
+#include "shaderCache.h"
+#include <stdio.h>
+#include <string.h>
+#include <map>
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#endif
+using namespace std;
+
+static const u64 FnvOffset = 14695981039346656037ULL;
+static const u64 FnvPrime = 1099511628211ULL;
+
+static map<string, string> ShaderFiles;
+
+static u64 HashBytes(u64 hash, const byte* data, uint size) {
+	for (uint i = 0; i < size; i++) {
+		hash ^= data[i];
+		hash *= FnvPrime;
+	}
+	return hash;
+}
+
+static void MakeCacheDir() {
+#ifdef _WIN32
+	_mkdir(SHADER_CACHE_DIR);
+#else
+	mkdir(SHADER_CACHE_DIR, 0755);
+#endif
+}
+
+static void GetCachePath(u64 hash, char* path) {
+	sprintf(path, "%s/%016llx.bin", SHADER_CACHE_DIR, (unsigned long long)hash);
+}
+
+const string& ReadShaderFile(const char* path) {
+	map<string, string>::iterator it = ShaderFiles.find(path);
+	if (it != ShaderFiles.end()) return it->second;
+
+	string text("");
+	FILE* file = fopen(path, "rb");
+	if (file) {
+		char buffer[4096];
+		size_t count = 0;
+		while ((count = fread(buffer, 1, sizeof(buffer), file)) > 0)
+			text.append(buffer, count);
+		fclose(file);
+	} else
+		printf("shader file %s read failed\n", path);
+	return ShaderFiles[path] = text;
+}
+
+void ClearShaderFiles() {
+	ShaderFiles.clear();
+}
+
+string ResolveIncludes(const char* source) {
+	if (!source) return "";
+	vector<string> incs; incs.clear();
+	string res(source);
+	size_t fi = res.find("#include");
+	while (fi != string::npos) {
+		res = res.replace(fi, strlen("#include"), string(""));
+
+		size_t fs = res.find_first_of('"', fi);
+		if (fs == string::npos) break;
+		size_t fe = res.find_first_of('"', fs + 1);
+		if (fe == string::npos) break;
+		string path = res.substr(fs + 1, fe - fs - 1);
+		res = res.replace(fs, fe - fs + 1, "");
+
+		incs.push_back(ReadShaderFile(path.data()) + string("\n"));
+		fi = res.find("#include");
+	}
+	string incStr("");
+	for (uint i = 0; i < incs.size(); ++i)
+		incStr += incs[i];
+	return incStr + res;
+}
+
+string ComposeShaderSource(const char* version, const string& exStr, const string& source) {
+	if (source.length() == 0) return "";
+	string shstr = string(version) + string("\n");
+	if (exStr.length() > 0) shstr += exStr + string("\n");
+	shstr += source;
+	return shstr;
+}
+
+u64 HashShaderSources(const string* sources, int count, const string& driver) {
+	u64 hash = FnvOffset;
+	uint version = SHADER_CACHE_VERSION;
+	hash = HashBytes(hash, (const byte*)&version, sizeof(uint));
+	hash = HashBytes(hash, (const byte*)driver.data(), (uint)driver.length());
+	for (int i = 0; i < count; i++) {
+		uint length = (uint)sources[i].length(); // Keeps stage boundaries in hash
+		hash = HashBytes(hash, (const byte*)&length, sizeof(uint));
+		hash = HashBytes(hash, (const byte*)sources[i].data(), length);
+	}
+	return hash;
+}
+
+bool LoadProgramBinary(u64 hash, uint& format, vector<byte>& data) {
+	char path[256];
+	GetCachePath(hash, path);
+	FILE* file = fopen(path, "rb");
+	if (!file) return false;
+
+	uint header[4] = { 0, 0, 0, 0 };
+	u64 key = 0;
+	bool ok = fread(header, sizeof(uint), 4, file) == 4 && fread(&key, sizeof(u64), 1, file) == 1;
+	ok = ok && header[0] == SHADER_CACHE_MAGIC && header[1] == SHADER_CACHE_VERSION && key == hash && header[3] > 0;
+	if (ok) {
+		format = header[2];
+		data.resize(header[3]);
+		ok = fread(&data[0], 1, header[3], file) == header[3];
+	}
+	fclose(file);
+	if (!ok) data.clear();
+	return ok;
+}
+
+// Write to temp file then rename, other instances never see half written cache
+bool SaveProgramBinary(u64 hash, uint format, const vector<byte>& data) {
+	if (data.size() <= 0) return false;
+	MakeCacheDir();
+	char path[256], tmpPath[300];
+	GetCachePath(hash, path);
+	sprintf(tmpPath, "%s.%p.tmp", path, &data);
+	FILE* file = fopen(tmpPath, "wb");
+	if (!file) return false;
+
+	uint header[4] = { SHADER_CACHE_MAGIC, SHADER_CACHE_VERSION, format, (uint)data.size() };
+	bool ok = fwrite(header, sizeof(uint), 4, file) == 4 && fwrite(&hash, sizeof(u64), 1, file) == 1 &&
+		fwrite(&data[0], 1, data.size(), file) == data.size();
+	fclose(file);
+
+	if (ok) {
+		remove(path);
+		ok = rename(tmpPath, path) == 0;
+	}
+	if (!ok) remove(tmpPath);
+	return ok;
+}
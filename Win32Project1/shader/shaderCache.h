@@ -0,0 +1,26 @@
+#ifndef SHADER_CACHE_H_
+#define SHADER_CACHE_H_
+
+#include "../constants/constants.h"
+#include <string>
+#include <vector>
+
+#define SHADER_CACHE_DIR "shader/cache"
+#define SHADER_CACHE_MAGIC 0x42534854 // "THSB"
+#define SHADER_CACHE_VERSION 1
+
+// No gl calls here, preprocess & hash work without a context
+
+// Text of shader file, each file read from disk once
+const std::string& ReadShaderFile(const char* path);
+void ClearShaderFiles();
+// Splice #include files in front of source
+std::string ResolveIncludes(const char* source);
+// Version line, attached defines then source, empty if no source
+std::string ComposeShaderSource(const char* version, const std::string& exStr, const std::string& source);
+// Key of program binary, driver string makes binaries of other drivers miss
+u64 HashShaderSources(const std::string* sources, int count, const std::string& driver);
+bool LoadProgramBinary(u64 hash, uint& format, std::vector<byte>& data);
+bool SaveProgramBinary(u64 hash, uint format, const std::vector<byte>& data);
+
+#endif
@@ -40,13 +40,17 @@ void ShaderManager::compile() {
 	while (itor != shaders.end()) {
 		Shader* shader = itor->second;
 		shader->compose();
-
-		shader->compile(true); // Preload
-		shader->dettach();
-
-		shader->compile(false);
+		if (!shader->loadBinary()) {
+			shader->compile(true); // Preload
+			shader->dettach();
+
+			shader->compile(false);
+			shader->saveBinary();
+		}
+		shader->reflect();
 		++itor;
 	}
+	ClearShaderFiles();
 }
 
 void ShaderManager::addShaderBindTex(Shader* shader) {
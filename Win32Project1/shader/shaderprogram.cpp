@@ -55,14 +55,6 @@ void printProgramInfoLog(GLuint obj, const char* vsStr, const char* fsStr)
 	}
 }
 
-std::string ShaderProgram::attach(const char* version, const char* shaderStr) {
-	if (!shaderStr || strlen(shaderStr) == 0) return "";
-	string shstr = string(version) + string("\n");
-	if (exStr.length() > 0) shstr += exStr + string("\n");
-	shstr += string(shaderStr);
-	return shstr;
-}
-
 ShaderProgram::ShaderProgram(const char* vert, const char* frag, const char* tesc, const char* tese, const char* geom) {
 	vfile = (char*)vert, ffile = (char*)frag, cfile = (char*)tesc, efile = (char*)tese, gfile = (char*)geom, pfile = NULL;
 	vs = NULL, fs = NULL, tc = NULL, te = NULL, gs = NULL, cs = NULL;
@@ -75,6 +67,8 @@ ShaderProgram::ShaderProgram(const char* vert, const char* frag, const char* tes
 	if (gfile) gs = textFileRead(gfile);
 
 	exStr = "";
+	sourceHash = 0;
+	shaderProg = 0;
 }
 
 ShaderProgram::ShaderProgram(const char* comp) {
@@ -85,6 +79,8 @@ ShaderProgram::ShaderProgram(const char* comp) {
 	if (pfile) cs = textFileRead(pfile);
 
 	exStr = "";
+	sourceHash = 0;
+	shaderProg = 0;
 }
 
 void ShaderProgram::attachDef(const char* def, const char* value) {
@@ -98,42 +94,27 @@ void ShaderProgram::attachEx(const char* ex) {
 void ShaderProgram::compose() {
 	const char* version = "#version 450";
 	if (vs && fs) {
-		vStr = attach(version, handleInclude(vs).data());
-		fStr = attach(version, handleInclude(fs).data());
-		cStr = attach(version, handleInclude(tc).data());
-		eStr = attach(version, handleInclude(te).data());
-		gStr = attach(version, handleInclude(gs).data());
+		vStr = ComposeShaderSource(version, exStr, ResolveIncludes(vs));
+		fStr = ComposeShaderSource(version, exStr, ResolveIncludes(fs));
+		cStr = ComposeShaderSource(version, exStr, ResolveIncludes(tc));
+		eStr = ComposeShaderSource(version, exStr, ResolveIncludes(te));
+		gStr = ComposeShaderSource(version, exStr, ResolveIncludes(gs));
 	}
-	if(cs) pStr = attach(version, handleInclude(cs).data());
+	if(cs) pStr = ComposeShaderSource(version, exStr, ResolveIncludes(cs));
+
+	string sources[6] = { vStr, fStr, cStr, eStr, gStr, pStr };
+	sourceHash = HashShaderSources(sources, 6, GetDriverString());
 }
 
-string ShaderProgram::handleInclude(const char* shaderStr) {
-	if (!shaderStr) return "";
-	vector<string> incs; incs.clear();
-	string res(shaderStr);
-	int fs = 0, fe = 0;
-	int fi = res.find("#include");
-	while (fi != string::npos) {
-		res = res.replace(fi, strlen("#include"), string(""));
-		
-		fs = res.find_first_of('"');
-		string path = res.substr(fs + 1);
-		fe = path.find_first_of('"');
-		path = path.substr(0, fe);
-		
-		res = res.replace(fs, strlen(path.data()) + 2, "");
-
-		char* fileStr = textFileRead((char*)path.data());
-		incs.push_back(string(fileStr) + string("\n"));
-		free(fileStr);
-
-		fi = res.find("#include");
+string ShaderProgram::GetDriverString() {
+	static string driver("");
+	if (driver.length() == 0) {
+		const char* vendor = (const char*)glGetString(GL_VENDOR);
+		const char* renderer = (const char*)glGetString(GL_RENDERER);
+		const char* version = (const char*)glGetString(GL_VERSION);
+		driver = string(vendor ? vendor : "") + "|" + string(renderer ? renderer : "") + "|" + string(version ? version : "");
 	}
-	string incStr("");
-	for (int i = 0; i < incs.size(); ++i)
-		incStr += incs[i];
-	res = incStr + res;
-	return res;
+	return driver;
 }
 
 void ShaderProgram::compile(bool preload) {
@@ -200,6 +181,7 @@ void ShaderProgram::compile(bool preload) {
 	if (geomShader) glAttachShader(shaderProg, geomShader);
 	if (compShader) glAttachShader(shaderProg, compShader);
 
+	glProgramParameteri(shaderProg, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
 	glLinkProgram(shaderProg);
 	if (!preload) {
 		if (vfile && ffile)
@@ -210,6 +192,36 @@ void ShaderProgram::compile(bool preload) {
 	}
 }
 
+bool ShaderProgram::loadBinary() {
+	uint format = 0;
+	vector<byte> data;
+	if (sourceHash == 0 || !LoadProgramBinary(sourceHash, format, data)) return false;
+
+	shaderProg = glCreateProgram();
+	glProgramBinary(shaderProg, (GLenum)format, &data[0], (GLsizei)data.size());
+	GLint isLinked = GL_FALSE;
+	glGetProgramiv(shaderProg, GL_LINK_STATUS, &isLinked);
+	if (isLinked == GL_FALSE) {
+		glDeleteProgram(shaderProg);
+		shaderProg = 0;
+		return false;
+	}
+	return true;
+}
+
+void ShaderProgram::saveBinary() {
+	GLint isLinked = GL_FALSE, length = 0;
+	glGetProgramiv(shaderProg, GL_LINK_STATUS, &isLinked);
+	glGetProgramiv(shaderProg, GL_PROGRAM_BINARY_LENGTH, &length);
+	if (isLinked == GL_FALSE || length <= 0) return;
+
+	GLenum format = 0;
+	vector<byte> data(length);
+	glGetProgramBinary(shaderProg, length, NULL, &format, &data[0]);
+	if (!SaveProgramBinary(sourceHash, (uint)format, data))
+		printf("program binary cache write failed\n");
+}
+
 void ShaderProgram::dettach() {
 	if (vertShader) glDetachShader(shaderProg, vertShader);
 	if (fragShader) glDetachShader(shaderProg, fragShader);
@@ -224,7 +236,9 @@ void ShaderProgram::dettach() {
 	if (teseShader) glDeleteShader(teseShader);
 	if (geomShader) glDeleteShader(geomShader);
 	if (compShader) glDeleteShader(compShader);
-	glDeleteProgram(shaderProg);
+	vertShader = 0, fragShader = 0, tescShader = 0, teseShader = 0, geomShader = 0, compShader = 0;
+	if (shaderProg) glDeleteProgram(shaderProg);
+	shaderProg = 0;
 }
 
 ShaderProgram::~ShaderProgram() {
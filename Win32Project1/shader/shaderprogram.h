@@ -4,6 +4,7 @@
 #include "../render/glheader.h"
 #include "../constants/constants.h"
 #include "textfile.h"
+#include "shaderCache.h"
 #include <string>
 
 class ShaderProgram {
@@ -23,11 +24,11 @@ private:
 	std::string pStr;
 private:
 	std::string exStr;
+	u64 sourceHash; // Of composed sources & driver, 0 before compose
 public:
 	GLuint shaderProg;
 private:
-	std::string attach(const char* version, const char* shaderStr);
-	std::string handleInclude(const char* shaderStr);
+	static std::string GetDriverString();
 public:
 	ShaderProgram(const char* vert, const char* frag, const char* tesc = NULL, const char* tese = NULL, const char* geom = NULL);
 	ShaderProgram(const char* comp);
@@ -35,6 +36,9 @@ public:
 public:
 	void compose();
 	void compile(bool preload);
+	// Link from cached binary, false if missing or driver refuses it
+	bool loadBinary();
+	void saveBinary();
 	void dettach();
 	void attachDef(const char* def, const char* value);
 	void attachEx(const char* ex);
@@ -190,6 +190,12 @@ void SimpleApplication::preDraw() {
 void SimpleApplication::draw() {
 	if (!sceneFilter || !renderMgr || !AssetManager::assetManager) return;
 	else preDraw();
+	render->beginFrame();
+
+	TextureBindless* texBld = AssetManager::assetManager->texBld;
+	bool texChanged = texBld->updateUploads(TEXTURE_UPLOAD_BUDGET);
+	if (texBld->updateStreaming()) texChanged = true;
+	if (texChanged) render->setTextureBindless2Shaders(texBld);
 
 	if (ssrChain) {
 		AssetManager::assetManager->setReflectTexture(ssrBlurFilter->getOutput(0));
@@ -336,8 +342,7 @@ void SimpleApplication::act(long startTime, long currentTime, float dTime, float
 	scene->updateNodes();
 
 	scene->collisionWorld->act(dTime);
-	scene->updateDynamicNodes();
-	scene->updateAnimNodes();
+	scene->updatePhysicsNodes();
 	scene->player->updateCamera();
 	updateMovement();
 
@@ -347,6 +352,7 @@ void SimpleApplication::act(long startTime, long currentTime, float dTime, float
 	animNode->getObject()->playEffect("bark");
 
 	scene->updateListenerPosition();
+	scene->updateSounds(dTime);
 	if (!cfgs->ssr) scene->updateReflectCamera();
 }
 
@@ -407,38 +413,38 @@ void SimpleApplication::initScene() {
 
 	// Load textures
 	assetMgr->addTextureBindless("cube.bmp", true);
-	assetMgr->addTextureBindless("ground_n.bmp", false);
+	assetMgr->addTextureBindless("ground_n.bmp", false, WRAP_REPEAT, USAGE_NORMAL);
 	assetMgr->addTextureBindless("ground.bmp", true);
-	assetMgr->addTextureBindless("ground_norm.bmp", false);
+	assetMgr->addTextureBindless("ground_norm.bmp", false, WRAP_REPEAT, USAGE_NORMAL);
 	assetMgr->addTextureBindless("ground_g.bmp", true);
 	assetMgr->addTextureBindless("ground_r.bmp", true);
 	assetMgr->addTextureBindless("ground_s.bmp", true);
 	assetMgr->addTextureBindless("ground_s2.bmp", true);
-	assetMgr->addTextureBindless("rnormal.bmp", false);
+	assetMgr->addTextureBindless("rnormal.bmp", false, WRAP_REPEAT, USAGE_NORMAL);
 	assetMgr->addTextureBindless("sand.bmp", true);
 	assetMgr->addTextureBindless("tree.bmp", true);
 	assetMgr->addTextureBindless("treeA.bmp", true);
 	assetMgr->addTextureBindless("mixedmoss-albedo2.bmp", true);
-	assetMgr->addTextureBindless("mixedmoss-normal2.bmp", false);
+	assetMgr->addTextureBindless("mixedmoss-normal2.bmp", false, WRAP_REPEAT, USAGE_NORMAL);
 	assetMgr->addTextureBindless("mixedmoss-roughness.bmp", false);
 	assetMgr->addTextureBindless("mixedmoss-metalness.bmp", false);
 	assetMgr->addTextureBindless("rustediron2_basecolor.png", true);
-	assetMgr->addTextureBindless("rustediron2_normal.png", false);
+	assetMgr->addTextureBindless("rustediron2_normal.png", false, WRAP_REPEAT, USAGE_NORMAL);
 	assetMgr->addTextureBindless("rustediron2_roughness.png", false);
 	assetMgr->addTextureBindless("rustediron2_metallic.png", false);
 	assetMgr->addTextureBindless("rustediron2_metallic_roughness.png", false);
 	assetMgr->addTextureBindless("streaky-metal1_albedo.png", true);
-	assetMgr->addTextureBindless("streaky-metal1_normal-ogl.png", false);
+	assetMgr->addTextureBindless("streaky-metal1_normal-ogl.png", false, WRAP_REPEAT, USAGE_NORMAL);
 	assetMgr->addTextureBindless("streaky-metal1_roughness.png", false);
 	assetMgr->addTextureBindless("streaky-metal1_metallic.png", false);
 	assetMgr->addTextureBindless("streaky-metal1_metallic_roughness.png", false);
 	assetMgr->addTextureBindless("lightgold_albedo.png", true);
-	assetMgr->addTextureBindless("lightgold_normal-ogl.png", false);
+	assetMgr->addTextureBindless("lightgold_normal-ogl.png", false, WRAP_REPEAT, USAGE_NORMAL);
 	assetMgr->addTextureBindless("lightgold_roughness.png", false);
 	assetMgr->addTextureBindless("lightgold_metallic.png", false);
 	assetMgr->addTextureBindless("lightgold_metallic_roughness.png", false);
 	assetMgr->addTextureBindless("grass1-albedo3.bmp", true);
-	assetMgr->addTextureBindless("grass1-normal1-dx.bmp", false);
+	assetMgr->addTextureBindless("grass1-normal1-dx.bmp", false, WRAP_REPEAT, USAGE_NORMAL);
 	assetMgr->addTextureBindless("ninja_red.bmp", true);
 	assetMgr->addTextureBindless("ninja_blue.bmp", true);
 	assetMgr->addDistortionTex("distortion.bmp");
@@ -527,6 +533,8 @@ void SimpleApplication::initScene() {
 	billboardTreeAMat->tex1 = "treeA.bmp";
 	mtlMgr->add(billboardTreeAMat);
 
+	if (cfgs->texbudget > 0) 
+		assetMgr->texBld->setStreamBudget((u64)cfgs->texbudget * 1024 * 1024);
 	assetMgr->initTextureBindless(mtlMgr);
 	render->setTextureBindless2Shaders(assetMgr->texBld);
 
@@ -924,11 +932,11 @@ void SimpleApplication::initScene() {
 	scene->updateNodes();
 	scene->initAnimNodes();
 
-	SoundObject* ambSound = new SoundObject("sounds/amb.wav");
+	SoundStream* ambSound = new SoundStream("sounds/amb.wav");
 	ambSound->setLoop(true);
 	ambSound->setGain(50.0);
 	ambSound->setPosition(vec3(0, 50, 0));
-	scene->addSound(ambSound);
+	scene->addStream(ambSound);
 	scene->playSounds();
 	
 	Application::initScene();
@@ -53,41 +53,44 @@ Sky::~Sky() {
 	if (skyBuff) delete skyBuff; skyBuff = NULL;
 }
 
-void Sky::update(Render* render, const vec3& sunPos, Shader* shader) {
+// Light direction comes from pass block
+void Sky::update(Render* render, Shader* shader) {
+	static int udotlId = Shader::GetUniformId("udotl");
+	static int timeId = Shader::GetUniformId("time");
+	static int viewProjectId = Shader::GetUniformId("viewProjectMatrix");
 	if (!skyBuff) return;
 	state->delay = 0;
 	state->skyPass = false;
 	state->atmoPass = true;
 	state->cloudPass = false;
 	state->shader = shader;
-	state->shader->setVector3("light", -sunPos.x, -sunPos.y, -sunPos.z);
-	state->shader->setFloat("udotl", state->udotl);
-	state->shader->setFloat("time", state->time);
+	state->shader->setFloat(udotlId, state->udotl);
+	state->shader->setFloat(timeId, state->time);
 	render->useFrameBuffer(skyBuff);
 	
 	for (int i = 0; i < MaxIblLevel; ++i) {
 		render->useFrameCube(0, i);
-		render->setShaderMat4(shader, "viewProjectMatrix", matPosx);
+		render->setShaderMat4(shader, viewProjectId, matPosx);
 		render->draw(NULL, skyNode->drawcall, state);
 
 		render->useFrameCube(1, i);
-		render->setShaderMat4(shader, "viewProjectMatrix", matNegx);
+		render->setShaderMat4(shader, viewProjectId, matNegx);
 		render->draw(NULL, skyNode->drawcall, state);
 
 		render->useFrameCube(2, i);
-		render->setShaderMat4(shader, "viewProjectMatrix", matPosy);
+		render->setShaderMat4(shader, viewProjectId, matPosy);
 		render->draw(NULL, skyNode->drawcall, state);
 
 		render->useFrameCube(3, i);
-		render->setShaderMat4(shader, "viewProjectMatrix", matNegy);
+		render->setShaderMat4(shader, viewProjectId, matNegy);
 		render->draw(NULL, skyNode->drawcall, state);
 
 		render->useFrameCube(4, i);
-		render->setShaderMat4(shader, "viewProjectMatrix", matPosz);
+		render->setShaderMat4(shader, viewProjectId, matPosz);
 		render->draw(NULL, skyNode->drawcall, state);
 
 		render->useFrameCube(5, i);
-		render->setShaderMat4(shader, "viewProjectMatrix", matNegz);
+		render->setShaderMat4(shader, viewProjectId, matNegz);
 		render->draw(NULL, skyNode->drawcall, state);
 	}
 }
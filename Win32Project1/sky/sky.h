@@ -27,7 +27,7 @@ public:
 	Sky(Scene* scene, bool dyn);
 	~Sky();
 public:
-	void update(Render* render, const vec3& sunPos, Shader* shader);
+	void update(Render* render, Shader* shader);
 	void draw(Render* render,Shader* shader,Camera* camera);
 };
 
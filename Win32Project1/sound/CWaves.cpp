@@ -102,7 +102,7 @@ bool CWaves::loadWavFile(const char* filename, ALuint* source, ALuint* buffer,
 	//check for success  
 	alBufferData(*buffer, *aFormat, (void*)data,
 		*aSize, *aFrequency);
-	alSourcei(*source, AL_BUFFER, *buffer);
+	if (source) alSourcei(*source, AL_BUFFER, *buffer);
 
 	//clean up and return true if successful  
 	free(mem);
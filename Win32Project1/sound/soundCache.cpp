@@ -0,0 +1,53 @@
+#include "soundCache.h"
+
+SoundCache::SoundCache() {
+	buffers.clear();
+}
+
+SoundCache::~SoundCache() {
+	std::map<std::string, SoundBuffer*>::iterator it;
+	for (it = buffers.begin(); it != buffers.end(); ++it) {
+		alDeleteBuffers(1, &it->second->buffer);
+		delete it->second;
+	}
+	buffers.clear();
+}
+
+SoundBuffer* SoundCache::acquire(const char* path) {
+	std::map<std::string, SoundBuffer*>::iterator it = buffers.find(path);
+	if (it != buffers.end()) {
+		it->second->refCount++;
+		return it->second;
+	}
+
+	SoundBuffer* sample = new SoundBuffer();
+	sample->path = path;
+	alGenBuffers(1, &sample->buffer);
+	CWaves file;
+	if (!file.loadWavFile(path, NULL, &sample->buffer, &sample->size, &sample->frequency, &sample->format)) {
+		printf("sound %s load failed\n", path);
+		alDeleteBuffers(1, &sample->buffer);
+		delete sample;
+		return NULL;
+	}
+
+	int channels = (sample->format == AL_FORMAT_STEREO8 || sample->format == AL_FORMAT_STEREO16) ? 2 : 1;
+	int bytes = (sample->format == AL_FORMAT_MONO16 || sample->format == AL_FORMAT_STEREO16) ? 2 : 1;
+	sample->duration = sample->frequency > 0 ? (float)sample->size / (channels * bytes * sample->frequency) : 0.0;
+	sample->refCount = 1;
+	buffers[sample->path] = sample;
+	return sample;
+}
+
+// Buffers stay until cache is gone, same file often comes back
+void SoundCache::release(SoundBuffer* sample) {
+	if (sample && sample->refCount > 0) sample->refCount--;
+}
+
+uint SoundCache::getMemorySize() {
+	uint size = 0;
+	std::map<std::string, SoundBuffer*>::iterator it;
+	for (it = buffers.begin(); it != buffers.end(); ++it)
+		size += it->second->size;
+	return size;
+}
@@ -0,0 +1,30 @@
+#ifndef SOUND_CACHE_H_
+#define SOUND_CACHE_H_
+
+#include "CWaves.h"
+#include <string>
+#include <map>
+
+// Pcm data of one file, shared by all sounds playing it
+struct SoundBuffer {
+	std::string path;
+	ALuint buffer;
+	ALenum format;
+	ALsizei frequency, size;
+	float duration; // Seconds
+	int refCount;
+};
+
+class SoundCache {
+private:
+	std::map<std::string, SoundBuffer*> buffers;
+public:
+	SoundCache();
+	~SoundCache();
+	// Load file once, NULL if it can not load
+	SoundBuffer* acquire(const char* path);
+	void release(SoundBuffer* sample);
+	uint getMemorySize();
+};
+
+#endif
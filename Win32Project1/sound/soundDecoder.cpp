@@ -0,0 +1,189 @@
+#include "soundDecoder.h"
+#include <string.h>
+
+static const int ImaIndexTable[16] = {
+	-1, -1, -1, -1, 2, 4, 6, 8,
+	-1, -1, -1, -1, 2, 4, 6, 8
+};
+
+static const int ImaStepTable[89] = {
+	7, 8, 9, 10, 11, 12, 13, 14, 16, 17,
+	19, 21, 23, 25, 28, 31, 34, 37, 41, 45,
+	50, 55, 60, 66, 73, 80, 88, 97, 107, 118,
+	130, 143, 157, 173, 190, 209, 230, 253, 279, 307,
+	337, 371, 408, 449, 494, 544, 598, 658, 724, 796,
+	876, 963, 1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066,
+	2272, 2499, 2749, 3024, 3327, 3660, 4026, 4428, 4871, 5358,
+	5894, 6484, 7132, 7845, 8630, 9493, 10442, 11487, 12635, 13899,
+	15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794, 32767
+};
+
+static inline short DecodeImaNibble(int nibble, int& predictor, int& index) {
+	int step = ImaStepTable[index];
+	int diff = step >> 3;
+	if (nibble & 1) diff += step >> 2;
+	if (nibble & 2) diff += step >> 1;
+	if (nibble & 4) diff += step;
+	predictor += (nibble & 8) ? -diff : diff;
+	predictor = predictor < -32768 ? -32768 : (predictor > 32767 ? 32767 : predictor);
+	index += ImaIndexTable[nibble];
+	index = index < 0 ? 0 : (index > 88 ? 88 : index);
+	return (short)predictor;
+}
+
+SoundDecoder::SoundDecoder() {
+	file = NULL;
+	format = 0;
+	channels = 0, sampleRate = 0, bitsPerSample = 0;
+	blockAlign = 0, samplesPerBlock = 0;
+	dataStart = 0;
+	dataSize = 0, dataRead = 0;
+	blockFrames = 0, blockPos = 0;
+}
+
+SoundDecoder::~SoundDecoder() {
+	close();
+}
+
+// Walk riff chunks to fmt & data, little endian files only
+bool SoundDecoder::open(const char* path) {
+	close();
+	file = fopen(path, "rb");
+	if (!file) {
+		printf("sound %s open failed\n", path);
+		return false;
+	}
+
+	char riff[12];
+	if (fread(riff, 1, 12, file) != 12 || memcmp(riff, "RIFF", 4) != 0 || memcmp(riff + 8, "WAVE", 4) != 0) {
+		printf("sound %s is not wave file\n", path);
+		close();
+		return false;
+	}
+
+	bool hasFormat = false;
+	while (true) {
+		char id[4];
+		uint size = 0;
+		if (fread(id, 1, 4, file) != 4 || fread(&size, 4, 1, file) != 1) break;
+		long next = ftell(file) + size + (size & 1);
+		if (memcmp(id, "fmt ", 4) == 0) {
+			byte fmt[26];
+			memset(fmt, 0, sizeof(fmt));
+			if (fread(fmt, 1, size < 26 ? size : 26, file) < 16) break;
+			format = fmt[0] | (fmt[1] << 8);
+			channels = fmt[2] | (fmt[3] << 8);
+			sampleRate = fmt[4] | (fmt[5] << 8) | (fmt[6] << 16) | (fmt[7] << 24);
+			blockAlign = fmt[12] | (fmt[13] << 8);
+			bitsPerSample = fmt[14] | (fmt[15] << 8);
+			samplesPerBlock = fmt[18] | (fmt[19] << 8);
+			if (format == WAVE_FORMAT_EXTENSIBLE) format = fmt[24] | (fmt[25] << 8); // Sub format guid
+			hasFormat = true;
+		} else if (memcmp(id, "data", 4) == 0) {
+			dataStart = ftell(file);
+			dataSize = size;
+			break;
+		}
+		fseek(file, next, SEEK_SET);
+	}
+
+	bool supported = hasFormat && dataStart > 0 && (channels == 1 || channels == 2);
+	if (format == WAVE_FORMAT_PCM)
+		supported = supported && (bitsPerSample == 8 || bitsPerSample == 16);
+	else if (format == WAVE_FORMAT_IMA_ADPCM) {
+		if (samplesPerBlock <= 0 && channels > 0) samplesPerBlock = (blockAlign - 4 * channels) * 2 / channels + 1;
+		supported = supported && bitsPerSample == 4 && blockAlign > 4 * channels;
+		block.resize(blockAlign);
+		blockPcm.resize(samplesPerBlock * channels);
+	} else
+		supported = false;
+	if (!supported) {
+		printf("sound %s format %d not supported\n", path, format);
+		close();
+		return false;
+	}
+	return rewind();
+}
+
+void SoundDecoder::close() {
+	if (file) fclose(file);
+	file = NULL;
+	dataStart = 0;
+	dataSize = 0, dataRead = 0;
+	blockFrames = 0, blockPos = 0;
+}
+
+bool SoundDecoder::rewind() {
+	if (!file) return false;
+	dataRead = 0;
+	blockFrames = 0, blockPos = 0;
+	return fseek(file, dataStart, SEEK_SET) == 0;
+}
+
+// Decode one ima adpcm block: per channel header, then 4 byte groups of 8 samples each channel
+bool SoundDecoder::readBlock() {
+	uint left = dataSize - dataRead;
+	uint size = left < (uint)blockAlign ? left : (uint)blockAlign;
+	if (size <= (uint)(4 * channels)) return false;
+	size = fread(&block[0], 1, size, file);
+	dataRead += size;
+	if (size <= (uint)(4 * channels)) return false;
+
+	int predictor[2], index[2];
+	for (int c = 0; c < channels; c++) {
+		byte* header = &block[4 * c];
+		predictor[c] = (short)(header[0] | (header[1] << 8));
+		index[c] = header[2] > 88 ? 88 : header[2];
+		blockPcm[c] = (short)predictor[c];
+	}
+
+	int frames = 1 + (size - 4 * channels) * 2 / channels;
+	if (frames > samplesPerBlock) frames = samplesPerBlock;
+	byte* data = &block[4 * channels];
+	for (int group = 0; 1 + group * 8 < frames; group++) {
+		for (int c = 0; c < channels; c++) {
+			byte* bytes = data + (group * channels + c) * 4;
+			for (int s = 0; s < 8; s++) {
+				int frame = 1 + group * 8 + s;
+				if (frame >= frames) break;
+				int nibble = (s & 1) ? (bytes[s >> 1] >> 4) : (bytes[s >> 1] & 0xf);
+				blockPcm[frame * channels + c] = DecodeImaNibble(nibble, predictor[c], index[c]);
+			}
+		}
+	}
+	blockFrames = frames;
+	blockPos = 0;
+	return true;
+}
+
+int SoundDecoder::decode(byte* out, int frames) {
+	if (!file) return 0;
+	int frameBytes = getFrameBytes();
+	if (format == WAVE_FORMAT_PCM) {
+		uint left = (dataSize - dataRead) / frameBytes;
+		uint count = (uint)frames < left ? (uint)frames : left;
+		count = fread(out, frameBytes, count, file);
+		dataRead += count * frameBytes;
+		return (int)count;
+	}
+
+	int written = 0;
+	while (written < frames) {
+		if (blockPos >= blockFrames && !readBlock()) break;
+		int count = blockFrames - blockPos;
+		if (count > frames - written) count = frames - written;
+		memcpy(out + written * frameBytes, &blockPcm[blockPos * channels], count * frameBytes);
+		blockPos += count;
+		written += count;
+	}
+	return written;
+}
+
+float SoundDecoder::getDuration() {
+	if (sampleRate <= 0 || channels <= 0) return 0.0;
+	if (format == WAVE_FORMAT_IMA_ADPCM) {
+		uint blocks = dataSize / blockAlign;
+		return (float)blocks * samplesPerBlock / sampleRate;
+	}
+	return (float)dataSize / (getFrameBytes() * sampleRate);
+}
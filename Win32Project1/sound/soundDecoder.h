@@ -0,0 +1,41 @@
+#ifndef SOUND_DECODER_H_
+#define SOUND_DECODER_H_
+
+#include "../constants/constants.h"
+#include <stdio.h>
+#include <vector>
+
+#define WAVE_FORMAT_PCM 1
+#define WAVE_FORMAT_IMA_ADPCM 0x11 // 4 bits per sample, decoded to 16 bit pcm
+#define WAVE_FORMAT_EXTENSIBLE 0xFFFE
+
+// Reads wav data in chunks from disk, no al calls so it runs on any thread
+class SoundDecoder {
+private:
+	FILE* file;
+	int format;
+	int channels, sampleRate, bitsPerSample;
+	int blockAlign, samplesPerBlock;
+	long dataStart;
+	uint dataSize, dataRead;
+	std::vector<byte> block;
+	std::vector<short> blockPcm;
+	int blockFrames, blockPos;
+private:
+	bool readBlock();
+public:
+	SoundDecoder();
+	~SoundDecoder();
+	bool open(const char* path);
+	void close();
+	// Fill out with up to frames frames, returns frames written, 0 at end
+	int decode(byte* out, int frames);
+	bool rewind();
+	int getChannels() { return channels; }
+	int getSampleRate() { return sampleRate; }
+	int getOutputBits() { return format == WAVE_FORMAT_IMA_ADPCM ? 16 : bitsPerSample; }
+	int getFrameBytes() { return channels * getOutputBits() / 8; }
+	float getDuration();
+};
+
+#endif
@@ -1,59 +1,101 @@
 #include "soundManager.h" 
 #include "../util/util.h"
+#include <algorithm>
 
 SoundObject::SoundObject(const char* path) {
-	filePath = std::string(path);
-	alGenBuffers(1, &alSampleSet);
-	alGenSources(1, &alSource);
-	CWaves file;
-	file.loadWavFile(filePath.data(), &alSource, &alSampleSet, &alBufferLen, &alFreqBuffer, &alFormatBuffer);
+	sample = NULL;
+	voice = -1;
+	position = vec3(0.0);
+	gain = 1.0;
+	playTime = 0.0;
+	priority = 0.0;
+	positionDirty = false;
+	isLoop = false;
 	isPlay = false;
-	setLoop(false);
-	setPosition(vec3(0.0));
+	if (SoundManager::soundManager) {
+		sample = SoundManager::soundManager->loadSample(path);
+		SoundManager::soundManager->addSound(this);
+	}
 }
 
+// Copies share pcm buffer, no file load
 SoundObject::SoundObject(const SoundObject& rhs) {
-	filePath = rhs.filePath;
-	alGenBuffers(1, &alSampleSet);
-	alGenSources(1, &alSource);
-	CWaves file;
-	file.loadWavFile(filePath.data(), &alSource, &alSampleSet, &alBufferLen, &alFreqBuffer, &alFormatBuffer);
-	isPlay = rhs.isPlay;
-	setLoop(rhs.isLoop);
-	setPosition(vec3(0, 0, 0));
+	sample = NULL;
+	voice = -1;
+	position = vec3(0.0);
+	gain = rhs.gain;
+	playTime = 0.0;
+	priority = 0.0;
+	positionDirty = false;
+	isLoop = rhs.isLoop;
+	isPlay = false;
+	if (SoundManager::soundManager) {
+		if (rhs.sample) sample = SoundManager::soundManager->loadSample(rhs.sample->path.data());
+		SoundManager::soundManager->addSound(this);
+	}
 }
 
 SoundObject::~SoundObject() {
-	alDeleteSources(1, &alSource);
-	alDeleteBuffers(1, &alSampleSet);
+	if (SoundManager::soundManager) SoundManager::soundManager->removeSound(this);
+}
+
+void SoundObject::bindVoice(int index, ALuint source) {
+	voice = index;
+	alSourcei(source, AL_BUFFER, sample->buffer);
+	alSourcei(source, AL_LOOPING, isLoop ? AL_TRUE : AL_FALSE);
+	alSourcef(source, AL_GAIN, gain);
+	alSource3f(source, AL_POSITION, position.x, position.y, position.z);
+	positionDirty = false;
+	alSourcef(source, AL_SEC_OFFSET, playTime);
+	alSourcePlay(source);
+}
+
+void SoundObject::unbindVoice(ALuint source) {
+	alSourceStop(source);
+	alSourcei(source, AL_BUFFER, 0);
+	voice = -1;
 }
 
+// Voice given on next manager update
 void SoundObject::play() {
-	ALint state;
-	alGetSourcei(alSource, AL_SOURCE_STATE, &state);
-	if (state != AL_PLAYING) alSourcePlay(alSource);
+	if (isPlay) return;
 	isPlay = true;
+	playTime = 0.0;
 }
 
 void SoundObject::stop() {
-	alSourceStop(alSource);
+	if (voice >= 0) alSourceStop(SoundManager::soundManager->getVoice(voice));
 	isPlay = false;
 }
 
 void SoundObject::setLoop(bool loop) {
 	isLoop = loop;
-	alSourcei(alSource, AL_LOOPING, isLoop ? AL_TRUE : AL_FALSE);
+	if (voice >= 0) alSourcei(SoundManager::soundManager->getVoice(voice), AL_LOOPING, isLoop ? AL_TRUE : AL_FALSE);
 }
 
-void SoundObject::setPosition(const vec3& position) {
-	alSource3f(alSource, AL_POSITION, position.x, position.y, position.z);
+// Sent to al in manager update, objects may move many times a frame
+void SoundObject::setPosition(const vec3& pos) {
+	position = pos;
+	positionDirty = true;
 }
 
-void SoundObject::setGain(float gain) {
-	alSourcef(alSource, AL_GAIN, gain);
+void SoundObject::setGain(float value) {
+	gain = value;
+	if (voice >= 0) alSourcef(SoundManager::soundManager->getVoice(voice), AL_GAIN, gain);
 }
 
+SoundManager* SoundManager::soundManager = NULL;
+
 SoundManager::SoundManager() {
+	soundManager = this;
+	cache = new SoundCache();
+	voices.clear();
+	voiceOwners.clear();
+	sounds.clear();
+	streams.clear();
+	decodePool = NULL;
+	listener = vec3(0.0);
+
 	context = NULL;
 	device = alcOpenDevice((const ALCchar*)"DirectSound3D");
 	if (!device) printf("Device error!\n");
@@ -61,11 +103,27 @@ SoundManager::SoundManager() {
 		context = alcCreateContext(device, NULL);
 		alcMakeContextCurrent(context);
 		addListener();
+		initVoices();
+		decodePool = new ThreadPool(1);
 		printf("Sound inited\n");
 	}
 }
 
 SoundManager::~SoundManager() {
+	if (decodePool) delete decodePool; decodePool = NULL;
+	streams.clear();
+	for (uint i = 0; i < sounds.size(); ++i) {
+		SoundObject* sound = sounds[i];
+		if (sound->voice >= 0) sound->unbindVoice(voices[sound->voice]);
+		sound->sample = NULL;
+	}
+	sounds.clear();
+	if (voices.size() > 0) alDeleteSources(voices.size(), &voices[0]);
+	voices.clear();
+	voiceOwners.clear();
+	delete cache;
+	if (soundManager == this) soundManager = NULL;
+
 	alcMakeContextCurrent(NULL);
 	if (context) alcDestroyContext(context);
 	if (device) alcCloseDevice(device);
@@ -77,6 +135,141 @@ void SoundManager::addListener() {
 	alListener3f(AL_POSITION, 0.0, 0.0, 0.0);
 }
 
+// Create sources until pool is full or device refuses more
+void SoundManager::initVoices() {
+	alGetError();
+	for (int i = 0; i < SOUND_MAX_VOICES; i++) {
+		ALuint source = 0;
+		alGenSources(1, &source);
+		if (alGetError() != AL_NO_ERROR) break;
+		voices.push_back(source);
+		voiceOwners.push_back(NULL);
+	}
+	printf("Sound voices: %d\n", (int)voices.size());
+}
+
 void SoundManager::setListenerPosition(const vec3& position) {
+	listener = position;
 	alListener3f(AL_POSITION, position.x, position.y, position.z);
-}
\ No newline at end of file
+}
+
+SoundBuffer* SoundManager::loadSample(const char* path) {
+	if (!context) return NULL;
+	return cache->acquire(path);
+}
+
+void SoundManager::addSound(SoundObject* sound) {
+	sounds.push_back(sound);
+}
+
+void SoundManager::removeSound(SoundObject* sound) {
+	if (sound->voice >= 0) {
+		voiceOwners[sound->voice] = NULL;
+		sound->unbindVoice(voices[sound->voice]);
+	}
+	cache->release(sound->sample);
+	sound->sample = NULL;
+	std::vector<SoundObject*>::iterator it = std::find(sounds.begin(), sounds.end(), sound);
+	if (it != sounds.end()) sounds.erase(it);
+}
+
+ALuint SoundManager::takeVoice() {
+	if (voices.size() <= 0) return 0;
+	int last = voices.size() - 1;
+	ALuint source = voices[last];
+	if (voiceOwners[last]) voiceOwners[last]->unbindVoice(source);
+	voices.pop_back();
+	voiceOwners.pop_back();
+	return source;
+}
+
+void SoundManager::returnVoice(ALuint source) {
+	voices.push_back(source);
+	voiceOwners.push_back(NULL);
+}
+
+void SoundManager::addStream(SoundStream* stream) {
+	streams.push_back(stream);
+}
+
+void SoundManager::removeStream(SoundStream* stream) {
+	std::vector<SoundStream*>::iterator it = std::find(streams.begin(), streams.end(), stream);
+	if (it != streams.end()) streams.erase(it);
+}
+
+static bool CompareSoundPriority(SoundObject* a, SoundObject* b) {
+	return a->getPriority() > b->getPriority();
+}
+
+void SoundManager::update(float dTime) {
+	for (uint i = 0; i < streams.size(); ++i)
+		streams[i]->update();
+
+	// Finished & stopped sounds give voices back
+	for (uint i = 0; i < voices.size(); ++i) {
+		SoundObject* owner = voiceOwners[i];
+		if (!owner) continue;
+		ALint state = AL_STOPPED;
+		alGetSourcei(voices[i], AL_SOURCE_STATE, &state);
+		if (state != AL_PLAYING) owner->isPlay = false;
+		if (!owner->isPlay) {
+			owner->unbindVoice(voices[i]);
+			voiceOwners[i] = NULL;
+		} else
+			alGetSourcef(voices[i], AL_SEC_OFFSET, &owner->playTime);
+	}
+
+	// Louder & nearer sounds first, inverse distance like al default model
+	// Sounds beyond range where gain falls under SOUND_MIN_GAIN are culled
+	std::vector<SoundObject*> playing;
+	for (uint i = 0; i < sounds.size(); ++i) {
+		SoundObject* sound = sounds[i];
+		if (!sound->isPlay || !sound->sample) continue;
+		float range = sound->gain * SOUND_REF_DISTANCE / SOUND_MIN_GAIN;
+		float distance2 = (sound->position - listener).GetSquaredLength();
+		if (distance2 > range * range) sound->priority = 0.0;
+		else {
+			float distance = sqrtf(distance2);
+			sound->priority = sound->gain * SOUND_REF_DISTANCE / (distance > SOUND_REF_DISTANCE ? distance : SOUND_REF_DISTANCE);
+			if (sound->voice >= 0) sound->priority *= SOUND_KEEP_BONUS;
+		}
+		playing.push_back(sound);
+	}
+	std::sort(playing.begin(), playing.end(), CompareSoundPriority);
+
+	for (uint i = 0; i < playing.size(); ++i) {
+		SoundObject* sound = playing[i];
+		if (sound->voice < 0 || (i < voices.size() && sound->priority > 0.0)) continue;
+		voiceOwners[sound->voice] = NULL;
+		sound->unbindVoice(voices[sound->voice]);
+	}
+	uint freeVoice = 0;
+	for (uint i = 0; i < playing.size() && i < voices.size(); ++i) {
+		SoundObject* sound = playing[i];
+		if (sound->priority <= 0.0) break;
+		if (sound->voice >= 0) continue;
+		while (voiceOwners[freeVoice]) freeVoice++;
+		voiceOwners[freeVoice] = sound;
+		sound->bindVoice(freeVoice, voices[freeVoice]);
+	}
+
+	// Moved sounds update their source once a frame, virtual ones only keep position
+	for (uint i = 0; i < voices.size(); ++i) {
+		SoundObject* owner = voiceOwners[i];
+		if (!owner || !owner->positionDirty) continue;
+		alSource3f(voices[i], AL_POSITION, owner->position.x, owner->position.y, owner->position.z);
+		owner->positionDirty = false;
+	}
+
+	// Virtual sounds keep their time, so they resume at right offset
+	for (uint i = 0; i < playing.size(); ++i) {
+		SoundObject* sound = playing[i];
+		if (sound->voice >= 0) continue;
+		sound->playTime += dTime;
+		if (sound->playTime < sound->sample->duration) continue;
+		if (sound->isLoop && sound->sample->duration > 0.0)
+			sound->playTime = fmodf(sound->playTime, sound->sample->duration);
+		else
+			sound->isPlay = false;
+	}
+}
@@ -2,18 +2,34 @@
 #define SOUND_MANAGER_H_
 
 #include "CWaves.h"
+#include "soundCache.h"
+#include "soundStream.h"
 #include "../util/util.h"
+#include "../util/threadPool.h"
 #include <string>
+#include <vector>
+#include <functional>
 
+#define SOUND_MAX_VOICES 32 // Real al sources, fewer if device limits
+#define SOUND_REF_DISTANCE 1.0
+#define SOUND_KEEP_BONUS 1.2 // Playing voices win ties, avoids swapping every frame
+#define SOUND_MIN_GAIN 0.01 // Attenuated gain under it is not audible
+
+// Lightweight sound, gets a real voice from pool only while it is among the loudest
 class SoundObject {
-private:   
-	ALenum alFormatBuffer;
-	ALsizei alFreqBuffer;  
-	ALsizei alBufferLen;
-	uint alSource;  
-	uint alSampleSet;
-	std::string filePath;
+	friend class SoundManager;
+private:
+	SoundBuffer* sample;
+	int voice; // Index in voice pool, -1 if virtual
+	vec3 position;
+	float gain;
+	float playTime; // Seconds played, kept while virtual
+	float priority; // 0 if out of audible range
+	bool positionDirty;
 	bool isLoop, isPlay;
+private:
+	void bindVoice(int index, ALuint source);
+	void unbindVoice(ALuint source);
 public:
 	SoundObject(const char* path);
 	SoundObject(const SoundObject& rhs);
@@ -24,19 +40,44 @@ public:
 	void setLoop(bool loop);
 	void setPosition(const vec3& position);
 	void setGain(float gain);
+	bool isPlaying() { return isPlay; }
+	bool isVirtual() { return voice < 0; }
+	float getPriority() { return priority; }
 };
 
 class SoundManager {
+public:
+	static SoundManager* soundManager;
 private:
 	ALCcontext* context;
 	ALCdevice* device;
+	SoundCache* cache;
+	std::vector<ALuint> voices;
+	std::vector<SoundObject*> voiceOwners;
+	std::vector<SoundObject*> sounds;
+	std::vector<SoundStream*> streams;
+	ThreadPool* decodePool;
+	vec3 listener;
 public:
 	SoundManager();
 	~SoundManager();
 private:
 	void addListener();
+	void initVoices();
 public:
 	void setListenerPosition(const vec3& position);
+	SoundBuffer* loadSample(const char* path);
+	void addSound(SoundObject* sound);
+	void removeSound(SoundObject* sound);
+	ALuint getVoice(int index) { return voices[index]; }
+	// Streams own a voice while they live, 0 if pool is empty
+	ALuint takeVoice();
+	void returnVoice(ALuint source);
+	void addStream(SoundStream* stream);
+	void removeStream(SoundStream* stream);
+	void pushDecode(const std::function<void()>& job) { decodePool->push(job); }
+	// Advance virtual sounds & give voices to loudest ones, once per frame
+	void update(float dTime);
 };
 
-#endif
\ No newline at end of file
+#endif
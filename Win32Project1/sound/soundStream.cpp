@@ -0,0 +1,163 @@
+#include "soundStream.h"
+#include "soundManager.h"
+#include <thread>
+
+SoundStream::SoundStream(const char* path) {
+	source = 0;
+	alFormat = AL_FORMAT_MONO16;
+	memset(buffers, 0, sizeof(buffers));
+	freeBuffers.clear();
+	freeChunks.clear();
+	readyChunks.clear();
+	decoding = false;
+	ended = false;
+	needReset = false;
+	position = vec3(0.0);
+	gain = 1.0;
+	isLoop = false, isPlay = false;
+
+	SoundManager* manager = SoundManager::soundManager;
+	if (!manager || !decoder.open(path)) return;
+	source = manager->takeVoice();
+	if (!source) return;
+
+	bool stereo = decoder.getChannels() == 2;
+	if (decoder.getOutputBits() == 16) alFormat = stereo ? AL_FORMAT_STEREO16 : AL_FORMAT_MONO16;
+	else alFormat = stereo ? AL_FORMAT_STEREO8 : AL_FORMAT_MONO8;
+
+	alGenBuffers(STREAM_CHUNK_COUNT, buffers);
+	for (int i = 0; i < STREAM_CHUNK_COUNT; i++) {
+		freeBuffers.push_back(buffers[i]);
+		chunks[i].resize(STREAM_CHUNK_BYTES);
+		chunkSizes[i] = 0;
+		freeChunks.push_back(i);
+	}
+	manager->addStream(this);
+}
+
+SoundStream::~SoundStream() {
+	while (decoding) std::this_thread::yield();
+	SoundManager* manager = SoundManager::soundManager;
+	if (manager) manager->removeStream(this);
+	if (source) {
+		alSourceStop(source);
+		alSourcei(source, AL_BUFFER, 0);
+		alDeleteBuffers(STREAM_CHUNK_COUNT, buffers);
+		if (manager) manager->returnVoice(source);
+	}
+	source = 0;
+	decoder.close();
+}
+
+// Worker thread, fills free chunks, rewinds looping tracks seamlessly
+void SoundStream::decodeChunks(bool loop) {
+	int frameBytes = decoder.getFrameBytes();
+	int chunkFrames = STREAM_CHUNK_BYTES / frameBytes;
+	while (freeChunks.size() > 0 && !ended) {
+		int chunk = freeChunks.front();
+		byte* data = &chunks[chunk][0];
+		int frames = 0;
+		bool rewound = false;
+		while (frames < chunkFrames) {
+			int count = decoder.decode(data + frames * frameBytes, chunkFrames - frames);
+			if (count > 0) {
+				frames += count;
+				rewound = false;
+			} else if (loop && !rewound && decoder.rewind())
+				rewound = true;
+			else {
+				ended = true;
+				break;
+			}
+		}
+		if (frames <= 0) break;
+		freeChunks.pop_front();
+		chunkSizes[chunk] = frames * frameBytes;
+		readyChunks.push_back(chunk);
+	}
+}
+
+// Stop source & drop queued data, start from track beginning
+void SoundStream::reset() {
+	alSourceStop(source);
+	alSourcei(source, AL_BUFFER, 0);
+	freeBuffers.clear();
+	for (int i = 0; i < STREAM_CHUNK_COUNT; i++)
+		freeBuffers.push_back(buffers[i]);
+	while (readyChunks.size() > 0) {
+		freeChunks.push_back(readyChunks.front());
+		readyChunks.pop_front();
+	}
+	decoder.rewind();
+	ended = false;
+	needReset = false;
+}
+
+void SoundStream::play() {
+	if (isPlay || !source) return;
+	isPlay = true;
+	needReset = true;
+}
+
+void SoundStream::stop() {
+	if (!source) return;
+	alSourceStop(source);
+	isPlay = false;
+}
+
+void SoundStream::setLoop(bool loop) {
+	isLoop = loop;
+}
+
+void SoundStream::setPosition(const vec3& pos) {
+	position = pos;
+	if (source) alSource3f(source, AL_POSITION, position.x, position.y, position.z);
+}
+
+void SoundStream::setGain(float value) {
+	gain = value;
+	if (source) alSourcef(source, AL_GAIN, gain);
+}
+
+void SoundStream::update() {
+	if (!isPlay || decoding) return;
+	if (needReset) reset();
+
+	ALint processed = 0;
+	alGetSourcei(source, AL_BUFFERS_PROCESSED, &processed);
+	for (int i = 0; i < processed; i++) {
+		ALuint buffer = 0;
+		alSourceUnqueueBuffers(source, 1, &buffer);
+		freeBuffers.push_back(buffer);
+	}
+	while (freeBuffers.size() > 0 && readyChunks.size() > 0) {
+		int chunk = readyChunks.front();
+		readyChunks.pop_front();
+		ALuint buffer = freeBuffers.back();
+		freeBuffers.pop_back();
+		alBufferData(buffer, alFormat, &chunks[chunk][0], chunkSizes[chunk], decoder.getSampleRate());
+		alSourceQueueBuffers(source, 1, &buffer);
+		freeChunks.push_back(chunk);
+	}
+
+	// Restart after underrun, end once all queued data played
+	ALint state = AL_STOPPED, queued = 0;
+	alGetSourcei(source, AL_SOURCE_STATE, &state);
+	alGetSourcei(source, AL_BUFFERS_QUEUED, &queued);
+	if (state != AL_PLAYING) {
+		if (queued > 0) alSourcePlay(source);
+		else if (ended && readyChunks.size() <= 0) {
+			isPlay = false;
+			return;
+		}
+	}
+
+	if (freeChunks.size() > 0 && !ended) {
+		decoding = true;
+		bool loop = isLoop;
+		SoundManager::soundManager->pushDecode([this, loop]() {
+			decodeChunks(loop);
+			decoding = false;
+		});
+	}
+}
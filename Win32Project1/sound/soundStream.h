@@ -0,0 +1,47 @@
+#ifndef SOUND_STREAM_H_
+#define SOUND_STREAM_H_
+
+#include "CWaves.h"
+#include "soundDecoder.h"
+#include "../util/util.h"
+#include <vector>
+#include <deque>
+#include <atomic>
+
+#define STREAM_CHUNK_COUNT 4 // Al buffers queued on source
+#define STREAM_CHUNK_BYTES 32768
+
+// Long track decoded in chunks on sound manager thread, only a few chunks resident
+class SoundStream {
+private:
+	SoundDecoder decoder;
+	ALuint source;
+	ALenum alFormat;
+	ALuint buffers[STREAM_CHUNK_COUNT];
+	std::vector<ALuint> freeBuffers;
+	std::vector<byte> chunks[STREAM_CHUNK_COUNT];
+	int chunkSizes[STREAM_CHUNK_COUNT];
+	std::deque<int> freeChunks, readyChunks; // Touched by worker only while decoding
+	std::atomic<bool> decoding;
+	bool ended; // Decoder reached end of a not looping track
+	bool needReset;
+	vec3 position;
+	float gain;
+	bool isLoop, isPlay;
+private:
+	void decodeChunks(bool loop);
+	void reset();
+public:
+	SoundStream(const char* path);
+	~SoundStream();
+	void play();
+	void stop();
+	void setLoop(bool loop);
+	void setPosition(const vec3& position);
+	void setGain(float gain);
+	bool isPlaying() { return isPlay; }
+	// Main thread, requeue played buffers & start next decode
+	void update();
+};
+
+#endif
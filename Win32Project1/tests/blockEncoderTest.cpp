@@ -0,0 +1,123 @@
+#include "../texture/blockEncoder.h"
+#include "test.h"
+#include <stdlib.h>
+#include <math.h>
+#include <vector>
+#include <algorithm>
+using namespace std;
+
+#define IMAGE_WIDTH 37 // Not multiples of 4, edge blocks clamp
+#define IMAGE_HEIGHT 29
+
+struct RoundTrip {
+	double psnr;
+	int maxError;
+};
+
+// Channels a format keeps: bc1 has no alpha here, bc5 only rg
+static int FormatChannels(int format) {
+	return format == BLOCK_BC5 ? 2 : (format == BLOCK_BC1 ? 3 : 4);
+}
+
+static RoundTrip EncodeDecode(int format, const vector<byte>& image, int width, int height) {
+	vector<byte> blocks(GetCompressedSize(format, width, height));
+	vector<byte> decoded(width * height * 4);
+	CompressImage(format, &image[0], width, height, &blocks[0]);
+	DecompressImage(format, &blocks[0], width, height, &decoded[0]);
+
+	int channels = FormatChannels(format);
+	double squared = 0.0;
+	RoundTrip res = { 0.0, 0 };
+	for (int i = 0; i < width * height; i++) {
+		for (int c = 0; c < channels; c++) {
+			int e = abs((int)decoded[i * 4 + c] - (int)image[i * 4 + c]);
+			squared += e * e;
+			res.maxError = e > res.maxError ? e : res.maxError;
+		}
+	}
+	double mse = squared / (width * height * channels);
+	res.psnr = mse > 0.0 ? 10.0 * log10(255.0 * 255.0 / mse) : 99.0;
+	return res;
+}
+
+static void FillGradient(vector<byte>& image) {
+	for (int y = 0; y < IMAGE_HEIGHT; y++) {
+		for (int x = 0; x < IMAGE_WIDTH; x++) {
+			byte* p = &image[(y * IMAGE_WIDTH + x) * 4];
+			p[0] = (byte)(x * 6), p[1] = (byte)(y * 8), p[2] = (byte)((x + y) * 3), p[3] = (byte)(255 - x * 4);
+		}
+	}
+}
+
+static void FillNoise(vector<byte>& image) {
+	for (uint i = 0; i < image.size(); i++) image[i] = (byte)(rand() & 255);
+}
+
+// Gradient channels are not collinear in a block, so error is endpoint line fit.
+// Noise is the worst case & only has to stay bounded
+static void TestImages() {
+	static const int formats[4] = { BLOCK_BC1, BLOCK_BC3, BLOCK_BC5, BLOCK_BC7 };
+	static const double gradientPsnr[4] = { 33.0, 34.0, 46.0, 34.0 };
+	static const int gradientError[4] = { 18, 18, 4, 14 };
+	static const double noisePsnr[4] = { 12.0, 13.0, 26.0, 12.0 };
+
+	vector<byte> gradient(IMAGE_WIDTH * IMAGE_HEIGHT * 4), noise(IMAGE_WIDTH * IMAGE_HEIGHT * 4);
+	FillGradient(gradient);
+	FillNoise(noise);
+	for (int f = 0; f < 4; f++) {
+		uint blocks = ((IMAGE_WIDTH + 3) / 4) * ((IMAGE_HEIGHT + 3) / 4);
+		CHECK(GetCompressedSize(formats[f], IMAGE_WIDTH, IMAGE_HEIGHT) == blocks * GetBlockBytes(formats[f]));
+
+		RoundTrip smooth = EncodeDecode(formats[f], gradient, IMAGE_WIDTH, IMAGE_HEIGHT);
+		RoundTrip rough = EncodeDecode(formats[f], noise, IMAGE_WIDTH, IMAGE_HEIGHT);
+		printf("bc%d gradient psnr %.2f max %d, noise psnr %.2f max %d\n", formats[f], smooth.psnr, smooth.maxError, rough.psnr, rough.maxError);
+		CHECK(smooth.psnr >= gradientPsnr[f]);
+		CHECK(smooth.maxError <= gradientError[f]);
+		CHECK(rough.psnr >= noisePsnr[f]);
+	}
+}
+
+// Solid & two color blocks are within endpoint precision of each format
+static void TestBlocks() {
+	int worst1 = 0, worst4 = 0, worst7 = 0, worstPair = 0;
+	byte block[64], out[16], decoded[64];
+	for (int n = 0; n < 200; n++) {
+		byte color[4] = { (byte)(rand() & 255), (byte)(rand() & 255), (byte)(rand() & 255), (byte)(rand() & 255) };
+		for (int i = 0; i < 64; i++) block[i] = color[i % 4];
+
+		EncodeBlockBC1(block, out);
+		DecodeBlockBC1(out, decoded);
+		for (int i = 0; i < 64; i++) {
+			if (i % 4 != 3) worst1 = max(worst1, abs((int)decoded[i] - (int)block[i]));
+		}
+		EncodeBlockBC4(block, 3, out);
+		DecodeBlockBC4(out, 3, decoded);
+		for (int i = 3; i < 64; i += 4) worst4 = max(worst4, abs((int)decoded[i] - (int)block[i]));
+		EncodeBlockBC7(block, out);
+		DecodeBlockBC7(out, decoded);
+		for (int i = 0; i < 64; i++) worst7 = max(worst7, abs((int)decoded[i] - (int)block[i]));
+
+		// Two colors, a line between endpoints
+		byte other[4] = { (byte)(rand() & 255), (byte)(rand() & 255), (byte)(rand() & 255), 255 };
+		for (int i = 0; i < 16; i++) {
+			for (int c = 0; c < 4; c++) block[i * 4 + c] = (i & 1) ? other[c] : color[c];
+		}
+		EncodeBlockBC1(block, out);
+		DecodeBlockBC1(out, decoded);
+		for (int i = 0; i < 64; i++) {
+			if (i % 4 != 3) worstPair = max(worstPair, abs((int)decoded[i] - (int)block[i]));
+		}
+	}
+	printf("solid max error bc1 %d, bc4 %d, bc7 %d, two color bc1 %d\n", worst1, worst4, worst7, worstPair);
+	CHECK(worst1 <= 4); // Half a 565 step
+	CHECK(worst4 == 0);
+	CHECK(worst7 <= 1); // Shared p bit
+	CHECK(worstPair <= 5);
+}
+
+int main() {
+	srand(5);
+	TestImages();
+	TestBlocks();
+	return TEST_RESULT;
+}
@@ -0,0 +1,310 @@
+#include "../render/cpuCull.h"
+#include "test.h"
+#include <string.h>
+#include <math.h>
+#include <vector>
+using namespace std;
+
+// cullCapture.txt holds view projection, mesh bases & packed transforms of every kind,
+// cullGolden.txt what multiCull.comp (shadow pass, no hi-z) outputs for them.
+// Run with -write to capture a new scene and write both files from GlslCull
+#define CAPTURE_FILE "cullCapture.txt"
+#define GOLDEN_FILE "cullGolden.txt"
+#define CAPTURE_MESHES 6
+#define CAPTURE_INSTANCES 300 // More than CULL_CHUNK_SIZE so pool splits work
+#define GOLDEN_EPS 1e-4f
+
+struct Capture {
+	float viewProj[16];
+	int meshCount;
+	vector<uint> bases;
+	vector<float> transforms[4];
+};
+
+struct Golden {
+	vector<uint> counts[4]; // Per mesh
+	vector<float> mats[4]; // Per mesh in input order, at base of mesh
+};
+
+// Scalar port of GetBound, FrustumCull, CheckCull & matrix build in multiCull.comp & util.glsl
+struct GlslVec4 {
+	float x, y, z, w;
+};
+
+static GlslVec4 MulMat(const float* m, const GlslVec4& v) {
+	GlslVec4 r;
+	r.x = m[0] * v.x + m[4] * v.y + m[8] * v.z + m[12] * v.w;
+	r.y = m[1] * v.x + m[5] * v.y + m[9] * v.z + m[13] * v.w;
+	r.z = m[2] * v.x + m[6] * v.y + m[10] * v.z + m[14] * v.w;
+	r.w = m[3] * v.x + m[7] * v.y + m[11] * v.z + m[15] * v.w;
+	return r;
+}
+
+static void MulMat4(const float* a, const float* b, float* r) {
+	for (int c = 0; c < 4; c++) {
+		for (int i = 0; i < 4; i++)
+			r[c * 4 + i] = a[i] * b[c * 4] + a[4 + i] * b[c * 4 + 1] + a[8 + i] * b[c * 4 + 2] + a[12 + i] * b[c * 4 + 3];
+	}
+}
+
+static bool GlslCheckCull(const GlslVec4* cp) {
+	for (int i = 0; i < 8; i++) {
+		if (cp[i].w < 0.001f) return false;
+	}
+	float minP[3] = { 1e30f, 1e30f, 1e30f }, maxP[3] = { -1e30f, -1e30f, -1e30f };
+	for (int i = 0; i < 8; i++) {
+		float p[3] = { cp[i].x / cp[i].w, cp[i].y / cp[i].w, cp[i].z / cp[i].w };
+		for (int a = 0; a < 3; a++) {
+			minP[a] = fminf(minP[a], p[a]);
+			maxP[a] = fmaxf(maxP[a], p[a]);
+		}
+	}
+	for (int a = 0; a < 3; a++) {
+		if (minP[a] > 1.0f || maxP[a] < -1.0f) return true;
+	}
+	return false;
+}
+
+static bool GlslFrustumCull(const float* viewProj, const float* ins) {
+	static const float signs[8][3] = {
+		{ 0.5f, 0.5f, 0.5f }, { 0.5f, 0.5f, -0.5f }, { -0.5f, 0.5f, -0.5f }, { -0.5f, 0.5f, 0.5f },
+		{ 0.5f, -0.5f, 0.5f }, { 0.5f, -0.5f, -0.5f }, { -0.5f, -0.5f, -0.5f }, { -0.5f, -0.5f, 0.5f }
+	};
+	const float* bound = ins + 8;
+	float pose[3] = { ins[0], bound[3], ins[2] };
+	GlslVec4 cp[8];
+	for (int i = 0; i < 8; i++) {
+		GlslVec4 bv = { pose[0] + bound[0] * signs[i][0], pose[1] + bound[1] * signs[i][1], pose[2] + bound[2] * signs[i][2], 1.0f };
+		cp[i] = MulMat(viewProj, bv);
+	}
+	return GlslCheckCull(cp);
+}
+
+// Translate(translate) * QuatToMat4(DecodeQuat(rotat)) * Scale(scale)
+static void GlslInstanceMatrix(const float* ins, float* mat) {
+	float q[4] = { ins[4], ins[5], ins[6], 1.0f }, sign = 1.0f;
+	if (q[2] > NEG_CHECK) q[2] -= NEG_CHECK * 2.0f, sign = -1.0f;
+	q[3] = sign * sqrtf(1.0f - (q[0] * q[0] + q[1] * q[1] + q[2] * q[2]));
+
+	float scale[3];
+	if (ins[7] > 0.0f) scale[0] = scale[1] = scale[2] = ins[3];
+	else {
+		int iv = (int)ins[3];
+		int z = iv >> 20;
+		int y = (iv - (z << 20)) >> 10;
+		scale[0] = ins[3] - (float)((z << 20) + (y << 10)), scale[1] = (float)y, scale[2] = (float)z;
+	}
+
+	float translate[16] = { 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, ins[0], ins[1], ins[2], 1 };
+	float rotate[16] = {
+		1.0f - 2.0f * q[1] * q[1] - 2.0f * q[2] * q[2], 2.0f * q[0] * q[1] + 2.0f * q[3] * q[2], 2.0f * q[0] * q[2] - 2.0f * q[3] * q[1], 0,
+		2.0f * q[0] * q[1] - 2.0f * q[3] * q[2], 1.0f - 2.0f * q[0] * q[0] - 2.0f * q[2] * q[2], 2.0f * q[1] * q[2] + 2.0f * q[3] * q[0], 0,
+		2.0f * q[0] * q[2] + 2.0f * q[3] * q[1], 2.0f * q[1] * q[2] - 2.0f * q[3] * q[0], 1.0f - 2.0f * q[0] * q[0] - 2.0f * q[1] * q[1], 0,
+		0, 0, 0, 1
+	};
+	float scaleMat[16] = { scale[0], 0, 0, 0, 0, scale[1], 0, 0, 0, 0, scale[2], 0, 0, 0, 0, 1 };
+	float tr[16];
+	MulMat4(translate, rotate, tr);
+	MulMat4(tr, scaleMat, mat);
+}
+
+// main() of multiCull.comp for one kind, atomicAdd replaced by input order
+static void GlslCull(const Capture& cap, int kind, Golden& golden) {
+	const vector<float>& ins = cap.transforms[kind];
+	int count = (int)ins.size() / CULL_TRANSFORM_SIZE;
+	vector<vector<float> > perMesh(cap.meshCount);
+	for (int i = 0; i < count; i++) {
+		const float* t = &ins[i * CULL_TRANSFORM_SIZE];
+		int meshid = (int)(kind == CULL_NORMAL ? t[12] : (kind == CULL_SINGLE ? t[13] : t[14]));
+		if (kind != CULL_ANIM && meshid >= cap.meshCount) continue;
+		if (kind != CULL_ANIM && GlslFrustumCull(cap.viewProj, t)) continue;
+
+		float outMat[16];
+		if (kind == CULL_BILL) memcpy(outMat, t, sizeof(outMat));
+		else {
+			float mat[16];
+			GlslInstanceMatrix(t, mat);
+			if (kind == CULL_ANIM) { // transpose(outMat), then outMat[3] = mesh
+				for (int c = 0; c < 4; c++)
+					for (int r = 0; r < 4; r++)
+						outMat[c * 4 + r] = mat[r * 4 + c];
+				memcpy(outMat + 12, t + 12, 4 * sizeof(float));
+			} else memcpy(outMat, mat, sizeof(outMat));
+		}
+		outMat[15] = t[15]; // outMat[3].w = mesh.w
+		perMesh[meshid].insert(perMesh[meshid].end(), outMat, outMat + 16);
+	}
+
+	golden.counts[kind].clear();
+	golden.mats[kind].clear();
+	for (int m = 0; m < cap.meshCount; m++) {
+		golden.counts[kind].push_back((uint)perMesh[m].size() / 16);
+		golden.mats[kind].insert(golden.mats[kind].end(), perMesh[m].begin(), perMesh[m].end());
+	}
+}
+
+static float Random(float a, float b) {
+	return a + (b - a) * (float)rand() / (float)RAND_MAX;
+}
+
+// Packed like InstanceData & AnimationData fill their transforms, boxes spread around
+// the frustum so edges, camera plane crossings & out of range mesh ids are all hit
+static void MakeCapture(Capture& cap) {
+	mat4 viewProj = perspective(60.0f, 1.5f, 1.0f, 2000.0f) * lookAt(0, 10, 0, 100, 0, 50, 0, 1, 0);
+	memcpy(cap.viewProj, viewProj.entries, sizeof(cap.viewProj));
+	cap.meshCount = CAPTURE_MESHES;
+	cap.bases.assign(cap.meshCount * 4, 0);
+
+	srand(7);
+	for (int kind = 0; kind < 4; kind++) {
+		vector<float>& out = cap.transforms[kind];
+		out.assign(CAPTURE_INSTANCES * CULL_TRANSFORM_SIZE, 0.0f);
+		for (int i = 0; i < CAPTURE_INSTANCES; i++) {
+			float* t = &out[i * CULL_TRANSFORM_SIZE];
+			float range = i % 4 == 0 ? 15.0f : (i % 4 == 1 ? 2500.0f : 600.0f); // Near, past far plane, around
+			t[0] = Random(-range, range), t[1] = Random(0.0f, 30.0f), t[2] = Random(-range, range);
+			if (kind == CULL_BILL) {
+				t[3] = Random(1.0f, 4.0f);
+				t[4] = Random(0.0f, 1.0f), t[5] = Random(0.0f, 1.0f), t[6] = Random(0.0f, 1.0f), t[7] = Random(0.0f, 1.0f);
+			} else {
+				vec4 quat(Random(-1, 1), Random(-1, 1), Random(-1, 1), Random(-1, 1));
+				vec3 quat3 = EncodeQuat(quat, false);
+				t[4] = quat3.x, t[5] = quat3.y, t[6] = quat3.z;
+				if (i % 2 == 0) t[3] = Random(0.5f, 3.0f), t[7] = 1.0f;
+				else t[3] = PackVec2Float(vec3((float)(rand() % 4) + 0.5f, (float)(rand() % 4 + 1), (float)(rand() % 4 + 1))), t[7] = -1.0f;
+			}
+			t[8] = Random(1.0f, 40.0f), t[9] = Random(1.0f, 40.0f), t[10] = Random(1.0f, 40.0f), t[11] = t[1] + t[9] * 0.5f;
+			int mesh = rand() % (kind == CULL_ANIM ? cap.meshCount : cap.meshCount + 1);
+			t[12] = t[13] = t[14] = (float)mesh;
+			t[15] = (float)(rand() % 16);
+		}
+	}
+
+	for (int kind = 0; kind < 4; kind++) {
+		uint base = 0;
+		for (int m = 0; m < cap.meshCount; m++) {
+			cap.bases[m * 4 + kind] = base;
+			for (int i = 0; i < CAPTURE_INSTANCES; i++)
+				if ((int)cap.transforms[kind][i * CULL_TRANSFORM_SIZE + 12] == m) base++;
+		}
+	}
+}
+
+static void WriteFloats(FILE* file, const float* v, int count) {
+	for (int i = 0; i < count; i++) fprintf(file, i + 1 < count ? "%.9g " : "%.9g\n", v[i]);
+}
+
+static bool ReadFloats(FILE* file, float* v, int count) {
+	for (int i = 0; i < count; i++) {
+		if (fscanf(file, "%f", v + i) != 1) return false;
+	}
+	return true;
+}
+
+static void WriteFiles(const Capture& cap, const Golden& golden) {
+	FILE* file = fopen(CAPTURE_FILE, "w");
+	fprintf(file, "%d\n", cap.meshCount);
+	WriteFloats(file, cap.viewProj, 16);
+	for (int m = 0; m < cap.meshCount; m++)
+		fprintf(file, "%u %u %u %u\n", cap.bases[m * 4], cap.bases[m * 4 + 1], cap.bases[m * 4 + 2], cap.bases[m * 4 + 3]);
+	for (int kind = 0; kind < 4; kind++) {
+		int count = (int)cap.transforms[kind].size() / CULL_TRANSFORM_SIZE;
+		fprintf(file, "%d\n", count);
+		for (int i = 0; i < count; i++) WriteFloats(file, &cap.transforms[kind][i * CULL_TRANSFORM_SIZE], CULL_TRANSFORM_SIZE);
+	}
+	fclose(file);
+
+	file = fopen(GOLDEN_FILE, "w");
+	for (int kind = 0; kind < 4; kind++) {
+		for (int m = 0; m < cap.meshCount; m++) fprintf(file, m + 1 < cap.meshCount ? "%u " : "%u\n", golden.counts[kind][m]);
+		for (uint i = 0; i < golden.mats[kind].size(); i += 16) WriteFloats(file, &golden.mats[kind][i], 16);
+	}
+	fclose(file);
+}
+
+static bool ReadFiles(Capture& cap, Golden& golden) {
+	FILE* file = fopen(CAPTURE_FILE, "r");
+	if (!file) return false;
+	bool ok = fscanf(file, "%d", &cap.meshCount) == 1 && ReadFloats(file, cap.viewProj, 16);
+	cap.bases.assign(cap.meshCount * 4, 0);
+	for (int i = 0; ok && i < cap.meshCount * 4; i++) ok = fscanf(file, "%u", &cap.bases[i]) == 1;
+	for (int kind = 0; ok && kind < 4; kind++) {
+		int count = 0;
+		ok = fscanf(file, "%d", &count) == 1;
+		cap.transforms[kind].assign(count * CULL_TRANSFORM_SIZE, 0.0f);
+		ok = ok && ReadFloats(file, &cap.transforms[kind][0], count * CULL_TRANSFORM_SIZE);
+	}
+	fclose(file);
+
+	file = fopen(GOLDEN_FILE, "r");
+	if (!ok || !file) return false;
+	for (int kind = 0; ok && kind < 4; kind++) {
+		uint total = 0;
+		golden.counts[kind].assign(cap.meshCount, 0);
+		for (int m = 0; ok && m < cap.meshCount; m++) {
+			ok = fscanf(file, "%u", &golden.counts[kind][m]) == 1;
+			total += golden.counts[kind][m];
+		}
+		golden.mats[kind].assign(total * 16, 0.0f);
+		ok = ok && ReadFloats(file, &golden.mats[kind][0], total * 16);
+	}
+	fclose(file);
+	return ok;
+}
+
+static bool NearlyEqual(float a, float b) {
+	return fabsf(a - b) <= GOLDEN_EPS * (1.0f + fabsf(b));
+}
+
+static void CompareKind(const Capture& cap, const Golden& golden, int kind, ThreadPool* pool) {
+	const vector<float>& ins = cap.transforms[kind];
+	int count = (int)ins.size() / CULL_TRANSFORM_SIZE;
+	vector<Indirect> indirects(cap.meshCount);
+	vector<float> outMats((count + 1) * 16, 0.0f);
+	int visible = CullInstances(kind, cap.viewProj, &ins[0], count, &indirects[0], cap.meshCount, &cap.bases[0], &outMats[0], pool);
+
+	int expected = 0, countDiff = 0, matDiff = 0;
+	uint goldenOffset = 0;
+	for (int m = 0; m < cap.meshCount; m++) {
+		expected += golden.counts[kind][m];
+		if (indirects[m].primCount != golden.counts[kind][m]) countDiff++;
+		if (indirects[m].baseInstance != cap.bases[m * 4 + kind]) countDiff++;
+		uint n = indirects[m].primCount < golden.counts[kind][m] ? indirects[m].primCount : golden.counts[kind][m];
+		for (uint i = 0; i < n * 16; i++) {
+			if (!NearlyEqual(outMats[indirects[m].baseInstance * 16 + i], golden.mats[kind][goldenOffset + i])) matDiff++;
+		}
+		goldenOffset += golden.counts[kind][m] * 16;
+	}
+	printf("kind %d %s: visible %d of %d, golden %d\n", kind, pool ? "pool" : "serial", visible, count, expected);
+	CHECK(visible == expected);
+	CHECK(countDiff == 0);
+	CHECK(matDiff == 0);
+}
+
+int main(int argc, char** argv) {
+	Capture cap;
+	Golden golden;
+	if (argc > 1 && strcmp(argv[1], "-write") == 0) {
+		MakeCapture(cap);
+		for (int kind = 0; kind < 4; kind++) GlslCull(cap, kind, golden);
+		WriteFiles(cap, golden);
+		printf("wrote %s & %s\n", CAPTURE_FILE, GOLDEN_FILE);
+		return 0;
+	}
+
+	CHECK(ReadFiles(cap, golden));
+	if (testFailures > 0) return TEST_RESULT;
+
+	// Golden must still match shader logic port, then cpu cull must match golden
+	Golden port;
+	for (int kind = 0; kind < 4; kind++) {
+		GlslCull(cap, kind, port);
+		CHECK(port.counts[kind] == golden.counts[kind]);
+	}
+	ThreadPool pool(3);
+	for (int kind = 0; kind < 4; kind++) {
+		CompareKind(cap, golden, kind, NULL);
+		CompareKind(cap, golden, kind, &pool);
+	}
+	return TEST_RESULT;
+}
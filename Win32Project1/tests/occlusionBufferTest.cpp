@@ -0,0 +1,74 @@
+#include "../render/occlusionBuffer.h"
+#include "test.h"
+#include <string.h>
+
+static mat4 Perspective(float fovy, float aspect, float zNear, float zFar) {
+	mat4 m;
+	for (int i = 0; i < 16; i++) m.entries[i] = 0.0f;
+	float f = 1.0f / tanf(fovy * 0.5f * 3.14159265f / 180.0f);
+	m.entries[0] = f / aspect, m.entries[5] = f;
+	m.entries[10] = -(zFar + zNear) / (zFar - zNear), m.entries[11] = -1.0f;
+	m.entries[14] = -2.0f * zFar * zNear / (zFar - zNear);
+	return m;
+}
+
+// World x seen at screen column sx for view space depth z
+static float ScreenToWorldX(const mat4& proj, float sx, float z, int width) {
+	return (sx / width * 2.0f - 1.0f) * -z / proj.entries[0];
+}
+
+static void AddScene(OcclusionBuffer& buffer, float wallRight) {
+	// Wall at z = -50 facing camera, ground at y = -10 crossing near plane
+	float wall[] = { -20, -10, -50, wallRight, -10, -50, wallRight, 10, -50, -20, 10, -50 };
+	int wallIndex[] = { 0, 1, 2, 0, 2, 3 };
+	float ground[] = { -500, -10, 10, 500, -10, 10, 500, -10, -1000, -500, -10, -1000 };
+	int groundIndex[] = { 0, 2, 1, 0, 3, 2 };
+	buffer.addTriangles(wall, 3, wallIndex, 6, NULL);
+	buffer.addTriangles(ground, 3, groundIndex, 6, NULL);
+}
+
+static void TestScene(ThreadPool* pool) {
+	mat4 proj = Perspective(60.0f, 16.0f / 9.0f, 1.0f, 2000.0f);
+	OcclusionBuffer buffer, serial;
+	buffer.begin(proj), serial.begin(proj);
+	AddScene(buffer, 20.0f), AddScene(serial, 20.0f);
+	buffer.rasterize(pool), serial.rasterize(NULL);
+	CHECK(buffer.getTriangleCount() > 2);
+	CHECK(memcmp(buffer.getDepth(), serial.getDepth(), buffer.getWidth() * buffer.getHeight() * sizeof(float)) == 0);
+
+	CHECK(!buffer.testBox(vec3(-2, -2, -80), vec3(2, 2, -76))); // Behind wall
+	CHECK(!buffer.testBox(vec3(-19, -9, -200), vec3(19, 9, -100))); // Large box behind wall
+	CHECK(!buffer.testBox(vec3(-2, -30, -80), vec3(2, -20, -76))); // Under ground
+	CHECK(buffer.testBox(vec3(-2, -2, -40), vec3(2, 2, -36))); // In front of wall
+	CHECK(buffer.testBox(vec3(-2, -2, -52), vec3(2, 2, -48))); // Through wall
+	CHECK(buffer.testBox(vec3(40, -2, -80), vec3(44, 2, -76))); // Beside wall
+	CHECK(buffer.testBox(vec3(-2, 30, -80), vec3(2, 34, -76))); // Above wall
+	CHECK(buffer.testBox(vec3(-45, -9, -200), vec3(19, 9, -100))); // Past wall edge
+	CHECK(buffer.testBox(vec3(248, -10, -300), vec3(252, -6, -296))); // Standing on ground
+	CHECK(buffer.testBox(vec3(-2, -2, 5), vec3(2, 2, 9))); // Behind camera
+	CHECK(buffer.getTestedCount() == 10 && buffer.getCulledCount() == 3);
+}
+
+// Wall edge at 0.7 of a column covers its centre, a box in the last 0.3 is visible
+static void TestPartialPixel() {
+	mat4 proj = Perspective(60.0f, 16.0f / 9.0f, 1.0f, 2000.0f);
+	OcclusionBuffer buffer;
+	int column = buffer.getWidth() * 2 / 3;
+	buffer.begin(proj);
+	AddScene(buffer, ScreenToWorldX(proj, column + 0.7f, -50.0f, buffer.getWidth()));
+	buffer.rasterize(NULL);
+
+	float left = ScreenToWorldX(proj, column + 0.8f, -80.0f, buffer.getWidth());
+	float right = ScreenToWorldX(proj, column + 0.95f, -80.0f, buffer.getWidth());
+	CHECK(buffer.testBox(vec3(left, -2, -80), vec3(right, 2, -80)));
+	left = ScreenToWorldX(proj, column - 4.0f, -76.0f, buffer.getWidth());
+	right = ScreenToWorldX(proj, column - 3.0f, -76.0f, buffer.getWidth());
+	CHECK(!buffer.testBox(vec3(left, -2, -80), vec3(right, 2, -76)));
+}
+
+int main() {
+	ThreadPool pool(4);
+	TestScene(&pool);
+	TestPartialPixel();
+	return TEST_RESULT;
+}
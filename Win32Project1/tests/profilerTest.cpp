@@ -0,0 +1,222 @@
+#include "../util/profiler.h"
+#include "test.h"
+#include <thread>
+#include <string>
+#include <vector>
+#include <map>
+#include <stdlib.h>
+#include <string.h>
+using namespace std;
+
+#define TRACE_FILE "profilerTest.json"
+#define FRAMES 50
+#define GPU_EVENTS (PROFILE_RING_SIZE + 100)
+
+// Just enough json to read the exported trace back
+struct JsonValue {
+	enum { NUL, BOOL, NUMBER, STRING, ARRAY, OBJECT } type;
+	double number;
+	string str;
+	vector<JsonValue> items;
+	map<string, JsonValue> members;
+	JsonValue() : type(NUL), number(0.0) {}
+	const JsonValue* get(const char* key) const {
+		map<string, JsonValue>::const_iterator it = members.find(key);
+		return it != members.end() ? &it->second : NULL;
+	}
+};
+
+class JsonReader {
+private:
+	const char* cur;
+	bool failed;
+private:
+	void skipSpace() {
+		while (*cur == ' ' || *cur == '\n' || *cur == '\r' || *cur == '\t') cur++;
+	}
+	bool expect(char c) {
+		skipSpace();
+		if (*cur != c) return failed = true, false;
+		cur++;
+		return true;
+	}
+	bool readString(string& out) {
+		if (!expect('"')) return false;
+		for (; *cur && *cur != '"'; cur++) {
+			if (*cur == '\\') cur++;
+			out += *cur;
+		}
+		return expect('"');
+	}
+public:
+	JsonReader(const char* text) : cur(text), failed(false) {}
+	bool ok() {
+		skipSpace();
+		return !failed && *cur == '\0';
+	}
+	void read(JsonValue& value) {
+		skipSpace();
+		if (*cur == '{') {
+			value.type = JsonValue::OBJECT, cur++;
+			skipSpace();
+			if (*cur == '}') { cur++; return; }
+			do {
+				string key;
+				if (!readString(key) || !expect(':')) return;
+				read(value.members[key]);
+				skipSpace();
+			} while (!failed && *cur == ',' && cur++);
+			expect('}');
+		} else if (*cur == '[') {
+			value.type = JsonValue::ARRAY, cur++;
+			skipSpace();
+			if (*cur == ']') { cur++; return; }
+			do {
+				value.items.push_back(JsonValue());
+				read(value.items.back());
+				skipSpace();
+			} while (!failed && *cur == ',' && cur++);
+			expect(']');
+		} else if (*cur == '"') {
+			value.type = JsonValue::STRING;
+			readString(value.str);
+		} else if (strncmp(cur, "true", 4) == 0 || strncmp(cur, "false", 5) == 0) {
+			value.type = JsonValue::BOOL, value.number = *cur == 't' ? 1.0 : 0.0;
+			cur += *cur == 't' ? 4 : 5;
+		} else if (strncmp(cur, "null", 4) == 0) {
+			cur += 4;
+		} else {
+			char* end = NULL;
+			value.type = JsonValue::NUMBER, value.number = strtod(cur, &end);
+			if (end == cur) failed = true;
+			cur = end;
+		}
+	}
+};
+
+struct TraceEvent {
+	string name;
+	double ts, dur;
+};
+
+static volatile double sink;
+
+static void Work(int n) {
+	for (int i = 0; i < n; i++) sink = sink + i * 0.5;
+}
+
+static void UpdateThread() {
+	Profiler::SetThreadName("update");
+	for (int f = 0; f < FRAMES; f++) {
+		PROFILE_SCOPE("updateFrame");
+		{
+			PROFILE_SCOPE("updateNodes");
+			Work(2000);
+		}
+		{
+			PROFILE_SCOPE("updateRenderQueues");
+			PROFILE_SCOPE("PushNodeToQueue");
+			Work(5000);
+		}
+	}
+}
+
+// Every event named child lies inside an event named parent on the same track
+static bool Nested(const vector<TraceEvent>& events, const char* child, const char* parent) {
+	int children = 0;
+	for (uint i = 0; i < events.size(); i++) {
+		if (events[i].name != child) continue;
+		children++;
+		bool inside = false;
+		for (uint j = 0; j < events.size() && !inside; j++) {
+			inside = events[j].name == parent && events[j].ts <= events[i].ts &&
+				events[i].ts + events[i].dur <= events[j].ts + events[j].dur;
+		}
+		if (!inside) return false;
+	}
+	return children > 0;
+}
+
+static int CountNamed(const vector<TraceEvent>& events, const char* name) {
+	int count = 0;
+	for (uint i = 0; i < events.size(); i++) count += events[i].name == name ? 1 : 0;
+	return count;
+}
+
+int main() {
+	for (int i = 0; i < 1000; i++) {
+		PROFILE_SCOPE("disabled");
+	}
+	Profiler::SetEnabled(true);
+	Profiler::SetThreadName("render");
+
+	// Gpu style track wraps its ring, export keeps newest events only
+	ProfileTrack* gpu = Profiler::CreateTrack("gpu");
+	for (int i = 0; i < GPU_EVENTS; i++) gpu->push(i == 0 ? "oldest" : (i + 1 == GPU_EVENTS ? "newest" : "gpu"), i, 1);
+
+	thread update(UpdateThread);
+	for (int f = 0; f < FRAMES; f++) {
+		PROFILE_SCOPE("frame");
+		PROFILE_SCOPE("renderShadow");
+		Work(3000);
+	}
+	update.join();
+	CHECK(Profiler::ExportChromeTrace(TRACE_FILE));
+	Profiler::Release();
+
+	FILE* file = fopen(TRACE_FILE, "rb");
+	CHECK(file != NULL);
+	if (!file) return TEST_RESULT;
+	string text;
+	char chunk[4096];
+	for (size_t n; (n = fread(chunk, 1, sizeof(chunk), file)) > 0;) text.append(chunk, n);
+	fclose(file);
+	remove(TRACE_FILE);
+
+	JsonValue root;
+	JsonReader reader(text.c_str());
+	reader.read(root);
+	CHECK(reader.ok());
+	const JsonValue* list = root.get("traceEvents");
+	CHECK(list && list->type == JsonValue::ARRAY);
+	if (!list) return TEST_RESULT;
+
+	map<int, string> trackNames;
+	map<string, vector<TraceEvent> > tracks;
+	for (uint i = 0; i < list->items.size(); i++) {
+		const JsonValue& item = list->items[i];
+		const JsonValue *name = item.get("name"), *ph = item.get("ph"), *tid = item.get("tid");
+		CHECK(name && ph && tid);
+		if (!name || !ph || !tid) continue;
+		if (ph->str == "M") {
+			const JsonValue* args = item.get("args");
+			CHECK(name->str == "thread_name" && args && args->get("name"));
+			if (args && args->get("name")) trackNames[(int)tid->number] = args->get("name")->str;
+		} else {
+			const JsonValue *ts = item.get("ts"), *dur = item.get("dur");
+			CHECK(ph->str == "X" && ts && dur);
+			CHECK(trackNames.count((int)tid->number) == 1); // Name comes before events of track
+			TraceEvent event = { name->str, ts ? ts->number : 0.0, dur ? dur->number : 0.0 };
+			tracks[trackNames[(int)tid->number]].push_back(event);
+		}
+	}
+
+	const vector<TraceEvent>& render = tracks["render"];
+	const vector<TraceEvent>& updates = tracks["update"];
+	const vector<TraceEvent>& gpus = tracks["gpu"];
+	printf("tracks %d, render %d, update %d, gpu %d events\n", (int)trackNames.size(), (int)render.size(), (int)updates.size(), (int)gpus.size());
+	CHECK(trackNames.size() == 3);
+	CHECK(CountNamed(render, "disabled") == 0);
+	CHECK(render.size() == 2 * FRAMES);
+	CHECK(CountNamed(render, "frame") == FRAMES && CountNamed(render, "renderShadow") == FRAMES);
+	CHECK(Nested(render, "renderShadow", "frame"));
+	CHECK(updates.size() == 4 * FRAMES);
+	CHECK(CountNamed(updates, "updateFrame") == FRAMES && CountNamed(updates, "PushNodeToQueue") == FRAMES);
+	CHECK(Nested(updates, "updateNodes", "updateFrame"));
+	CHECK(Nested(updates, "updateRenderQueues", "updateFrame"));
+	CHECK(Nested(updates, "PushNodeToQueue", "updateRenderQueues"));
+	CHECK(CountNamed(updates, "frame") == 0 && CountNamed(render, "updateFrame") == 0);
+	CHECK(gpus.size() < PROFILE_RING_SIZE);
+	CHECK(CountNamed(gpus, "oldest") == 0 && CountNamed(gpus, "newest") == 1);
+	return TEST_RESULT;
+}
@@ -0,0 +1,143 @@
+#include "../render/sortKey.h"
+#include "test.h"
+#include <stdlib.h>
+#include <chrono>
+#include <vector>
+#include <set>
+using namespace std;
+
+#define NODE_COUNT 4000
+#define BATCH_COUNT 300
+#define SHADER_COUNT 4 // Node types drawn by RenderQueue::draw
+#define MATERIAL_COUNT 60
+#define MESH_COUNT 400
+#define BENCH_FRAMES 200
+
+// One draw as RenderQueue sees it, transitions are counted between neighbours
+struct Draw {
+	int layer;
+	uint shader, material, mesh;
+	float depth;
+	int order; // Push order, for stability check
+};
+
+struct Transitions {
+	int shader, material, mesh;
+	Transitions() : shader(0), material(0), mesh(0) {}
+};
+
+static Transitions CountTransitions(const vector<Draw*>& draws) {
+	Transitions t;
+	for (uint i = 1; i < draws.size(); i++) {
+		const Draw* a = draws[i - 1];
+		const Draw* b = draws[i];
+		bool shader = a->shader != b->shader;
+		bool material = shader || a->material != b->material;
+		t.shader += shader ? 1 : 0;
+		t.material += material ? 1 : 0;
+		t.mesh += material || a->mesh != b->mesh ? 1 : 0;
+	}
+	return t;
+}
+
+static void SortDraws(vector<Draw*>& draws, vector<u64>& keys) {
+	vector<u64> tmpKeys(draws.size());
+	vector<void*> tmpValues(draws.size());
+	RadixSortKeys(&keys[0], (void**)&draws[0], &tmpKeys[0], &tmpValues[0], (int)draws.size());
+}
+
+// Nodes arrive in scene tree order, which mixes node types, materials & meshes
+static void BenchNodes() {
+	vector<Draw> nodes(NODE_COUNT);
+	set<pair<uint, uint> > states;
+	for (int i = 0; i < NODE_COUNT; i++) {
+		Draw& d = nodes[i];
+		d.layer = i % 50 == 0 ? SORT_LAYER_TRANSPARENT : SORT_LAYER_OPAQUE;
+		d.shader = d.layer == SORT_LAYER_TRANSPARENT ? SHADER_COUNT : rand() % SHADER_COUNT;
+		d.material = rand() % MATERIAL_COUNT, d.mesh = rand() % MESH_COUNT;
+		d.depth = (float)rand() / (float)RAND_MAX;
+		d.order = i;
+		if (d.layer == SORT_LAYER_OPAQUE) states.insert(make_pair(d.shader, d.material));
+	}
+
+	vector<Draw*> draws(NODE_COUNT);
+	vector<u64> keys(NODE_COUNT);
+	double sortTime = 0.0;
+	for (int f = 0; f < BENCH_FRAMES; f++) {
+		for (int i = 0; i < NODE_COUNT; i++) {
+			Draw& d = nodes[i];
+			draws[i] = &d;
+			keys[i] = MakeSortKey(d.layer, d.shader, d.material, d.mesh, d.depth);
+		}
+		if (f == 0) {
+			Transitions before = CountTransitions(draws);
+			printf("nodes   unsorted: shader %d, material %d, mesh %d\n", before.shader, before.material, before.mesh);
+		}
+		auto start = chrono::steady_clock::now();
+		SortDraws(draws, keys);
+		sortTime += chrono::duration<double, micro>(chrono::steady_clock::now() - start).count();
+	}
+	Transitions after = CountTransitions(draws);
+	printf("nodes   sorted:   shader %d, material %d, mesh %d, %.1f us per sort of %d\n",
+		after.shader, after.material, after.mesh, sortTime / BENCH_FRAMES, NODE_COUNT);
+
+	// Opaque first grouped by shader then material, water after it far to near
+	int opaque = 0, depthOrder = 0, unstable = 0;
+	for (uint i = 0; i < draws.size(); i++) opaque += draws[i]->layer == SORT_LAYER_OPAQUE ? 1 : 0;
+	for (uint i = 1; i < draws.size(); i++) {
+		const Draw* a = draws[i - 1];
+		const Draw* b = draws[i];
+		if (a->layer > b->layer) depthOrder++;
+		else if (a->layer == SORT_LAYER_TRANSPARENT && b->layer == SORT_LAYER_TRANSPARENT && a->depth < b->depth - 1e-4f) depthOrder++;
+		else if (a->layer == SORT_LAYER_OPAQUE && b->layer == SORT_LAYER_OPAQUE && a->shader == b->shader &&
+			a->material == b->material && a->mesh == b->mesh) {
+			if (a->depth > b->depth + 1e-4f) depthOrder++;
+			if (keys[i - 1] == keys[i] && a->order > b->order) unstable++;
+		}
+	}
+	CHECK(draws[0]->layer == SORT_LAYER_OPAQUE && draws[opaque]->layer == SORT_LAYER_TRANSPARENT);
+	vector<Draw*> opaqueDraws(draws.begin(), draws.begin() + opaque);
+	CHECK(CountTransitions(opaqueDraws).material == (int)states.size() - 1); // Each shader & material pair once
+	CHECK(after.shader <= SHADER_COUNT); // Each opaque shader once, then water
+	CHECK(depthOrder == 0);
+	CHECK(unstable == 0);
+}
+
+// Multi instance batches used to be added in map order of mesh pointers
+static void BenchBatches() {
+	vector<Draw> batches(BATCH_COUNT);
+	set<uint> materials;
+	for (int i = 0; i < BATCH_COUNT; i++) {
+		Draw& d = batches[i];
+		d.layer = SORT_LAYER_OPAQUE, d.shader = 0, d.depth = 0.0f;
+		d.material = rand() % MATERIAL_COUNT, d.mesh = i;
+		d.order = i;
+		materials.insert(d.material);
+	}
+
+	vector<Draw*> draws(BATCH_COUNT);
+	vector<u64> keys(BATCH_COUNT);
+	for (int i = 0; i < BATCH_COUNT; i++) draws[i] = &batches[i];
+	for (int i = BATCH_COUNT - 1; i > 0; i--) swap(draws[i], draws[rand() % (i + 1)]); // Pointer order
+	Transitions before = CountTransitions(draws);
+
+	for (int i = 0; i < BATCH_COUNT; i++) keys[i] = MakeBatchKey(draws[i]->shader, draws[i]->material, draws[i]->mesh);
+	SortDraws(draws, keys);
+	Transitions after = CountTransitions(draws);
+	printf("batches unsorted: material %d, sorted: material %d of %d materials\n", before.material, after.material, (int)materials.size());
+
+	bool sceneOrder = true;
+	for (uint i = 1; i < draws.size(); i++) {
+		if (draws[i - 1]->material == draws[i]->material && draws[i - 1]->mesh > draws[i]->mesh) sceneOrder = false;
+	}
+	CHECK(after.material == (int)materials.size() - 1);
+	CHECK(after.material < before.material);
+	CHECK(sceneOrder);
+}
+
+int main() {
+	srand(11);
+	BenchNodes();
+	BenchBatches();
+	return TEST_RESULT;
+}
@@ -0,0 +1,209 @@
+#include "../render/stateTracker.h"
+#include "../render/recordDevice.h"
+#include "test.h"
+#include <string.h>
+#include <vector>
+using namespace std;
+
+// Mode values only have to differ, trackers never interpret them
+#define MODE_LESS 1
+#define MODE_LEQUAL 2
+#define MODE_CULL_BACK 1
+#define MODE_CULL_FRONT 2
+#define MODE_GREATER 3
+
+#define CALL_DRAW CALL_TYPE_COUNT // Checkpoint, device state must match here
+#define FRAMES 3
+
+// Device state after all calls that reached it, what gl would hold
+class MirrorDevice : public RenderDevice {
+public:
+	int caps[CAP_COUNT], depth, alpha, cull, mask;
+	float threshold, clearColors[4];
+	bool line;
+	int viewports[4];
+	uint program, framebuffer, textures[STATE_TEXTURE_UNITS];
+	uint clears;
+public:
+	MirrorDevice() {
+		for (int i = 0; i < CAP_COUNT; i++) caps[i] = 0;
+		depth = alpha = cull = mask = 0, threshold = 0.0f, line = false;
+		for (int i = 0; i < 4; i++) clearColors[i] = 0.0f, viewports[i] = 0;
+		program = framebuffer = 0, clears = 0;
+		for (int i = 0; i < STATE_TEXTURE_UNITS; i++) textures[i] = 0;
+	}
+	virtual void setCap(int cap, bool enable) { caps[cap] = enable ? 1 : 0; }
+	virtual void depthFunc(int mode) { depth = mode; }
+	virtual void alphaFunc(int mode, float value) { alpha = mode, threshold = value; }
+	virtual void cullFace(int mode) { cull = mode; }
+	virtual void polygonMode(bool isLine) { line = isLine; }
+	virtual void colorMask(bool r, bool g, bool b, bool a) { mask = (r ? 1 : 0) | (g ? 2 : 0) | (b ? 4 : 0) | (a ? 8 : 0); }
+	virtual void clearColor(float r, float g, float b, float a) { clearColors[0] = r, clearColors[1] = g, clearColors[2] = b, clearColors[3] = a; }
+	virtual void clear(bool color, bool depthBit, bool stencil) { clears++; }
+	virtual void viewport(int x, int y, int width, int height) { viewports[0] = x, viewports[1] = y, viewports[2] = width, viewports[3] = height; }
+	virtual void useProgram(uint prog) { program = prog; }
+	virtual void bindTexture(uint unit, uint texture) { textures[unit] = texture; }
+	virtual void bindFramebuffer(uint fbo) { framebuffer = fbo; }
+	bool same(const MirrorDevice& o) const {
+		return memcmp(caps, o.caps, sizeof(caps)) == 0 && depth == o.depth && alpha == o.alpha && threshold == o.threshold &&
+			cull == o.cull && mask == o.mask && line == o.line && memcmp(clearColors, o.clearColors, sizeof(clearColors)) == 0 &&
+			memcmp(viewports, o.viewports, sizeof(viewports)) == 0 && program == o.program && framebuffer == o.framebuffer &&
+			memcmp(textures, o.textures, sizeof(textures)) == 0 && clears == o.clears;
+	}
+};
+
+struct Call {
+	int type;
+	int a, b, c, d;
+	float f;
+};
+
+static void Add(vector<Call>& calls, int type, int a = 0, int b = 0, int c = 0, int d = 0, float f = 0.0f) {
+	Call call = { type, a, b, c, d, f };
+	calls.push_back(call);
+}
+
+// Same calls Render makes per pass, each pass sets its full state
+// even when the previous pass left most of it unchanged
+static void RecordPass(vector<Call>& calls, uint fbo, int width, int height, uint program, int textureCount, bool shadow, bool blend, int draws) {
+	Add(calls, CALL_FRAMEBUFFER, fbo);
+	Add(calls, CALL_VIEWPORT, 0, 0, width, height);
+	Add(calls, CALL_CLEAR_COLOR, 0, 0, 0, 0, 0.0f);
+	Add(calls, CALL_CLEAR, 1, 1, 0);
+	Add(calls, CALL_CAP, CAP_DEPTH_TEST, blend ? 0 : 1);
+	Add(calls, CALL_CAP, CAP_BLEND, blend ? 1 : 0);
+	Add(calls, CALL_CAP, CAP_CULL, 1);
+	Add(calls, CALL_CULL_FACE, shadow ? MODE_CULL_FRONT : MODE_CULL_BACK);
+	Add(calls, CALL_DEPTH_FUNC, shadow ? MODE_LESS : MODE_LEQUAL);
+	Add(calls, CALL_COLOR_MASK, shadow ? 0 : 1);
+	Add(calls, CALL_POLYGON_MODE, 0);
+	for (int d = 0; d < draws; d++) {
+		Add(calls, CALL_PROGRAM, program);
+		Add(calls, CALL_CAP, CAP_ALPHA_TEST, d % 3 == 0 ? 1 : 0);
+		Add(calls, CALL_ALPHA_FUNC, MODE_GREATER, 0, 0, 0, 0.5f);
+		for (int t = 0; t < textureCount; t++) Add(calls, CALL_TEXTURE, t, program * 100 + t);
+		Add(calls, CALL_DRAW);
+	}
+}
+
+// Three shadow cascades, gbuffer, deferred lighting, water & two filters
+static vector<Call> RecordFrame() {
+	vector<Call> calls;
+	for (int c = 0; c < 3; c++) RecordPass(calls, 10 + c, 2048, 2048, 1, 0, true, false, 12);
+	RecordPass(calls, 20, 1280, 720, 2, 4, false, false, 40);
+	RecordPass(calls, 21, 1280, 720, 3, 6, false, false, 1);
+	RecordPass(calls, 21, 1280, 720, 4, 3, false, true, 2);
+	RecordPass(calls, 22, 640, 360, 5, 1, false, false, 1);
+	RecordPass(calls, 0, 1280, 720, 6, 2, false, false, 1);
+	return calls;
+}
+
+static void Replay(const Call& call, StateTracker* tracker, RenderDevice* device) {
+	switch (call.type) {
+		case CALL_CAP:
+			if (tracker) tracker->setCap(call.a, call.b != 0);
+			else device->setCap(call.a, call.b != 0);
+			break;
+		case CALL_DEPTH_FUNC: tracker ? tracker->setDepthFunc(call.a) : device->depthFunc(call.a); break;
+		case CALL_ALPHA_FUNC: tracker ? tracker->setAlphaFunc(call.a, call.f) : device->alphaFunc(call.a, call.f); break;
+		case CALL_CULL_FACE: tracker ? tracker->setCullFace(call.a) : device->cullFace(call.a); break;
+		case CALL_POLYGON_MODE: tracker ? tracker->setPolygonMode(call.a != 0) : device->polygonMode(call.a != 0); break;
+		case CALL_COLOR_MASK: {
+			bool on = call.a != 0;
+			tracker ? tracker->setColorMask(on, on, on, on) : device->colorMask(on, on, on, on);
+			break;
+		}
+		case CALL_CLEAR_COLOR: tracker ? tracker->setClearColor(call.f, call.f, call.f, call.f) : device->clearColor(call.f, call.f, call.f, call.f); break;
+		case CALL_CLEAR: tracker ? tracker->clear(call.a != 0, call.b != 0, call.c != 0) : device->clear(call.a != 0, call.b != 0, call.c != 0); break;
+		case CALL_VIEWPORT: tracker ? tracker->setViewport(call.a, call.b, call.c, call.d) : device->viewport(call.a, call.b, call.c, call.d); break;
+		case CALL_PROGRAM: tracker ? tracker->useProgram(call.a) : device->useProgram(call.a); break;
+		case CALL_TEXTURE:
+			if (tracker) tracker->bindTexture(call.a, call.b);
+			else device->bindTexture(call.a, call.b);
+			break;
+		case CALL_FRAMEBUFFER: tracker ? tracker->bindFramebuffer(call.a) : device->bindFramebuffer(call.a); break;
+	}
+}
+
+// Tracked calls leave device in same state as untracked ones at every draw,
+// while repeated frames only pass on real changes
+static void TestPassSequence() {
+	vector<Call> frame = RecordFrame();
+	uint stateCalls = 0;
+	for (uint i = 0; i < frame.size(); i++) stateCalls += frame[i].type != CALL_DRAW ? 1 : 0;
+
+	MirrorDevice direct, tracked;
+	RecordDevice record(&tracked);
+	StateTracker tracker(&record);
+	int mismatches = 0;
+	uint issued[FRAMES];
+	for (int f = 0; f < FRAMES; f++) {
+		tracker.resetCounters();
+		record.reset();
+		for (uint i = 0; i < frame.size(); i++) {
+			if (frame[i].type == CALL_DRAW) {
+				if (!tracked.same(direct)) mismatches++;
+				continue;
+			}
+			Replay(frame[i], NULL, &direct);
+			Replay(frame[i], &tracker, NULL);
+		}
+		issued[f] = tracker.getIssued();
+		printf("frame %d: %u state calls, %u issued, %u skipped\n", f, stateCalls, tracker.getIssued(), tracker.getSkipped());
+		if (f == FRAMES - 1) record.print();
+		CHECK(tracker.getIssued() + tracker.getSkipped() == stateCalls);
+		CHECK(record.getTotal() == tracker.getIssued());
+	}
+	CHECK(mismatches == 0);
+	CHECK(issued[1] == issued[2]); // Steady frames pass on same changes
+	CHECK(issued[1] <= issued[0]);
+	CHECK(issued[1] * 4 < stateCalls);
+	CHECK(record.getCount(CALL_CLEAR) == 8); // Clears are never state, always issued
+	CHECK(record.getCount(CALL_PROGRAM) == 6); // Once per program change, not per draw
+	CHECK(record.getCount(CALL_FRAMEBUFFER) == 7);
+	CHECK(record.getCount(CALL_CLEAR_COLOR) == 0);
+	CHECK(record.getCount(CALL_POLYGON_MODE) == 0);
+}
+
+// Exact counts of a short sequence, then invalidate after outside gl calls
+static void TestExactCounts() {
+	RecordDevice record(NULL);
+	StateTracker tracker(&record);
+	for (int f = 0; f < 3; f++) {
+		tracker.setCap(CAP_CULL, true);
+		tracker.setDepthFunc(MODE_LESS);
+		tracker.useProgram(3);
+		tracker.useProgram(3);
+		tracker.bindTexture(0, 5);
+		tracker.bindTexture(0, 5);
+		tracker.bindTexture(1, 5);
+		tracker.setViewport(0, 0, 10, 10);
+		tracker.setAlphaFunc(MODE_GREATER, 0.5f);
+		tracker.setAlphaFunc(MODE_GREATER, 0.25f);
+	}
+	CHECK(record.getCount(CALL_CAP) == 1);
+	CHECK(record.getCount(CALL_DEPTH_FUNC) == 1);
+	CHECK(record.getCount(CALL_PROGRAM) == 1);
+	CHECK(record.getCount(CALL_TEXTURE) == 2);
+	CHECK(record.getCount(CALL_VIEWPORT) == 1);
+	CHECK(record.getCount(CALL_ALPHA_FUNC) == 6); // Threshold changes every call
+	CHECK(tracker.getIssued() == 12 && tracker.getSkipped() == 18);
+	CHECK(tracker.bindTexture(0, 7) == 5);
+	CHECK(tracker.isCapEnabled(CAP_CULL) && !tracker.isCapEnabled(CAP_BLEND));
+
+	record.reset();
+	tracker.invalidateTextures();
+	CHECK(tracker.bindTexture(0, 7) == 0); // Unknown after invalidate
+	tracker.useProgram(3);
+	CHECK(record.getCount(CALL_TEXTURE) == 1 && record.getCount(CALL_PROGRAM) == 0);
+	tracker.invalidate();
+	tracker.useProgram(3);
+	tracker.setCap(CAP_CULL, true);
+	CHECK(record.getCount(CALL_PROGRAM) == 1 && record.getCount(CALL_CAP) == 1);
+}
+
+int main() {
+	TestExactCounts();
+	TestPassSequence();
+	return TEST_RESULT;
+}
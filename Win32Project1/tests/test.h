@@ -0,0 +1,15 @@
+#ifndef TEST_H_
+#define TEST_H_
+
+#include <stdio.h>
+
+// Minimal checks for headless tests, main returns TEST_RESULT
+static int testFailures = 0;
+
+#define CHECK(cond) do { \
+	if (!(cond)) { printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); testFailures++; } \
+} while (0)
+
+#define TEST_RESULT (testFailures > 0 ? (printf("%d check(s) failed\n", testFailures), 1) : (printf("passed\n"), 0))
+
+#endif
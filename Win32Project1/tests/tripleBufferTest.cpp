@@ -0,0 +1,61 @@
+#include "../util/tripleBuffer.h"
+#include "test.h"
+#include <thread>
+#include <chrono>
+
+#define SLOT_INTS 256
+#define FRAMES 50000
+
+struct Slot {
+	unsigned int frame[SLOT_INTS]; // Whole slot holds one frame number, mixed values mean a torn read
+};
+
+// Writer publishes frames 1..FRAMES, reader acquires until it sees the last one.
+// Yields slow one side down so both drop & wait paths are exercised, also on one core
+static void RunPair(const char* name, int writerYields, int readerYields) {
+	static Slot slots[3];
+	for (int s = 0; s < 3; s++) {
+		for (int i = 0; i < SLOT_INTS; i++) slots[s].frame[i] = 0;
+	}
+	TripleBuffer buffer;
+
+	std::thread writer([&]() {
+		int back = buffer.getBack();
+		for (unsigned int f = 1; f <= FRAMES; f++) {
+			for (int i = 0; i < SLOT_INTS; i++) slots[back].frame[i] = f;
+			for (int y = 0; y < writerYields; y++) std::this_thread::yield();
+			back = buffer.publish();
+		}
+	});
+
+	unsigned int last = 0, reads = 0, waits = 0, torn = 0, backwards = 0;
+	while (last < FRAMES) {
+		if (!buffer.acquire()) {
+			waits++;
+			std::this_thread::yield();
+			continue;
+		}
+		const Slot& slot = slots[buffer.getFront()];
+		unsigned int frame = slot.frame[0];
+		for (int i = 1; i < SLOT_INTS; i++) {
+			if (slot.frame[i] != frame) torn++;
+		}
+		for (int y = 0; y < readerYields; y++) std::this_thread::yield();
+		if (frame <= last) backwards++;
+		last = frame, reads++;
+	}
+	writer.join();
+
+	printf("%-14s published %u read %u dropped %u waits %u\n", name, buffer.getPublished(), reads, buffer.getDropped(), waits);
+	CHECK(torn == 0);
+	CHECK(backwards == 0);
+	CHECK(buffer.getPublished() == FRAMES);
+	CHECK(reads + buffer.getDropped() == FRAMES); // Every frame is read or overwritten once
+}
+
+int main() {
+	RunPair("balanced", 1, 1);
+	RunPair("slow reader", 1, 4);
+	RunPair("slow writer", 4, 1);
+	return TEST_RESULT;
+}
@@ -0,0 +1,453 @@
+#include "blockEncoder.h"
+#include <string.h>
+#include <stdlib.h>
+#include <math.h>
+
+static const int Bc7Weights[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+static inline float ClampColor(float v) {
+	return v < 0.0 ? 0.0 : (v > 255.0 ? 255.0 : v);
+}
+
+static void LoadBlock(const byte* rgba, float px[16][4]) {
+	for (int i = 0; i < 16; i++) {
+		for (int c = 0; c < 4; c++)
+			px[i][c] = rgba[i * 4 + c];
+	}
+}
+
+// Principal axis of block texels by power iteration, returns endpoints on that axis
+static void FitLine(const float px[16][4], int channels, float* e0, float* e1) {
+	float mean[4] = { 0, 0, 0, 0 };
+	for (int i = 0; i < 16; i++) {
+		for (int c = 0; c < channels; c++)
+			mean[c] += px[i][c];
+	}
+	for (int c = 0; c < channels; c++) mean[c] /= 16.0;
+
+	float cov[4][4];
+	memset(cov, 0, sizeof(cov));
+	for (int i = 0; i < 16; i++) {
+		for (int a = 0; a < channels; a++) {
+			for (int b = 0; b < channels; b++)
+				cov[a][b] += (px[i][a] - mean[a]) * (px[i][b] - mean[b]);
+		}
+	}
+
+	// Start from the channel with largest variance
+	int maxc = 0;
+	for (int c = 1; c < channels; c++)
+		if (cov[c][c] > cov[maxc][maxc]) maxc = c;
+	float axis[4] = { 0, 0, 0, 0 };
+	for (int c = 0; c < channels; c++) axis[c] = cov[maxc][c];
+
+	for (int iter = 0; iter < 8; iter++) {
+		float next[4] = { 0, 0, 0, 0 }, len = 0.0;
+		for (int a = 0; a < channels; a++) {
+			for (int b = 0; b < channels; b++)
+				next[a] += cov[a][b] * axis[b];
+			len = fmaxf(len, fabsf(next[a]));
+		}
+		if (len <= 0.0) break;
+		for (int c = 0; c < channels; c++) axis[c] = next[c] / len;
+	}
+
+	float len = 0.0;
+	for (int c = 0; c < channels; c++) len += axis[c] * axis[c];
+	len = sqrtf(len);
+	if (len > 0.0) {
+		for (int c = 0; c < channels; c++) axis[c] /= len;
+	}
+
+	float tmin = 0.0, tmax = 0.0;
+	for (int i = 0; i < 16; i++) {
+		float t = 0.0;
+		for (int c = 0; c < channels; c++)
+			t += (px[i][c] - mean[c]) * axis[c];
+		tmin = fminf(tmin, t), tmax = fmaxf(tmax, t);
+	}
+	for (int c = 0; c < channels; c++) {
+		e0[c] = ClampColor(mean[c] + axis[c] * tmax);
+		e1[c] = ClampColor(mean[c] + axis[c] * tmin);
+	}
+}
+
+// Solve endpoints minimizing error for fixed indices, weights[idx] is share of e1
+static bool RefineLine(const float px[16][4], int channels, const int* idx, const float* weights, float* e0, float* e1) {
+	float aa = 0.0, ab = 0.0, bb = 0.0;
+	float ax[4] = { 0, 0, 0, 0 }, bx[4] = { 0, 0, 0, 0 };
+	for (int i = 0; i < 16; i++) {
+		float wb = weights[idx[i]], wa = 1.0 - wb;
+		aa += wa * wa, ab += wa * wb, bb += wb * wb;
+		for (int c = 0; c < channels; c++)
+			ax[c] += wa * px[i][c], bx[c] += wb * px[i][c];
+	}
+	float det = aa * bb - ab * ab;
+	if (fabsf(det) < 0.0001) return false;
+	for (int c = 0; c < channels; c++) {
+		e0[c] = ClampColor((ax[c] * bb - bx[c] * ab) / det);
+		e1[c] = ClampColor((bx[c] * aa - ax[c] * ab) / det);
+	}
+	return true;
+}
+
+static int NearestIndex(const float* p, const int palette[][4], int count, int channels, int* error) {
+	int best = 0, bestErr = 0x7fffffff;
+	for (int k = 0; k < count; k++) {
+		int err = 0;
+		for (int c = 0; c < channels; c++) {
+			int d = (int)(p[c] + 0.5) - palette[k][c];
+			err += d * d;
+		}
+		if (err < bestErr) best = k, bestErr = err;
+	}
+	*error += bestErr;
+	return best;
+}
+
+static void WriteBits(byte* out, int& pos, uint value, int count) {
+	for (int b = 0; b < count; b++, pos++) {
+		if ((value >> b) & 1) out[pos >> 3] |= (byte)(1 << (pos & 7));
+	}
+}
+
+static uint ReadBits(const byte* in, int& pos, int count) {
+	uint value = 0;
+	for (int b = 0; b < count; b++, pos++)
+		value |= (uint)((in[pos >> 3] >> (pos & 7)) & 1) << b;
+	return value;
+}
+
+// BC1 -----------------------------------------------------------------------
+
+static ushort Pack565(const float* c) {
+	int r = (int)(c[0] * 31.0 / 255.0 + 0.5);
+	int g = (int)(c[1] * 63.0 / 255.0 + 0.5);
+	int b = (int)(c[2] * 31.0 / 255.0 + 0.5);
+	return (ushort)((r << 11) | (g << 5) | b);
+}
+
+static void Unpack565(ushort v, int* c) {
+	int r = (v >> 11) & 31, g = (v >> 5) & 63, b = v & 31;
+	c[0] = (r << 3) | (r >> 2);
+	c[1] = (g << 2) | (g >> 4);
+	c[2] = (b << 3) | (b >> 2);
+	c[3] = 255;
+}
+
+static void Bc1Palette(ushort c0, ushort c1, bool four, int palette[4][4]) {
+	Unpack565(c0, palette[0]);
+	Unpack565(c1, palette[1]);
+	for (int c = 0; c < 3; c++) {
+		if (four) {
+			palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+			palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+		} else {
+			palette[2][c] = (palette[0][c] + palette[1][c]) / 2;
+			palette[3][c] = 0;
+		}
+	}
+	palette[2][3] = 255;
+	palette[3][3] = four ? 255 : 0;
+}
+
+// Quantize endpoints to 565 in four color mode & pick indices
+static int Bc1Fit(const float px[16][4], const float* e0, const float* e1, ushort& c0, ushort& c1, int* idx) {
+	c0 = Pack565(e0), c1 = Pack565(e1);
+	if (c0 < c1) {
+		ushort tmp = c0;
+		c0 = c1, c1 = tmp;
+	}
+
+	int error = 0;
+	int palette[4][4];
+	Bc1Palette(c0, c1, true, palette);
+	int count = c0 == c1 ? 1 : 4;
+	for (int i = 0; i < 16; i++)
+		idx[i] = NearestIndex(px[i], palette, count, 3, &error);
+	return error;
+}
+
+void EncodeBlockBC1(const byte* rgba, byte* out) {
+	static const float weights[4] = { 0.0, 1.0, 1.0 / 3.0, 2.0 / 3.0 };
+	float px[16][4];
+	LoadBlock(rgba, px);
+
+	float e0[4], e1[4];
+	FitLine(px, 3, e0, e1);
+	ushort c0, c1;
+	int idx[16];
+	int error = Bc1Fit(px, e0, e1, c0, c1, idx);
+
+	// One least squares pass on chosen indices, keep it only if better
+	if (error > 0) {
+		int palette[4][4];
+		Bc1Palette(c0, c1, true, palette);
+		float r0[4], r1[4];
+		for (int c = 0; c < 3; c++) r0[c] = palette[0][c], r1[c] = palette[1][c];
+		if (RefineLine(px, 3, idx, weights, r0, r1)) {
+			ushort n0, n1;
+			int nidx[16];
+			if (Bc1Fit(px, r0, r1, n0, n1, nidx) < error) {
+				c0 = n0, c1 = n1;
+				memcpy(idx, nidx, sizeof(idx));
+			}
+		}
+	}
+
+	uint bits = 0;
+	for (int i = 0; i < 16; i++)
+		bits |= (uint)idx[i] << (i * 2);
+	out[0] = c0 & 0xff, out[1] = c0 >> 8;
+	out[2] = c1 & 0xff, out[3] = c1 >> 8;
+	for (int b = 0; b < 4; b++)
+		out[4 + b] = (bits >> (b * 8)) & 0xff;
+}
+
+static void DecodeColorBlock(const byte* in, byte* rgba, bool forceFour) {
+	ushort c0 = in[0] | (in[1] << 8), c1 = in[2] | (in[3] << 8);
+	uint bits = in[4] | (in[5] << 8) | (in[6] << 16) | ((uint)in[7] << 24);
+	int palette[4][4];
+	Bc1Palette(c0, c1, forceFour || c0 > c1, palette);
+	for (int i = 0; i < 16; i++) {
+		int k = (bits >> (i * 2)) & 3;
+		for (int c = 0; c < 4; c++)
+			rgba[i * 4 + c] = (byte)palette[k][c];
+	}
+}
+
+void DecodeBlockBC1(const byte* in, byte* rgba) {
+	DecodeColorBlock(in, rgba, false);
+}
+
+// BC4 -----------------------------------------------------------------------
+
+static void Bc4Palette(int a0, int a1, int* palette) {
+	palette[0] = a0, palette[1] = a1;
+	if (a0 > a1) {
+		for (int k = 2; k < 8; k++)
+			palette[k] = ((8 - k) * a0 + (k - 1) * a1) / 7;
+	} else {
+		for (int k = 2; k < 6; k++)
+			palette[k] = ((6 - k) * a0 + (k - 1) * a1) / 5;
+		palette[6] = 0, palette[7] = 255;
+	}
+}
+
+void EncodeBlockBC4(const byte* rgba, int channel, byte* out) {
+	int vmin = 255, vmax = 0;
+	for (int i = 0; i < 16; i++) {
+		int v = rgba[i * 4 + channel];
+		if (v < vmin) vmin = v;
+		if (v > vmax) vmax = v;
+	}
+
+	// Eight value mode needs a0 > a1, flat block keeps all indices 0
+	int palette[8];
+	Bc4Palette(vmax, vmin, palette);
+	u64 bits = 0;
+	for (int i = 0; vmax > vmin && i < 16; i++) {
+		int v = rgba[i * 4 + channel], best = 0, bestErr = 256;
+		for (int k = 0; k < 8; k++) {
+			int err = abs(v - palette[k]);
+			if (err < bestErr) best = k, bestErr = err;
+		}
+		bits |= (u64)best << (i * 3);
+	}
+	out[0] = (byte)vmax, out[1] = (byte)vmin;
+	for (int b = 0; b < 6; b++)
+		out[2 + b] = (bits >> (b * 8)) & 0xff;
+}
+
+void DecodeBlockBC4(const byte* in, int channel, byte* rgba) {
+	int palette[8];
+	Bc4Palette(in[0], in[1], palette);
+	u64 bits = 0;
+	for (int b = 0; b < 6; b++)
+		bits |= (u64)in[2 + b] << (b * 8);
+	for (int i = 0; i < 16; i++)
+		rgba[i * 4 + channel] = (byte)palette[(bits >> (i * 3)) & 7];
+}
+
+// BC3 & BC5 -----------------------------------------------------------------
+
+void EncodeBlockBC3(const byte* rgba, byte* out) {
+	EncodeBlockBC4(rgba, 3, out);
+	EncodeBlockBC1(rgba, out + 8);
+}
+
+void DecodeBlockBC3(const byte* in, byte* rgba) {
+	DecodeColorBlock(in + 8, rgba, true);
+	DecodeBlockBC4(in, 3, rgba);
+}
+
+void EncodeBlockBC5(const byte* rgba, byte* out) {
+	EncodeBlockBC4(rgba, 0, out);
+	EncodeBlockBC4(rgba, 1, out + 8);
+}
+
+void DecodeBlockBC5(const byte* in, byte* rgba) {
+	for (int i = 0; i < 16; i++)
+		rgba[i * 4 + 2] = 0, rgba[i * 4 + 3] = 255;
+	DecodeBlockBC4(in, 0, rgba);
+	DecodeBlockBC4(in + 8, 1, rgba);
+}
+
+// BC7 mode 6 ----------------------------------------------------------------
+
+// 7 bit endpoint with shared p-bit, choose p-bit with less error
+static void QuantizeBc7Endpoint(const float* e, int* q, int& p) {
+	float bestErr = 0.0;
+	for (int pbit = 0; pbit < 2; pbit++) {
+		int tq[4];
+		float err = 0.0;
+		for (int c = 0; c < 4; c++) {
+			int v = (int)((e[c] - pbit) * 0.5 + 0.5);
+			tq[c] = v < 0 ? 0 : (v > 127 ? 127 : v);
+			float d = (float)((tq[c] << 1) | pbit) - e[c];
+			err += d * d;
+		}
+		if (pbit == 0 || err < bestErr) {
+			bestErr = err, p = pbit;
+			memcpy(q, tq, sizeof(tq));
+		}
+	}
+}
+
+static void Bc7Palette(const int* q0, int p0, const int* q1, int p1, int palette[16][4]) {
+	for (int c = 0; c < 4; c++) {
+		int a = (q0[c] << 1) | p0, b = (q1[c] << 1) | p1;
+		for (int k = 0; k < 16; k++)
+			palette[k][c] = ((64 - Bc7Weights[k]) * a + Bc7Weights[k] * b + 32) >> 6;
+	}
+}
+
+static int Bc7Fit(const float px[16][4], const float* e0, const float* e1, int* q0, int& p0, int* q1, int& p1, int* idx) {
+	QuantizeBc7Endpoint(e0, q0, p0);
+	QuantizeBc7Endpoint(e1, q1, p1);
+	int palette[16][4];
+	Bc7Palette(q0, p0, q1, p1, palette);
+	int error = 0;
+	for (int i = 0; i < 16; i++)
+		idx[i] = NearestIndex(px[i], palette, 16, 4, &error);
+	return error;
+}
+
+void EncodeBlockBC7(const byte* rgba, byte* out) {
+	static const float weights[16] = { 0.0 / 64, 4.0 / 64, 9.0 / 64, 13.0 / 64, 17.0 / 64, 21.0 / 64, 26.0 / 64, 30.0 / 64,
+		34.0 / 64, 38.0 / 64, 43.0 / 64, 47.0 / 64, 51.0 / 64, 55.0 / 64, 60.0 / 64, 64.0 / 64 };
+
+	float px[16][4];
+	LoadBlock(rgba, px);
+
+	float e0[4], e1[4];
+	FitLine(px, 4, e0, e1);
+	int q0[4], q1[4], p0 = 0, p1 = 0, idx[16];
+	int error = Bc7Fit(px, e0, e1, q0, p0, q1, p1, idx);
+
+	if (error > 0 && RefineLine(px, 4, idx, weights, e0, e1)) {
+		int n0[4], n1[4], np0 = 0, np1 = 0, nidx[16];
+		if (Bc7Fit(px, e0, e1, n0, np0, n1, np1, nidx) < error) {
+			memcpy(q0, n0, sizeof(n0)), memcpy(q1, n1, sizeof(n1));
+			memcpy(idx, nidx, sizeof(idx));
+			p0 = np0, p1 = np1;
+		}
+	}
+
+	// Anchor texel index msb is implicit 0, swap endpoints if needed
+	if (idx[0] >= 8) {
+		int tq[4];
+		memcpy(tq, q0, sizeof(tq)), memcpy(q0, q1, sizeof(tq)), memcpy(q1, tq, sizeof(tq));
+		int tp = p0;
+		p0 = p1, p1 = tp;
+		for (int i = 0; i < 16; i++) idx[i] = 15 - idx[i];
+	}
+
+	memset(out, 0, 16);
+	int pos = 0;
+	WriteBits(out, pos, 1 << 6, 7);
+	for (int c = 0; c < 4; c++) {
+		WriteBits(out, pos, q0[c], 7);
+		WriteBits(out, pos, q1[c], 7);
+	}
+	WriteBits(out, pos, p0, 1);
+	WriteBits(out, pos, p1, 1);
+	for (int i = 0; i < 16; i++)
+		WriteBits(out, pos, idx[i], i == 0 ? 3 : 4);
+}
+
+// Only mode 6 is decoded, other modes give transparent black
+void DecodeBlockBC7(const byte* in, byte* rgba) {
+	memset(rgba, 0, 64);
+	int pos = 0;
+	if (ReadBits(in, pos, 7) != (1 << 6)) return;
+
+	int q0[4], q1[4];
+	for (int c = 0; c < 4; c++) {
+		q0[c] = ReadBits(in, pos, 7);
+		q1[c] = ReadBits(in, pos, 7);
+	}
+	int p0 = ReadBits(in, pos, 1), p1 = ReadBits(in, pos, 1);
+	int palette[16][4];
+	Bc7Palette(q0, p0, q1, p1, palette);
+	for (int i = 0; i < 16; i++) {
+		int k = ReadBits(in, pos, i == 0 ? 3 : 4);
+		for (int c = 0; c < 4; c++)
+			rgba[i * 4 + c] = (byte)palette[k][c];
+	}
+}
+
+// Images --------------------------------------------------------------------
+
+uint GetBlockBytes(int format) {
+	return format == BLOCK_BC1 ? 8 : 16;
+}
+
+uint GetCompressedSize(int format, int width, int height) {
+	return ((width + 3) / 4) * ((height + 3) / 4) * GetBlockBytes(format);
+}
+
+void CompressImage(int format, const byte* rgba, int width, int height, byte* out) {
+	byte block[64];
+	uint blockBytes = GetBlockBytes(format);
+	for (int by = 0; by < height; by += 4) {
+		for (int bx = 0; bx < width; bx += 4) {
+			for (int y = 0; y < 4; y++) {
+				int sy = by + y < height ? by + y : height - 1;
+				for (int x = 0; x < 4; x++) {
+					int sx = bx + x < width ? bx + x : width - 1;
+					memcpy(block + (y * 4 + x) * 4, rgba + (sy * width + sx) * 4, 4);
+				}
+			}
+
+			switch (format) {
+				case BLOCK_BC1: EncodeBlockBC1(block, out); break;
+				case BLOCK_BC3: EncodeBlockBC3(block, out); break;
+				case BLOCK_BC5: EncodeBlockBC5(block, out); break;
+				case BLOCK_BC7: EncodeBlockBC7(block, out); break;
+			}
+			out += blockBytes;
+		}
+	}
+}
+
+void DecompressImage(int format, const byte* in, int width, int height, byte* rgba) {
+	byte block[64];
+	uint blockBytes = GetBlockBytes(format);
+	for (int by = 0; by < height; by += 4) {
+		for (int bx = 0; bx < width; bx += 4) {
+			switch (format) {
+				case BLOCK_BC1: DecodeBlockBC1(in, block); break;
+				case BLOCK_BC3: DecodeBlockBC3(in, block); break;
+				case BLOCK_BC5: DecodeBlockBC5(in, block); break;
+				case BLOCK_BC7: DecodeBlockBC7(in, block); break;
+			}
+			in += blockBytes;
+
+			for (int y = 0; y < 4 && by + y < height; y++) {
+				for (int x = 0; x < 4 && bx + x < width; x++)
+					memcpy(rgba + ((by + y) * width + bx + x) * 4, block + (y * 4 + x) * 4, 4);
+			}
+		}
+	}
+}
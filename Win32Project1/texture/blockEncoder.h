@@ -0,0 +1,33 @@
+#ifndef BLOCK_ENCODER_H_
+#define BLOCK_ENCODER_H_
+
+#include "../constants/constants.h"
+
+// Block compressed formats, each 4x4 texel block
+#define BLOCK_NONE 0
+#define BLOCK_BC1 1 // rgb 565 endpoints, 8 bytes
+#define BLOCK_BC3 3 // bc1 color + bc4 alpha, 16 bytes
+#define BLOCK_BC5 5 // two bc4 channels rg, 16 bytes
+#define BLOCK_BC7 7 // mode 6 rgba 7.7.7.7+p, 16 bytes
+
+// Block in/out is 16 rgba8 texels in row order
+void EncodeBlockBC1(const byte* rgba, byte* out);
+void EncodeBlockBC4(const byte* rgba, int channel, byte* out);
+void EncodeBlockBC3(const byte* rgba, byte* out);
+void EncodeBlockBC5(const byte* rgba, byte* out);
+void EncodeBlockBC7(const byte* rgba, byte* out);
+
+// Decoders match gpu result, used to check encoder output
+void DecodeBlockBC1(const byte* in, byte* rgba);
+void DecodeBlockBC4(const byte* in, int channel, byte* rgba);
+void DecodeBlockBC3(const byte* in, byte* rgba);
+void DecodeBlockBC5(const byte* in, byte* rgba);
+void DecodeBlockBC7(const byte* in, byte* rgba);
+
+uint GetBlockBytes(int format);
+uint GetCompressedSize(int format, int width, int height);
+// Whole rgba8 image, edge blocks clamp to last row & column
+void CompressImage(int format, const byte* rgba, int width, int height, byte* out);
+void DecompressImage(int format, const byte* in, int width, int height, byte* rgba);
+
+#endif
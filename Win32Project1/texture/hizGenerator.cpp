@@ -28,24 +28,26 @@ HizGenerator::~HizGenerator() {
 }
 
 void HizGenerator::genMipmap(Render* render, Shader* shader, Texture2D* texDepth) {
+	static int oddId = Shader::GetUniformId("uOdd");
+	static int lastLevelId = Shader::GetUniformId("uLastLevel");
 	int currentWidth = render->viewWidth, currentHeight = render->viewHeight;
 	numLevels = 1 + (int)floorf(log2f(fmaxf(currentWidth, currentHeight)));
 
-	glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+	render->states->bindFramebuffer(fbo);
 	
 	state->shader = shader;
 	uint texBefore = render->useTexture(TEXTURE_2D, 0, texDepth->id);
 	render->setColorWrite(false);
 
 	for (int i = 1; i < numLevels; i++) {
-		state->shader->setFloat("uOdd", (currentWidth % 2 != 0 || currentHeight % 2 != 0) ? 1.0 : 0.0);
-		state->shader->setFloat("uLastLevel", i - 1);
+		state->shader->setFloat(oddId, (currentWidth % 2 != 0 || currentHeight % 2 != 0) ? 1.0 : 0.0);
+		state->shader->setFloat(lastLevelId, i - 1);
 
 		currentWidth /= 2, currentHeight /= 2;
 		currentWidth = currentWidth > 0 ? currentWidth : 1;
 		currentHeight = currentHeight > 0 ? currentHeight : 1;
 
-		glViewport(0, 0, currentWidth, currentHeight);
+		render->states->setViewport(0, 0, currentWidth, currentHeight);
 		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, texDepth->id, i);
 
 		render->draw(NULL, boardNode->drawcall, state);
@@ -55,12 +57,14 @@ void HizGenerator::genMipmap(Render* render, Shader* shader, Texture2D* texDepth
 }
 
 void HizGenerator::drawDebug(Camera* camera, Render* render, Shader* shader, Texture2D* texDepth, int level) {
+	static int levelId = Shader::GetUniformId("uLevel");
+	static int camParamId = Shader::GetUniformId("uCamParam");
 	render->setFrameBuffer(NULL);
 
 	int levelUse = level > numLevels - 1 ? numLevels - 1 : level;
 	state->shader = shader;
-	state->shader->setFloat("uLevel", (float)levelUse);
-	state->shader->setVector2("uCamParam", camera->zNear, camera->zFar);
+	state->shader->setFloat(levelId, (float)levelUse);
+	state->shader->setVector2(camParamId, camera->zNear, camera->zFar);
 	
 	uint texBefore = render->useTexture(TEXTURE_2D, 0, texDepth->id);
 	render->draw(NULL, boardNode->drawcall, state);
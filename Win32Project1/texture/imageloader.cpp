@@ -3,6 +3,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include "../constants/constants.h"
+#include "mipGenerator.h"
 
 void InitImageLoaders() {
 #ifdef FREEIMAGE_LIB
@@ -17,11 +18,15 @@ void ReleaseImageLoaders() {
 }
 
 ImageLoader::ImageLoader(const char* path) {
+	width = 0, height = 0;
+	data = NULL;
+	mipmaps.clear();
+
 	FREE_IMAGE_FORMAT fif = FreeImage_GetFileType(path, 0);
 	FIBITMAP* dib = NULL;
 	if (FreeImage_FIFSupportsReading(fif))
 		dib = FreeImage_Load(fif, path);
-	else return;
+	if (!dib) return;
 
 	bool hasAlpha = FreeImage_GetBPP(dib) == 32;
 	if (!hasAlpha) {
@@ -48,5 +53,14 @@ ImageLoader::ImageLoader(const char* path) {
 }
 
 ImageLoader::~ImageLoader() {
-	free(data); data = NULL;
+	if (data) free(data); data = NULL;
+	for (uint i = 0; i < mipmaps.size(); i++)
+		free(mipmaps[i].data);
+	mipmaps.clear();
+}
+
+// Build full mip chain on cpu, so it can run out of gl thread
+void ImageLoader::generateMipmaps(bool srgb, bool premultiply, float alphaRef) {
+	if (!data || mipmaps.size() > 0) return;
+	GenerateMipChain(width, height, data, srgb, premultiply, alphaRef, mipmaps);
 }
\ No newline at end of file
@@ -1,13 +1,24 @@
 #ifndef IMAGELOADER_H_
 #define IMAGELOADER_H_
 
+#include <vector>
+
+struct ImageLevel {
+	int width, height;
+	unsigned char* data;
+	ImageLevel(int w, int h, unsigned char* d) :width(w), height(h), data(d) {}
+};
+
 class ImageLoader {
 public:
 	int width, height;
 	unsigned char* data;
+	std::vector<ImageLevel> mipmaps; // Levels after base level, empty until generated
 public:
 	ImageLoader(const char* path);
 	~ImageLoader();
+	void generateMipmaps(bool srgb = false, bool premultiply = false, float alphaRef = 0.0);
+	int getLevelCount() { return (int)mipmaps.size() + 1; }
 };
 
 void InitImageLoaders();
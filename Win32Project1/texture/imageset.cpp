@@ -1,6 +1,7 @@
 #include "imageset.h"
 #include "../constants/constants.h"
 #include "../render/render.h"
+#include "../util/threadPool.h"
 using namespace std;
 
 ImageSet::ImageSet() {
@@ -37,7 +38,7 @@ int ImageSet::findTexture(const string name) {
 
 void ImageSet::initTextureArray(string dir) {
 	if (imageNames.size() <= 0) return;
-	images = new ImageLoader*[imageNames.size()];
+	images = new CookedTexture*[imageNames.size()];
 
 	glGenTextures(1,&setId);
 	glBindTexture(GL_TEXTURE_2D_ARRAY,setId);
@@ -47,23 +48,46 @@ void ImageSet::initTextureArray(string dir) {
 	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
 	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
 
+	// Layers share one block format, bc7 keeps alpha of any layer
 	string path=dir.append("/");
 	string name("");
+	CookedTexture* first = NULL;
+	GLenum interFormat = GetCompressedFormat(BLOCK_BC7, true);
+
+	// Cook layers in parallel, upload in order
+	ThreadPool pool;
+	pool.parallelFor(imageNames.size(), [this, &path](int i) {
+		images[i] = LoadCookedTexture((path + imageNames[i]).c_str(), USAGE_COLOR, true, BLOCK_BC7);
+	});
+
 	for (unsigned int i = 0; i < imageNames.size(); i++) {
 		name = imageNames[i];
-		images[i] = new ImageLoader((path + name).c_str());
-		if (i == 0) {
-			glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_SRGB_ALPHA,
-				images[i]->width, images[i]->height,
-				imageNames.size(), 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+		CookedTexture* layer = images[i];
+		if (!layer) {
+			printf("image %s load failed\n", name.data());
+			continue;
+		}
+		if (!first) {
+			first = layer;
+			glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LEVEL, first->getLevelCount() - 1);
+			for (int l = 0; l < first->getLevelCount(); l++) {
+				CookedLevel& level = first->levels[l];
+				glCompressedTexImage3D(GL_TEXTURE_2D_ARRAY, l, interFormat,
+					level.width, level.height, imageNames.size(), 0,
+					level.size * imageNames.size(), NULL);
+			}
+		} else if (layer->width != first->width || layer->height != first->height) {
+			printf("image %s size differs from set\n", name.data());
+			continue;
 		}
 
-		glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, i,
-			images[i]->width, images[i]->height,
-			1, GL_RGBA, GL_UNSIGNED_BYTE, images[i]->data);
+		for (int l = 0; l < layer->getLevelCount(); l++) {
+			CookedLevel& level = layer->levels[l];
+			glCompressedTexSubImage3D(GL_TEXTURE_2D_ARRAY, l, 0, 0, i,
+				level.width, level.height, 1, interFormat, level.size, level.data);
+		}
 	}
 
-	glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
 	glBindTexture(GL_TEXTURE_2D_ARRAY,0);
 	/*
 	if(images){
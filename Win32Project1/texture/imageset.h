@@ -10,14 +10,14 @@
 
 #include "../render/glheader.h"
 #include "../constants/constants.h"
-#include "imageloader.h"
+#include "textureCooker.h"
 #include <map>
 #include <string>
 #include <vector>
 
 class ImageSet {
 private:
-	ImageLoader** images;
+	CookedTexture** images;
 	std::map<std::string,int> set;
 	void releaseTextureArray();
 public:
@@ -0,0 +1,183 @@
+#include "mipGenerator.h"
+#include "../constants/constants.h"
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE__)
+#include <xmmintrin.h>
+#define MIP_USE_SSE
+#endif
+
+#define MIP_TAPS 8
+#define LINEAR_STEPS 4096
+
+// Lanczos2 kernel for 2:1 reduction, taps at -3.5 .. 3.5 source texels
+static const float MipKernel[MIP_TAPS] = { -0.0089, -0.0419, 0.1165, 0.4343, 0.4343, 0.1165, -0.0419, -0.0089 };
+
+struct ColorTables {
+	float toLinear[256];
+	byte toSrgb[LINEAR_STEPS + 1];
+	ColorTables() {
+		for (int i = 0; i < 256; i++) {
+			float c = i / 255.0;
+			toLinear[i] = c <= 0.04045 ? c / 12.92 : powf((c + 0.055) / 1.055, 2.4);
+		}
+		for (int i = 0; i <= LINEAR_STEPS; i++) {
+			float c = (float)i / LINEAR_STEPS;
+			float s = c <= 0.0031308 ? c * 12.92 : 1.055 * powf(c, 1.0 / 2.4) - 0.055;
+			toSrgb[i] = (byte)(s * 255.0 + 0.5);
+		}
+	}
+};
+
+static const ColorTables& GetTables() {
+	static ColorTables tables;
+	return tables;
+}
+
+// dst += src * w for one rgba texel
+static inline void MulAdd(float* dst, const float* src, float w) {
+#ifdef MIP_USE_SSE
+	_mm_storeu_ps(dst, _mm_add_ps(_mm_loadu_ps(dst), _mm_mul_ps(_mm_loadu_ps(src), _mm_set1_ps(w))));
+#else
+	dst[0] += src[0] * w, dst[1] += src[1] * w;
+	dst[2] += src[2] * w, dst[3] += src[3] * w;
+#endif
+}
+
+struct MipSource {
+	const byte* bytes; // Base level
+	const float* floats; // Generated levels, linear & premultiplied if asked
+	int width, height;
+	bool srgb, premultiply;
+};
+
+static void LoadRow(const MipSource& src, int y, float* row) {
+	if (src.floats) {
+		memcpy(row, src.floats + y * src.width * 4, src.width * 4 * sizeof(float));
+		return;
+	}
+	const float* toLinear = GetTables().toLinear;
+	const byte* p = src.bytes + y * src.width * 4;
+	for (int x = 0; x < src.width; x++, p += 4, row += 4) {
+		float a = p[3] / 255.0;
+		float weight = src.premultiply ? a : 1.0;
+		for (int c = 0; c < 3; c++)
+			row[c] = (src.srgb ? toLinear[p[c]] : p[c] / 255.0) * weight;
+		row[3] = a;
+	}
+}
+
+static void FilterRow(const float* row, int sw, float* out, int dw) {
+	for (int x = 0; x < dw; x++, out += 4) {
+		out[0] = 0.0, out[1] = 0.0, out[2] = 0.0, out[3] = 0.0;
+		for (int k = 0; k < MIP_TAPS; k++) {
+			int sx = x * 2 - 3 + k;
+			sx = sx < 0 ? 0 : (sx >= sw ? sw - 1 : sx);
+			MulAdd(out, row + sx * 4, MipKernel[k]);
+		}
+	}
+}
+
+// Separable pass, filtered source rows kept in a ring of MIP_TAPS rows
+static void DownsampleLevel(const MipSource& src, float* dst, int dw, int dh) {
+	int sw = src.width, sh = src.height;
+	float* row = (float*)malloc(sw * 4 * sizeof(float));
+	float* ring = (float*)malloc(MIP_TAPS * dw * 4 * sizeof(float));
+	int ringRows[MIP_TAPS];
+	for (int k = 0; k < MIP_TAPS; k++) ringRows[k] = -1;
+
+	for (int y = 0; y < dh; y++) {
+		float* out = dst + y * dw * 4;
+		memset(out, 0, dw * 4 * sizeof(float));
+		for (int k = 0; k < MIP_TAPS; k++) {
+			int sy = y * 2 - 3 + k;
+			sy = sy < 0 ? 0 : (sy >= sh ? sh - 1 : sy);
+			int slot = sy % MIP_TAPS;
+			float* filtered = ring + slot * dw * 4;
+			if (ringRows[slot] != sy) {
+				LoadRow(src, sy, row);
+				FilterRow(row, sw, filtered, dw);
+				ringRows[slot] = sy;
+			}
+			for (int x = 0; x < dw; x++)
+				MulAdd(out + x * 4, filtered + x * 4, MipKernel[k]);
+		}
+	}
+
+	free(ring);
+	free(row);
+}
+
+static float BaseCoverage(const byte* rgba, int count, float alphaRef) {
+	int passed = 0;
+	for (int i = 0; i < count; i++)
+		passed += rgba[i * 4 + 3] >= alphaRef * 255.0 ? 1 : 0;
+	return (float)passed / count;
+}
+
+static float LevelCoverage(const float* level, int count, float alphaRef, float scale) {
+	int passed = 0;
+	for (int i = 0; i < count; i++)
+		passed += level[i * 4 + 3] * scale >= alphaRef ? 1 : 0;
+	return (float)passed / count;
+}
+
+// Smallest alpha scale giving at least base coverage, by bisection
+static float FindAlphaScale(const float* level, int count, float alphaRef, float coverage) {
+	float low = 0.0, high = 4.0;
+	for (int i = 0; i < 10; i++) {
+		float mid = (low + high) * 0.5;
+		if (LevelCoverage(level, count, alphaRef, mid) < coverage) low = mid;
+		else high = mid;
+	}
+	return high;
+}
+
+static void StoreLevel(const float* level, int count, bool srgb, bool premultiply, float alphaScale, byte* out) {
+	const byte* toSrgb = GetTables().toSrgb;
+	for (int i = 0; i < count; i++, level += 4, out += 4) {
+		float a = level[3] < 0.0 ? 0.0 : (level[3] > 1.0 ? 1.0 : level[3]);
+		float invA = premultiply ? (a > 0.001 ? 1.0 / a : 0.0) : 1.0;
+		for (int c = 0; c < 3; c++) {
+			float v = level[c] * invA;
+			v = v < 0.0 ? 0.0 : (v > 1.0 ? 1.0 : v);
+			out[c] = srgb ? toSrgb[(int)(v * LINEAR_STEPS + 0.5)] : (byte)(v * 255.0 + 0.5);
+		}
+		a *= alphaScale;
+		out[3] = (byte)((a > 1.0 ? 1.0 : a) * 255.0 + 0.5);
+	}
+}
+
+void GenerateMipChain(int width, int height, const unsigned char* rgba, bool srgb, bool premultiply, float alphaRef, std::vector<ImageLevel>& levels) {
+	if (!rgba || width <= 0 || height <= 0) return;
+
+	// Coverage only matters if base level has cut out texels
+	float coverage = -1.0;
+	if (alphaRef > 0.0) {
+		for (int i = 0; i < width * height && coverage < 0.0; i++) {
+			if (rgba[i * 4 + 3] < 255) coverage = BaseCoverage(rgba, width * height, alphaRef);
+		}
+	}
+
+	MipSource src = { rgba, NULL, width, height, srgb, premultiply };
+	float* prev = NULL;
+	while (src.width > 1 || src.height > 1) {
+		int dw = src.width > 1 ? src.width / 2 : 1;
+		int dh = src.height > 1 ? src.height / 2 : 1;
+		float* cur = (float*)malloc(dw * dh * 4 * sizeof(float));
+		DownsampleLevel(src, cur, dw, dh);
+
+		float scale = coverage >= 0.0 ? FindAlphaScale(cur, dw * dh, alphaRef, coverage) : 1.0;
+		byte* out = (byte*)malloc(dw * dh * 4 * sizeof(byte));
+		StoreLevel(cur, dw * dh, srgb, premultiply, scale, out);
+		levels.push_back(ImageLevel(dw, dh, out));
+
+		if (prev) free(prev);
+		prev = cur;
+		src.bytes = NULL, src.floats = cur;
+		src.width = dw, src.height = dh;
+	}
+	if (prev) free(prev);
+}
@@ -0,0 +1,15 @@
+#ifndef MIP_GENERATOR_H_
+#define MIP_GENERATOR_H_
+
+#include "imageloader.h"
+#include <vector>
+
+#define ALPHA_TEST_REF 0.3 // Same as alpha test in phong.frag
+
+// Build levels after base of rgba8 image with 8 tap lanczos kernel,
+// srgb data filtered in linear space, color weighted by alpha if premultiply,
+// normals & masks filter each channel alone as alpha may be unrelated data,
+// alphaRef > 0 keeps alpha test coverage of base level in every level
+void GenerateMipChain(int width, int height, const unsigned char* rgba, bool srgb, bool premultiply, float alphaRef, std::vector<ImageLevel>& levels);
+
+#endif
@@ -0,0 +1,78 @@
+#include "rectPacker.h"
+
+SkylinePacker::SkylinePacker(int w, int h) {
+	width = w, height = h;
+	usedArea = 0;
+	skyline.clear();
+	skyline.push_back(SkylineNode(0, 0, w));
+}
+
+SkylinePacker::~SkylinePacker() {
+	skyline.clear();
+}
+
+// Top of rect placed at skyline[index].x, rect rests on highest node it spans
+bool SkylinePacker::fits(int index, int w, int h, int& y) {
+	int x = skyline[index].x;
+	if (x + w > width) return false;
+	int widthLeft = w;
+	y = skyline[index].y;
+	for (unsigned int i = index; widthLeft > 0; i++) {
+		if (i >= skyline.size()) return false;
+		if (skyline[i].y > y) y = skyline[i].y;
+		if (y + h > height) return false;
+		widthLeft -= skyline[i].width;
+	}
+	return true;
+}
+
+void SkylinePacker::addLevel(int index, int x, int y, int w, int h) {
+	skyline.insert(skyline.begin() + index, SkylineNode(x, y + h, w));
+
+	// Cut nodes now covered by the new one
+	for (int i = index + 1; i < (int)skyline.size(); i++) {
+		SkylineNode& prev = skyline[i - 1];
+		SkylineNode& node = skyline[i];
+		if (node.x >= prev.x + prev.width) break;
+		int shrink = prev.x + prev.width - node.x;
+		node.x += shrink;
+		node.width -= shrink;
+		if (node.width > 0) break;
+		skyline.erase(skyline.begin() + i);
+		i--;
+	}
+
+	for (int i = 0; i + 1 < (int)skyline.size(); i++) {
+		if (skyline[i].y == skyline[i + 1].y) {
+			skyline[i].width += skyline[i + 1].width;
+			skyline.erase(skyline.begin() + i + 1);
+			i--;
+		}
+	}
+}
+
+bool SkylinePacker::insert(int w, int h, int& x, int& y) {
+	int bestIndex = -1, bestTop = height + 1, bestWidth = width + 1;
+	for (unsigned int i = 0; i < skyline.size(); i++) {
+		int ny = 0;
+		if (!fits(i, w, h, ny)) continue;
+		if (ny + h < bestTop || (ny + h == bestTop && skyline[i].width < bestWidth)) {
+			bestIndex = i;
+			bestTop = ny + h;
+			bestWidth = skyline[i].width;
+			x = skyline[i].x, y = ny;
+		}
+	}
+	if (bestIndex < 0) return false;
+
+	addLevel(bestIndex, x, y, w, h);
+	usedArea += w * h;
+	return true;
+}
+
+int SkylinePacker::getUsedHeight() {
+	int top = 0;
+	for (unsigned int i = 0; i < skyline.size(); i++)
+		if (skyline[i].y > top) top = skyline[i].y;
+	return top;
+}
@@ -0,0 +1,31 @@
+#ifndef RECT_PACKER_H_
+#define RECT_PACKER_H_
+
+#include <vector>
+
+struct SkylineNode {
+	int x, y, width;
+	SkylineNode(int px, int py, int w) :x(px), y(py), width(w) {}
+};
+
+// Skyline bottom left packing into a fixed size page
+class SkylinePacker {
+private:
+	int width, height;
+	std::vector<SkylineNode> skyline;
+	int usedArea;
+private:
+	bool fits(int index, int w, int h, int& y);
+	void addLevel(int index, int x, int y, int w, int h);
+public:
+	SkylinePacker(int w, int h);
+	~SkylinePacker();
+	bool insert(int w, int h, int& x, int& y);
+	int getUsedArea() { return usedArea; }
+	int getWidth() { return width; }
+	int getHeight() { return height; }
+	// Lowest height holding all rects, pages can be cropped to it
+	int getUsedHeight();
+};
+
+#endif
@@ -1,4 +1,5 @@
 #include "textureBuffer.h"
+#include "../render/ringBuffer.h"
 
 TextureBuffer::TextureBuffer(int p, int c, int size, void* data) :precision(p), component(c), maxSize(size) {
     switch (precision) {
@@ -82,7 +83,9 @@ TextureBuffer::~TextureBuffer() {
 }
 
 void TextureBuffer::update(uint size, void* data) {
-    glNamedBufferSubData(buffId, 0, size * component * bitSize, data);
+    uint bytes = size * component * bitSize;
+    if (!RingBuffer::uploads || !RingBuffer::uploads->upload(buffId, 0, bytes, data))
+        glNamedBufferSubData(buffId, 0, bytes, data);
 }
 
 u64 TextureBuffer::genBindless() {
@@ -0,0 +1,190 @@
+#include "textureCooker.h"
+#include "mipGenerator.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#endif
+using namespace std;
+
+static const u64 FnvOffset = 14695981039346656037ULL;
+static const u64 FnvPrime = 1099511628211ULL;
+
+static u64 HashBytes(u64 hash, const byte* data, uint size) {
+	for (uint i = 0; i < size; i++) {
+		hash ^= data[i];
+		hash *= FnvPrime;
+	}
+	return hash;
+}
+
+static void MakeCacheDir() {
+#ifdef _WIN32
+	_mkdir(TEXTURE_CACHE_DIR);
+#else
+	mkdir(TEXTURE_CACHE_DIR, 0755);
+#endif
+}
+
+CookedTexture::CookedTexture() {
+	format = BLOCK_NONE;
+	width = 0, height = 0;
+	levels.clear();
+}
+
+CookedTexture::~CookedTexture() {
+	for (uint i = 0; i < levels.size(); i++)
+		free(levels[i].data);
+	levels.clear();
+}
+
+// Header: magic version format levels, then width height size & blocks of each level
+bool CookedTexture::load(const char* path, int firstLevel) {
+	FILE* file = fopen(path, "rb");
+	if (!file) return false;
+
+	uint header[4];
+	bool valid = fread(header, sizeof(uint), 4, file) == 4 &&
+		header[0] == COOKED_MAGIC && header[1] == COOKED_VERSION &&
+		header[3] > 0 && header[3] <= 16;
+	format = valid ? header[2] : BLOCK_NONE;
+	valid = valid && (format == BLOCK_BC1 || format == BLOCK_BC3 || format == BLOCK_BC5 || format == BLOCK_BC7);
+	for (uint l = 0; valid && l < header[3]; l++) {
+		uint info[3];
+		valid = fread(info, sizeof(uint), 3, file) == 3 &&
+			info[0] > 0 && info[1] > 0 && info[2] == GetCompressedSize(format, info[0], info[1]);
+		if (!valid) break;
+		if ((int)l < firstLevel) {
+			valid = fseek(file, info[2], SEEK_CUR) == 0;
+			continue;
+		}
+		byte* data = (byte*)malloc(info[2]);
+		valid = fread(data, 1, info[2], file) == info[2];
+		levels.push_back(CookedLevel(info[0], info[1], info[2], data));
+	}
+	fclose(file);
+
+	valid = valid && levels.size() > 0;
+	if (!valid) {
+		for (uint i = 0; i < levels.size(); i++)
+			free(levels[i].data);
+		levels.clear();
+		format = BLOCK_NONE;
+		return false;
+	}
+	width = levels[0].width, height = levels[0].height;
+	return true;
+}
+
+// Write to temp file then rename, other loaders never see half written cache
+bool CookedTexture::save(const char* path) {
+	char tmpPath[512];
+	sprintf(tmpPath, "%s.%p.tmp", path, this);
+	FILE* file = fopen(tmpPath, "wb");
+	if (!file) return false;
+
+	uint header[4] = { COOKED_MAGIC, COOKED_VERSION, (uint)format, (uint)levels.size() };
+	bool ok = fwrite(header, sizeof(uint), 4, file) == 4;
+	for (uint l = 0; ok && l < levels.size(); l++) {
+		uint info[3] = { (uint)levels[l].width, (uint)levels[l].height, levels[l].size };
+		ok = fwrite(info, sizeof(uint), 3, file) == 3 &&
+			fwrite(levels[l].data, 1, levels[l].size, file) == levels[l].size;
+	}
+	fclose(file);
+
+	if (ok) ok = rename(tmpPath, path) == 0;
+	if (!ok) remove(tmpPath);
+	return ok;
+}
+
+uint CookedTexture::getMemorySize() {
+	uint size = 0;
+	for (uint i = 0; i < levels.size(); i++)
+		size += levels[i].size;
+	return size;
+}
+
+int ChooseBlockFormat(int usage, const ImageLoader* img) {
+	if (usage == USAGE_NORMAL) return BLOCK_BC5;
+	if (usage == USAGE_MASK) return BLOCK_BC7;
+
+	int texels = img->width * img->height;
+	for (int i = 0; i < texels; i++) {
+		if (img->data[i * 4 + 3] < 255) return BLOCK_BC3;
+	}
+	return BLOCK_BC1;
+}
+
+CookedTexture* CookTexture(ImageLoader* img, int format, int usage, bool srgb) {
+	if (!img->data) return NULL;
+	// Only colors are gamma encoded, alpha weighted & alpha tested
+	bool color = usage == USAGE_COLOR;
+	img->generateMipmaps(color && srgb, color, color ? ALPHA_TEST_REF : 0.0);
+
+	CookedTexture* tex = new CookedTexture();
+	tex->format = format;
+	tex->width = img->width, tex->height = img->height;
+	for (int l = 0; l < img->getLevelCount(); l++) {
+		int w = l == 0 ? img->width : img->mipmaps[l - 1].width;
+		int h = l == 0 ? img->height : img->mipmaps[l - 1].height;
+		const byte* src = l == 0 ? img->data : img->mipmaps[l - 1].data;
+		uint size = GetCompressedSize(format, w, h);
+		byte* data = (byte*)malloc(size);
+		CompressImage(format, src, w, h, data);
+		tex->levels.push_back(CookedLevel(w, h, size, data));
+	}
+	return tex;
+}
+
+u64 HashTextureFile(const char* path, int usage, bool srgb, int format) {
+	FILE* file = fopen(path, "rb");
+	if (!file) return 0;
+
+	u64 hash = FnvOffset;
+	byte buffer[65536];
+	size_t count = 0;
+	while ((count = fread(buffer, 1, sizeof(buffer), file)) > 0)
+		hash = HashBytes(hash, buffer, (uint)count);
+	fclose(file);
+
+	int settings[4] = { COOKED_VERSION, usage, srgb ? 1 : 0, format };
+	return HashBytes(hash, (const byte*)settings, sizeof(settings));
+}
+
+CookedTexture* LoadCookedTexture(const char* path, int usage, bool srgb, int format) {
+	u64 hash = HashTextureFile(path, usage, srgb, format);
+	if (hash == 0) return NULL;
+	char cachePath[256];
+	sprintf(cachePath, "%s/%016llx.tbc", TEXTURE_CACHE_DIR, hash);
+
+	CookedTexture* tex = new CookedTexture();
+	tex->cachePath = cachePath;
+	if (tex->load(cachePath)) return tex;
+	delete tex;
+
+	ImageLoader* img = new ImageLoader(path);
+	tex = NULL;
+	if (img->data) {
+		if (format == BLOCK_NONE) format = ChooseBlockFormat(usage, img);
+		tex = CookTexture(img, format, usage, srgb);
+		tex->cachePath = cachePath;
+		MakeCacheDir();
+		if (!tex->save(cachePath))
+			printf("texture %s cook cache write failed\n", path);
+	}
+	delete img;
+	return tex;
+}
+
+GLenum GetCompressedFormat(int format, bool srgb) {
+	switch (format) {
+		case BLOCK_BC1: return srgb ? GL_COMPRESSED_SRGB_S3TC_DXT1_EXT : GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+		case BLOCK_BC3: return srgb ? GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT : GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+		case BLOCK_BC5: return GL_COMPRESSED_RG_RGTC2;
+		case BLOCK_BC7: return srgb ? GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM : GL_COMPRESSED_RGBA_BPTC_UNORM;
+	}
+	return GL_RGBA;
+}
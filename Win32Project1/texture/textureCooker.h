@@ -0,0 +1,53 @@
+#ifndef TEXTURE_COOKER_H_
+#define TEXTURE_COOKER_H_
+
+#include "../render/glheader.h"
+#include "../constants/constants.h"
+#include "blockEncoder.h"
+#include "imageloader.h"
+#include <vector>
+#include <string>
+
+#define TEXTURE_CACHE_DIR "texture/cache"
+#define COOKED_MAGIC 0x43423354 // "T3BC"
+#define COOKED_VERSION 3
+
+// How shaders read the texture, decides block format
+#define USAGE_AUTO -1
+#define USAGE_COLOR 0 // bc1, bc3 if alpha used
+#define USAGE_NORMAL 1 // bc5, shader rebuilds z
+#define USAGE_MASK 2 // bc7
+
+struct CookedLevel {
+	int width, height;
+	uint size;
+	byte* data;
+	CookedLevel(int w, int h, uint s, byte* d) :width(w), height(h), size(s), data(d) {}
+};
+
+class CookedTexture {
+public:
+	int format;
+	int width, height; // Of first loaded level
+	std::vector<CookedLevel> levels;
+	std::string cachePath;
+public:
+	CookedTexture();
+	~CookedTexture();
+	// Levels finer than firstLevel are skipped
+	bool load(const char* path, int firstLevel = 0);
+	bool save(const char* path);
+	uint getMemorySize();
+	int getLevelCount() { return (int)levels.size(); }
+};
+
+int ChooseBlockFormat(int usage, const ImageLoader* img);
+// Encode image & its mip chain, no gl calls so it can run on any thread
+CookedTexture* CookTexture(ImageLoader* img, int format, int usage, bool srgb);
+// Content hash of source file bytes & cook settings, 0 if file missing
+u64 HashTextureFile(const char* path, int usage, bool srgb, int format);
+// Load from cache keyed by content hash or cook & store it, NULL if source can not load
+CookedTexture* LoadCookedTexture(const char* path, int usage, bool srgb, int format = BLOCK_NONE);
+GLenum GetCompressedFormat(int format, bool srgb);
+
+#endif
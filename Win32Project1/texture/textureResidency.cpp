@@ -0,0 +1,153 @@
+#include "textureResidency.h"
+#include <math.h>
+#include <algorithm>
+using namespace std;
+
+TextureResidency::TextureResidency(int count, u64 budgetBytes) {
+	entries.resize(count);
+	requests = new atomic<int>[count];
+	for (int i = 0; i < count; i++) requests[i] = 0;
+	budget = budgetBytes;
+	frame = 0;
+}
+
+TextureResidency::~TextureResidency() {
+	delete[] requests;
+	entries.clear();
+}
+
+int TextureResidency::initTexture(int index, int width, const vector<uint>& levelSizes, bool streamed) {
+	ResidencyEntry& entry = entries[index];
+	entry.width = width;
+	entry.levelSizes = levelSizes;
+	entry.streamed = streamed;
+	entry.tail = 0;
+	int count = (int)levelSizes.size();
+	while (entry.tail < count - 1 && (width >> entry.tail) > STREAM_TAIL_SIZE)
+		entry.tail++;
+	entry.resident = streamed ? entry.tail : 0;
+	entry.requested = 0, entry.target = entry.resident;
+	entry.lastUsed = 0;
+	entry.loading = false;
+	return entry.resident;
+}
+
+void TextureResidency::request(int index, float screenSize) {
+	int size = (int)ceilf(screenSize);
+	int old = requests[index].load();
+	while (size > old && !requests[index].compare_exchange_weak(old, size));
+}
+
+u64 TextureResidency::sizeFrom(const ResidencyEntry& entry, int level) {
+	u64 size = 0;
+	for (uint l = level; l < entry.levelSizes.size(); l++)
+		size += entry.levelSizes[l];
+	return size;
+}
+
+bool TextureResidency::isRecent(const ResidencyEntry& entry) {
+	return entry.lastUsed > 0 && frame - entry.lastUsed <= STREAM_KEEP_FRAMES;
+}
+
+// Coarsen targets of least recently used textures until all fit, return total
+u64 TextureResidency::fitBudget() {
+	u64 total = 0;
+	for (uint i = 0; i < entries.size(); i++)
+		total += sizeFrom(entries[i], entries[i].target);
+
+	while (total > budget) {
+		int drop = -1;
+		for (uint i = 0; i < entries.size(); i++) {
+			ResidencyEntry& entry = entries[i];
+			if (!entry.streamed || entry.target >= entry.tail) continue;
+			if (drop < 0) drop = i;
+			else {
+				ResidencyEntry& worst = entries[drop];
+				if (entry.lastUsed < worst.lastUsed || (entry.lastUsed == worst.lastUsed && entry.target < worst.target))
+					drop = i;
+			}
+		}
+		if (drop < 0) break;
+		ResidencyEntry& entry = entries[drop];
+		total -= entry.levelSizes[entry.target];
+		entry.target++;
+	}
+	return total;
+}
+
+void TextureResidency::update(vector<ResidencyChange>& changes) {
+	frame++;
+	for (uint i = 0; i < entries.size(); i++) {
+		ResidencyEntry& entry = entries[i];
+		int size = requests[i].exchange(0);
+		if (entry.levelSizes.empty()) continue;
+		if (!entry.streamed) {
+			entry.target = 0;
+			continue;
+		}
+		if (size > 0) {
+			entry.requested = min(EstimateMipLevel(entry.width, size), entry.tail);
+			entry.lastUsed = frame;
+		}
+		// Never requested ones may be drawn outside queues, keep them sharp if budget allows
+		if (entry.lastUsed == 0) entry.target = 0;
+		else entry.target = isRecent(entry) ? entry.requested : entry.tail;
+	}
+
+	bool overBudget = getResidentSize() > budget;
+	fitBudget();
+
+	// Drops are immediate, skip single level drops of visible textures to avoid flicker
+	int loading = 0;
+	vector<pair<u64, int> > loads;
+	for (uint i = 0; i < entries.size(); i++) {
+		ResidencyEntry& entry = entries[i];
+		if (!entry.streamed) continue;
+		if (entry.loading) {
+			loading++;
+			continue;
+		}
+		if (entry.target > entry.resident) {
+			if (overBudget || !isRecent(entry) || entry.target > entry.resident + 1)
+				changes.push_back(ResidencyChange(i, entry.target));
+		} else if (entry.target < entry.resident) {
+			u64 priority = ((u64)entry.lastUsed << 8) | (u64)(entry.resident - entry.target);
+			loads.push_back(pair<u64, int>(priority, i));
+		}
+	}
+
+	sort(loads.begin(), loads.end());
+	for (int l = (int)loads.size() - 1; l >= 0 && loading < STREAM_MAX_LOADS; l--, loading++) {
+		ResidencyEntry& entry = entries[loads[l].second];
+		entry.loading = true;
+		changes.push_back(ResidencyChange(loads[l].second, entry.target));
+	}
+}
+
+void TextureResidency::finishChange(int index, int level) {
+	entries[index].resident = level;
+	entries[index].loading = false;
+}
+
+void TextureResidency::cancelChange(int index) {
+	entries[index].loading = false;
+}
+
+u64 TextureResidency::getResidentSize() {
+	u64 size = 0;
+	for (uint i = 0; i < entries.size(); i++)
+		size += sizeFrom(entries[i], entries[i].resident);
+	return size;
+}
+
+// Level whose width matches texels covering object on screen
+int EstimateMipLevel(int width, float screenSize) {
+	if (screenSize < 1.0) screenSize = 1.0;
+	int level = (int)floorf(log2f(width / screenSize)) - STREAM_LEVEL_BIAS;
+	return level < 0 ? 0 : level;
+}
+
+float ProjectedScreenSize(float radius, float distance, float fovy, float screenHeight) {
+	if (distance <= radius) return screenHeight;
+	return radius / (distance * tanf(fovy * 0.5 * A2R)) * screenHeight;
+}
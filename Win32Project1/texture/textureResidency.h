@@ -0,0 +1,67 @@
+#ifndef TEXTURE_RESIDENCY_H_
+#define TEXTURE_RESIDENCY_H_
+
+#include "../constants/constants.h"
+#include <vector>
+#include <atomic>
+
+#define STREAM_TAIL_SIZE 64 // Levels this wide or smaller never leave
+#define STREAM_KEEP_FRAMES 120 // Unseen frames before texture drops to tail
+#define STREAM_MAX_LOADS 2 // Loads in flight at once
+#define STREAM_LEVEL_BIAS 1 // Sharper than projected size, uv often tiles
+
+struct ResidencyEntry {
+	bool streamed; // Not streamed ones stay full & only count in budget
+	int width;
+	std::vector<uint> levelSizes;
+	int tail; // Coarsest level that can be the finest resident one
+	int resident; // Finest resident level
+	int requested, target;
+	uint lastUsed; // 0 if never requested
+	bool loading;
+	ResidencyEntry() {
+		streamed = false;
+		width = 0;
+		tail = 0, resident = 0;
+		requested = 0, target = 0;
+		lastUsed = 0;
+		loading = false;
+	}
+};
+
+struct ResidencyChange {
+	int index, level;
+	ResidencyChange(int i, int l) :index(i), level(l) {}
+};
+
+// Decides finest resident mip of each texture within a memory budget,
+// no gl calls, caller applies the changes & reports back
+class TextureResidency {
+private:
+	std::vector<ResidencyEntry> entries;
+	std::atomic<int>* requests; // Max screen size asked since last update
+	u64 budget;
+	uint frame;
+private:
+	u64 sizeFrom(const ResidencyEntry& entry, int level);
+	u64 fitBudget();
+	bool isRecent(const ResidencyEntry& entry);
+public:
+	TextureResidency(int count, u64 budgetBytes);
+	~TextureResidency();
+	// Returns level to upload first
+	int initTexture(int index, int width, const std::vector<uint>& levelSizes, bool streamed);
+	// Any thread, screenSize in pixels
+	void request(int index, float screenSize);
+	void update(std::vector<ResidencyChange>& changes);
+	void finishChange(int index, int level);
+	void cancelChange(int index);
+	int getResident(int index) { return entries[index].resident; }
+	u64 getResidentSize();
+	u64 getBudget() { return budget; }
+};
+
+int EstimateMipLevel(int width, float screenSize);
+float ProjectedScreenSize(float radius, float distance, float fovy, float screenHeight);
+
+#endif
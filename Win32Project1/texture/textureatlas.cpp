@@ -1,19 +1,23 @@
 #include "textureatlas.h"
 #include "../render/render.h"
 #include "../constants/constants.h"
+#include "../util/threadPool.h"
+#include "mipGenerator.h"
+#include "rectPacker.h"
 #include <stdlib.h>
+#include <algorithm>
 using namespace std;
 
 TextureAtlas::TextureAtlas() {
 	texId = 0;
-	perImgWidth = 0, perImgHeight = 0;
-	pCountW = 0, pCountH = 0;
-	pixW = 0, pixH = 0;
-	atlasInfo = (float*)malloc(4 * sizeof(float));
+	pageWidth = 0, pageHeight = 0;
+	pageCount = 0;
+	rectData = NULL;
 	imageNames.clear();
 	images = NULL;
-	data = NULL;
-	offsetMap.clear();
+	rectMap.clear();
+	rects.clear();
+	pageUsed.clear();
 }
 
 TextureAtlas::~TextureAtlas() {
@@ -24,32 +28,114 @@ TextureAtlas::~TextureAtlas() {
 		images = NULL;
 	}
 
-	free(atlasInfo);
+	if (rectData) free(rectData); rectData = NULL;
 	releaseAtlas();
 	imageNames.clear();
-
-	map<string, TexOffset*>::iterator it = offsetMap.begin();
-	while (it != offsetMap.end()) {
-		delete it->second;
-		++it;
-	}
-	offsetMap.clear();
+	rectMap.clear();
+	rects.clear();
+	pageUsed.clear();
 }
 
 void TextureAtlas::releaseAtlas() {
 	if (texId) glDeleteTextures(1, &texId);
+	texId = 0;
 }
 
 void TextureAtlas::addTexture(const string name) {
+	if (rectMap.find(name) != rectMap.end()) return;
+	rectMap[name] = imageNames.size();
 	imageNames.push_back(name);
-	offsetMap[name] = new TexOffset();
+	rects.push_back(AtlasRect());
 }
 
-TexOffset* TextureAtlas::findTextureOfs(const string name) {
-	map<string, TexOffset*>::iterator it = offsetMap.find(name);
-	if (it != offsetMap.end())
+int TextureAtlas::findTexture(const string name) {
+	map<string, int>::iterator it = rectMap.find(name);
+	if (it != rectMap.end())
 		return it->second;
-	return NULL;
+	return -1;
+}
+
+AtlasRect* TextureAtlas::findTextureRect(const string name) {
+	int index = findTexture(name);
+	return index >= 0 ? &rects[index] : NULL;
+}
+
+static bool CompareImageSize(const pair<int, int>& a, const pair<int, int>& b) {
+	return a.first > b.first || (a.first == b.first && a.second < b.second);
+}
+
+// Tallest first into the first page with room, open a new page when none fits
+void TextureAtlas::packRects() {
+	vector<pair<int, int> > order; // height, image index
+	for (uint i = 0; i < imageNames.size(); i++) {
+		if (images[i]->data) order.push_back(pair<int, int>(images[i]->height, i));
+		else printf("atlas image %s load failed\n", imageNames[i].data());
+	}
+	sort(order.begin(), order.end(), CompareImageSize);
+
+	vector<SkylinePacker*> packers;
+	int usedWidth = 0, usedHeight = 0;
+	for (uint o = 0; o < order.size(); o++) {
+		int i = order[o].second;
+		int w = images[i]->width + 2 * ATLAS_PADDING, h = images[i]->height + 2 * ATLAS_PADDING;
+		if (w > ATLAS_PAGE_SIZE || h > ATLAS_PAGE_SIZE) {
+			printf("atlas image %s larger than page\n", imageNames[i].data());
+			continue;
+		}
+
+		int x = 0, y = 0, page = -1;
+		for (uint p = 0; p < packers.size() && page < 0; p++) {
+			if (packers[p]->insert(w, h, x, y)) page = p;
+		}
+		if (page < 0) {
+			packers.push_back(new SkylinePacker(ATLAS_PAGE_SIZE, ATLAS_PAGE_SIZE));
+			packers.back()->insert(w, h, x, y);
+			page = packers.size() - 1;
+		}
+
+		AtlasRect& rect = rects[i];
+		rect.page = page;
+		rect.x = x + ATLAS_PADDING, rect.y = y + ATLAS_PADDING;
+		rect.width = images[i]->width, rect.height = images[i]->height;
+		usedWidth = max(usedWidth, x + w);
+		usedHeight = max(usedHeight, y + h);
+	}
+
+	// Pages share one size in the array, crop it to the packed area
+	pageCount = packers.size();
+	pageWidth = (usedWidth + 3) & ~3;
+	pageHeight = (usedHeight + 3) & ~3;
+	pageUsed.assign(pageCount, 0);
+	for (int p = 0; p < pageCount; p++) delete packers[p];
+	packers.clear();
+
+	rectData = (float*)malloc(rects.size() * ATLAS_RECT_CHANNEL * sizeof(float));
+	memset(rectData, 0, rects.size() * ATLAS_RECT_CHANNEL * sizeof(float));
+	for (uint i = 0; i < rects.size(); i++) {
+		AtlasRect& rect = rects[i];
+		if (rect.page < 0) continue;
+		rect.u0 = (float)rect.x / pageWidth, rect.v0 = (float)rect.y / pageHeight;
+		rect.u1 = (float)(rect.x + rect.width) / pageWidth, rect.v1 = (float)(rect.y + rect.height) / pageHeight;
+		pageUsed[rect.page] += rect.width * rect.height;
+
+		float* data = rectData + i * ATLAS_RECT_CHANNEL;
+		data[0] = rect.u0, data[1] = rect.v0, data[2] = rect.u1, data[3] = rect.v1;
+		data[4] = rect.page, data[5] = rect.width, data[6] = rect.height;
+	}
+}
+
+// Copy image into its rect, padding repeats edge texels
+void TextureAtlas::copyImage(byte* page, int index) {
+	AtlasRect& rect = rects[index];
+	const byte* src = images[index]->data;
+	for (int y = -ATLAS_PADDING; y < rect.height + ATLAS_PADDING; y++) {
+		int sy = y < 0 ? 0 : (y >= rect.height ? rect.height - 1 : y);
+		byte* dst = page + ((rect.y + y) * pageWidth + rect.x - ATLAS_PADDING) * 4;
+		for (int x = -ATLAS_PADDING; x < rect.width + ATLAS_PADDING; x++, dst += 4) {
+			int sx = x < 0 ? 0 : (x >= rect.width ? rect.width - 1 : x);
+			memcpy(dst, src + (sy * rect.width + sx) * 4, 4);
+		}
+	}
 }
 
 void TextureAtlas::createAtlas(string dir) {
@@ -58,96 +144,73 @@ void TextureAtlas::createAtlas(string dir) {
 	images = new ImageLoader*[imageCount];
 
 	string path = dir.append("/");
-	string name("");
-	for (unsigned int i = 0; i < imageCount; i++) {
-		name = imageNames[i];
-		images[i] = new ImageLoader((path + name).c_str());
+	ThreadPool pool;
+	pool.parallelFor(imageCount, [this, &path](int i) {
+		images[i] = new ImageLoader((path + imageNames[i]).c_str());
+	});
+
+	packRects();
+	if (pageCount <= 0) return;
+
+	uint pageSize = pageWidth * pageHeight * 4 * sizeof(byte);
+	vector<byte*> pages(pageCount, (byte*)NULL);
+	vector<vector<ImageLevel> > mipmaps(pageCount);
+	for (int p = 0; p < pageCount; p++) {
+		pages[p] = (byte*)malloc(pageSize);
+		memset(pages[p], 0, pageSize);
 	}
-
-	float sqrtCount = sqrtf((float)imageCount);
-	pCountW = ceilf(sqrtCount);
-	pCountH = ceilf(sqrtCount);
-
-	perImgWidth = images[0]->width;
-	perImgHeight = images[0]->height;
-
-	uint bw = 32, bh = 32;
-
-	uint atlasWidth = pCountW * (perImgWidth + 2 * bw);
-	uint atlasHeight = pCountH * (perImgHeight + 2 * bh);
-	pixW = 1.0 / (float)atlasWidth;
-	pixH = 1.0 / (float)atlasHeight;
-
-	atlasInfo[0] = pixW, atlasInfo[1] = pixH;
-	atlasInfo[2] = perImgWidth, atlasInfo[3] = perImgHeight;
-
-	uint pixelCount = atlasWidth * atlasHeight;
-	data = (byte*)malloc(pixelCount * 4 * sizeof(byte));
-	memset(data, 0, pixelCount * 4 * sizeof(byte));
-
-	uint curPix = 0;
-	for (uint pch = 0; pch < pCountH; pch++) {
-		for (uint h = 0; h < perImgHeight + 2 * bh; h++) {
-			for (uint pcw = 0; pcw < pCountW; pcw++) {
-				uint imgIndex = pch * pCountW + pcw;
-				for (uint w = 0; w < perImgWidth + 2 * bw; w++) {
-					bool border = w<bw || w>(perImgWidth - 1 + bw) || h<bh || h>(perImgHeight - 1 + bh);
-					if (!border) {
-						uint pixIndex = (h - bh) * perImgWidth + (w - bw);
-						if (imageCount - 1 >= imgIndex) {
-							data[curPix * 4 + 0] = images[imgIndex]->data[pixIndex * 4 + 0];
-							data[curPix * 4 + 1] = images[imgIndex]->data[pixIndex * 4 + 1];
-							data[curPix * 4 + 2] = images[imgIndex]->data[pixIndex * 4 + 2];
-							data[curPix * 4 + 3] = images[imgIndex]->data[pixIndex * 4 + 3];
-						}
-					} else {
-						data[curPix * 4 + 0] = 0;
-						data[curPix * 4 + 1] = 0;
-						data[curPix * 4 + 2] = 0;
-						data[curPix * 4 + 3] = 0;
-					}
-					curPix++;
-				}
-			}
-		}
+	for (int i = 0; i < imageCount; i++) {
+		if (rects[i].page >= 0) copyImage(pages[rects[i].page], i);
 	}
 
-	for (uint pch = 0; pch < pCountH; pch++) {
-		for (uint pcw = 0; pcw < pCountW; pcw++) {
-			uint imgIndex = pch * pCountW + pcw;
-			if (imageCount - 1 >= imgIndex) {
-				string imgName = imageNames[imgIndex];
-				TexOffset* ofs = offsetMap[imgName];
-				ofs->x = pcw * (2 * bw + perImgWidth) + bw;
-				ofs->y = pch * (2 * bh + perImgHeight) + bh;
-			}
-		}
-	}
+	// Mips filtered in linear space on cpu, pages in parallel
+	pool.parallelFor(pageCount, [this, &pages, &mipmaps](int p) {
+		GenerateMipChain(pageWidth, pageHeight, pages[p], true, true, ALPHA_TEST_REF, mipmaps[p]);
+	});
+	int levels = min((int)mipmaps[0].size(), ATLAS_MAX_LEVEL);
 
 	glGenTextures(1, &texId);
-	glBindTexture(GL_TEXTURE_2D, texId);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-	glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAX_ANISOTROPY_EXT, Render::MaxAniso);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, texId);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+	glTexParameterf(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_ANISOTROPY_EXT, Render::MaxAniso);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LEVEL, levels);
+
+	glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_SRGB_ALPHA, pageWidth, pageHeight, pageCount, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+	for (int l = 0; l < levels; l++)
+		glTexImage3D(GL_TEXTURE_2D_ARRAY, l + 1, GL_SRGB_ALPHA, mipmaps[0][l].width, mipmaps[0][l].height, pageCount, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+	for (int p = 0; p < pageCount; p++) {
+		glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, p, pageWidth, pageHeight, 1, GL_RGBA, GL_UNSIGNED_BYTE, pages[p]);
+		for (int l = 0; l < levels; l++) {
+			ImageLevel& level = mipmaps[p][l];
+			glTexSubImage3D(GL_TEXTURE_2D_ARRAY, l + 1, 0, 0, p, level.width, level.height, 1, GL_RGBA, GL_UNSIGNED_BYTE, level.data);
+		}
+	}
+	glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
 
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_SRGB_ALPHA, atlasWidth, atlasHeight, 0, GL_RGBA, GL_UNSIGNED_BYTE, data);
+	for (int p = 0; p < pageCount; p++) {
+		free(pages[p]);
+		for (uint l = 0; l < mipmaps[p].size(); l++)
+			free(mipmaps[p][l].data);
+	}
+	for (int i = 0; i < imageCount; i++)
+		delete images[i];
+	delete[] images;
+	images = NULL;
 
-	glGenerateMipmap(GL_TEXTURE_2D);
-	glBindTexture(GL_TEXTURE_2D, 0);
+	printReport();
+}
 
-	if (data) free(data); data = NULL;
-	/*
-	if (images) {
-		for (uint i = 0; i < imageCount; i++)
-			delete images[i];
-		delete[] images;
-		images = NULL;
-	}
-	*/
-	printf("img: %d,%d,%d\n", pCountW, pCountH, imageCount);
-	map<string, TexOffset*>::iterator it = offsetMap.begin();
-	while (it != offsetMap.end()) {
-		printf("%s:%d,%d\n", it->first.data(), it->second->x, it->second->y);
-		++it;
+void TextureAtlas::printReport() {
+	int pageArea = pageWidth * pageHeight;
+	int usedArea = 0;
+	printf("atlas: %d images in %d pages of %dx%d\n", (int)imageNames.size(), pageCount, pageWidth, pageHeight);
+	for (int p = 0; p < pageCount; p++) {
+		usedArea += pageUsed[p];
+		printf("  page %d: %.1f%% used\n", p, pageUsed[p] * 100.0 / pageArea);
 	}
+	if (pageCount > 0)
+		printf("  total: %.1f%% used, %d KB\n", usedArea * 100.0 / (pageArea * pageCount), pageArea * pageCount * 4 / 1024);
 }
\ No newline at end of file
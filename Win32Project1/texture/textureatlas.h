@@ -7,10 +7,19 @@
 #include <string>
 #include <vector>
 
-struct TexOffset {
-	int x, y;
-	TexOffset() {
-		x = 0, y = 0;
+#define ATLAS_PAGE_SIZE 2048
+#define ATLAS_PADDING 8 // Edge texels repeated around each image
+#define ATLAS_MAX_LEVEL 3 // Lower mips would bleed through padding
+#define ATLAS_RECT_CHANNEL 8 // u0 v0 u1 v1 page width height 0
+
+struct AtlasRect {
+	int page;
+	int x, y, width, height; // Texels without padding
+	float u0, v0, u1, v1;
+	AtlasRect() {
+		page = -1;
+		x = 0, y = 0, width = 0, height = 0;
+		u0 = 0, v0 = 0, u1 = 0, v1 = 0;
 	}
 };
 
@@ -18,22 +27,27 @@ class TextureAtlas {
 private:
 	ImageLoader** images;
 	std::vector<std::string> imageNames;
-	unsigned char* data;
-	std::map<std::string, TexOffset*> offsetMap;
-	int pCountW, pCountH;
+	std::map<std::string, int> rectMap;
+	std::vector<AtlasRect> rects;
+	std::vector<int> pageUsed;
+	int pageCount;
 public:
-	GLuint texId;
-	int perImgWidth, perImgHeight;
-	float pixW, pixH;
-	float* atlasInfo;
+	GLuint texId; // Texture array, one layer per page
+	int pageWidth, pageHeight;
+	float* rectData;
 private:
 	void releaseAtlas();
+	void packRects();
+	void copyImage(unsigned char* page, int index);
 public:
 	TextureAtlas();
 	~TextureAtlas();
 	void addTexture(const std::string name);
-	TexOffset* findTextureOfs(const std::string name);
+	int findTexture(const std::string name);
+	AtlasRect* findTextureRect(const std::string name);
 	void createAtlas(std::string dir);
+	void printReport();
+	int getPageCount() { return pageCount; }
 };
 
 #endif
\ No newline at end of file
@@ -1,21 +1,53 @@
 #include "texturebindless.h"
 #include "../render/render.h"
+#include <chrono>
 using namespace std;
 
 TextureBindless::TextureBindless() {
 	texinds.clear();
 	texnames.clear();
 	texSrgbs.clear();
+	texUsages.clear();
 	wraps.clear();
-	imgs.clear();
+	cooks.clear();
 	texids = NULL;
 	texhnds = NULL;
 	size = 0;
+
+	holderIds[0] = 0, holderIds[1] = 0;
+	holderHnds[0] = 0, holderHnds[1] = 0;
+	texReady.clear();
+	readyCount = 0;
+	loadPool = NULL;
+	staged.clear();
+	stopLoading = false;
+
+	residency = NULL;
+	streamBudget = 0;
+	texStreamed.clear();
+	streamPool = NULL;
+	streamed.clear();
 }
 
 TextureBindless::~TextureBindless() {
-	for (int i = 0; i < size; i++)
-		glMakeTextureHandleNonResidentARB(texhnds[i]);
+	if (loadPool) {
+		stageLock.lock();
+		stopLoading = true;
+		stageLock.unlock();
+		stageCond.notify_all();
+		delete loadPool; loadPool = NULL;
+	}
+
+	if (streamPool) delete streamPool; streamPool = NULL;
+	for (uint i = 0; i < streamed.size(); i++) {
+		if (streamed[i].second) delete streamed[i].second;
+	}
+	streamed.clear();
+	if (residency) delete residency; residency = NULL;
+
+	for (int i = 0; i < size; i++) {
+		if (texReady[i]) glMakeTextureHandleNonResidentARB(texhnds[i]);
+	}
 	if (texhnds) free(texhnds); texhnds = NULL;
 
 	if (texids) {
@@ -23,23 +55,37 @@ TextureBindless::~TextureBindless() {
 		free(texids); texids = NULL;
 	}
 
+	for (int i = 0; i < 2; i++) {
+		if (!holderIds[i]) continue;
+		glMakeTextureHandleNonResidentARB(holderHnds[i]);
+		glDeleteTextures(1, &holderIds[i]);
+	}
+
 	releaseMemory();
 	
 	texnames.clear();
 	texSrgbs.clear();
+	texUsages.clear();
 	texinds.clear();
 	wraps.clear();
+	layouts.clear();
+	texReady.clear();
+	texStreamed.clear();
 }
 
 void TextureBindless::releaseMemory() {
-	for (uint i = 0; i < imgs.size(); i++)
-		delete imgs[i];
-	imgs.clear();
+	for (uint i = 0; i < cooks.size(); i++) {
+		if (cooks[i]) delete cooks[i];
+		cooks[i] = NULL;
+	}
 }
 
-void TextureBindless::addTexture(const string name, bool srgb, int wrap) {
+void TextureBindless::addTexture(const string name, bool srgb, int wrap, int usage) {
+	if (usage == USAGE_AUTO) usage = srgb ? USAGE_COLOR : USAGE_MASK;
 	texnames.push_back(name);
 	texSrgbs.push_back(srgb);
+	texUsages.push_back(usage);
+	texStreamed.push_back(false);
 	wraps.push_back(wrap);
 	texinds[name] = size;
 	size++;
@@ -52,39 +98,237 @@ int TextureBindless::findTexture(const string name) {
 	return -1;
 }
 
+// 1x1 textures: flat normal for linear data, mid grey for colors
+void TextureBindless::createPlaceholders() {
+	static const byte pixels[2][4] = { { 128, 128, 255, 255 }, { 128, 128, 128, 255 } };
+	glGenTextures(2, holderIds);
+	for (int i = 0; i < 2; i++) {
+		glBindTexture(GL_TEXTURE_2D, holderIds[i]);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+		glTexImage2D(GL_TEXTURE_2D, 0, i == 0 ? GL_RGBA : GL_SRGB_ALPHA, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels[i]);
+		holderHnds[i] = glGetTextureHandleARB(holderIds[i]);
+		glMakeTextureHandleResidentARB(holderHnds[i]);
+	}
+	glBindTexture(GL_TEXTURE_2D, 0);
+}
+
 void TextureBindless::initData(string dir) {
 	string path = dir.append("/");
 
+	// Textures created on upload, streaming recreates them with other levels
 	texids = (GLuint*)malloc(size * sizeof(GLuint));
 	memset(texids, 0, size * sizeof(GLuint));
-	glGenTextures(size, texids);
 	texhnds = (u64*)malloc(size * sizeof(u64));
 	memset(texhnds, 0, size * sizeof(u64));
 
+	createPlaceholders();
+	cooks.resize(size, NULL);
+	layouts.resize(size);
+	texReady.resize(size, false);
+	readyCount = 0;
+	for (int i = 0; i < size; i++)
+		texhnds[i] = holderHnds[texSrgbs[i] ? 1 : 0];
+
+	// Load cooked blocks or cook them on workers, gl thread only uploads
+	stopLoading = false;
+	loadPool = new ThreadPool();
 	for (int i = 0; i < size; i++) {
-		ImageLoader* img = new ImageLoader((path + texnames[i]).data());
-		imgs.push_back(img);
-		glBindTexture(GL_TEXTURE_2D, texids[i]);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-		glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAX_ANISOTROPY_EXT, Render::MaxAniso);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, wraps[i]);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, wraps[i]);
-		GLint interFormat = GL_SRGB_ALPHA;
-		if (texSrgbs[i])
-			interFormat = GL_SRGB_ALPHA;
-		else
-			interFormat = GL_RGBA;
-		glTexImage2D(GL_TEXTURE_2D, 0, interFormat, img->width, img->height, 0, GL_RGBA, GL_UNSIGNED_BYTE, img->data);
-		glGenerateMipmap(GL_TEXTURE_2D);
-
-		GLuint64 texHnd = glGetTextureHandleARB(texids[i]);
-		glMakeTextureHandleResidentARB(texHnd);
-		texhnds[i] = texHnd;
+		string file = path + texnames[i];
+		loadPool->push([this, i, file]() { decodeTexture(i, file); });
 	}
-	glBindTexture(GL_TEXTURE_2D, 0);
 
-#ifndef _DEBUG
-	releaseMemory();
-#endif
-}
\ No newline at end of file
+	if (streamBudget > 0) {
+		residency = new TextureResidency(size, streamBudget);
+		streamPool = new ThreadPool(1);
+	}
+}
+
+void TextureBindless::decodeTexture(int i, const string& path) {
+	{
+		// Wait for staging room, keep decoded memory bounded
+		unique_lock<mutex> guard(stageLock);
+		while (!stopLoading && staged.size() >= MAX_STAGED_TEXTURES)
+			stageCond.wait(guard);
+		if (stopLoading) return;
+	}
+
+	CookedTexture* tex = LoadCookedTexture(path.data(), texUsages[i], texSrgbs[i]);
+
+	lock_guard<mutex> guard(stageLock);
+	if (stopLoading) {
+		if (tex) delete tex;
+		return;
+	}
+	cooks[i] = tex;
+	staged.push_back(i);
+}
+
+// Immutable storage for levels from first on, sampler state set
+GLuint TextureBindless::createTexture(int i, int first) {
+	BindlessLayout& layout = layouts[i];
+	GLuint id = 0;
+	// Dsa calls, streaming runs mid frame & must not touch unit bindings
+	glCreateTextures(GL_TEXTURE_2D, 1, &id);
+	glTextureParameteri(id, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTextureParameteri(id, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+	glTextureParameterf(id, GL_TEXTURE_MAX_ANISOTROPY_EXT, Render::MaxAniso);
+	glTextureParameteri(id, GL_TEXTURE_WRAP_S, wraps[i]);
+	glTextureParameteri(id, GL_TEXTURE_WRAP_T, wraps[i]);
+	glTextureParameteri(id, GL_TEXTURE_MAX_LEVEL, layout.levels - first - 1);
+	int width = layout.width >> first, height = layout.height >> first;
+	glTextureStorage2D(id, layout.levels - first, layout.format, width > 0 ? width : 1, height > 0 ? height : 1);
+	return id;
+}
+
+void TextureBindless::uploadLevels(GLuint id, int i, CookedTexture* tex, int skip) {
+	for (int l = skip; l < tex->getLevelCount(); l++) {
+		CookedLevel& level = tex->levels[l];
+		glCompressedTextureSubImage2D(id, l - skip, 0, 0, level.width, level.height, layouts[i].format, level.size, level.data);
+	}
+}
+
+// Make new texture resident & release the old one, shaders need new handles
+void TextureBindless::swapTexture(int i, GLuint id) {
+	GLuint64 texHnd = glGetTextureHandleARB(id);
+	glMakeTextureHandleResidentARB(texHnd);
+	if (texReady[i]) {
+		glMakeTextureHandleNonResidentARB(texhnds[i]);
+		glDeleteTextures(1, &texids[i]);
+	}
+	texids[i] = id;
+	texhnds[i] = texHnd;
+	texReady[i] = true;
+}
+
+void TextureBindless::uploadTexture(int i) {
+	CookedTexture* tex = cooks[i];
+	if (tex) {
+		BindlessLayout& layout = layouts[i];
+		layout.format = GetCompressedFormat(tex->format, texSrgbs[i]);
+		layout.width = tex->width, layout.height = tex->height;
+		layout.levels = tex->getLevelCount();
+		layout.cachePath = tex->cachePath;
+
+		// Streamed textures start from their small tail levels
+		int first = 0;
+		if (residency) {
+			vector<uint> sizes;
+			for (int l = 0; l < tex->getLevelCount(); l++)
+				sizes.push_back(tex->levels[l].size);
+			first = residency->initTexture(i, tex->width, sizes, texStreamed[i]);
+		}
+		GLuint id = createTexture(i, first);
+		uploadLevels(id, i, tex, first);
+		swapTexture(i, id);
+	} else 
+		printf("texture %s load failed, keep placeholder\n", texnames[i].data());
+	readyCount++;
+
+	if (tex) delete tex;
+	cooks[i] = NULL;
+}
+
+// Upload staged textures within budget, return true if any handle changed
+bool TextureBindless::updateUploads(float budgetMs) {
+	if (!loadPool) return false;
+	chrono::steady_clock::time_point start = chrono::steady_clock::now();
+	bool changed = false;
+	while (readyCount < size) {
+		int i = -1;
+		stageLock.lock();
+		if (staged.size() > 0) {
+			i = staged.front();
+			staged.pop_front();
+		}
+		stageLock.unlock();
+		if (i < 0) break;
+		stageCond.notify_one();
+
+		uploadTexture(i);
+		changed = true;
+		float spent = chrono::duration<float, milli>(chrono::steady_clock::now() - start).count();
+		if (spent >= budgetMs) break;
+	}
+
+	if (readyCount >= size) {
+		delete loadPool; loadPool = NULL;
+	}
+	return changed;
+}
+
+// Block until every texture uploaded
+void TextureBindless::finishUploads() {
+	while (loadPool) {
+		if (!updateUploads(MAX_VAL))
+			this_thread::yield();
+	}
+}
+
+// Coarser levels copied on gpu, no reload needed
+void TextureBindless::dropLevels(int i, int level) {
+	BindlessLayout& layout = layouts[i];
+	int resident = residency->getResident(i);
+	GLuint id = createTexture(i, level);
+	for (int l = level; l < layout.levels; l++) {
+		int width = layout.width >> l, height = layout.height >> l;
+		glCopyImageSubData(texids[i], GL_TEXTURE_2D, l - resident, 0, 0, 0,
+			id, GL_TEXTURE_2D, l - level, 0, 0, 0, width > 0 ? width : 1, height > 0 ? height : 1, 1);
+	}
+	swapTexture(i, id);
+}
+
+void TextureBindless::streamTexture(int i, int level) {
+	string cachePath = layouts[i].cachePath;
+	streamPool->push([this, i, level, cachePath]() {
+		CookedTexture* tex = new CookedTexture();
+		if (!tex->load(cachePath.data(), level)) {
+			printf("texture %s stream from %s failed\n", texnames[i].data(), cachePath.data());
+			delete tex; tex = NULL;
+		}
+		lock_guard<mutex> guard(stageLock);
+		streamed.push_back(pair<int, CookedTexture*>(i, tex));
+	});
+}
+
+// Apply finished loads & new residency decisions, true if any handle changed
+bool TextureBindless::updateStreaming() {
+	if (!residency || loadPool) return false;
+	bool changed = false;
+	while (true) {
+		pair<int, CookedTexture*> loaded(-1, (CookedTexture*)NULL);
+		stageLock.lock();
+		if (streamed.size() > 0) {
+			loaded = streamed.front();
+			streamed.pop_front();
+		}
+		stageLock.unlock();
+		if (loaded.first < 0) break;
+
+		int i = loaded.first;
+		CookedTexture* tex = loaded.second;
+		int level = tex ? layouts[i].levels - tex->getLevelCount() : -1;
+		if (level >= 0) {
+			GLuint id = createTexture(i, level);
+			uploadLevels(id, i, tex, 0);
+			swapTexture(i, id);
+			residency->finishChange(i, level);
+			changed = true;
+		} else
+			residency->cancelChange(i);
+		if (tex) delete tex;
+	}
+
+	vector<ResidencyChange> changes;
+	residency->update(changes);
+	for (uint c = 0; c < changes.size(); c++) {
+		ResidencyChange& change = changes[c];
+		if (change.level > residency->getResident(change.index)) {
+			dropLevels(change.index, change.level);
+			residency->finishChange(change.index, change.level);
+			changed = true;
+		} else
+			streamTexture(change.index, change.level);
+	}
+	return changed;
+}
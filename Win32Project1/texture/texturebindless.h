@@ -3,10 +3,25 @@
 
 #include "../render/glheader.h"
 #include "../constants/constants.h"
-#include "imageloader.h"
+#include "../util/threadPool.h"
+#include "textureCooker.h"
+#include "textureResidency.h"
 #include <map>
 #include <string>
 #include <vector>
+#include <deque>
+
+#ifndef MAX_STAGED_TEXTURES
+#define MAX_STAGED_TEXTURES 8
+#define TEXTURE_UPLOAD_BUDGET 2.0 // Milliseconds per frame
+#endif
+
+struct BindlessLayout {
+	GLenum format;
+	int width, height, levels;
+	std::string cachePath; // Streamed levels read from it
+	BindlessLayout() :format(0), width(0), height(0), levels(0) {}
+};
 
 class TextureBindless {
 private:
@@ -14,20 +29,58 @@ private:
 	GLuint* texids;
 	u64* texhnds;
 	std::vector<bool> texSrgbs;
+	std::vector<int> texUsages;
 	std::vector<std::string> texnames;
-	std::vector<ImageLoader*> imgs;
+	std::vector<CookedTexture*> cooks;
 	std::vector<int> wraps;
+	std::vector<BindlessLayout> layouts;
 	int size;
+private:
+	// Placeholder textures used until real one uploaded, 0 linear 1 srgb
+	GLuint holderIds[2];
+	u64 holderHnds[2];
+	std::vector<bool> texReady;
+	int readyCount;
+	// Loaded from cook cache on workers, uploaded by gl thread
+	ThreadPool* loadPool;
+	std::mutex stageLock;
+	std::condition_variable stageCond;
+	std::deque<int> staged;
+	bool stopLoading;
+private:
+	// Mip streaming, only when a budget is set
+	TextureResidency* residency;
+	u64 streamBudget;
+	std::vector<bool> texStreamed;
+	ThreadPool* streamPool;
+	std::deque<std::pair<int, CookedTexture*> > streamed;
 private:
 	void releaseMemory();
+	void createPlaceholders();
+	void decodeTexture(int i, const std::string& path);
+	void uploadTexture(int i);
+	GLuint createTexture(int i, int first);
+	void uploadLevels(GLuint id, int i, CookedTexture* tex, int skip);
+	void swapTexture(int i, GLuint id);
+	void dropLevels(int i, int level);
+	void streamTexture(int i, int level);
 public:
 	TextureBindless();
 	~TextureBindless();
-	void addTexture(const std::string name, bool srgb, int wrap = WRAP_REPEAT);
+	void addTexture(const std::string name, bool srgb, int wrap = WRAP_REPEAT, int usage = USAGE_AUTO);
+	void setUsage(int i, int usage) { texUsages[i] = usage; }
 	int findTexture(const std::string name);
 	void initData(std::string dir);
+	bool updateUploads(float budgetMs);
+	void finishUploads();
+	bool isLoaded() { return readyCount >= size; }
+	void setStreamBudget(u64 bytes) { streamBudget = bytes; }
+	void setStreamed(int i) { if (i >= 0) texStreamed[i] = true; }
+	bool isStreaming() { return residency != NULL; }
+	void requestTexture(int i, float screenSize) { if (residency && i >= 0) residency->request(i, screenSize); }
+	bool updateStreaming();
 	int getSize() { return size; }
 	GLuint64* getHnds() { return texhnds; }
 };
 
-#endif
\ No newline at end of file
+#endif
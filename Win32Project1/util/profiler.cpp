@@ -0,0 +1,112 @@
+#include "profiler.h"
+#include <chrono>
+#include <stdio.h>
+#include <string.h>
+using namespace std;
+
+atomic<bool> Profiler::enabled(false);
+mutex Profiler::trackLock;
+vector<ProfileTrack*> Profiler::tracks;
+
+static const chrono::steady_clock::time_point ProfileStart = chrono::steady_clock::now();
+static thread_local ProfileTrack* CurrentTrack = NULL;
+
+ProfileTrack::ProfileTrack(int tid, const char* trackName) {
+	id = tid;
+	strncpy(name, trackName, PROFILE_NAME_SIZE - 1);
+	name[PROFILE_NAME_SIZE - 1] = '\0';
+	events = new ProfileEvent[PROFILE_RING_SIZE];
+	count = 0;
+}
+
+ProfileTrack::~ProfileTrack() {
+	delete[] events;
+}
+
+void ProfileTrack::push(const char* eventName, u64 start, u64 duration) {
+	uint index = count.load(memory_order_relaxed);
+	ProfileEvent& event = events[index % PROFILE_RING_SIZE];
+	event.name = eventName;
+	event.start = start;
+	event.duration = duration;
+	count.store(index + 1, memory_order_release);
+}
+
+u64 Profiler::Now() {
+	return (u64)chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - ProfileStart).count();
+}
+
+ProfileTrack* Profiler::CreateTrack(const char* name) {
+	lock_guard<mutex> guard(trackLock);
+	int id = (int)tracks.size() + 1;
+	char threadName[PROFILE_NAME_SIZE];
+	if (!name) {
+		snprintf(threadName, PROFILE_NAME_SIZE, "thread %d", id);
+		name = threadName;
+	}
+	ProfileTrack* track = new ProfileTrack(id, name);
+	tracks.push_back(track);
+	return track;
+}
+
+ProfileTrack* Profiler::ThreadTrack() {
+	if (!CurrentTrack) CurrentTrack = CreateTrack(NULL);
+	return CurrentTrack;
+}
+
+void Profiler::SetThreadName(const char* name) {
+	if (!IsEnabled()) return;
+	ProfileTrack* track = ThreadTrack();
+	lock_guard<mutex> guard(trackLock);
+	strncpy(track->name, name, PROFILE_NAME_SIZE - 1);
+}
+
+static void WriteJsonString(FILE* file, const char* str) {
+	fputc('"', file);
+	for (; *str; str++) {
+		if (*str == '"' || *str == '\\') fputc('\\', file);
+		if ((unsigned char)*str >= 0x20) fputc(*str, file);
+	}
+	fputc('"', file);
+}
+
+// Producers may still run, events being overwritten at the ring tail are skipped
+bool Profiler::ExportChromeTrace(const char* path) {
+	FILE* file = fopen(path, "w");
+	if (!file) {
+		printf("profiler can not write %s\n", path);
+		return false;
+	}
+
+	lock_guard<mutex> guard(trackLock);
+	fprintf(file, "{\"traceEvents\":[\n");
+	bool first = true;
+	for (uint t = 0; t < tracks.size(); t++) {
+		ProfileTrack* track = tracks[t];
+		fprintf(file, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":", first ? "" : ",\n", track->id);
+		WriteJsonString(file, track->name);
+		fprintf(file, "}}");
+		first = false;
+
+		uint count = track->count.load(memory_order_acquire);
+		uint begin = count > PROFILE_RING_SIZE ? count - PROFILE_RING_SIZE + PROFILE_RING_SIZE / 16 : 0;
+		for (uint i = begin; i < count; i++) {
+			const ProfileEvent& event = track->events[i % PROFILE_RING_SIZE];
+			fprintf(file, ",\n{\"name\":");
+			WriteJsonString(file, event.name);
+			fprintf(file, ",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%llu,\"dur\":%llu}", 
+				track->id, (unsigned long long)event.start, (unsigned long long)event.duration);
+		}
+	}
+	fprintf(file, "\n],\"displayTimeUnit\":\"ms\"}\n");
+	fclose(file);
+	printf("profile trace written to %s\n", path);
+	return true;
+}
+
+void Profiler::Release() {
+	lock_guard<mutex> guard(trackLock);
+	for (uint i = 0; i < tracks.size(); i++) delete tracks[i];
+	tracks.clear();
+	CurrentTrack = NULL;
+}
@@ -0,0 +1,71 @@
+#ifndef PROFILER_H_
+#define PROFILER_H_
+
+#include "../constants/constants.h"
+#include <vector>
+#include <mutex>
+#include <atomic>
+
+#define PROFILE_RING_SIZE 16384 // Events kept per track, oldest overwritten
+#define PROFILE_NAME_SIZE 32
+#define PROFILE_TRACE_PATH "profile.json"
+
+struct ProfileEvent {
+	const char* name; // Not copied, use string literals
+	u64 start, duration; // Microseconds since profiler started
+};
+
+// Events of one thread or one gpu queue, written by a single producer
+struct ProfileTrack {
+	int id;
+	char name[PROFILE_NAME_SIZE];
+	ProfileEvent* events;
+	std::atomic<uint> count; // Events ever written, ring index is count % size
+	ProfileTrack(int tid, const char* trackName);
+	~ProfileTrack();
+	void push(const char* name, u64 start, u64 duration);
+};
+
+// Scoped cpu timings kept in per thread rings & exported as chrome trace json,
+// a disabled profiler costs one relaxed load per scope
+class Profiler {
+private:
+	static std::atomic<bool> enabled;
+	static std::mutex trackLock;
+	static std::vector<ProfileTrack*> tracks;
+public:
+	static void SetEnabled(bool enable) { enabled.store(enable); }
+	static bool IsEnabled() { return enabled.load(std::memory_order_relaxed); }
+	static u64 Now();
+	// Track of calling thread, created on first use
+	static ProfileTrack* ThreadTrack();
+	// Skipped if disabled, call after enabling
+	static void SetThreadName(const char* name);
+	// Extra track fed by something other than a cpu thread, NULL names it by id
+	static ProfileTrack* CreateTrack(const char* name);
+	static void Record(const char* name, u64 start, u64 end) { ThreadTrack()->push(name, start, end - start); }
+	// Readable by chrome://tracing & perfetto
+	static bool ExportChromeTrace(const char* path);
+	// Only after other profiled threads stopped
+	static void Release();
+};
+
+class ProfileScope {
+private:
+	const char* name;
+	u64 start;
+public:
+	ProfileScope(const char* scopeName) {
+		name = Profiler::IsEnabled() ? scopeName : NULL;
+		start = name ? Profiler::Now() : 0;
+	}
+	~ProfileScope() {
+		if (name) Profiler::Record(name, start, Profiler::Now());
+	}
+};
+
+#define PROFILE_JOIN2(a, b) a##b
+#define PROFILE_JOIN(a, b) PROFILE_JOIN2(a, b)
+#define PROFILE_SCOPE(name) ProfileScope PROFILE_JOIN(profileScope, __LINE__)(name)
+
+#endif
@@ -0,0 +1,108 @@
+#include "threadPool.h"
+#include "../constants/constants.h"
+#include <atomic>
+#include <memory>
+
+int ThreadPool::GetHardwareThreads() {
+	int count = (int)std::thread::hardware_concurrency();
+	return count > 0 ? count : 1;
+}
+
+ThreadPool::ThreadPool(int count) {
+	if (count <= 0) count = GetHardwareThreads() - 1;
+	if (count <= 0) count = 1;
+	running = 0;
+	stopping = false;
+	for (int i = 0; i < count; ++i)
+		workers.push_back(new std::thread(&ThreadPool::workLoop, this));
+}
+
+ThreadPool::~ThreadPool() {
+	lock.lock();
+	stopping = true;
+	lock.unlock();
+	jobCond.notify_all();
+	for (uint i = 0; i < workers.size(); ++i) {
+		workers[i]->join();
+		delete workers[i];
+	}
+	workers.clear();
+}
+
+void ThreadPool::workLoop() {
+	while (true) {
+		std::function<void()> job;
+		{
+			std::unique_lock<std::mutex> guard(lock);
+			while (!stopping && jobs.empty())
+				jobCond.wait(guard);
+			if (jobs.empty()) return; // Stopping & nothing left
+			job = jobs.front();
+			jobs.pop();
+			running++;
+		}
+		job();
+		{
+			std::lock_guard<std::mutex> guard(lock);
+			running--;
+			if (running == 0 && jobs.empty())
+				idleCond.notify_all();
+		}
+	}
+}
+
+void ThreadPool::push(const std::function<void()>& job) {
+	lock.lock();
+	jobs.push(job);
+	lock.unlock();
+	jobCond.notify_one();
+}
+
+void ThreadPool::wait() {
+	std::unique_lock<std::mutex> guard(lock);
+	while (running > 0 || !jobs.empty())
+		idleCond.wait(guard);
+}
+
+void ThreadPool::parallelFor(int count, const std::function<void(int)>& job) {
+	if (count <= 0) return;
+	if (count == 1) {
+		job(0);
+		return;
+	}
+
+	// Workers & caller take indices from a shared counter
+	// State is shared, late helpers find nothing left & exit safely
+	struct ForState {
+		std::function<void(int)> job;
+		std::atomic<int> next, done;
+		int count;
+		std::mutex doneLock;
+		std::condition_variable doneCond;
+	};
+	std::shared_ptr<ForState> state(new ForState());
+	state->job = job;
+	state->next = 0;
+	state->done = 0;
+	state->count = count;
+	std::function<void()> runner = [state]() {
+		int finished = 0;
+		for (int i = state->next++; i < state->count; i = state->next++) {
+			state->job(i);
+			finished++;
+		}
+		if (finished > 0 && (state->done += finished) == state->count) {
+			std::lock_guard<std::mutex> guard(state->doneLock);
+			state->doneCond.notify_all();
+		}
+	};
+
+	int helpers = (int)workers.size() < count - 1 ? (int)workers.size() : count - 1;
+	for (int i = 0; i < helpers; ++i)
+		push(runner);
+	runner();
+
+	std::unique_lock<std::mutex> guard(state->doneLock);
+	while (state->done < count)
+		state->doneCond.wait(guard);
+}
@@ -0,0 +1,34 @@
+#ifndef THREAD_POOL_H_
+#define THREAD_POOL_H_
+
+#include <vector>
+#include <queue>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+
+// Fixed worker threads running pushed jobs in order of arrival
+class ThreadPool {
+private:
+	std::vector<std::thread*> workers;
+	std::queue<std::function<void()> > jobs;
+	std::mutex lock;
+	std::condition_variable jobCond, idleCond;
+	int running;
+	bool stopping;
+private:
+	void workLoop();
+public:
+	ThreadPool(int count = 0);
+	~ThreadPool();
+	void push(const std::function<void()>& job);
+	void wait();
+	// Run job(i) for i in [0, count) on workers & caller, return when all done
+	void parallelFor(int count, const std::function<void(int)>& job);
+	int getThreadCount() { return (int)workers.size(); }
+public:
+	static int GetHardwareThreads();
+};
+
+#endif
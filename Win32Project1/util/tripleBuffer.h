@@ -0,0 +1,43 @@
+#ifndef TRIPLE_BUFFER_H_
+#define TRIPLE_BUFFER_H_
+
+#include <atomic>
+
+#define TRIPLE_INDEX_MASK 3
+#define TRIPLE_NEW_BIT 4
+
+// Lock free handoff of 3 slots between one writer & one reader,
+// writer fills back, reader uses front, middle one is swapped atomically.
+// Reader always gets newest published slot, unread ones are overwritten
+class TripleBuffer {
+private:
+	std::atomic<int> middle; // Slot index | TRIPLE_NEW_BIT if unread
+	int back, front; // Owned by writer & reader thread
+	std::atomic<unsigned int> published, dropped;
+public:
+	TripleBuffer() {
+		back = 0, middle = 1, front = 2;
+		published = 0, dropped = 0;
+	}
+	// Writer thread, returns slot to fill next
+	int publish() {
+		int old = middle.exchange(back | TRIPLE_NEW_BIT, std::memory_order_acq_rel);
+		if (old & TRIPLE_NEW_BIT) dropped++;
+		published++;
+		back = old & TRIPLE_INDEX_MASK;
+		return back;
+	}
+	// Reader thread, false if nothing new since last acquire
+	bool acquire() {
+		if (!(middle.load(std::memory_order_relaxed) & TRIPLE_NEW_BIT)) return false;
+		int old = middle.exchange(front, std::memory_order_acq_rel);
+		front = old & TRIPLE_INDEX_MASK;
+		return true;
+	}
+	int getBack() { return back; }
+	int getFront() { return front; }
+	unsigned int getPublished() { return published; }
+	unsigned int getDropped() { return dropped; }
+};
+
+#endif
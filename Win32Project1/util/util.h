@@ -431,6 +431,8 @@ struct ConfigArg {
 	bool vsync;
 	bool dualthread;
 	bool dualqueue;
+	bool physthread;
+	bool physterrain;
 	int smoothframe;
 	int graphQuality;
 	int shadowQuality;
@@ -441,6 +443,12 @@ struct ConfigArg {
 	bool dynsky;
 	bool cartoon;
 	bool debug;
+	int texbudget; // MB of streamed textures, 0 keeps all full
+	bool cpucull; // Cull multi instances on worker threads instead of compute shader
+	bool occlusion; // Skip main view nodes hidden behind terrain & big static meshes
+	int ringsize; // MB of persistent mapped upload ring, 0 uploads buffers directly
+	bool profile; // Record scoped timings, trace written on exit
+	bool shadowcache; // Reuse static shadow cascade culling until light camera or static nodes change
 };
 
 #define MIN_VAL 1.175494351e-38f